@@ -401,6 +401,48 @@ class _DistTestBase(object):
             group, group_id, rank, dist.reduce_op.MAX, -1, 10, 10
         )
 
+    # COMPRESSED ALL REDUCE
+    def _test_all_reduce_compressed_helper(self, group, group_id, rank):
+        if not group:
+            return
+
+        expected = _build_tensor(5, sum(group) + len(group))
+        for method in ['fp16', 'bf16', 'topk', 'sign']:
+            compressor = dist.Compressor(method, ratio=1)
+            tensor = _build_tensor(5, rank + 1)
+            dist.all_reduce(tensor, group=group_id, compressor=compressor)
+            self.assertEqual(tensor, expected)
+            if method == 'fp16':
+                # the padding and the chunks encoded again don't count
+                self.assertEqual(compressor.stats, (tensor.numel() * 4, tensor.numel() * 2))
+        self.assertEqual(compressor.stats, (tensor.numel() * 4, 4 + (tensor.numel() + 7) // 8))
+
+        # the elements not sent by top-k are sent by the next calls
+        compressor = dist.Compressor('topk', ratio=0.5)
+        tensor = _build_tensor(5, rank + 1)
+        dist.all_reduce(tensor, group=group_id, compressor=compressor)
+        sent = (tensor.numel() + 1) // 2
+        self.assertEqual(tensor.ne(0).sum(), sent)
+        tensor2 = _build_tensor(5, 0)
+        dist.all_reduce(tensor2, group=group_id, compressor=compressor)
+        self.assertEqual(tensor + tensor2, expected)
+        self.assertEqual(compressor.compression_ratio, float(tensor.numel() * 4) / (sent * 8))
+
+        self.assertRaises(ValueError, lambda: dist.all_reduce(
+            tensor, dist.reduce_op.MAX, group_id, compressor=compressor))
+
+        self._barrier()
+
+    @unittest.skipIf(BACKEND == 'gloo', "Gloo does not support scatter")
+    def test_all_reduce_compressed(self):
+        group, group_id, rank = self._init_global_test()
+        self._test_all_reduce_compressed_helper(group, group_id, rank)
+
+    @unittest.skipIf(BACKEND == 'gloo', "Gloo does not support scatter")
+    def test_all_reduce_compressed_group(self):
+        group, group_id, rank = self._init_group_test()
+        self._test_all_reduce_compressed_helper(group, group_id, rank)
+
     # SCATTER
     def _test_scatter_helper(self, group, group_id, rank):
         for dest in group:
@@ -466,6 +508,65 @@ class _DistTestBase(object):
         group, group_id, rank = self._init_group_test()
         self._test_all_gather_helper(group, group_id, rank)
 
+    # REDUCE SCATTER
+    def _test_reduce_scatter_helper(self, group, group_id, rank):
+        if not group:
+            return
+
+        # process j contributes j + i to the i-th chunk
+        tensors = [_build_tensor(5, rank + i) for i in range(len(group))]
+        tensor = _build_tensor(5, -1)
+        dist.reduce_scatter(tensor, tensors, dist.reduce_op.SUM, group_id)
+        self.assertEqual(tensor, _build_tensor(5, sum(group) + len(group) * group.index(rank)))
+
+        dist.reduce_scatter(tensor, tensors, dist.reduce_op.MAX, group_id)
+        self.assertEqual(tensor, _build_tensor(5, max(group) + group.index(rank)))
+
+        self._barrier()
+
+    def test_reduce_scatter(self):
+        group, group_id, rank = self._init_global_test()
+        self._test_reduce_scatter_helper(group, group_id, rank)
+
+    def test_reduce_scatter_group(self):
+        group, group_id, rank = self._init_group_test()
+        self._test_reduce_scatter_helper(group, group_id, rank)
+
+    # ASYNC COLLECTIVES
+    def _test_async_collectives_helper(self, group, group_id, rank):
+        if not group:
+            return
+
+        src = group[0]
+        sum_tensor = _build_tensor(5, rank)
+        bcast_tensor = _build_tensor(5, 7 if rank == src else -1)
+        tensors = [_build_tensor(5, -1) for i in group]
+        requests = [
+            dist.all_reduce(sum_tensor, group=group_id, async_op=True),
+            dist.broadcast(bcast_tensor, src, group_id, async_op=True),
+            dist.all_gather(tensors, bcast_tensor, group_id, async_op=True),
+            dist.barrier(group_id, async_op=True),
+        ]
+        for request in requests:
+            request.wait()
+            self.assertTrue(request.is_completed())
+
+        self.assertEqual(sum_tensor, _build_tensor(5, sum(group)))
+        self.assertEqual(bcast_tensor, _build_tensor(5, 7))
+        for t in tensors:
+            self.assertEqual(t, _build_tensor(5, 7))
+        self.assertIsNone(dist.barrier(group_id))
+
+        self._barrier()
+
+    def test_async_collectives(self):
+        group, group_id, rank = self._init_global_test()
+        self._test_async_collectives_helper(group, group_id, rank)
+
+    def test_async_collectives_group(self):
+        group, group_id, rank = self._init_group_test()
+        self._test_async_collectives_helper(group, group_id, rank)
+
     # BARRIER
     def _test_barrier_helper(self, group, group_id, rank):
         WAIT_TIME = 0.3  # seconds
@@ -1,5 +1,6 @@
 import torch
 import torch.jit
+import torch.onnx
 import torch.nn as nn
 import torch.nn.functional as F
 import unittest
@@ -8,6 +9,7 @@ from torch.autograd import Variable, Function
 from torch.autograd.function import traceable
 from common import TestCase, run_tests
 import io
+import tempfile
 
 try:
     import torchvision
@@ -694,6 +696,57 @@ class TestJit(TestCase):
         z, _ = model(x, y, _assert_compiled=True)
         z.sum().backward()
 
+    def test_native_symbolics(self):
+        class MyModel(nn.Module):
+            def __init__(self):
+                super(MyModel, self).__init__()
+                self.fc1 = nn.Linear(4, 6)
+                self.fc2 = nn.Linear(12, 5)
+
+            def forward(self, x):
+                x = F.relu(self.fc1(x) * 2 + 1)
+                x = F.max_pool2d(x.view(2, 1, 2, 3), 1).view(2, 6)
+                x = torch.cat([x, x.t().t()], 1)
+                y = F.leaky_relu(self.fc2(x), 0.2)
+                y = y - y.mm(y.transpose(0, 1)).mm(y)
+                return F.log_softmax(F.sigmoid(y).neg() / 3, dim=1)
+
+        x = Variable(torch.randn(2, 4))
+        model = MyModel()
+
+        def to_onnx(native_symbolics):
+            trace, _ = torch.jit.trace(model, x)
+            torch._C._jit_pass_onnx(trace, native_symbolics)
+            return str(trace)
+
+        self.assertEqual(to_onnx(True), to_onnx(False))
+
+    def test_native_symbolics_pool_scalar_args(self):
+        def f(x):
+            return F.avg_pool2d(F.max_pool2d(x, 2), 3, 1, 1)
+
+        x = Variable(torch.randn(1, 1, 4, 4))
+        traces = []
+        for native_symbolics in (True, False):
+            trace, _ = torch.jit.trace(f, x)
+            torch._C._jit_pass_onnx(trace, native_symbolics)
+            traces.append(str(trace))
+        self.assertExpected(traces[0])
+        self.assertEqual(traces[0], traces[1])
+
+    def test_export_to_file(self):
+        model = nn.Sequential(nn.Linear(4, 5), nn.ReLU(), nn.Linear(5, 3))
+        x = Variable(torch.randn(2, 4))
+
+        buffer = io.BytesIO()
+        torch.onnx.export(model, x, buffer)
+        with tempfile.TemporaryFile() as f:
+            f.write(b'header')
+            torch.onnx.export(model, x, f)
+            f.write(b'footer')
+            f.seek(0)
+            self.assertEqual(f.read(), b'header' + buffer.getvalue() + b'footer')
+
     @skipIfNoTorchVision
     def test_alexnet(self):
         x = Variable(torch.randn(10, 3, 224, 224).fill_(1.0), requires_grad=True)
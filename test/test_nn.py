@@ -1,5 +1,9 @@
 import math
+import os
+import sys
 import random
+import subprocess
+import textwrap
 import string
 import unittest
 import itertools
@@ -74,6 +78,19 @@ def _assertGradAndGradgradChecks(test_case, apply_fn, inputs):
     test_case.assertTrue(gradgradcheck(apply_fn, inputs, grad_y,))
 
 
+def _run_in_new_interpreter(code, args=(), **env):
+    # for settings that are only read once per process
+    env = dict(os.environ, **env)
+    code = 'import torch\nfrom torch.autograd import Variable\n' + textwrap.dedent(code)
+    subprocess.check_call([sys.executable, '-c', code] + list(args), env=env)
+
+
+def _run_with_capped_omp_team(code):
+    # OMP_THREAD_LIMIT below OMP_NUM_THREADS makes OpenMP start smaller
+    # teams than num_threads() clauses ask for
+    _run_in_new_interpreter(code, OMP_NUM_THREADS='4', OMP_THREAD_LIMIT='2')
+
+
 class InputVariableMixin(object):
     def _get_input(self):
         input = TestBase._get_input(self)
@@ -934,6 +951,49 @@ class TestNN(NNTestCase):
         self.assertEqual(output[0][0].sum().data[0], 0)
         self.assertEqual(output[1][2].sum().data[0], 0)
 
+    def test_embedding_sparse_backward(self):
+        input = Variable(torch.LongTensor(40, 50).random_(0, 3000))
+        input.data[0].fill_(7)
+        for padding_idx, scale_grad_by_freq in product([None, 7], [False, True]):
+            dense = nn.Embedding(3000, 8, padding_idx=padding_idx,
+                                 scale_grad_by_freq=scale_grad_by_freq).double()
+            sparse = nn.Embedding(3000, 8, padding_idx=padding_idx,
+                                  scale_grad_by_freq=scale_grad_by_freq, sparse=True).double()
+            sparse.weight.data.copy_(dense.weight.data)
+            grad_output = torch.randn(40, 50, 8).double()
+            dense(input).backward(grad_output)
+            sparse(input).backward(grad_output)
+            grad = sparse.weight.grad.data
+            self.assertTrue(grad.is_coalesced())
+            self.assertEqual(grad._indices().size(1), len(set(input.data.view(-1).tolist()) - {padding_idx}))
+            self.assertEqual(grad.to_dense(), dense.weight.grad.data)
+
+    def test_embedding_sparse_backward_all_padding(self):
+        embedding = nn.Embedding(10, 3, padding_idx=2, sparse=True)
+        embedding(Variable(torch.LongTensor([[2, 2], [2, 2]]))).sum().backward()
+        grad = embedding.weight.grad.data
+        self.assertEqual(grad._nnz(), 0)
+        self.assertEqual(grad._dimI(), 1)
+        self.assertEqual(grad._dimV(), 1)
+        self.assertEqual(grad.to_dense(), torch.zeros(10, 3))
+
+        # the empty gradient accumulates with the next ones
+        embedding(Variable(torch.LongTensor([1, 2, 4]))).sum().backward()
+        expected = torch.zeros(10, 3)
+        expected[1].fill_(1)
+        expected[4].fill_(1)
+        self.assertEqual(embedding.weight.grad.data.to_dense(), expected)
+
+    def test_embedding_backward_capped_omp_team(self):
+        _run_with_capped_omp_team("""
+            input = Variable(torch.LongTensor(40000).random_(0, 3000))
+            embedding = torch.nn.Embedding(3000, 4).double()
+            grad_output = torch.randn(40000, 4).double()
+            embedding(input).backward(grad_output)
+            expected = torch.zeros(3000, 4).double().index_add_(0, input.data, grad_output)
+            assert (embedding.weight.grad.data - expected).abs().max() < 1e-10
+        """)
+
     def test_embedding_max_norm(self):
         embedding = nn.Embedding(22, 5, max_norm=1.0)
         input = Variable(torch.LongTensor([2, 8, 8, 6]))
@@ -1091,6 +1151,69 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'sum')
         self._test_EmbeddingBag(False, 'mean')
 
+    def test_EmbeddingBag_max_weighted_sparse(self):
+        N, D = 20, 6
+        input = Variable(torch.LongTensor([3, 1, 1, 7, 4, 0, 19, 3, 3, 12]))
+        offsets = Variable(torch.LongTensor([0, 3, 3, 8]))
+        grad_output = torch.randn(4, D)
+        e = nn.Embedding(N, D)
+        bags = [(0, 3), (3, 3), (3, 8), (8, 10)]
+
+        # max against Embedding followed by max over each bag, empty bags are 0
+        es = nn.EmbeddingBag(N, D, mode='max')
+        es.weight.data.copy_(e.weight.data)
+        output = es(input, offsets)
+        ref_output = torch.cat([e(input[s:t]).max(0, keepdim=True)[0] if t > s
+                                else Variable(torch.zeros(1, D)) for s, t in bags])
+        self.assertEqual(output, ref_output)
+        output.backward(grad_output)
+        ref_output.backward(grad_output)
+        self.assertEqual(es.weight.grad, e.weight.grad)
+
+        # weighted sum, with gradients for both the weights and the embeddings
+        e.zero_grad()
+        es = nn.EmbeddingBag(N, D, mode='sum')
+        es.weight.data.copy_(e.weight.data)
+        psw = Variable(torch.rand(10), requires_grad=True)
+        ref_psw = Variable(psw.data.clone(), requires_grad=True)
+        output = es(input, offsets, psw)
+        rows = e(input) * ref_psw.unsqueeze(1)
+        ref_output = torch.cat([rows[s:t].sum(0, keepdim=True) if t > s
+                                else Variable(torch.zeros(1, D)) for s, t in bags])
+        self.assertEqual(output, ref_output)
+        output.backward(grad_output)
+        ref_output.backward(grad_output)
+        self.assertEqual(es.weight.grad, e.weight.grad)
+        self.assertEqual(psw.grad, ref_psw.grad)
+        self.assertRaises(ValueError, lambda: nn.EmbeddingBag(N, D, mode='mean')(input, offsets, psw))
+
+        # the inputs are saved for backward, so in-place changes are caught
+        psw = Variable(torch.rand(10))
+        output = es(input, offsets, psw)
+        psw.mul_(2)
+        self.assertRaises(RuntimeError, lambda: output.backward(grad_output))
+
+        # the kernels check the offsets themselves, as every lookup has to be in a bag
+        from torch._thnn import type2backend
+        backend = type2backend[torch.FloatTensor]
+        for bad_offsets in ([2, 3, 3, 8], [0, 3, 2, 8]):
+            self.assertRaises(RuntimeError, lambda: backend.LookupTableBag_updateOutput(
+                backend.library_state, input.data, torch.LongTensor(bad_offsets), e.weight.data,
+                torch.FloatTensor(), None, torch.LongTensor(), 0))
+
+        # sparse gradients are coalesced and match the dense ones
+        for mode, scale_grad_by_freq in itertools.product(['sum', 'mean', 'max'], [False, True]):
+            dense = nn.EmbeddingBag(N, D, mode=mode, scale_grad_by_freq=scale_grad_by_freq)
+            sparse = nn.EmbeddingBag(N, D, mode=mode, scale_grad_by_freq=scale_grad_by_freq,
+                                     sparse=True)
+            sparse.weight.data.copy_(dense.weight.data)
+            dense(input, offsets).backward(grad_output)
+            sparse(input, offsets).backward(grad_output)
+            grad = sparse.weight.grad.data
+            self.assertTrue(grad.is_coalesced())
+            self.assertEqual(grad._nnz(), 7)
+            self.assertEqual(grad.to_dense(), dense.weight.grad.data)
+
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     def test_EmbeddingBag_cuda(self):
         self._test_EmbeddingBag(True, 'sum')
@@ -1869,6 +1992,92 @@ class TestNN(NNTestCase):
         self.assertRaisesRegex(RuntimeError, 'Specify retain_graph=True',
                                lambda: o1.sum().backward())
 
+    def test_Conv2d_cpu_algorithms(self):
+        # the Winograd and direct CPU algorithms must match the im2col one.
+        # THNN_CONV_ALGORITHM is read once per process, so every algorithm
+        # runs in its own interpreter, with the same seed
+        import tempfile
+        code = """
+            import sys
+            torch.manual_seed(0)
+            results = []
+            for in_planes, out_planes, kernel, stride, padding in [
+                    (16, 16, 3, 1, 1), (16, 20, 3, 1, 0), (3, 8, 3, 1, 1), (2, 4, 5, 2, 2), (1, 1, 7, 2, 3)]:
+                conv = torch.nn.Conv2d(in_planes, out_planes, kernel, stride, padding).double()
+                input = Variable(torch.randn(2, in_planes, 9, 7).double(), requires_grad=True)
+                output = conv(input)
+                grad_output = Variable(torch.arange(0, output.numel()).view_as(output.data).double())
+                grads = torch.autograd.grad(output, [input] + list(conv.parameters()), grad_output)
+                results.append([output.data] + [g.data for g in grads])
+            torch.save(results, sys.argv[1])
+        """
+        results = []
+        for algorithm in ('mm', 'winograd', 'direct'):
+            fd, path = tempfile.mkstemp()
+            os.close(fd)
+            try:
+                _run_in_new_interpreter(code, [path], THNN_CONV_ALGORITHM=algorithm)
+                results.append(torch.load(path))
+            finally:
+                os.remove(path)
+        for result in results[1:]:
+            for layer, expected_layer in zip(result, results[0]):
+                for value, expected in zip(layer, expected_layer):
+                    self.assertEqual(value, expected, prec=1e-8)
+
+    def test_Conv2d_batch_weight_grad(self):
+        # the weight gradient of a batch is computed with GEMMs spanning
+        # several frames; it must match the sum over single frames
+        for in_planes, padding in [(16, 1), (3, 0)]:
+            conv = nn.Conv2d(in_planes, 8, 3, padding=padding).double()
+            input = Variable(torch.randn(6, in_planes, 7, 8).double())
+            grads = torch.autograd.grad(conv(input).sum(), conv.parameters())
+            expected = [torch.zeros(p.size()).double() for p in conv.parameters()]
+            for frame in input.split(1):
+                frame_grads = torch.autograd.grad(conv(frame).sum(), conv.parameters())
+                for acc, grad in zip(expected, frame_grads):
+                    acc += grad.data
+            for grad, expected_grad in zip(grads, expected):
+                self.assertEqual(grad.data, expected_grad, prec=1e-10)
+
+    def test_Conv2d_batch_weight_grad_capped_omp_team(self):
+        _run_with_capped_omp_team("""
+            conv = torch.nn.Conv2d(3, 8, 3).double()
+            input = Variable(torch.randn(6, 3, 7, 8).double())
+            grad = torch.autograd.grad(conv(input).sum(), conv.weight)[0].data
+            expected = sum(torch.autograd.grad(conv(frame).sum(), conv.weight)[0].data
+                           for frame in input.split(1))
+            assert (grad - expected).abs().max() < 1e-10
+        """)
+
+    def test_Conv2d_cpu_benchmark(self):
+        import os
+        import tempfile
+        conv = nn.Conv2d(16, 16, 3, padding=1)
+        input = Variable(torch.randn(2, 16, 10, 10), requires_grad=True)
+        expected = conv(input)
+        expected_grads = torch.autograd.grad(expected.sum(), [input] + list(conv.parameters()))
+
+        fd, path = tempfile.mkstemp()
+        os.close(fd)
+        try:
+            torch.backends.cpu.set_benchmark_cache(path)
+            with torch.backends.cpu.flags(benchmark=True):
+                # the first call times the backends, the second hits the cache
+                for _ in range(2):
+                    output = conv(input)
+                    grads = torch.autograd.grad(output.sum(), [input] + list(conv.parameters()))
+                    self.assertEqual(output, expected, prec=1e-4)
+                    for grad, expected_grad in zip(grads, expected_grads):
+                        self.assertEqual(grad, expected_grad, prec=1e-4)
+            with open(path) as f:
+                entries = f.read().splitlines()
+            self.assertEqual(len(entries), 1)
+            self.assertIn('g1', entries[0])
+        finally:
+            torch.backends.cpu.set_benchmark_cache('')
+            os.remove(path)
+
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     def test_Conv2d_large_workspace(self):
         # These sizes require huge cuDNN workspaces. Make sure we choose a
@@ -2202,6 +2411,145 @@ class TestNN(NNTestCase):
 
             (hx + cx).sum().backward()
 
+    def test_rnn_cell_fused_cpu(self):
+        # the CPU cells use the fused THNN kernels; compare them against
+        # the same cells written with autograd ops
+        def lstm_ref(input, hidden, w_ih, w_hh, b_ih, b_hh):
+            gates = F.linear(input, w_ih, b_ih) + F.linear(hidden[0], w_hh, b_hh)
+            i, f, c, o = gates.chunk(4, 1)
+            cy = F.sigmoid(f) * hidden[1] + F.sigmoid(i) * F.tanh(c)
+            return F.sigmoid(o) * F.tanh(cy), cy
+
+        def gru_ref(input, hidden, w_ih, w_hh, b_ih, b_hh):
+            i_r, i_i, i_n = F.linear(input, w_ih, b_ih).chunk(3, 1)
+            h_r, h_i, h_n = F.linear(hidden, w_hh, b_hh).chunk(3, 1)
+            r = F.sigmoid(i_r + h_r)
+            z = F.sigmoid(i_i + h_i)
+            n = F.tanh(i_n + r * h_n)
+            return n + z * (hidden - n)
+
+        for module, ref in ((nn.LSTMCell, lstm_ref), (nn.GRUCell, gru_ref)):
+            for bias in (True, False):
+                cell = module(10, 20, bias=bias).double()
+                input = Variable(torch.randn(3, 10).double(), requires_grad=True)
+                hx = Variable(torch.randn(3, 20).double(), requires_grad=True)
+                if module is nn.LSTMCell:
+                    hidden = (hx, Variable(torch.randn(3, 20).double(), requires_grad=True))
+                else:
+                    hidden = hx
+                inputs = [input, hx] + list(cell.parameters())
+                if module is nn.LSTMCell:
+                    inputs.append(hidden[1])
+
+                results = []
+                for fn in (cell, lambda i, h: ref(i, h, cell.weight_ih, cell.weight_hh,
+                                                  cell.bias_ih, cell.bias_hh)):
+                    out = fn(input, hidden)
+                    out = sum(o.sum() * (k + 1) for k, o in enumerate(out)) if isinstance(out, tuple) \
+                        else out.sum()
+                    results.append((out.data,) + torch.autograd.grad(out, inputs))
+                for fused, unfused in zip(*results):
+                    self.assertEqual(fused, unfused, prec=1e-10)
+
+    def test_rnn_cell_fused_cpu_double_backward(self):
+        # the fused CPU kernels can only be differentiated once, so the cells
+        # differentiate their autograd ops when create_graph=True
+        from torch.nn._functions.rnn import LSTMCell, GRUCell
+        for cell, num_gates in ((LSTMCell, 4), (GRUCell, 3)):
+            for bias in (True, False):
+                input = Variable(torch.randn(2, 3).double(), requires_grad=True)
+                hx = Variable(torch.randn(2, 4).double(), requires_grad=True)
+                cx = Variable(torch.randn(2, 4).double(), requires_grad=True)
+                weights = [Variable(torch.randn(num_gates * 4, 3).double(), requires_grad=True),
+                           Variable(torch.randn(num_gates * 4, 4).double(), requires_grad=True)]
+                if bias:
+                    weights += [Variable(torch.randn(num_gates * 4).double(), requires_grad=True)
+                                for _ in range(2)]
+
+                if cell is LSTMCell:
+                    def fn(input, hx, cx, *weights):
+                        return LSTMCell(input, (hx, cx), *weights)
+                    inputs = (input, hx, cx) + tuple(weights)
+                    grad_outputs = (Variable(torch.randn(2, 4).double(), requires_grad=True),
+                                    Variable(torch.randn(2, 4).double(), requires_grad=True))
+                else:
+                    def fn(input, hx, *weights):
+                        return GRUCell(input, hx, *weights)
+                    inputs = (input, hx) + tuple(weights)
+                    grad_outputs = (Variable(torch.randn(2, 4).double(), requires_grad=True),)
+                self.assertTrue(gradgradcheck(fn, inputs, grad_outputs))
+
+    def test_RNN_cpu_native_vs_autograd(self):
+        # CPU LSTM and GRU layers run whole sequences natively; compare them
+        # against the per-step autograd implementation
+        from torch.nn._functions.rnn import AutogradRNN
+        lengths = [5, 5, 3, 1]
+        for mode, packed, batch_first in product(('LSTM', 'GRU'), (False, True), (False, True)):
+            rnn = getattr(nn, mode)(3, 4, num_layers=2, bidirectional=True,
+                                    batch_first=batch_first).double()
+            input = torch.randn(4, 5, 3) if batch_first else torch.randn(5, 4, 3)
+            input = Variable(input.double(), requires_grad=True)
+            hx = Variable(torch.randn(4, 4, 4).double(), requires_grad=True)
+            hidden = (hx, hx * 2) if mode == 'LSTM' else hx
+            batch_sizes = None
+            rnn_input = input
+            if packed:
+                rnn_input = rnn_utils.pack_padded_sequence(input, lengths, batch_first=batch_first)
+                batch_sizes = rnn_input.batch_sizes
+
+            output, hy = rnn(rnn_input, hidden)
+            ref_fn = AutogradRNN(mode, 3, 4, num_layers=2, batch_first=batch_first,
+                                 bidirectional=True, batch_sizes=batch_sizes)
+            ref_output, ref_hy = ref_fn(rnn_input.data if packed else input, rnn.all_weights, hidden)
+
+            if packed:
+                output = output.data
+            outputs = [output] + list(hy if mode == 'LSTM' else (hy,))
+            ref_outputs = [ref_output] + list(ref_hy if mode == 'LSTM' else (ref_hy,))
+            params = [input, hx] + list(rnn.parameters())
+            grads = [Variable(torch.randn(*o.size()).double()) for o in outputs]
+            results = torch.autograd.grad(outputs, params, grads)
+            ref_results = torch.autograd.grad(ref_outputs, params, grads)
+            for out, ref_out in zip(outputs + list(results), ref_outputs + list(ref_results)):
+                self.assertEqual(out, ref_out, prec=1e-10)
+
+    def test_RNN_cpu_native_double_backward(self):
+        # the native CPU layers can only be differentiated once, so they
+        # differentiate AutogradRNN when create_graph=True
+        from torch.nn._functions.rnn import RNN
+        for mode in ('LSTM', 'GRU'):
+            is_lstm = mode == 'LSTM'
+            gate_size = (4 if is_lstm else 3) * 2
+            input = Variable(torch.randn(3, 2, 2).double(), requires_grad=True)
+            hidden = [Variable(torch.randn(1, 2, 2).double(), requires_grad=True)
+                      for _ in range(2 if is_lstm else 1)]
+            weights = [Variable(torch.randn(gate_size, 2).double(), requires_grad=True),
+                       Variable(torch.randn(gate_size, 2).double(), requires_grad=True),
+                       Variable(torch.randn(gate_size).double(), requires_grad=True),
+                       Variable(torch.randn(gate_size).double(), requires_grad=True)]
+
+            def fn(input, *args):
+                hx = tuple(args[:2]) if is_lstm else args[0]
+                output, hy = RNN(mode, 2, 2)(input, [list(args[len(hidden):])], hx)
+                return (output,) + (hy if is_lstm else (hy,))
+
+            inputs = (input,) + tuple(hidden) + tuple(weights)
+            grad_outputs = tuple(Variable(torch.randn(*o.size()).double(), requires_grad=True)
+                                 for o in fn(*inputs))
+            self.assertTrue(gradgradcheck(fn, inputs, grad_outputs))
+
+        # the recomputation replays the dropout masks of the forward
+        rnn = nn.LSTM(3, 4, num_layers=2, dropout=0.5).double()
+        input = Variable(torch.randn(5, 2, 3).double(), requires_grad=True)
+        hidden = (Variable(torch.randn(2, 2, 4).double()), Variable(torch.randn(2, 2, 4).double()))
+        output, _ = rnn(input, hidden)
+        grad = Variable(torch.randn(*output.size()).double())
+        params = [input] + list(rnn.parameters())
+        grads = torch.autograd.grad(output, params, grad.data, retain_graph=True)
+        double_grads = torch.autograd.grad(output, params, grad, create_graph=True)
+        for g, double_g in zip(grads, double_grads):
+            self.assertEqual(g, double_g, prec=1e-10)
+
     @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
     def test_cudnn_weight_format(self):
         rnns = [
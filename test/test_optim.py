@@ -339,6 +339,82 @@ class TestOptim(TestCase):
                 lr=1e-2)
         )
 
+    def test_fused_step(self):
+        # contiguous float/double parameters go through the fused kernels,
+        # transposed ones through the per-op implementation
+        def make_params(contiguous):
+            torch.manual_seed(2)
+            params = []
+            for size in [(10, 7), (50, 30), (1, 1)]:
+                data = torch.randn(*size)
+                if not contiguous:
+                    data = data.t().contiguous().t()
+                params.append(Variable(data.double(), requires_grad=True))
+            return params
+
+        constructors = [
+            lambda params: optim.SGD(params, lr=1e-2),
+            lambda params: optim.SGD(params, lr=1e-2, weight_decay=1e-2),
+            lambda params: optim.SGD(params, lr=1e-2, momentum=0.9, dampening=0.1, weight_decay=1e-2),
+            lambda params: optim.SGD(params, lr=1e-2, momentum=0.9, nesterov=True),
+            lambda params: optim.Adam(params, lr=1e-2, weight_decay=1e-2),
+            lambda params: optim.Adagrad(params, lr=1e-2, lr_decay=1e-3, weight_decay=1e-2),
+            lambda params: optim.RMSprop(params, lr=1e-2, weight_decay=1e-2),
+            lambda params: optim.RMSprop(params, lr=1e-2, momentum=0.9, centered=True),
+        ]
+        for constructor in constructors:
+            fused_params, params = make_params(True), make_params(False)
+            fused_optimizer, optimizer = constructor(fused_params), constructor(params)
+            for i in range(5):
+                for o, ps in ((fused_optimizer, fused_params), (optimizer, params)):
+                    o.zero_grad()
+                    sum((p * p).sum() * (j + 1) for j, p in enumerate(ps)).backward()
+                    o.step()
+            # the gradients are modified in the same way too
+            for fused_p, p in zip(fused_params, params):
+                self.assertEqual(fused_p, p, prec=1e-10)
+                self.assertEqual(fused_p.grad, p.grad, prec=1e-10)
+
+    def test_sparse_row_step(self):
+        # sparse gradients go through the row-sparse kernels; when the same
+        # rows are touched in every step the lazy updates match dense ones
+        rows = torch.LongTensor([[4, 0, 4, 7]])
+        constructors = [
+            lambda params: optim.SGD(params, lr=1e-2, momentum=0.9, dampening=0.1),
+            lambda params: optim.SGD(params, lr=1e-2, momentum=0.9, nesterov=True),
+            lambda params: optim.Adam(params, lr=1e-2),
+            lambda params: optim.Adagrad(params, lr=1e-2, lr_decay=1e-3),
+        ]
+        for constructor in constructors:
+            torch.manual_seed(2)
+            data = torch.randn(10, 3).double()
+            sparse_param = Variable(data.clone(), requires_grad=True)
+            dense_param = Variable(data.clone(), requires_grad=True)
+            sparse_optimizer = constructor([sparse_param])
+            dense_optimizer = constructor([dense_param])
+            for p in (sparse_param, dense_param):
+                p.sum().backward()
+            for i in range(5):
+                grad = sparse.DoubleTensor(rows, torch.randn(4, 3).double(), torch.Size([10, 3]))
+                sparse_param.grad.data = grad
+                dense_param.grad.data = grad.to_dense()
+                sparse_optimizer.step()
+                dense_optimizer.step()
+            self.assertEqual(sparse_param.data, dense_param.data, prec=1e-10)
+            for row in [1, 2, 3, 5, 6, 8, 9]:
+                self.assertEqual(sparse_param.data[row], data[row], prec=0)
+
+        # like the dense step, the weight decay is added to the gradient rows
+        sparse_param = Variable(data.clone(), requires_grad=True)
+        sparse_param.sum().backward()
+        values = torch.randn(4, 3).double()
+        sparse_param.grad.data = sparse.DoubleTensor(rows, values, torch.Size([10, 3]))
+        expected = sparse_param.grad.data.coalesce().to_dense()
+        for row in [0, 4, 7]:
+            expected[row].add_(1e-2, data[row])
+        optim.SGD([sparse_param], lr=1e-2, momentum=0.9, weight_decay=1e-2).step()
+        self.assertEqual(sparse_param.grad.data.to_dense(), expected, prec=1e-10)
+
     def test_asgd(self):
         self._test_rosenbrock(
             lambda params: optim.ASGD(params, lr=1e-3),
@@ -618,6 +618,19 @@ class TestSparse(TestCase):
         self._test_sparse_mask_shape([50, 30, 20], [2])
         self._test_sparse_mask_shape([5, 5, 5, 5, 5, 5], [2])
 
+    def test_coalesce_add_mul_large(self):
+        # enough nonzeros for coalesce, add and mul to be split across threads
+        shape = [200, 100, 3]
+        x1, _, _ = self._gen_sparse(2, 40000, shape)
+        x2, _, _ = self._gen_sparse(2, 30000, shape)
+        y1, y2 = x1.coalesce(), x2.coalesce()
+        self.assertEqual(y1.to_dense(), x1.to_dense())
+        indices = y1._indices()
+        linear = indices[0] * shape[1] + indices[1]
+        self.assertEqual((linear[1:] <= linear[:-1]).sum(), 0)
+        self.assertEqual((y1 + y2).to_dense(), x1.to_dense() + x2.to_dense())
+        self.assertEqual((y1 * y2).to_dense(), x1.to_dense() * x2.to_dense())
+
     def test_sparse_add_coalesce(self):
         i = self.IndexTensor([[1, 2, 1]])
         v = self.ValueTensor([3, 4, 5])
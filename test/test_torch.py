@@ -4071,6 +4071,33 @@ class TestTorch(TestCase):
             rootview = c[8]
             self.assertEqual(rootview.data_ptr(), c[0].data_ptr())
 
+    def test_serialization_page_aligned(self):
+        a = torch.randn(100, 50)
+        b = [a, a[10:20], torch.arange(1, 11).int(), torch.DoubleTensor(), a.storage()]
+        with tempfile.NamedTemporaryFile() as f:
+            torch.save(b, f.name, page_aligned=True)
+            for mmap_mode in (None, 'c', 'r'):
+                c = torch.load(f.name, mmap_mode=mmap_mode)
+                self.assertEqual(b, c, 0)
+                self.assertEqual(c[1].data_ptr(), c[0][10].data_ptr())
+            c = torch.load(f.name, mmap_mode='c')
+            c[0].fill_(1)
+            # copy-on-write mappings don't write back to the file
+            self.assertEqual(torch.load(f.name)[0], a, 0)
+            self.assertRaises(ValueError, lambda: torch.load(f.name, mmap_mode='w'))
+
+    def test_serialization_async(self):
+        a = torch.randn(100, 50)
+        b = [a, a[10:20], torch.arange(1, 11).int(), torch.DoubleTensor()]
+        expected = [t.clone() for t in b]
+        with tempfile.NamedTemporaryFile() as f:
+            future = torch.save_async(b, f.name, num_threads=2, fsync=True)
+            # the storages were snapshotted, so this doesn't change the file
+            a.fill_(0)
+            self.assertTrue(future.wait())
+            self.assertTrue(future.done())
+            self.assertEqual(torch.load(f.name), expected, 0)
+
     def test_half_tensor(self):
         x = torch.randn(5, 5).float()
         y = torch.randn(5, 5).float()
@@ -4388,6 +4415,27 @@ class TestTorch(TestCase):
         z = from_dlpack(to_dlpack(x))
         self.assertEqual(z, x)
 
+    def test_dlpack_storage(self):
+        x = torch.randn(10)
+        storage = x.storage().share_memory_()
+        z = from_dlpack(to_dlpack(storage))
+        self.assertEqual(z, x)
+        z[0] = 5
+        self.assertEqual(x[0], 5)
+
+        # capsules which are never consumed release the storage with them
+        class StorageRef(object):
+            def __init__(self, ptr):
+                self.cdata = ptr
+
+        y = torch.randn(10)
+        ref = y.storage()._weak_ref(StorageRef)
+        capsule = to_dlpack(y)
+        del y
+        self.assertIsNotNone(ref.cdata)
+        del capsule
+        self.assertIsNone(ref.cdata)
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_from_numpy(self):
         dtypes = [
@@ -4396,11 +4444,29 @@ class TestTorch(TestCase):
             np.int64,
             np.int32,
             np.int16,
+            np.int8,
             np.uint8
         ]
         for dtype in dtypes:
             array = np.array([1, 2, 3, 4], dtype=dtype)
             self.assertEqual(torch.from_numpy(array), torch.Tensor([1, 2, 3, 4]))
+        array = np.array([1, 2, 3, 4], dtype=np.float16)
+        self.assertEqual(torch.from_numpy(array).float(), torch.Tensor([1, 2, 3, 4]))
+
+        # check negative strides, which can't be shared
+        x = np.linspace(1, 25, 25)
+        x.shape = (5, 5)
+        self.assertRaises(RuntimeError, lambda: torch.from_numpy(x[:, ::-1]))
+        expected = torch.arange(1, 26).view(5, 5).index_select(1, torch.arange(4, -1, -1).long())
+        self.assertEqual(torch.from_numpy(x[:, ::-1].copy()), expected)
+
+        # check buffer protocol
+        x = bytearray(b'\x01\x02\x03')
+        y = torch.from_numpy(x)
+        self.assertEqual(y, torch.ByteTensor([1, 2, 3]))
+        y[0] = 4
+        self.assertEqual(x[0], 4)
+        self.assertRaises(RuntimeError, lambda: torch.from_numpy(b'\x01\x02'))
 
         # check storage offset
         x = np.linspace(1, 125, 125)
@@ -4637,6 +4703,60 @@ class TestTorch(TestCase):
         y = x[2:]
         self.assertEqual(int(y), 3)
 
+    def test_noncontig_elementwise(self):
+        for shape in [(7, 5, 3), (64, 33, 2, 9), (1, 300, 1, 20)]:
+            a = torch.randn(*shape).transpose(0, -1)
+            b = torch.randn(*reversed(shape))
+            ac = a.contiguous()
+            self.assertEqual(a + 2, ac + 2)
+            self.assertEqual(a * b, ac * b)
+            self.assertEqual(b / a, b / ac)
+            self.assertEqual(torch.add(a, 3, b), torch.add(ac, 3, b))
+            self.assertEqual(a.sin(), ac.sin())
+            r = torch.zeros(*shape).transpose(0, -1)
+            r.copy_(b)
+            self.assertEqual(r, b)
+
+    def test_thread_budget(self):
+        import threading
+        old_budget = torch.get_thread_budget()
+        try:
+            for budget in [1, 2]:
+                torch.set_thread_budget(budget)
+                self.assertEqual(torch.get_thread_budget(), min(budget, old_budget))
+                # the budget caps the OpenMP team of the calling thread, so
+                # raw omp pragmas can't use more threads either
+                self.assertLessEqual(torch.get_num_threads(), budget)
+                x = torch.randn(200, 300)
+                expected = x.t().contiguous() + 1
+                self.assertEqual(x.t() + 1, expected)
+                self.assertEqual(x.clone(), x)
+
+            # budgets are per thread
+            other_budget = []
+            thread = threading.Thread(target=lambda: other_budget.append(torch.get_thread_budget()))
+            thread.start()
+            thread.join()
+            self.assertEqual(other_budget, [old_budget])
+            self.assertEqual(torch.get_thread_budget(), min(2, old_budget))
+        finally:
+            torch.set_thread_budget(0)
+        self.assertEqual(torch.get_thread_budget(), old_budget)
+        self.assertEqual(torch.get_num_threads(), old_budget)
+        self.assertRaises(RuntimeError, lambda: torch.set_thread_budget(-1))
+
+    def test_type_conversion_copy(self):
+        # odd sizes exercise the scalar tails of the vectorized kernels
+        for n in [1, 7, 33, 20001]:
+            x = torch.randn(n, 3).mul_(100)
+            for src in [x, x.t()]:
+                self.assertEqual(src.double().float(), src, 0)
+                self.assertEqual(src.half().float(), src, 1e-1)
+                self.assertEqual(src.half().double().float(), src, 1e-1)
+                self.assertEqual(src.abs().byte().float(), src.abs().byte().long().float(), 0)
+                self.assertEqual(src.long().int().float(), src.long().float(), 0)
+                self.assertEqual(src.int().float(), src.long().float(), 0)
+
 # Functions to test negative dimension wrapping
 METHOD = 1
 INPLACE_METHOD = 2
@@ -15,7 +15,7 @@ from .version import __version__
 __all__ = [
     'typename', 'is_tensor', 'is_storage', 'set_default_tensor_type',
     'set_rng_state', 'get_rng_state', 'manual_seed', 'initial_seed',
-    'save', 'load', 'set_printoptions', 'chunk', 'split', 'stack', 'matmul',
+    'save', 'save_async', 'load', 'set_printoptions', 'chunk', 'split', 'stack', 'matmul',
     'DoubleStorage', 'FloatStorage', 'LongStorage', 'IntStorage',
     'ShortStorage', 'CharStorage', 'ByteStorage',
     'DoubleTensor', 'FloatTensor', 'LongTensor', 'IntTensor',
@@ -112,7 +112,7 @@ def set_default_tensor_type(t):
 
 
 from .random import set_rng_state, get_rng_state, manual_seed, initial_seed
-from .serialization import save, load
+from .serialization import save, save_async, load
 from ._tensor_str import set_printoptions
 
 ################################################################################
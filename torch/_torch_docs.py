@@ -1440,6 +1440,11 @@ The returned tensor and `ndarray` share the same memory. Modifications to the
 tensor will be reflected in the `ndarray` and vice versa. The returned tensor
 is not resizable.
 
+Other objects supporting the buffer protocol (e.g. `bytearray`, `memoryview`
+or `mmap.mmap`) are shared in the same way. Arrays with negative strides,
+such as `a[::-1]`, can't be represented by a tensor, so they are rejected
+rather than copied; call `a.copy()` first to get a tensor from them.
+
 Example::
 
     >>> a = numpy.array([1, 2, 3])
@@ -1679,6 +1684,15 @@ get_num_threads() -> int
 Gets the number of OpenMP threads used for parallelizing CPU operations
 """)
 
+add_docstr(torch._C.get_thread_budget,
+           """
+get_thread_budget() -> int
+
+Gets the number of threads CPU operations started from the current thread
+may use. This is the budget set with :func:`set_thread_budget`, or the number
+of OpenMP threads if no budget was set.
+""")
+
 add_docstr(torch._C.gt,
            """
 gt(input, other, out=None) -> Tensor
@@ -3862,6 +3876,35 @@ set_num_threads(int)
 Sets the number of OpenMP threads used for parallelizing CPU operations
 """)
 
+add_docstr(torch._C.set_thread_affinity,
+           """
+set_thread_affinity(cores)
+
+Pins the current thread and the worker threads it uses for CPU operations to
+the given cores, worker `i` being pinned to ``cores[i % len(cores)]``.
+If no thread budget is set, the budget becomes ``len(cores)``.
+An empty sequence removes the pinning. Only supported on Linux.
+
+Args:
+    cores (sequence of int): the core ids to pin to
+
+Example::
+
+    >>> # run two replicas on one host, each on its own half of the cores
+    >>> torch.set_thread_affinity(range(0, 8))   # in replica 0
+    >>> torch.set_thread_affinity(range(8, 16))  # in replica 1
+""")
+
+add_docstr(torch._C.set_thread_budget,
+           """
+set_thread_budget(int)
+
+Caps the number of threads CPU operations started from the current thread
+may use. Unlike :func:`set_num_threads`, the budget only applies to the
+calling thread, so each thread serving a model replica can get its own
+share of the cores. A budget of 0 removes the cap.
+""")
+
 add_docstr(torch._C.sigmoid,
            """
 sigmoid(input, out=None) -> Tensor
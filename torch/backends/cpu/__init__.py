@@ -0,0 +1,41 @@
+import os
+import torch
+from contextlib import contextmanager
+
+# When set, the first call of a CPU 2d convolution with a new configuration
+# (shape, stride, padding, dilation, groups and thread count) times each
+# backend available for it (THNN's unfold + GEMM, Winograd and direct
+# algorithms, NNPACK, MKL-DNN) and every later call uses the fastest one.
+benchmark = False
+
+
+def set_benchmark_cache(path):
+    r"""Sets the file that keeps the algorithms picked by :attr:`benchmark`
+    across runs. Entries already in the file are loaded, and new ones are
+    appended as they are found. An empty path stops saving them.
+
+    The cache file can also be given with the ``TORCH_CPU_CONV_BENCHMARK_CACHE``
+    environment variable.
+    """
+    torch._C._set_cpu_conv_benchmark_cache(path)
+
+
+def set_flags(_benchmark):
+    global benchmark
+    orig_flags = benchmark
+    benchmark = _benchmark
+    return orig_flags
+
+
+@contextmanager
+def flags(benchmark=False):
+    orig_flags = set_flags(benchmark)
+    try:
+        yield
+    finally:
+        # recover the previous value
+        set_flags(orig_flags)
+
+
+if os.environ.get('TORCH_CPU_CONV_BENCHMARK_CACHE'):
+    set_benchmark_cache(os.environ['TORCH_CPU_CONV_BENCHMARK_CACHE'])
@@ -12,6 +12,7 @@
 
 #include "torch/csrc/DynamicTypes.h"
 #include "torch/csrc/autograd/generated/python_nn_functions.h"
+#include "torch/csrc/autograd/functions/convolution.h"
 #include "torch/csrc/utils/python_strings.h"
 #include "torch/csrc/jit/python_tracer.h"
 #include "torch/csrc/jit/init.h"
@@ -145,6 +146,51 @@ static PyObject * THPModule_setNumThreads(PyObject *module, PyObject *arg)
   Py_RETURN_NONE;
 }
 
+static PyObject * THPModule_getThreadBudget(PyObject *module)
+{
+  return PyLong_FromLong(THGetThreadBudget());
+}
+
+static PyObject * THPModule_setThreadBudget(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "set_thread_budget expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  THSetThreadBudget((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_setCpuConvBenchmarkCache(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(arg), "_set_cpu_conv_benchmark_cache "
+          "expects a string, but got %s", THPUtils_typename(arg));
+  torch::autograd::set_cpu_conv_benchmark_cache(THPUtils_unpackString(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_setThreadAffinity(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PySequence_Check(arg), "set_thread_affinity expects a sequence "
+          "of ints, but got %s", THPUtils_typename(arg));
+  THPObjectPtr seq(PySequence_Fast(arg, "set_thread_affinity expects a sequence of ints"));
+  if (!seq) return NULL;
+  Py_ssize_t ncores = PySequence_Fast_GET_SIZE(seq.get());
+  std::vector<int> cores(ncores);
+  for (Py_ssize_t i = 0; i < ncores; i++) {
+    PyObject *core = PySequence_Fast_GET_ITEM(seq.get(), i);
+    THPUtils_assert(THPUtils_checkLong(core), "set_thread_affinity expects a "
+            "sequence of ints, but got %s at position %d", THPUtils_typename(core), (int)i);
+    cores[i] = (int)THPUtils_unpackLong(core);
+  }
+  THSetThreadAffinity(cores.data(), (int)ncores);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 bool THPModule_isTensor(PyObject *obj)
 {
   int result = PySet_Contains(tensor_classes, (PyObject*)Py_TYPE(obj));
@@ -165,25 +211,41 @@ PyObject * THPModule_fromNumpy(PyObject *_unused, PyObject *array)
   THPUtils_setError("torch was compiled without numpy support");
   return NULL;
 #else
+  // Other objects exposing their memory through the buffer protocol are
+  // wrapped in an array sharing it
+  THPObjectPtr buffer_array;
+  if (!PyArray_Check(array) && PyObject_CheckBuffer(array)) {
+    buffer_array = PyArray_FromAny(array, nullptr, 0, 0, 0, nullptr);
+    if (!buffer_array) return NULL;
+    THPUtils_assert(PyArray_ISWRITEABLE((PyArrayObject*)buffer_array.get()),
+        "from_numpy can't share the memory of a read-only %s",
+        THPUtils_typename(array));
+    array = buffer_array.get();
+  }
   THPUtils_assert(PyArray_Check(array), "from_numpy expects an np.ndarray "
-      "but got %s", THPUtils_typename(array));
+      "or an object supporting the buffer protocol but got %s",
+      THPUtils_typename(array));
   int type = PyArray_TYPE((PyArrayObject*)array);
   if (type == NPY_DOUBLE) {
     return PyObject_CallFunctionObjArgs(THPDoubleTensorClass, array, NULL);
   } else if (type == NPY_FLOAT) {
     return PyObject_CallFunctionObjArgs(THPFloatTensorClass, array, NULL);
+  } else if (type == NPY_HALF) {
+    return PyObject_CallFunctionObjArgs(THPHalfTensorClass, array, NULL);
   } else if (type == NPY_INT64) {
     return PyObject_CallFunctionObjArgs(THPLongTensorClass, array, NULL);
   } else if (type == NPY_INT32) {
     return PyObject_CallFunctionObjArgs(THPIntTensorClass, array, NULL);
   } else if (type == NPY_INT16) {
     return PyObject_CallFunctionObjArgs(THPShortTensorClass, array, NULL);
+  } else if (type == NPY_INT8) {
+    return PyObject_CallFunctionObjArgs(THPCharTensorClass, array, NULL);
   } else if (type == NPY_UINT8) {
     return PyObject_CallFunctionObjArgs(THPByteTensorClass, array, NULL);
   }
   THPUtils_setError("can't convert a given np.ndarray to a tensor - it has an "
-      "invalid type. The only supported types are: double, float, int64, "
-      "int32, and uint8.");
+      "invalid type. The only supported types are: double, float, float16, "
+      "int64, int32, int16, int8, and uint8.");
   return NULL;
 #endif
 }
@@ -428,6 +490,34 @@ static PyObject * THPModule_cat(PyObject *_unused, PyObject *args, PyObject *kwa
   return THPUtils_dispatchStateless(tensor, "cat", args, kwargs);
 }
 
+// The fused optimizer steps take lists of tensors, and dispatch on the type
+// of the first parameter
+static PyObject * dispatchStatelessOptimStep(PyObject *args, const char *name) {
+  PyObject *tensor = THPDefaultTensorClass;
+  THPObjectPtr item;
+  if (PyTuple_GET_SIZE(args) > 0 && PySequence_Check(PyTuple_GET_ITEM(args, 0))) {
+    item = PySequence_GetItem(PyTuple_GET_ITEM(args, 0), 0);
+    if (item && THPModule_isTensor(item.get())) {
+      tensor = item.get();
+    }
+    PyErr_Clear();
+  }
+  return THPUtils_dispatchStateless(tensor, name, args, NULL);
+}
+
+#define IMPLEMENT_STATELESS_OPTIM_STEP(name)                                   \
+static PyObject * TH_CONCAT_2(THPModule_, name)(PyObject *_unused, PyObject *args) \
+{                                                                              \
+  return dispatchStatelessOptimStep(args, #name);                              \
+}
+
+IMPLEMENT_STATELESS_OPTIM_STEP(_adam_step)
+IMPLEMENT_STATELESS_OPTIM_STEP(_adagrad_step)
+IMPLEMENT_STATELESS_OPTIM_STEP(_sgd_step)
+IMPLEMENT_STATELESS_OPTIM_STEP(_rmsprop_step)
+
+#undef IMPLEMENT_STATELESS_OPTIM_STEP
+
 PyObject *THPModule_safeCall(PyObject *_unused, PyObject *args, PyObject *kwargs)
 {
   PyObject *result = NULL;
@@ -547,16 +637,27 @@ PyObject *THPModule_hasDistributed(PyObject *_unused)
 #endif
 }
 
+// Releases the tensor of a capsule which was never passed to from_dlpack.
+// Consumed capsules are renamed and their tensor belongs to the consumer.
+static void THPModule_freeDLPackCapsule(PyObject *capsule)
+{
+  if (!PyCapsule_IsValid(capsule, "dltensor"))
+    return;
+  DLManagedTensor * dlMTensor = (DLManagedTensor *)PyCapsule_GetPointer(capsule, "dltensor");
+  dlMTensor->destructor(dlMTensor);
+}
+
 PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *data)
 {
   THPUtils_assert(THPModule_isTensor(data), "data must be a Tensor");
   auto atTensor = torch::createTensor(data);
   DLManagedTensor* dlMTensor = at::toDLPack(atTensor);
-  return PyCapsule_New(dlMTensor, "dltensor", NULL);
+  return PyCapsule_New(dlMTensor, "dltensor", THPModule_freeDLPackCapsule);
 }
 
 PyObject *THPModule_fromDLPack(PyObject *_unused, PyObject *data)
 {
+  HANDLE_TH_ERRORS
   DLManagedTensor * dlMTensor = (DLManagedTensor *)PyCapsule_GetPointer(data, "dltensor");
   THPUtils_assert(dlMTensor, "from_dlpack received an invalid capsule. "
     "Note that DLTensor capsules can be consumed only once, "
@@ -564,10 +665,12 @@ PyObject *THPModule_fromDLPack(PyObject *_unused, PyObject *data)
   // atensor steals the ownership of the underlying storage. It also passes a
   // destructor function that will be called when the underlying storage goes
   // out of scope. When the destructor is called, the dlMTensor is destructed too.
+  // If fromDLPack throws (e.g. on negative strides), the capsule still owns it.
   at::Tensor atensor = at::fromDLPack(dlMTensor);
   // Make sure this capsule will never be used again.
   PyCapsule_SetName(data, "used_dltensor");
   return torch::createPyObject(atensor);
+  END_HANDLE_TH_ERRORS
 }
 
 #ifdef WITH_CUDA
@@ -593,6 +696,10 @@ static PyMethodDef TorchMethods[] = {
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, NULL},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  NULL},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       NULL},
+  {"get_thread_budget", (PyCFunction)THPModule_getThreadBudget, METH_NOARGS,  NULL},
+  {"set_thread_budget", (PyCFunction)THPModule_setThreadBudget, METH_O,       NULL},
+  {"set_thread_affinity", (PyCFunction)THPModule_setThreadAffinity, METH_O,   NULL},
+  {"_set_cpu_conv_benchmark_cache", (PyCFunction)THPModule_setCpuConvBenchmarkCache, METH_O, NULL},
   {"from_numpy",      (PyCFunction)THPModule_fromNumpy,         METH_O,       NULL},
   {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_O,       NULL},
   {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_O,       NULL},
@@ -701,6 +808,10 @@ static PyMethodDef TorchMethods[] = {
   {"arange",          (PyCFunction)THPModule_arange,            METH_VARARGS | METH_KEYWORDS, NULL},
   {"gather",          (PyCFunction)THPModule_gather,            METH_VARARGS | METH_KEYWORDS, NULL},
   {"cat",             (PyCFunction)THPModule_cat,               METH_VARARGS | METH_KEYWORDS, NULL},
+  {"_adam_step",      (PyCFunction)THPModule__adam_step,        METH_VARARGS, NULL},
+  {"_adagrad_step",   (PyCFunction)THPModule__adagrad_step,     METH_VARARGS, NULL},
+  {"_sgd_step",       (PyCFunction)THPModule__sgd_step,         METH_VARARGS, NULL},
+  {"_rmsprop_step",   (PyCFunction)THPModule__rmsprop_step,     METH_VARARGS, NULL},
   {"masked_select",   (PyCFunction)THPModule_masked_select,     METH_VARARGS | METH_KEYWORDS, NULL},
   {"gesv",            (PyCFunction)THPModule_gesv,              METH_VARARGS | METH_KEYWORDS, NULL},
   {"gels",            (PyCFunction)THPModule_gels,              METH_VARARGS | METH_KEYWORDS, NULL},
@@ -9,6 +9,7 @@
 #include "torch/csrc/utils/auto_gpu.h"
 
 #include <ATen/ATen.h>
+#include <THNN/THNN.h>
 
 #ifdef WITH_CUDNN
 #include "torch/csrc/cudnn/Conv.h"
@@ -121,6 +122,9 @@ auto ConvParams::use_cudnn(const at::Tensor& input) const -> bool {
 
 auto ConvParams::use_mkldnn(const at::Tensor& input) const -> bool {
 #ifdef WITH_MKLDNN
+  if (cpu_algorithm != CpuConvAlgorithm::Default && cpu_algorithm != CpuConvAlgorithm::MKLDNN) {
+    return false;
+  }
   if (input.type().ID() != at::TypeID::CPUFloat) {
     // mkldnn only supports CPU Float tensor
     return false;
@@ -140,12 +144,16 @@ auto ConvParams::use_mkldnn(const at::Tensor& input) const -> bool {
 
 auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
 #ifdef WITH_NNPACK
+  if (cpu_algorithm != CpuConvAlgorithm::Default && cpu_algorithm != CpuConvAlgorithm::NNPACK) {
+    return false;
+  }
   return input.type().ID() == at::TypeID::CPUFloat && // only on CPU Float Tensors
          !is_strided() && // doesn't support strides
          !is_dilated() && // or dilation
          !transposed &&   // or transposed tensors
          input.ndimension() == 4 && // must be in NCHW format
-         input.size(0) >= 16; // ensure large enough batch size to ensure perf, tuneable
+         // ensure large enough batch size to ensure perf, unless the benchmark picked it
+         (cpu_algorithm == CpuConvAlgorithm::NNPACK || input.size(0) >= 16);
 #endif
   return false;
 }
@@ -306,6 +314,13 @@ auto ConvForward::apply(const variable_list& inputs) -> variable_list {
     weight = view4d(weight);
   }
 
+  if (cpu_benchmark && cpu_algorithm == CpuConvAlgorithm::Default &&
+      !input.type().isCuda() && input.ndimension() == 4 &&
+      !transposed && !is_dilated()) {
+    // the choice is copied into ConvBackward along with the other params
+    cpu_algorithm = find_cpu_conv_algorithm(*this, input, weight, bias);
+  }
+
   auto output = input.type().tensor();
   tensor_list columns(groups);
   tensor_list ones(groups);
@@ -798,6 +813,29 @@ auto ConvBackwardBackward::releaseVariables() -> void {
 
 // Forward and backward functions for Tensor
 
+// Forces the THNN algorithm picked by the CPU benchmark for the duration of
+// a forward call
+struct THNNConvAlgorithmGuard {
+  explicit THNNConvAlgorithmGuard(CpuConvAlgorithm algorithm)
+    : previous(THNN_SpatialConvolution_getAlgorithm()) {
+    switch (algorithm) {
+      case CpuConvAlgorithm::THNNMM:
+        THNN_SpatialConvolution_setAlgorithm(THNN_CONV_ALGO_MM); break;
+      case CpuConvAlgorithm::THNNWinograd:
+        THNN_SpatialConvolution_setAlgorithm(THNN_CONV_ALGO_WINOGRAD); break;
+      case CpuConvAlgorithm::THNNDirect:
+        THNN_SpatialConvolution_setAlgorithm(THNN_CONV_ALGO_DIRECT); break;
+      default:
+        break;
+    }
+  }
+  ~THNNConvAlgorithmGuard() {
+    THNN_SpatialConvolution_setAlgorithm(previous);
+  }
+
+  THNNConvAlgorithm previous;
+};
+
 static at::Tensor compute_output(
     at::Tensor& input, at::Tensor& weight, at::Tensor& bias,
     at::Tensor& columns, at::Tensor& ones,
@@ -846,6 +884,7 @@ static at::Tensor compute_output(
         } else {
           /* CPU implementation has specialized MM kernels
              for non-dilated case here */
+          THNNConvAlgorithmGuard algorithm_guard(params.cpu_algorithm);
           return at::conv2d_forward(
               input, weight, kernel_size, bias,
               stride, padding,
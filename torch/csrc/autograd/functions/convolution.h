@@ -27,6 +27,17 @@ struct Context {};
 
 namespace torch { namespace autograd {
 
+// CPU backends of a non-transposed, non-dilated 2d convolution, as picked
+// by the CPU benchmark (Default leaves the choice to the usual heuristics)
+enum class CpuConvAlgorithm {
+  Default,
+  THNNMM,
+  THNNWinograd,
+  THNNDirect,
+  NNPACK,
+  MKLDNN
+};
+
 struct ConvParams {
   std::vector<int> stride;
   std::vector<int> padding;
@@ -37,6 +48,8 @@ struct ConvParams {
   bool benchmark;
   bool deterministic;
   bool cudnn_enabled;
+  bool cpu_benchmark;
+  CpuConvAlgorithm cpu_algorithm = CpuConvAlgorithm::Default;
 
   bool is_strided() const;
   bool is_dilated() const;
@@ -61,6 +74,15 @@ struct ConvForward : public ForwardFunction<>, public ConvParams, public HasSymb
   std::vector<int64_t> output_size(at::Tensor& input, at::Tensor& weight) const;
 };
 
+// Times every CPU backend able to run the convolution on these 4d tensors
+// the first time their shape is seen, and returns the fastest one. Results
+// are cached per shape and thread count, and kept in the file given to
+// set_cpu_conv_benchmark_cache so later runs can skip the search.
+CpuConvAlgorithm find_cpu_conv_algorithm(
+    const ConvParams& params, const at::Tensor& input,
+    const at::Tensor& weight, const at::Tensor& bias);
+void set_cpu_conv_benchmark_cache(const std::string& path);
+
 struct ConvBackward : public Function, public ConvParams {
   ConvBackward(
       FunctionFlags flags,
@@ -0,0 +1,185 @@
+#include "convolution.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include <TH/TH.h>
+
+// Autotuning of CPU convolutions, the CPU counterpart of cudnn's benchmark
+// mode: the first time a (shape, stride, padding, dilation, groups, threads)
+// configuration shows up, each CPU backend able to run it is timed on the
+// actual tensors and the fastest one is used for every later call.
+
+namespace torch { namespace autograd {
+
+namespace {
+
+struct CpuAlgorithmName {
+  CpuConvAlgorithm algorithm;
+  const char* name;
+};
+
+const CpuAlgorithmName algorithm_names[] = {
+  { CpuConvAlgorithm::THNNMM, "thnn_mm" },
+  { CpuConvAlgorithm::THNNWinograd, "thnn_winograd" },
+  { CpuConvAlgorithm::THNNDirect, "thnn_direct" },
+  { CpuConvAlgorithm::NNPACK, "nnpack" },
+  { CpuConvAlgorithm::MKLDNN, "mkldnn" },
+};
+
+const char* algorithm_name(CpuConvAlgorithm algorithm) {
+  for (auto& entry : algorithm_names) {
+    if (entry.algorithm == algorithm) return entry.name;
+  }
+  return "default";
+}
+
+bool parse_algorithm(const std::string& name, CpuConvAlgorithm* algorithm) {
+  for (auto& entry : algorithm_names) {
+    if (name == entry.name) {
+      *algorithm = entry.algorithm;
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+void write_list(std::ostream& out, char tag, const T& values) {
+  out << tag;
+  for (size_t i = 0; i < values.size(); ++i) {
+    out << (i ? "," : "") << values[i];
+  }
+  out << ' ';
+}
+
+// Keys are plain text so that the cache file stays readable and can be
+// edited or pruned by hand
+std::string make_key(const ConvParams& params, const at::Tensor& input, const at::Tensor& weight) {
+  std::ostringstream key;
+  key << input.type().toString() << ' ';
+  write_list(key, 'i', input.sizes());
+  write_list(key, 'w', weight.sizes());
+  write_list(key, 's', params.stride);
+  write_list(key, 'p', params.padding);
+  write_list(key, 'd', params.dilation);
+  key << 'g' << params.groups << " t" << THGetThreadBudget();
+  return key.str();
+}
+
+struct CpuBenchmarkCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, CpuConvAlgorithm> map;
+  std::string path;
+
+  bool find(const std::string& key, CpuConvAlgorithm* algorithm) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = map.find(key);
+    if (it == map.end()) {
+      return false;
+    }
+    *algorithm = it->second;
+    return true;
+  }
+
+  void insert(const std::string& key, CpuConvAlgorithm algorithm) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!map.emplace(key, algorithm).second || path.empty()) {
+      return;
+    }
+    std::ofstream file(path, std::ios::app);
+    file << key << '\t' << algorithm_name(algorithm) << '\n';
+  }
+
+  void load(const std::string& new_path) {
+    std::lock_guard<std::mutex> guard(mutex);
+    path = new_path;
+    if (path.empty()) {
+      return;
+    }
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+      auto tab = line.rfind('\t');
+      CpuConvAlgorithm algorithm;
+      // skip lines that are malformed or name a backend this build lacks
+      if (tab == std::string::npos || !parse_algorithm(line.substr(tab + 1), &algorithm)) {
+        continue;
+      }
+      map[line.substr(0, tab)] = algorithm;
+    }
+  }
+};
+
+CpuBenchmarkCache cpu_benchmark_cache;
+
+// Number of timed runs per candidate, after one warmup run. The best time
+// is kept, as it is the least disturbed by other work on the machine.
+const int benchmark_runs = 3;
+
+double time_forward(const ConvParams& params, const variable_list& inputs) {
+  ConvForward forward(params);
+  forward.apply(inputs);
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < benchmark_runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    forward.apply(inputs);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+} // anonymous namespace
+
+CpuConvAlgorithm find_cpu_conv_algorithm(
+    const ConvParams& params, const at::Tensor& input,
+    const at::Tensor& weight, const at::Tensor& bias) {
+  auto key = make_key(params, input, weight);
+  CpuConvAlgorithm algorithm;
+  if (cpu_benchmark_cache.find(key, &algorithm)) {
+    return algorithm;
+  }
+
+  // Timing runs go through the regular forward with a fixed algorithm,
+  // on inputs that don't require grad so no graph is recorded
+  variable_list inputs = {
+    make_variable(input, false),
+    make_variable(weight, false),
+    bias.defined() ? make_variable(bias, false) : Variable()
+  };
+  ConvParams candidate = params;
+  candidate.cpu_benchmark = false;
+
+  bool winograd_ok = weight.size(2) == 3 && weight.size(3) == 3 && !params.is_strided();
+  double best = std::numeric_limits<double>::max();
+  algorithm = CpuConvAlgorithm::THNNMM;
+  for (auto& entry : algorithm_names) {
+    candidate.cpu_algorithm = entry.algorithm;
+    if ((entry.algorithm == CpuConvAlgorithm::THNNWinograd && !winograd_ok) ||
+        (entry.algorithm == CpuConvAlgorithm::NNPACK && !candidate.use_nnpack(input)) ||
+        (entry.algorithm == CpuConvAlgorithm::MKLDNN && !candidate.use_mkldnn(input))) {
+      continue;
+    }
+    double elapsed = time_forward(candidate, inputs);
+    if (elapsed < best) {
+      best = elapsed;
+      algorithm = entry.algorithm;
+    }
+  }
+
+  cpu_benchmark_cache.insert(key, algorithm);
+  return algorithm;
+}
+
+void set_cpu_conv_benchmark_cache(const std::string& path) {
+  cpu_benchmark_cache.load(path);
+}
+
+}} // namespace torch::autograd
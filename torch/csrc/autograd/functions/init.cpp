@@ -35,7 +35,7 @@ struct ConvCtor {
   ConvForward* operator()(PyObject* args) {
     ConvParams params;
 
-    TupleParser parser(args, 9);
+    TupleParser parser(args, 10);
     parser.parse(params.stride, "stride");
     parser.parse(params.padding, "padding");
     parser.parse(params.dilation, "dilation");
@@ -45,6 +45,7 @@ struct ConvCtor {
     parser.parse(params.benchmark, "benchmark");
     parser.parse(params.deterministic, "deterministic");
     parser.parse(params.cudnn_enabled, "cudnn_enabled");
+    parser.parse(params.cpu_benchmark, "cpu_benchmark");
 
     return new ConvForward(std::move(params));
   }
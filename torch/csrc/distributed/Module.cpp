@@ -240,6 +240,20 @@ static THDGroup _getGroup(PyObject *obj)
   return it->second;
 }
 
+// Collectives take a trailing `async_op` flag. When it is set they return a
+// request instead of waiting for the collective to complete.
+static bool _isAsync(PyObject *args, Py_ssize_t index)
+{
+  return PyTuple_GET_ITEM(args, index) == Py_True;
+}
+
+static PyObject* _wrapRequest(THDRequest *req)
+{
+  if (!req)
+    Py_RETURN_NONE;
+  return THPWrapper_New(req, (void(*)(void*))THDRequest_free);
+}
+
 PyObject* THDPModule_isend(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
@@ -341,17 +355,94 @@ PyObject* THDPModule_recv(PyObject *_unused, PyObject *args)
 PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0))) {
-    THPUtils_invalidArguments(args, NULL, "all_reduce", 1, "(tensor in_out, reduce_op op, group gr)");
+  if (PyTuple_GET_SIZE(args) != 4 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
+    THPUtils_invalidArguments(args, NULL, "all_reduce", 1,
+        "(tensor in_out, reduce_op op, group gr, bool async_op)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   THDReduceOp op = _getReduceOp(PyTuple_GET_ITEM(args, 1));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
+  THDRequest* req = nullptr;
+  {
+    AutoNoGIL guard;
+    if (_isAsync(args, 3)) {
+      req = THDIallReduce(desc, op, group);
+    } else {
+      THDAllReduce(desc, op, group);
+    }
+  }
+  return _wrapRequest(req);
+  END_HANDLE_TH_ERRORS
+}
+
+static THDCompressor* _unpackCompressor(PyObject *obj)
+{
+  return static_cast<THDCompressor*>(THPWrapper_get(obj));
+}
+
+PyObject* THDPModule_newCompressor(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 2 || !THPUtils_checkString(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkDouble(PyTuple_GET_ITEM(args, 1))) {
+    THPUtils_invalidArguments(args, NULL, "newCompressor", 1,
+        "(string method, float ratio)");
+    return NULL;
+  }
+
+  static const std::unordered_map<std::string, THDCompression> name2compression = {
+    {"fp16", THDCompressionFP16},
+    {"bf16", THDCompressionBF16},
+    {"topk", THDCompressionTOPK},
+    {"sign", THDCompressionSIGN},
+  };
+  std::string method = THPUtils_unpackString(PyTuple_GET_ITEM(args, 0));
+  auto it = name2compression.find(method);
+  if (it == name2compression.end()) {
+    throw std::runtime_error("unknown compression method '" + method + "', "
+        "should be one of: fp16, bf16, topk, sign");
+  }
+
+  double ratio = THPUtils_unpackDouble(PyTuple_GET_ITEM(args, 1));
+  THDCompressor* compressor = THDCompressor_new(it->second, ratio);
+  return THPWrapper_New(compressor, (void(*)(void*))THDCompressor_free);
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject* THDPModule_compressorStats(PyObject *_unused, PyObject *_compressor)
+{
+  HANDLE_TH_ERRORS
+  if (!THPWrapper_check(_compressor)) {
+    THPUtils_invalidArguments(_compressor, NULL, "compressorStats", 1, "(compressor c)");
+    return NULL;
+  }
+
+  uint64_t uncompressed_bytes, compressed_bytes;
+  THDCompressor_stats(_unpackCompressor(_compressor), &uncompressed_bytes, &compressed_bytes);
+  return Py_BuildValue("(KK)", (unsigned long long)uncompressed_bytes,
+      (unsigned long long)compressed_bytes);
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject* THDPModule_allReduceCompressed(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 3 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !THPWrapper_check(PyTuple_GET_ITEM(args, 1))) {
+    THPUtils_invalidArguments(args, NULL, "all_reduce_compressed", 1,
+        "(tensor in_out, compressor c, group gr)");
+    return NULL;
+  }
+
+  THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
+  THDCompressor* compressor = _unpackCompressor(PyTuple_GET_ITEM(args, 1));
+  auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   {
     AutoNoGIL guard;
-    THDAllReduce(desc, op, group);
+    THDAllReduceCompressed(desc, compressor, group);
   }
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
@@ -360,10 +451,11 @@ PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
 PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 4 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
-        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 5 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 4))) {
     THPUtils_invalidArguments(args, NULL, "reduce", 1,
-        "(tensor reduced, int dst_rank, reduce_op op, group gr)");
+        "(tensor reduced, int dst_rank, reduce_op op, group gr, bool async_op)");
     return NULL;
   }
 
@@ -371,32 +463,43 @@ PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
   THDReduceOp op = _getReduceOp(PyTuple_GET_ITEM(args, 2));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   int dst_rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  THDRequest* req = nullptr;
   {
     AutoNoGIL guard;
-    THDReduce(desc, op, dst_rank, group);
+    if (_isAsync(args, 4)) {
+      req = THDIreduce(desc, op, dst_rank, group);
+    } else {
+      THDReduce(desc, op, dst_rank, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
   END_HANDLE_TH_ERRORS
 }
 
 PyObject* THDPModule_broadcast(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
-        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     THPUtils_invalidArguments(args, NULL, "broadcast", 1,
-        "(tensor src_dst, int src_rank, group gr)");
+        "(tensor src_dst, int src_rank, group gr, bool async_op)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   int src_rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  THDRequest* req = nullptr;
   {
     AutoNoGIL guard;
-    THDBroadcast(desc, src_rank, group);
+    if (_isAsync(args, 3)) {
+      req = THDIbroadcast(desc, src_rank, group);
+    } else {
+      THDBroadcast(desc, src_rank, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
   END_HANDLE_TH_ERRORS
 }
 
@@ -410,9 +513,11 @@ PyObject* THDPModule_allGather(PyObject *_unused, PyObject *args)
   std::vector<at::Tensor> raw_descriptors;
   THDGroup group;
   at::Tensor desc;
+  THDRequest* req = nullptr;
 
-  if (PyTuple_GET_SIZE(args) != 3 || !PySequence_Check(sequence) ||
-        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !PySequence_Check(sequence) ||
+        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     goto invalid_arguments;
   }
 
@@ -436,13 +541,17 @@ PyObject* THDPModule_allGather(PyObject *_unused, PyObject *args)
   desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 1));
   {
     AutoNoGIL guard;
-    THDAllGather(raw_descriptors.data(), length, desc, group);
+    if (_isAsync(args, 3)) {
+      req = THDIallGather(raw_descriptors.data(), length, desc, group);
+    } else {
+      THDAllGather(raw_descriptors.data(), length, desc, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
 
 invalid_arguments:
   THPUtils_invalidArguments(args, NULL, "allGather", 1,
-      "(list[tensor] output, tensor input, group gr)");
+      "(list[tensor] output, tensor input, group gr, bool async_op)");
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
 }
@@ -450,20 +559,26 @@ invalid_arguments:
 PyObject* THDPModule_gatherSend(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     THPUtils_invalidArguments(args, NULL, "gatherSend", 1,
-        "(tensor input, int dst_rank, group gr)");
+        "(tensor input, int dst_rank, group gr, bool async_op)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   int dst_rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  THDRequest* req = nullptr;
   {
     AutoNoGIL guard;
-    THDGatherSend(desc, dst_rank, group);
+    if (_isAsync(args, 3)) {
+      req = THDIgatherSend(desc, dst_rank, group);
+    } else {
+      THDGatherSend(desc, dst_rank, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
   END_HANDLE_TH_ERRORS
 }
 
@@ -477,9 +592,11 @@ PyObject* THDPModule_gatherRecv(PyObject *_unused, PyObject *args)
   std::vector<at::Tensor> raw_descriptors;
   THDGroup group;
   at::Tensor desc;
+  THDRequest* req = nullptr;
 
-  if (PyTuple_GET_SIZE(args) != 3 || !PySequence_Check(sequence) ||
-        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !PySequence_Check(sequence) ||
+        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     goto invalid_arguments;
   }
 
@@ -503,13 +620,17 @@ PyObject* THDPModule_gatherRecv(PyObject *_unused, PyObject *args)
   group = _getGroup(PyTuple_GET_ITEM(args, 2));
   {
     AutoNoGIL guard;
-    THDGatherRecv(raw_descriptors.data(), length, desc, group);
+    if (_isAsync(args, 3)) {
+      req = THDIgatherRecv(raw_descriptors.data(), length, desc, group);
+    } else {
+      THDGatherRecv(raw_descriptors.data(), length, desc, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
 
 invalid_arguments:
   THPUtils_invalidArguments(args, NULL, "gatherRecv", 1,
-      "(list[tensor] output, tensor input, group gr)");
+      "(list[tensor] output, tensor input, group gr, bool async_op)");
   return NULL;
   END_HANDLE_TH_ERRORS
 }
@@ -524,9 +645,11 @@ PyObject* THDPModule_scatterSend(PyObject *_unused, PyObject *args)
   std::vector<at::Tensor> raw_descriptors;
   THDGroup group;
   at::Tensor desc;
+  THDRequest* req = nullptr;
 
-  if (PyTuple_GET_SIZE(args) != 3 || !PySequence_Check(sequence) ||
-        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !PySequence_Check(sequence) ||
+        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     goto invalid_arguments;
   }
 
@@ -550,13 +673,17 @@ PyObject* THDPModule_scatterSend(PyObject *_unused, PyObject *args)
   group = _getGroup(PyTuple_GET_ITEM(args, 2));
   {
     AutoNoGIL guard;
-    THDScatterSend(raw_descriptors.data(), length, desc, group);
+    if (_isAsync(args, 3)) {
+      req = THDIscatterSend(raw_descriptors.data(), length, desc, group);
+    } else {
+      THDScatterSend(raw_descriptors.data(), length, desc, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
 
 invalid_arguments:
   THPUtils_invalidArguments(args, NULL, "scatterSend", 1,
-      "(list[tensor] input, tensor output, group gr)");
+      "(list[tensor] input, tensor output, group gr, bool async_op)");
   return NULL;
   END_HANDLE_TH_ERRORS
 }
@@ -564,32 +691,102 @@ invalid_arguments:
 PyObject* THDPModule_scatterRecv(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
-        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
+  if (PyTuple_GET_SIZE(args) != 4 || !THPModule_isTensor(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 3))) {
     THPUtils_invalidArguments(args, NULL, "scatterRecv", 1,
-        "(tensor output, int src_rank, group gr)");
+        "(tensor output, int src_rank, group gr, bool async_op)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   int src_rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  THDRequest* req = nullptr;
   {
     AutoNoGIL guard;
-    THDScatterRecv(desc, src_rank, group);
+    if (_isAsync(args, 3)) {
+      req = THDIscatterRecv(desc, src_rank, group);
+    } else {
+      THDScatterRecv(desc, src_rank, group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject* THDPModule_reduceScatter(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject* sequence = PyTuple_GET_ITEM(args, 0);
+  Py_ssize_t tmp_length;
+  std::size_t length;
+  std::vector<at::Tensor> descriptors;
+  THDGroup group;
+  THDReduceOp op;
+  at::Tensor desc;
+  THDRequest* req = nullptr;
+
+  if (PyTuple_GET_SIZE(args) != 5 || !PySequence_Check(sequence) ||
+        !THPModule_isTensor(PyTuple_GET_ITEM(args, 1)) ||
+        !PyBool_Check(PyTuple_GET_ITEM(args, 4))) {
+    goto invalid_arguments;
+  }
+
+  tmp_length = PySequence_Length(sequence);
+  THPUtils_assert(tmp_length >= 0, "couldn't obtain the length of %s",
+      THPUtils_typename(sequence));
+
+  length = static_cast<std::size_t>(tmp_length);
+  descriptors.reserve(length);
+  for (std::size_t i = 0; i < length; ++i) {
+    if (!THPModule_isTensor(PySequence_ITEM(sequence, i)))
+      goto invalid_arguments;
+
+    descriptors.push_back(
+      THDPModule_makeDescriptor(PySequence_ITEM(sequence, i))
+    );
+  }
+
+  desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 1));
+  op = _getReduceOp(PyTuple_GET_ITEM(args, 2));
+  group = _getGroup(PyTuple_GET_ITEM(args, 3));
+  {
+    AutoNoGIL guard;
+    if (_isAsync(args, 4)) {
+      req = THDIreduceScatter(descriptors.data(), length, desc, op, group);
+    } else {
+      THDReduceScatter(descriptors.data(), length, desc, op, group);
+    }
+  }
+  return _wrapRequest(req);
+
+invalid_arguments:
+  THPUtils_invalidArguments(args, NULL, "reduceScatter", 1,
+      "(list[tensor] input, tensor output, reduce_op op, group gr, bool async_op)");
+  return NULL;
   END_HANDLE_TH_ERRORS
 }
 
-PyObject* THDPModule_barrier(PyObject *_unused, PyObject *_group)
+PyObject* THDPModule_barrier(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 2 || !PyBool_Check(PyTuple_GET_ITEM(args, 1))) {
+    THPUtils_invalidArguments(args, NULL, "barrier", 1, "(group gr, bool async_op)");
+    return NULL;
+  }
+
+  THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 0));
+  THDRequest* req = nullptr;
   {
     AutoNoGIL guard;
-    THDBarrier(_getGroup(_group));
+    if (_isAsync(args, 1)) {
+      req = THDIbarrier(group);
+    } else {
+      THDBarrier(group);
+    }
   }
-  Py_RETURN_NONE;
+  return _wrapRequest(req);
   END_HANDLE_TH_ERRORS
 }
 
@@ -717,6 +914,7 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_recv_any_source", (PyCFunction)THDPModule_recvAnySource, METH_O, NULL},
   {"_dist_recv", (PyCFunction)THDPModule_recv, METH_VARARGS, NULL},
   {"_dist_all_reduce", (PyCFunction)THDPModule_allReduce, METH_VARARGS, NULL},
+  {"_dist_all_reduce_compressed", (PyCFunction)THDPModule_allReduceCompressed, METH_VARARGS, NULL},
   {"_dist_reduce", (PyCFunction)THDPModule_reduce, METH_VARARGS, NULL},
   {"_dist_broadcast", (PyCFunction)THDPModule_broadcast, METH_VARARGS, NULL},
   {"_dist_all_gather", (PyCFunction)THDPModule_allGather, METH_VARARGS, NULL},
@@ -724,8 +922,11 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_gather_recv", (PyCFunction)THDPModule_gatherRecv, METH_VARARGS, NULL},
   {"_dist_scatter_send", (PyCFunction)THDPModule_scatterSend, METH_VARARGS, NULL},
   {"_dist_scatter_recv", (PyCFunction)THDPModule_scatterRecv, METH_VARARGS, NULL},
-  {"_dist_barrier", (PyCFunction)THDPModule_barrier, METH_O, NULL},
+  {"_dist_reduce_scatter", (PyCFunction)THDPModule_reduceScatter, METH_VARARGS, NULL},
+  {"_dist_barrier", (PyCFunction)THDPModule_barrier, METH_VARARGS, NULL},
   {"_dist_new_group", (PyCFunction)THDPModule_newGroup, METH_VARARGS, NULL},
+  {"_dist_new_compressor", (PyCFunction)THDPModule_newCompressor, METH_VARARGS, NULL},
+  {"_dist_compressor_stats", (PyCFunction)THDPModule_compressorStats, METH_O, NULL},
   {"_dist_request_is_completed", (PyCFunction)THDPModule_requestIsCompleted, METH_O, NULL},
   {"_dist_request_wait", (PyCFunction)THDPModule_requestWait, METH_O, NULL},
   {NULL}
@@ -197,6 +197,26 @@ static PyObject * THPStorage_(fromFile)(PyObject *_unused, PyObject *args, PyObj
   END_HANDLE_TH_ERRORS
 }
 
+#if !defined(THC_GENERIC_FILE) && !defined(THD_GENERIC_FILE)
+static PyObject * THPStorage_(newWithMappedFile)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  const char *filename;
+  Py_ssize_t offset;
+  Py_ssize_t size;
+  int readonly = 0;
+  if (!PyArg_ParseTuple(args, "snn|i", &filename, &offset, &size, &readonly)) {
+    return NULL;
+  }
+  THPUtils_assert(size > 0, "_new_with_mapped_file expects a positive size, "
+      "but got %ld", (long)size);
+  int flags = readonly ? TH_ALLOCATOR_MAPPED_READONLY : 0;
+  THStorage *storage = THStorage_(newWithMappingAtOffset)(LIBRARY_STATE filename, offset, size, flags);
+  return (PyObject*)THPStorage_(New)(storage);
+  END_HANDLE_TH_ERRORS
+}
+#endif
+
 #ifndef THD_GENERIC_FILE
 PyObject * THPStorage_(writeFile)(THPStorage *self, PyObject *file)
 {
@@ -204,7 +224,33 @@ PyObject * THPStorage_(writeFile)(THPStorage *self, PyObject *file)
   int fd = PyObject_AsFileDescriptor(file);
   THPUtils_assert(fd != -1, "_write_file couldn't retrieve a file descriptor "
       "from given object");
-  THPStorage_(writeFileRaw)(self->cdata, fd);
+  {
+    AutoNoGIL no_gil;
+    THPStorage_(writeFileRaw)(self->cdata, fd);
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(writeFileAt)(THPStorage *self, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyTuple_GET_SIZE(args) == 2, "_write_file_at expects a file "
+      "and an offset");
+  PyObject *file = PyTuple_GET_ITEM(args, 0);
+  PyObject *offset = PyTuple_GET_ITEM(args, 1);
+  int fd = PyObject_AsFileDescriptor(file);
+  THPUtils_assert(fd != -1, "_write_file_at couldn't retrieve a file descriptor "
+      "from given object");
+  THPUtils_assert(THPUtils_checkLong(offset), "_write_file_at expects an int "
+      "offset, but got %s", THPUtils_typename(offset));
+  int64_t file_offset = THPUtils_unpackLong(offset);
+  THPUtils_assert(file_offset >= 0, "_write_file_at expects a non-negative offset");
+  {
+    // the storage is kept alive by self, so the write doesn't need the GIL
+    AutoNoGIL no_gil;
+    THPStorage_(writeFileRawAt)(self->cdata, fd, file_offset);
+  }
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
 }
@@ -301,11 +347,13 @@ static PyMethodDef THPStorage_(methods)[] = {
   {"data_ptr", (PyCFunction)THPStorage_(dataPtr), METH_NOARGS, NULL},
   {"is_pinned", (PyCFunction)THPStorage_(isPinned), METH_NOARGS, NULL},
   {"_write_file", (PyCFunction)THPStorage_(writeFile), METH_O, NULL},
+  {"_write_file_at", (PyCFunction)THPStorage_(writeFileAt), METH_VARARGS, NULL},
   {"_new_with_file", (PyCFunction)THPStorage_(newWithFile), METH_O | METH_STATIC, NULL},
   {"_set_from_file", (PyCFunction)THPStorage_(setFromFile), METH_VARARGS, NULL},
 #endif // !defined(THD_GENERIC_FILE)
 #if !defined(THC_GENERIC_FILE) && !defined(THD_GENERIC_FILE)
   {"from_buffer", (PyCFunction)THPStorage_(fromBuffer), METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL},
+  {"_new_with_mapped_file", (PyCFunction)THPStorage_(newWithMappedFile), METH_VARARGS | METH_STATIC, NULL},
 #endif
   {"from_file", (PyCFunction)THPStorage_(fromFile), METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL},
 #ifdef THC_GENERIC_FILE
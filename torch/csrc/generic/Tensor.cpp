@@ -23,6 +23,12 @@
 #ifdef TH_REAL_IS_BYTE
 #define NUMPY_TYPE_ENUM NPY_UINT8
 #endif
+#ifdef TH_REAL_IS_CHAR
+#define NUMPY_TYPE_ENUM NPY_INT8
+#endif
+#ifdef TH_REAL_IS_HALF
+#define NUMPY_TYPE_ENUM NPY_HALF
+#endif
 
 #define COPY_FROM_ARRAY_CPU(ELTYPE, ARRAY, STORAGE, SIZE) \
 { \
@@ -33,6 +39,15 @@
   }                                                       \
 }
 
+#define COPY_FROM_ARRAY_CPU_HALF(ELTYPE, ARRAY, STORAGE, SIZE) \
+{ \
+  ELTYPE *arrdata = (ELTYPE*)PyArray_DATA(ARRAY);         \
+  real *data = STORAGE->data;                             \
+  for (size_t i=0; i<SIZE; i++) {                         \
+    data[i] = TH_float2half((float)arrdata[i]);           \
+  }                                                       \
+}
+
 #define COPY_FROM_ARRAY_CUDA(ELTYPE, ARRAY, STORAGE, SIZE) \
 { \
   ELTYPE *arrdata = (ELTYPE*)PyArray_DATA(ARRAY);              \
@@ -69,6 +84,8 @@
 #else
 #define COPY_FROM_ARRAY COPY_FROM_ARRAY_CUDA
 #endif
+#elif defined(TH_REAL_IS_HALF)
+#define COPY_FROM_ARRAY COPY_FROM_ARRAY_CPU_HALF
 #else
 #define COPY_FROM_ARRAY COPY_FROM_ARRAY_CPU
 #endif
@@ -180,13 +197,15 @@ THTensor* THPTensor_(fromNumpy)(PyObject *numpy_array) {
       // we have to cast sizeof to long, because otherwise stride gets
       // promoted to size_t, and is UB for negative values
       strides_data[i] = PyArray_STRIDE(array, i) / elsize;
+      // Tensors can't have negative strides (a negative stride is what asks
+      // TH to compute a contiguous one), and copying views like a[::-1]
+      // would break the guarantee that the memory is shared
       if (strides_data[i] < 0) {
         THPUtils_setError("some of the strides of a given numpy array are "
             "negative. This is currently not supported, but will be added in "
             "future releases.");
         return NULL;
       }
-      // XXX: this won't work for negative strides
       storage_size += strides_data[i] * (sizes_data[i] - 1);
     }
 
@@ -213,6 +232,7 @@ THTensor* THPTensor_(fromNumpy)(PyObject *numpy_array) {
         case NPY_INT32:  COPY_FROM_ARRAY(int32_t, array, storage, storage_size); break;
         case NPY_INT16:  COPY_FROM_ARRAY(int16_t, array, storage, storage_size); break;
         case NPY_UINT8:  COPY_FROM_ARRAY(uint8_t, array, storage, storage_size); break;
+        case NPY_INT8:   COPY_FROM_ARRAY(int8_t,  array, storage, storage_size); break;
       }
       result = THTensor_(newWithStorage)(LIBRARY_STATE storage, 0, sizes, strides);
     }
@@ -1876,5 +1896,6 @@ bool THPTensor_(postInit)(PyObject *module)
 }
 
 #undef NUMPY_TYPE_ENUM
+#undef COPY_FROM_ARRAY
 
 #endif
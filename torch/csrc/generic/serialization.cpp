@@ -27,6 +27,13 @@ THTensor * THPTensor_(newWithMetadataFileRaw)(int fd, THStorage *storage)
 }
 
 void THPStorage_(writeFileRaw)(THStorage *self, int fd)
+{
+  THPStorage_(writeFileRawAt)(self, fd, -1);
+}
+
+// Writes the size and the data of the storage at offset, or at the current
+// file position if offset is negative.
+void THPStorage_(writeFileRawAt)(THStorage *self, int fd, int64_t offset)
 {
   real *data;
   int64_t size = self->size;
@@ -37,25 +44,15 @@ void THPStorage_(writeFileRaw)(THStorage *self, int fd)
   data = (real*)cpu_data.get();
   THCudaCheck(cudaMemcpy(data, self->data, size * sizeof(real), cudaMemcpyDeviceToHost));
 #endif
-  ssize_t result = write(fd, &size, sizeof(int64_t));
-  if (result != sizeof(int64_t))
-    throw std::system_error(result, std::system_category());
+  THP_writeBuffer(fd, &size, sizeof(int64_t), offset);
+  if (offset >= 0)
+    offset += sizeof(int64_t);
   // fast track for bytes and little endian
   if (sizeof(real) == 1 || THP_nativeByteOrder() == THPByteOrder::THP_LITTLE_ENDIAN) {
-    char *bytes = (char *) data;
-    int64_t remaining = sizeof(real) * size;
-    while (remaining > 0) {
-      // we write and read in 1GB blocks to avoid bugs on some OSes
-      ssize_t result = write(fd, bytes, THMin(remaining, 1073741824));
-      if (result < 0)
-        throw std::system_error(result, std::system_category());
-      bytes += result;
-      remaining -= result;
-    }
-    if (remaining != 0)
-      throw std::system_error(result, std::system_category());
+    THP_writeBuffer(fd, data, sizeof(real) * size, offset);
   } else {
-    int64_t buffer_size = std::min(size, (int64_t)5000);
+    // convert in large batches, so that the writes stay big
+    int64_t buffer_size = std::min(size, (int64_t)1 << 20);
     std::unique_ptr<uint8_t[]> le_buffer(new uint8_t[buffer_size * sizeof(real)]);
     for (int64_t i = 0; i < size; i += buffer_size) {
       size_t to_convert = std::min(size - i, buffer_size);
@@ -75,7 +72,9 @@ void THPStorage_(writeFileRaw)(THStorage *self, int fd)
             THPByteOrder::THP_LITTLE_ENDIAN,
             to_convert);
       }
-      SYSCHECK(write(fd, le_buffer.get(), to_convert * sizeof(real)));
+      THP_writeBuffer(fd, le_buffer.get(), to_convert * sizeof(real), offset);
+      if (offset >= 0)
+        offset += to_convert * sizeof(real);
     }
   }
 }
@@ -5,6 +5,7 @@
 void THPTensor_(writeMetadataRaw)(THTensor *self, int fd);
 THTensor * THPTensor_(newWithMetadataFileRaw)(int fd, THStorage *storage);
 void THPStorage_(writeFileRaw)(THStorage *self, int fd);
+void THPStorage_(writeFileRawAt)(THStorage *self, int fd, int64_t offset);
 THStorage * THPStorage_(readFileRaw)(int fd, THStorage *storage);
 
 #endif
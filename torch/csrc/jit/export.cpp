@@ -11,7 +11,10 @@
 #include "torch/csrc/utils/functional.h"
 #include <ATen/ATen.h>
 
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <unistd.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -253,27 +256,99 @@ void validateGraph(const std::shared_ptr<Graph>& graph) {
   }
 }
 
+// Buffers small writes; tensor data is usually passed in large pieces, which
+// are written straight from the memory of the tensor.
+struct FileWriter {
+  static constexpr size_t kBufferSize = 1 << 16;
+
+  FileWriter(int fd) : fd(fd), buffer(kBufferSize), used(0), error(0) {}
+
+  bool write(const pb_byte_t* data, size_t count) {
+    if (used + count > buffer.size()) {
+      if (!flush()) return false;
+      if (count >= buffer.size())
+        return writeAll(data, count);
+    }
+    std::memcpy(buffer.data() + used, data, count);
+    used += count;
+    return true;
+  }
+
+  bool flush() {
+    bool ok = writeAll(buffer.data(), used);
+    used = 0;
+    return ok;
+  }
+
+  bool writeAll(const pb_byte_t* data, size_t count) {
+    while (count > 0) {
+      ssize_t written = ::write(fd, data, count);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        error = errno;
+        return false;
+      }
+      data += written;
+      count -= written;
+    }
+    return true;
+  }
+
+  int fd;
+  std::vector<pb_byte_t> buffer;
+  size_t used;
+  int error;
+};
+
+bool writeToFile(pb_ostream_t* stream, const pb_byte_t* buf, size_t count) {
+  return static_cast<FileWriter*>(stream->state)->write(buf, count);
 }
 
-std::string ExportGraph(const std::shared_ptr<Graph>& graph,
-                        const std::vector<at::Tensor> & initializers) {
+bool writeToString(pb_ostream_t* stream, const pb_byte_t* buf, size_t count) {
+  static_cast<std::string*>(stream->state)->append(reinterpret_cast<const char*>(buf), count);
+  return true;
+}
 
+// Encodes the model in a single pass: sizes of nested messages are computed
+// once (see micropb_encode_submessage), and the data of initializers is
+// passed to the stream without copying it.
+void encodeToStream(pb_ostream_t* stream, const std::shared_ptr<Graph>& graph,
+                    const std::vector<at::Tensor>& initializers) {
   validateGraph(graph);
 
   onnx::ModelProto model_proto;
-  // Set up nanopb callbacks and compute the amount of space needed to store
-  // the resulting protobuf
   encodeModel(&model_proto, graph, initializers);
 
-  size_t out_size;
-  pb_get_encoded_size(&out_size, onnx_ModelProto_fields, &model_proto.proto);
+  if (!pb_encode(stream, onnx_ModelProto_fields, &model_proto.proto)) {
+    throw std::runtime_error(std::string("ONNX export failed: ") + PB_GET_ERROR(stream));
+  }
+}
 
-  // Allocate storage and export the graph
-  std::string out(out_size, '\0');
-  pb_ostream_t ostream = pb_ostream_from_buffer(reinterpret_cast<pb_byte_t *>(&out[0]), out_size);
-  pb_encode(&ostream, onnx_ModelProto_fields, &model_proto.proto);
+}
 
+std::string ExportGraph(const std::shared_ptr<Graph>& graph,
+                        const std::vector<at::Tensor> & initializers) {
+  std::string out;
+  pb_ostream_t ostream = {&writeToString, &out, SIZE_MAX, 0};
+  encodeToStream(&ostream, graph, initializers);
   return out;
 }
 
+void ExportGraph(const std::shared_ptr<Graph>& graph,
+                 const std::vector<at::Tensor> & initializers,
+                 int fd) {
+  FileWriter writer(fd);
+  pb_ostream_t ostream = {&writeToFile, &writer, SIZE_MAX, 0};
+  bool encoded = true;
+  try {
+    encodeToStream(&ostream, graph, initializers);
+  } catch (const std::runtime_error& e) {
+    if (!writer.error) throw;
+    encoded = false;
+  }
+  if (!encoded || !writer.flush()) {
+    throw std::runtime_error(std::string("ONNX export failed: ") + strerror(writer.error));
+  }
+}
+
 }}
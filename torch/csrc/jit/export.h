@@ -7,4 +7,10 @@ namespace torch { namespace jit {
 std::string ExportGraph(const std::shared_ptr<Graph>& graph,
                         const std::vector<at::Tensor> & initializers);
 
+// Writes the protobuf to the file descriptor 'fd' as it's being encoded,
+// without keeping it in memory.
+void ExportGraph(const std::shared_ptr<Graph>& graph,
+                 const std::vector<at::Tensor> & initializers,
+                 int fd);
+
 }}
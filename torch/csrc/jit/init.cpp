@@ -39,7 +39,7 @@ void initJITBindings(PyObject *module) {
   auto m = py::handle(module).cast<py::module>();
 
   m.def("_jit_init", loadPythonClasses)
-   .def("_jit_pass_onnx", ToONNX)
+   .def("_jit_pass_onnx", ToONNX, py::arg("state"), py::arg("native_symbolics") = true)
    .def("_jit_pass_onnx_peephole", graph_pass<PeepholeOptimizeONNX>)
    .def("_jit_pass_fuse", graph_pass<FuseGraph>)
    .def("_jit_pass_dce", graph_pass<EliminateDeadCode>)
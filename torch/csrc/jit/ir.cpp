@@ -1,11 +1,15 @@
+#ifndef NO_PYTHON
 #include <Python.h>
+#endif
 #include "ir.h"
 
+#ifndef NO_PYTHON
 #include "torch/csrc/utils/auto_gil.h"
 #include "torch/csrc/utils/python_strings.h"
 #include "torch/csrc/autograd/function.h"
 
 #include "pybind11/pybind11.h"
+#endif
 
 #include <iostream>
 #include <unordered_map>
@@ -16,12 +20,15 @@
 #include <algorithm>
 #include <string>
 
+#ifndef NO_PYTHON
 namespace py = pybind11;
+#endif
 
 namespace torch { namespace jit {
 
 constexpr int max_tensor_display_size = 10;
 
+#ifndef NO_PYTHON
 std::string getPythonName(const PyObject* obj, bool is_legacy) {
   AutoGIL gil;
   if (is_legacy) {
@@ -34,6 +41,7 @@ std::string getPythonName(const PyObject* obj, bool is_legacy) {
     return THPUtils_unpackString(name.get());
   }
 }
+#endif
 void printNodeRef(std::ostream & out, const Node * n) {
   out << "%" << n->uniqueName();
 }
@@ -54,6 +62,7 @@ std::ostream& operator<<(std::ostream & out, const at::ArrayRef<T> & nodes) {
   return out;
 }
 
+#ifndef NO_PYTHON
 std::ostream& printPyObject(std::ostream & out, const THPObjectPtr& obj) {
   AutoGIL gil;
   auto pyobj = py::handle(const_cast<PyObject*>(obj.get()));
@@ -100,6 +109,21 @@ std::string PythonOp::name() const {
 std::string CppOp::name() const {
   return fn->name();
 }
+#else
+// Graphs built without Python (e.g. by the inference runtime) never contain
+// Python or autograd operators, but the printer still has to link.
+std::ostream& printPyObject(std::ostream & out, const THPObjectPtr& obj) {
+  return out << "<PyObject>";
+}
+
+std::string PythonOp::name() const {
+  return "PythonOp";
+}
+
+std::string CppOp::name() const {
+  return "CppOp";
+}
+#endif
 
 static void emitUses(std::ostream & out, const Node * n) {
   size_t i = 0;
@@ -511,7 +535,7 @@ void LintGraph(std::shared_ptr<Graph>& graph) {
   graph->lint();
 }
 
-
+#ifndef NO_PYTHON
 void PythonOp::cloneFrom(Node * other_) {
   Node::cloneFrom(other_);
   auto other = other_->cast<PythonOp>();
@@ -524,5 +548,6 @@ void PythonOp::cloneFrom(Node * other_) {
     this->scalar_args.emplace_back(sa.get());
   }
 }
+#endif
 
 }}
@@ -1,5 +1,6 @@
 #include "torch/csrc/utils/pybind.h"
 #include "torch/csrc/jit/passes/onnx.h"
+#include "torch/csrc/jit/passes/onnx/symbolic.h"
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/symbolic.h"
 #include "torch/csrc/utils/functional.h"
@@ -26,7 +27,7 @@ bool hasUsedHandle(Node *node) {
 } // anonymous namespace
 
 // Transform PythonOps and Cpp Ops into Node's that match ONNX semantics.
-void ToONNX(std::shared_ptr<tracer::TracingState>& state) {
+void ToONNX(std::shared_ptr<tracer::TracingState>& state, bool native_symbolics) {
   // Check that the tracing state is live (it should be, because
   // you were supposed to request zero derivatives.)
   if (state->is_expired()) {
@@ -228,6 +229,13 @@ void ToONNX(std::shared_ptr<tracer::TracingState>& state) {
         // Undefined nodes get passed into Convolution, but then they are
         // removed.  We'll test for leftover Undefined in export.cpp
         cloneNode(node);
+      } else if (native_symbolics) {
+        node_list outputs;
+        if (runNativeSymbolic(ctx.graph, node, fmap(node->inputs(), envFn), outputs)) {
+          setOutputs(symbolToString(node->kind()), node, outputs);
+        } else {
+          callPySymbolicFunction(node);
+        }
       } else {
         callPySymbolicFunction(node);
       }
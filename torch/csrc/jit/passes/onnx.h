@@ -5,6 +5,9 @@
 
 namespace torch { namespace jit {
 
-void ToONNX(std::shared_ptr<tracer::TracingState>& state);
+// ATen operators are translated by the C++ rules from onnx/symbolic.h when
+// possible, unless 'native_symbolics' is false, and by the functions from
+// torch/onnx/symbolic.py otherwise.
+void ToONNX(std::shared_ptr<tracer::TracingState>& state, bool native_symbolics = true);
 
 }}
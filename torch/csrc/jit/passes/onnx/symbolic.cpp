@@ -0,0 +1,272 @@
+#include "torch/csrc/jit/passes/onnx/symbolic.h"
+
+#include <numeric>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+// C++ versions of the most common rules of torch/onnx/symbolic.py.  Calling
+// into Python for every node dominates the export time of large graphs, so
+// the operators that show up most often are translated here.  Keep them in
+// sync with their Python counterparts: attributes are added in the order of
+// their names, like _newNode does.
+
+namespace {
+
+using SymbolicFn = bool (*)(Graph* g, Node* n, const node_list& inputs, node_list& outputs);
+
+Node* appendOp(Graph* g, Symbol kind, const node_list& inputs) {
+  return g->appendNode(g->create(kind, inputs));
+}
+
+Node* appendOp(Graph* g, const char* kind, const node_list& inputs) {
+  return appendOp(g, stringToSymbol(kind), inputs);
+}
+
+TensorType* tensorType(Node* n) {
+  return n->hasType() ? n->type()->cast<TensorType>() : nullptr;
+}
+
+// Scalar arguments are recorded as one element tensors
+double scalarAttr(Node* n, Symbol name) {
+  return n->t(name).pImpl->localScalar().toDouble();
+}
+
+Symbol attr(const char* name) {
+  return stringToSymbol(name);
+}
+
+// See Note [Pointwise by scalar] in torch/onnx/symbolic.py
+bool pointwise(Graph* g, Node* n, const node_list& inputs, node_list& outputs,
+               Symbol kind, bool has_alpha) {
+  if (has_alpha && (!n->hasAttribute(kalpha) || scalarAttr(n, kalpha) != 1))
+    return false;
+  if (inputs.size() == 2) {
+    outputs = {appendOp(g, kind, inputs)};
+    return true;
+  }
+  if (inputs.size() != 1 || !n->hasAttribute(kother))
+    return false;
+  auto self_type = tensorType(inputs[0]);
+  if (!self_type)
+    return false;
+
+  auto other = n->t(kother);
+  other = other.toType(other.type().toScalarType(self_type->scalarType()));
+  auto constant = appendOp(g, kConstant, {});
+  constant->t_(kvalue, other.view({}));
+  auto node = appendOp(g, kind, {inputs[0], constant});
+  node->i_(kbroadcast, 1);
+  outputs = {node};
+  return true;
+}
+
+bool add(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  return pointwise(g, n, inputs, outputs, kAdd, true);
+}
+
+bool sub(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  return pointwise(g, n, inputs, outputs, kSub, true);
+}
+
+bool mul(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  return pointwise(g, n, inputs, outputs, kMul, false);
+}
+
+bool div(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  return pointwise(g, n, inputs, outputs, kDiv, false);
+}
+
+template<BuiltinSymbol kind>
+bool unary(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  if (inputs.size() != 1 || n->hasAttributes())
+    return false;
+  outputs = {appendOp(g, kind, inputs)};
+  return true;
+}
+
+bool cat(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto node = appendOp(g, "Concat", inputs);
+  node->i_(kaxis, n->i(kdim));
+  outputs = {node};
+  return true;
+}
+
+bool mm(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto self_type = tensorType(inputs.at(0));
+  if (!self_type || self_type->scalarType() == at::kHalf)
+    return false;
+  // A dummy C tensor, which is ignored since beta = 0
+  auto c = appendOp(g, kConstant, {});
+  c->t_(kvalue, at::CPU(self_type->scalarType()).zeros({1}));
+  auto node = appendOp(g, kGemm, {inputs.at(0), inputs.at(1), c});
+  node->f_(kalpha, 1.0);
+  node->f_(kbeta, 0.0);
+  node->i_(kbroadcast, 1);
+  outputs = {node};
+  return true;
+}
+
+bool addmm(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto node = appendOp(g, kGemm, {inputs.at(1), inputs.at(2), inputs.at(0)});
+  node->f_(kalpha, scalarAttr(n, kalpha));
+  node->f_(kbeta, scalarAttr(n, kbeta));
+  outputs = {node};
+  return true;
+}
+
+bool t(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto node = appendOp(g, kTranspose, inputs);
+  node->is_(kperm, {1, 0});
+  outputs = {node};
+  return true;
+}
+
+bool transpose(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  int64_t dim0 = n->i(attr("dim0"));
+  int64_t dim1 = n->i(attr("dim1"));
+  if (dim0 == dim1) {
+    outputs = {inputs.at(0)};
+    return true;
+  }
+
+  auto self_type = tensorType(inputs.at(0));
+  if (!self_type)
+    return false;
+  // NB: Transpose in ONNX is actually a Permute
+  std::vector<int64_t> axes(self_type->sizes().size());
+  std::iota(axes.begin(), axes.end(), 0);
+  int64_t num_dims = axes.size();
+  if (dim0 < 0) dim0 += num_dims;
+  if (dim1 < 0) dim1 += num_dims;
+  if (dim0 < 0 || dim0 >= num_dims || dim1 < 0 || dim1 >= num_dims)
+    return false;
+  std::swap(axes[dim0], axes[dim1]);
+  auto node = appendOp(g, kTranspose, inputs);
+  node->is_(kperm, std::move(axes));
+  outputs = {node};
+  return true;
+}
+
+bool view(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto node = appendOp(g, kReshape, inputs);
+  node->is_(kshape, std::vector<int64_t>(n->is(ksize)));
+  outputs = {node};
+  return true;
+}
+
+bool threshold(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  if (scalarAttr(n, attr("threshold")) != 0 || scalarAttr(n, kvalue) != 0)
+    return false;
+  outputs = {appendOp(g, "Relu", inputs)};
+  return true;
+}
+
+bool leaky_relu(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto node = appendOp(g, "LeakyRelu", inputs);
+  node->f_(kalpha, scalarAttr(n, attr("negative_slope")));
+  outputs = {node};
+  return true;
+}
+
+Node* appendSoftmax(Graph* g, Node* n, const node_list& inputs) {
+  auto node = appendOp(g, "Softmax", inputs);
+  if (n->hasAttribute(kdim))
+    node->i_(kaxis, n->i(kdim));
+  return node;
+}
+
+bool softmax(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  outputs = {appendSoftmax(g, n, inputs)};
+  return true;
+}
+
+bool log_softmax(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  auto softmax = appendSoftmax(g, n, inputs);
+  softmax->setType(inputs.at(0)->typeOption());
+  outputs = {appendOp(g, "Log", {softmax})};
+  return true;
+}
+
+// Like _pool_pair in symbolic.py: an IntList[2] argument may hold a single
+// int used for both dimensions (see check_intlist in ATen)
+std::vector<int64_t> pair(std::vector<int64_t> list) {
+  if (list.size() == 1)
+    list.push_back(list[0]);
+  return list;
+}
+
+bool max_pool2d(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  if (n->i(attr("ceil_mode")))
+    return false;
+  auto kernel_size = pair(n->is(attr("kernel_size")));
+  auto stride = pair(n->is(kstride));
+  if (stride.empty())
+    stride = kernel_size;
+  auto node = appendOp(g, "MaxPool", inputs);
+  node->is_(kdilations, pair(n->is(kdilation)));
+  node->is_(kkernel_shape, std::move(kernel_size));
+  node->is_(kpads, pair(n->is(attr("padding"))));
+  node->is_(kstrides, std::move(stride));
+  // indices aren't supported
+  outputs = {node, nullptr};
+  return true;
+}
+
+bool avg_pool2d(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  if (n->i(attr("ceil_mode")))
+    return false;
+  auto kernel_size = pair(n->is(attr("kernel_size")));
+  auto stride = pair(n->is(kstride));
+  if (stride.empty())
+    stride = kernel_size;
+  auto node = appendOp(g, "AveragePool", inputs);
+  node->is_(kkernel_shape, std::move(kernel_size));
+  node->is_(kpads, pair(n->is(attr("padding"))));
+  node->is_(kstrides, std::move(stride));
+  outputs = {node};
+  return true;
+}
+
+const std::unordered_map<Symbol, SymbolicFn>& symbolics() {
+  static std::unordered_map<Symbol, SymbolicFn> symbolics = {
+    {kadd, add},
+    {stringToSymbol("sub"), sub},
+    {kmul, mul},
+    {stringToSymbol("div"), div},
+    {kneg, unary<kNeg>},
+    {ktanh, unary<kTanh>},
+    {ksigmoid, unary<kSigmoid>},
+    {kcat, cat},
+    {stringToSymbol("mm"), mm},
+    {stringToSymbol("addmm"), addmm},
+    {stringToSymbol("t"), t},
+    {stringToSymbol("transpose"), transpose},
+    {stringToSymbol("view"), view},
+    {stringToSymbol("threshold"), threshold},
+    {stringToSymbol("leaky_relu"), leaky_relu},
+    {stringToSymbol("softmax"), softmax},
+    {stringToSymbol("log_softmax"), log_softmax},
+    {stringToSymbol("max_pool2d"), max_pool2d},
+    {stringToSymbol("avg_pool2d"), avg_pool2d},
+  };
+  return symbolics;
+}
+
+} // anonymous namespace
+
+bool runNativeSymbolic(Graph* g, Node* n, const node_list& inputs, node_list& outputs) {
+  // See Note [Export inplace]
+  Symbol kind = n->kind();
+  std::string name = symbolToString(kind);
+  if (!name.empty() && name.back() == '_')
+    kind = stringToSymbol(name.substr(0, name.size() - 1));
+
+  auto& all_symbolics = symbolics();
+  auto it = all_symbolics.find(kind);
+  if (it == all_symbolics.end())
+    return false;
+  return it->second(g, n, inputs, outputs);
+}
+
+}}
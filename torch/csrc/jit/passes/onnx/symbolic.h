@@ -0,0 +1,15 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Translates an ATen operator into ONNX nodes appended to 'g', without calling
+// into Python.  'inputs' are the inputs of 'n' already translated into 'g'.
+// Returns false if there is no C++ rule for the operator, or the rule doesn't
+// support this particular call, in which case the symbolic function from
+// torch/onnx/symbolic.py has to be used.  Rules produce exactly the same
+// nodes as their Python counterparts.
+bool runNativeSymbolic(Graph* g, Node* n, const node_list& inputs, node_list& outputs);
+
+}}
@@ -6,6 +6,7 @@
 #include "torch/csrc/jit/export.h"
 #include "torch/csrc/jit/pybind.h"
 #include "torch/csrc/utils/python_strings.h"
+#include "torch/csrc/utils/auto_gil.h"
 
 #include <sstream>
 
@@ -40,6 +41,11 @@ void initPythonTracerBindings(PyObject* module_) {
       ASSERT_UNEXPIRED("export");
       return py::bytes(ExportGraph(s.graph, initializers));
     })
+    .def("export_to_file", [](TracingState& s, int fd, const std::vector<at::Tensor>& initializers) {
+      ASSERT_UNEXPIRED("export_to_file");
+      AutoNoGIL no_gil;
+      ExportGraph(s.graph, initializers, fd);
+    })
     .def("graph", [](TracingState& s) {
       return s.graph;
     })
@@ -0,0 +1,150 @@
+/*
+ * Measures the latency and throughput of the inference runtime on a model
+ * exported with torch.onnx.export. Inputs are random, with the sizes recorded
+ * in the model except for the batch size.
+ *
+ * Usage: predictor_benchmark model.onnx [--batch N] [--threads N]
+ *          [--clients N] [--iterations N] [--warmup N]
+ *
+ *   --threads    - threads of the pool shared by all clients, which split
+ *                  single operators (1 uses the OpenMP threads of TH instead),
+ *   --clients    - threads running inferences concurrently, each with its own
+ *                  predictor,
+ *   --iterations - inferences timed per client,
+ *   --warmup     - inferences per client before timing, the first of which
+ *                  plans the memory.
+ */
+
+#include "torch/csrc/jit/runtime/import.h"
+#include "torch/csrc/jit/runtime/predictor.h"
+
+#include <TH/THGeneral.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace torch::jit;
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+  size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+  return sorted[index];
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s model.onnx [--batch N] [--threads N] [--clients N] "
+                 "[--iterations N] [--warmup N]\n", argv[0]);
+    return 1;
+  }
+  std::string path = argv[1];
+  int64_t batch = 0;
+  int threads = 1;
+  int clients = 1;
+  int iterations = 100;
+  int warmup = 5;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    int value = std::atoi(argv[i + 1]);
+    if (!std::strcmp(argv[i], "--batch")) batch = value;
+    else if (!std::strcmp(argv[i], "--threads")) threads = value;
+    else if (!std::strcmp(argv[i], "--clients")) clients = value;
+    else if (!std::strcmp(argv[i], "--iterations")) iterations = value;
+    else if (!std::strcmp(argv[i], "--warmup")) warmup = value;
+    else {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (threads < 1 || clients < 1 || iterations < 1 || warmup < 1) {
+    std::fprintf(stderr, "--threads, --clients, --iterations and --warmup must be positive\n");
+    return 1;
+  }
+
+  auto start = Clock::now();
+  std::vector<at::Tensor> initializers;
+  auto graph = ImportGraphFromFile(path, initializers);
+  std::vector<std::vector<int64_t>> input_sizes;
+  for (size_t i = 0; i < graph->inputs().size() - initializers.size(); ++i) {
+    auto type = graph->inputs()[i]->type()->cast<TensorType>();
+    if (!type) {
+      std::fprintf(stderr, "the model doesn't record the sizes of input %zu\n", i);
+      return 1;
+    }
+    input_sizes.push_back(type->sizes());
+    if (batch > 0 && !input_sizes.back().empty())
+      input_sizes.back()[0] = batch;
+  }
+  double load_ms = millisecondsSince(start);
+  start = Clock::now();
+  auto program = std::make_shared<const Program>(graph, initializers);
+  double compile_ms = millisecondsSince(start);
+
+  // The pool replaces the parallelism of TH
+  std::shared_ptr<ThreadPool> pool;
+  if (threads > 1) {
+    THSetNumThreads(1);
+    pool = std::make_shared<ThreadPool>(threads);
+  }
+
+  std::vector<std::vector<double>> latencies(clients);
+  std::vector<size_t> arena_sizes(clients);
+  std::vector<std::thread> client_threads;
+  for (int id = 0; id < clients; ++id) {
+    client_threads.emplace_back([&, id] {
+      Predictor predictor(program, pool);
+      std::vector<at::Tensor> inputs;
+      for (auto& sizes : input_sizes)
+        inputs.push_back(at::CPU(at::kFloat).randn(sizes));
+      for (int i = 0; i < warmup; ++i)
+        predictor.run(inputs);
+      for (int i = 0; i < iterations; ++i) {
+        auto inference_start = Clock::now();
+        predictor.run(inputs);
+        latencies[id].push_back(millisecondsSince(inference_start));
+      }
+      arena_sizes[id] = predictor.arenaSize();
+    });
+  }
+  for (auto& thread : client_threads)
+    thread.join();
+
+  // Clients run concurrently, so the throughput is limited by the slowest one
+  std::vector<double> all_latencies;
+  double total_ms = 0;
+  for (int id = 0; id < clients; ++id) {
+    all_latencies.insert(all_latencies.end(), latencies[id].begin(), latencies[id].end());
+    double client_ms = 0;
+    for (auto latency : latencies[id])
+      client_ms += latency;
+    total_ms = std::max(total_ms, client_ms);
+  }
+  std::sort(all_latencies.begin(), all_latencies.end());
+  double mean = 0;
+  for (auto latency : all_latencies)
+    mean += latency;
+  mean /= all_latencies.size();
+  double inferences_per_second = all_latencies.size() / (total_ms / 1000);
+  int64_t samples = input_sizes.empty() || input_sizes[0].empty() ? 1 : input_sizes[0][0];
+
+  std::printf("%s: %zu instructions, batch %lld, %d threads, %d clients\n", path.c_str(),
+              program->instructions.size(), static_cast<long long>(samples), threads, clients);
+  std::printf("load       %10.3f ms\n", load_ms);
+  std::printf("compile    %10.3f ms\n", compile_ms);
+  std::printf("arena      %10.3f MB per client\n", arena_sizes[0] / double(1 << 20));
+  std::printf("latency    %10.3f ms mean, %.3f p50, %.3f p90, %.3f p99\n", mean,
+              percentile(all_latencies, 0.5), percentile(all_latencies, 0.9),
+              percentile(all_latencies, 0.99));
+  std::printf("throughput %10.1f inferences/s, %.1f samples/s\n", inferences_per_second,
+              inferences_per_second * samples);
+  return 0;
+}
@@ -0,0 +1,454 @@
+#include "torch/csrc/jit/runtime/import.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// Field numbers of the messages of onnx.proto, see torch/csrc/onnx/onnx.pb.h.
+// The runtime doesn't link nanopb, so the wire format is decoded by hand.
+enum ModelField { kModelGraph = 7 };
+enum GraphField { kGraphNode = 1, kGraphInitializer = 5, kGraphInput = 11, kGraphOutput = 12 };
+enum NodeField { kNodeInput = 1, kNodeOutput = 2, kNodeOpType = 4, kNodeAttribute = 5 };
+enum AttributeField {
+  kAttrName = 1, kAttrF = 2, kAttrI = 3, kAttrS = 4, kAttrT = 5, kAttrG = 6,
+  kAttrFloats = 7, kAttrInts = 8, kAttrStrings = 9, kAttrTensors = 10, kAttrGraphs = 11,
+};
+enum TensorField {
+  kTensorDims = 1, kTensorDataType = 2, kTensorFloatData = 4, kTensorInt32Data = 5,
+  kTensorInt64Data = 7, kTensorName = 8, kTensorRawData = 9, kTensorDoubleData = 10,
+};
+enum ValueInfoField { kValueInfoName = 1, kValueInfoType = 2 };
+// TypeProto.tensor_type, TensorTypeProto.elem_type and shape,
+// TensorShapeProto.dim and Dimension.dim_value all use field number 1,
+// except for TensorTypeProto.shape.
+enum TypeField { kTypeTensorType = 1, kTensorTypeElemType = 1, kTensorTypeShape = 2,
+                 kShapeDim = 1, kDimensionValue = 1 };
+
+enum WireType { kVarint = 0, kFixed64 = 1, kBytes = 2, kFixed32 = 5 };
+
+[[noreturn]] void fail(const std::string& message) {
+  throw std::runtime_error("ONNX import failed: " + message);
+}
+
+// Reads the fields of a serialized message one by one.  Nothing is copied
+// until a field is read: nested messages and tensor data point into the
+// serialized model.
+struct ProtoReader {
+  ProtoReader(const char* data, size_t size)
+    : pos(reinterpret_cast<const uint8_t*>(data))
+    , end(pos + size) {}
+
+  bool next() {
+    if (pos == end)
+      return false;
+    uint64_t key = varint();
+    field = key >> 3;
+    wire_type = key & 7;
+    return true;
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos == end)
+        fail("truncated varint");
+      uint8_t byte = *pos++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    fail("varint is too long");
+  }
+
+  int64_t int64() {
+    expect(kVarint);
+    return static_cast<int64_t>(varint());
+  }
+
+  template<typename T>
+  T fixed() {
+    if (static_cast<size_t>(end - pos) < sizeof(T))
+      fail("truncated fixed size field");
+    T value;
+    std::memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  float float32() {
+    expect(kFixed32);
+    return fixed<float>();
+  }
+
+  ProtoReader message() {
+    expect(kBytes);
+    uint64_t size = varint();
+    if (size > static_cast<uint64_t>(end - pos))
+      fail("truncated field");
+    ProtoReader nested(reinterpret_cast<const char*>(pos), size);
+    pos += size;
+    return nested;
+  }
+
+  std::string string() {
+    auto nested = message();
+    return std::string(reinterpret_cast<const char*>(nested.pos), nested.end - nested.pos);
+  }
+
+  // Repeated numeric fields may be packed into a single field
+  void int64s(std::vector<int64_t>& values) {
+    if (wire_type != kBytes) {
+      values.push_back(int64());
+      return;
+    }
+    auto packed = message();
+    while (packed.pos != packed.end)
+      values.push_back(static_cast<int64_t>(packed.varint()));
+  }
+
+  template<typename T, WireType type>
+  void fixeds(std::vector<T>& values) {
+    if (wire_type != kBytes) {
+      expect(type);
+      values.push_back(fixed<T>());
+      return;
+    }
+    auto packed = message();
+    while (packed.pos != packed.end)
+      values.push_back(packed.fixed<T>());
+  }
+
+  void skip() {
+    switch (wire_type) {
+      case kVarint: varint(); break;
+      case kFixed64: fixed<uint64_t>(); break;
+      case kBytes: message(); break;
+      case kFixed32: fixed<uint32_t>(); break;
+      default: fail("unsupported wire type " + std::to_string(wire_type));
+    }
+  }
+
+  void expect(int type) {
+    if (wire_type != type)
+      fail("unexpected wire type of field " + std::to_string(field));
+  }
+
+  const uint8_t* pos;
+  const uint8_t* end;
+  uint32_t field = 0;
+  int wire_type = 0;
+};
+
+at::ScalarType scalarType(int64_t data_type) {
+  // TensorProto.DataType
+  switch (data_type) {
+    case 1: return at::kFloat;
+    case 2: return at::kByte;
+    case 3: return at::kChar;
+    case 5: return at::kShort;
+    case 6: return at::kInt;
+    case 7: return at::kLong;
+    case 10: return at::kHalf;
+    case 11: return at::kDouble;
+    default: fail("unsupported tensor data type " + std::to_string(data_type));
+  }
+}
+
+template<typename T>
+void copyValues(at::Tensor& tensor, const std::vector<T>& values, at::ScalarType type) {
+  if (static_cast<int64_t>(values.size()) != tensor.numel())
+    fail("tensor has the wrong number of values");
+  // Typed data is only used for small tensors, e.g. by other exporters
+  auto source = at::CPU(type).tensor({static_cast<int64_t>(values.size())});
+  std::memcpy(source.data_ptr(), values.data(), values.size() * sizeof(T));
+  tensor.view({tensor.numel()}).copy_(source);
+}
+
+at::Tensor readTensor(ProtoReader reader, std::string* name = nullptr) {
+  std::vector<int64_t> dims;
+  int64_t data_type = 0;
+  const uint8_t* raw_data = nullptr;
+  size_t raw_size = 0;
+  std::vector<float> floats;
+  std::vector<double> doubles;
+  std::vector<int64_t> ints;
+  while (reader.next()) {
+    switch (reader.field) {
+      case kTensorDims: reader.int64s(dims); break;
+      case kTensorDataType: data_type = reader.int64(); break;
+      case kTensorFloatData: reader.fixeds<float, kFixed32>(floats); break;
+      case kTensorDoubleData: reader.fixeds<double, kFixed64>(doubles); break;
+      case kTensorInt32Data:
+      case kTensorInt64Data: reader.int64s(ints); break;
+      case kTensorName:
+        if (name) *name = reader.string();
+        else reader.skip();
+        break;
+      case kTensorRawData: {
+        auto data = reader.message();
+        raw_data = data.pos;
+        raw_size = data.end - data.pos;
+      } break;
+      default: reader.skip();
+    }
+  }
+
+  // Scalars are exported as tensors without dimensions
+  if (dims.empty())
+    dims.push_back(1);
+  auto tensor = at::CPU(scalarType(data_type)).tensor(dims);
+  if (raw_data) {
+    if (raw_size != tensor.numel() * tensor.type().elementSizeInBytes())
+      fail("raw data of tensor has the wrong size");
+    std::memcpy(tensor.data_ptr(), raw_data, raw_size);
+  } else if (!floats.empty()) {
+    copyValues(tensor, floats, at::kFloat);
+  } else if (!doubles.empty()) {
+    copyValues(tensor, doubles, at::kDouble);
+  } else if (!ints.empty()) {
+    copyValues(tensor, ints, at::kLong);
+  } else if (tensor.numel() != 0) {
+    fail("tensor has no data");
+  }
+  return tensor;
+}
+
+// Returns the name of the value, and its type if it has one
+std::string readValueInfo(ProtoReader reader, TypePtr& type) {
+  std::string name;
+  while (reader.next()) {
+    if (reader.field == kValueInfoName) {
+      name = reader.string();
+    } else if (reader.field == kValueInfoType) {
+      auto type_proto = reader.message();
+      while (type_proto.next()) {
+        if (type_proto.field != kTypeTensorType) {
+          type_proto.skip();
+          continue;
+        }
+        auto tensor_type = type_proto.message();
+        int64_t elem_type = 0;
+        std::vector<int64_t> sizes;
+        while (tensor_type.next()) {
+          if (tensor_type.field == kTensorTypeElemType) {
+            elem_type = tensor_type.int64();
+          } else if (tensor_type.field == kTensorTypeShape) {
+            auto shape = tensor_type.message();
+            while (shape.next()) {
+              if (shape.field != kShapeDim) {
+                shape.skip();
+                continue;
+              }
+              auto dim = shape.message();
+              while (dim.next()) {
+                if (dim.field == kDimensionValue) sizes.push_back(dim.int64());
+                else dim.skip();
+              }
+            }
+          } else {
+            tensor_type.skip();
+          }
+        }
+        std::vector<int64_t> strides(sizes.size());
+        int64_t stride = 1;
+        for (size_t i = sizes.size(); i-- > 0;) {
+          strides[i] = stride;
+          stride *= sizes[i];
+        }
+        type = std::make_shared<TensorType>(scalarType(elem_type), -1, sizes, strides);
+      }
+    } else {
+      reader.skip();
+    }
+  }
+  return name;
+}
+
+std::shared_ptr<Graph> readGraph(ProtoReader reader, std::vector<at::Tensor>& initializers);
+
+void readAttribute(ProtoReader reader, Node* n) {
+  std::string name;
+  // AttributeProto has no type field: the kind of the attribute follows from
+  // the fields which are set
+  AttributeKind kind = AttributeKind::is;
+  double f = 0;
+  int64_t i = 0;
+  std::string s;
+  at::Tensor t;
+  std::shared_ptr<Graph> g;
+  std::vector<float> floats;
+  std::vector<int64_t> ints;
+  std::vector<std::string> strings;
+  std::vector<at::Tensor> tensors;
+  std::vector<std::shared_ptr<Graph>> graphs;
+  std::vector<at::Tensor> unused_initializers;
+  while (reader.next()) {
+    switch (reader.field) {
+      case kAttrName: name = reader.string(); break;
+      case kAttrF: f = reader.float32(); kind = AttributeKind::f; break;
+      case kAttrI: i = reader.int64(); kind = AttributeKind::i; break;
+      case kAttrS: s = reader.string(); kind = AttributeKind::s; break;
+      case kAttrT: t = readTensor(reader.message()); kind = AttributeKind::t; break;
+      case kAttrG: g = readGraph(reader.message(), unused_initializers); kind = AttributeKind::g; break;
+      case kAttrFloats: reader.fixeds<float, kFixed32>(floats); kind = AttributeKind::fs; break;
+      case kAttrInts: reader.int64s(ints); kind = AttributeKind::is; break;
+      case kAttrStrings: strings.push_back(reader.string()); kind = AttributeKind::ss; break;
+      case kAttrTensors: tensors.push_back(readTensor(reader.message())); kind = AttributeKind::ts; break;
+      case kAttrGraphs:
+        graphs.push_back(readGraph(reader.message(), unused_initializers));
+        kind = AttributeKind::gs;
+        break;
+      default: reader.skip();
+    }
+  }
+  if (name.empty())
+    fail("attribute without a name");
+
+  Symbol symbol = stringToSymbol(name);
+  switch (kind) {
+    case AttributeKind::f: n->f_(symbol, f); break;
+    case AttributeKind::fs: n->fs_(symbol, std::vector<double>(floats.begin(), floats.end())); break;
+    case AttributeKind::i: n->i_(symbol, i); break;
+    case AttributeKind::is: n->is_(symbol, std::move(ints)); break;
+    case AttributeKind::s: n->s_(symbol, s); break;
+    case AttributeKind::ss: n->ss_(symbol, std::move(strings)); break;
+    case AttributeKind::t: n->t_(symbol, t); break;
+    case AttributeKind::ts: n->ts_(symbol, std::move(tensors)); break;
+    case AttributeKind::g: n->g_(symbol, g); break;
+    case AttributeKind::gs: n->gs_(symbol, std::move(graphs)); break;
+  }
+}
+
+struct NodeProto {
+  std::string op_type;
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  std::vector<ProtoReader> attributes;
+};
+
+NodeProto readNode(ProtoReader reader) {
+  NodeProto node;
+  while (reader.next()) {
+    switch (reader.field) {
+      case kNodeInput: node.inputs.push_back(reader.string()); break;
+      case kNodeOutput: node.outputs.push_back(reader.string()); break;
+      case kNodeOpType: node.op_type = reader.string(); break;
+      case kNodeAttribute: node.attributes.push_back(reader.message()); break;
+      default: reader.skip();
+    }
+  }
+  return node;
+}
+
+std::shared_ptr<Graph> readGraph(ProtoReader reader, std::vector<at::Tensor>& initializers) {
+  std::vector<std::pair<std::string, TypePtr>> inputs;
+  std::vector<std::string> outputs;
+  std::vector<NodeProto> nodes;
+  std::unordered_map<std::string, at::Tensor> weights;
+  while (reader.next()) {
+    switch (reader.field) {
+      case kGraphNode: nodes.push_back(readNode(reader.message())); break;
+      case kGraphInitializer: {
+        std::string name;
+        auto tensor = readTensor(reader.message(), &name);
+        weights[name] = tensor;
+      } break;
+      case kGraphInput: {
+        TypePtr type;
+        auto name = readValueInfo(reader.message(), type);
+        inputs.emplace_back(std::move(name), std::move(type));
+      } break;
+      case kGraphOutput: {
+        TypePtr type;
+        outputs.push_back(readValueInfo(reader.message(), type));
+      } break;
+      default: reader.skip();
+    }
+  }
+
+  auto graph = std::make_shared<Graph>();
+  std::unordered_map<std::string, Node*> values;
+  auto addInput = [&](const std::pair<std::string, TypePtr>& input) {
+    auto param = graph->addInput();
+    if (input.second)
+      param->setType(input.second);
+    values[input.first] = param;
+  };
+  // Inputs with initializers go last
+  for (auto& input : inputs) {
+    if (!weights.count(input.first))
+      addInput(input);
+  }
+  initializers.clear();
+  for (auto& input : inputs) {
+    auto it = weights.find(input.first);
+    if (it == weights.end())
+      continue;
+    addInput(input);
+    initializers.push_back(it->second);
+  }
+  if (initializers.size() != weights.size())
+    fail("initializer doesn't match any input of the graph");
+
+  auto lookup = [&](const std::string& name) {
+    auto it = values.find(name);
+    if (it == values.end())
+      fail("undefined value " + name);
+    return it->second;
+  };
+
+  for (auto& node_proto : nodes) {
+    std::vector<Node*> node_inputs;
+    for (auto& name : node_proto.inputs)
+      node_inputs.push_back(lookup(name));
+    auto n = graph->appendNode(graph->create(stringToSymbol(node_proto.op_type), node_inputs));
+    for (auto& attribute : node_proto.attributes)
+      readAttribute(attribute, n);
+    if (node_proto.outputs.size() == 1) {
+      values[node_proto.outputs[0]] = n;
+    } else {
+      for (size_t i = 0; i < node_proto.outputs.size(); ++i)
+        values[node_proto.outputs[i]] = graph->appendNode(graph->createSelect(n, i));
+    }
+  }
+
+  for (auto& name : outputs)
+    graph->registerOutput(lookup(name));
+  return graph;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<Graph> ImportGraph(const std::string& serialized_model,
+                                   std::vector<at::Tensor>& initializers) {
+  ProtoReader model(serialized_model.data(), serialized_model.size());
+  std::shared_ptr<Graph> graph;
+  while (model.next()) {
+    if (model.field == kModelGraph) {
+      graph = readGraph(model.message(), initializers);
+    } else {
+      model.skip();
+    }
+  }
+  if (!graph)
+    fail("the model has no graph");
+  return graph;
+}
+
+std::shared_ptr<Graph> ImportGraphFromFile(const std::string& path,
+                                           std::vector<at::Tensor>& initializers) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    fail("couldn't open " + path);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return ImportGraph(contents.str(), initializers);
+}
+
+}}
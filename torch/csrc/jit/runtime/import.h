@@ -0,0 +1,19 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// The inverse of ExportGraph: builds the graph of a serialized ONNX model.
+// The weights stored in the model are returned in 'initializers'; they are
+// bound to the last inputs of the graph, in order, like the initializers
+// passed to ExportGraph.  Inputs of the graph have the types recorded in the
+// model, other nodes have no types.
+std::shared_ptr<Graph> ImportGraph(const std::string& serialized_model,
+                                   std::vector<at::Tensor>& initializers);
+
+// Reads the model from the file at 'path'.
+std::shared_ptr<Graph> ImportGraphFromFile(const std::string& path,
+                                           std::vector<at::Tensor>& initializers);
+
+}}
@@ -0,0 +1,575 @@
+#include "torch/csrc/jit/runtime/operators.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+// Kernels of the ONNX operators produced by the exporter (see
+// torch/onnx/symbolic.py and the symbolic methods of autograd functions).
+// They use the _out variants of ATen functions wherever they exist, so that
+// they can write to preallocated outputs.  See Note [Preallocated outputs]
+
+namespace {
+
+using OperatorCreator = Operator (*)(Node* n);
+using UnaryFn = void (*)(at::Tensor& out, const at::Tensor& self);
+using BinaryFn = void (*)(at::Tensor& out, const at::Tensor& self, const at::Tensor& other);
+
+[[noreturn]] void unsupported(Node* n, const std::string& reason) {
+  throw std::runtime_error(std::string("unsupported operator ") +
+                           symbolToString(n->kind()) + ": " + reason);
+}
+
+// Attributes missing from a node have their ONNX default values
+int64_t intAttr(Node* n, const char* name, int64_t default_value) {
+  Symbol symbol = stringToSymbol(name);
+  return n->hasAttribute(symbol) ? n->i(symbol) : default_value;
+}
+
+double floatAttr(Node* n, const char* name, double default_value) {
+  Symbol symbol = stringToSymbol(name);
+  return n->hasAttribute(symbol) ? n->f(symbol) : default_value;
+}
+
+std::vector<int64_t> intsAttr(Node* n, const char* name, std::vector<int64_t> default_value = {}) {
+  Symbol symbol = stringToSymbol(name);
+  return n->hasAttribute(symbol) ? n->is(symbol) : default_value;
+}
+
+std::string stringAttr(Node* n, const char* name, const std::string& default_value) {
+  Symbol symbol = stringToSymbol(name);
+  return n->hasAttribute(symbol) ? n->s(symbol) : default_value;
+}
+
+// Returns the i-th output, allocating it if it isn't preallocated.  The _out
+// functions of ATen resize it as needed.
+at::Tensor& output(std::vector<at::Tensor>& outputs, size_t i, const at::Tensor& like) {
+  auto& out = outputs.at(i);
+  if (!out.defined())
+    out = like.type().tensor();
+  return out;
+}
+
+// For the results which ATen can't compute into an existing tensor
+void setOutput(std::vector<at::Tensor>& outputs, size_t i, const at::Tensor& value) {
+  auto& out = outputs.at(i);
+  if (out.defined()) {
+    out.copy_(value);
+  } else {
+    out = value;
+  }
+}
+
+// 2d kernels take pairs of sizes.  Pads may also be given separately for the
+// beginning and the end of each dimension, but they have to be symmetric.
+std::vector<int64_t> pairAttr(Node* n, const char* name, int64_t default_value) {
+  auto values = intsAttr(n, name, {default_value, default_value});
+  if (values.size() == 4) {
+    if (values[0] != values[2] || values[1] != values[3])
+      unsupported(n, "asymmetric pads");
+    values.resize(2);
+  }
+  if (values.size() != 2)
+    unsupported(n, std::string("only 2d ") + name + " are supported");
+  return values;
+}
+
+// The old ONNX broadcasting: 'other' matches a contiguous range of the
+// dimensions of 'self', starting at 'axis', or the last dimensions if 'axis'
+// is negative.
+at::Tensor broadcastTo(const at::Tensor& other, const at::Tensor& self, int64_t axis) {
+  if (other.numel() == 1)
+    return other.view({1}).expand(self.sizes());
+  int64_t self_dim = self.dim();
+  int64_t other_dim = other.dim();
+  if (axis < 0)
+    axis = self_dim - other_dim;
+  if (axis < 0 || axis + other_dim > self_dim)
+    throw std::runtime_error("can't broadcast tensors: the second one has too many dimensions");
+  std::vector<int64_t> sizes(self_dim, 1);
+  for (int64_t i = 0; i < other_dim; ++i)
+    sizes[axis + i] = other.size(i);
+  return other.contiguous().view(sizes).expand(self.sizes());
+}
+
+Operator pointwise(Node* n, BinaryFn fn) {
+  bool broadcast = intAttr(n, "broadcast", 0);
+  int64_t axis = intAttr(n, "axis", -1);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    auto other = broadcast ? broadcastTo(inputs.at(1), self, axis) : inputs.at(1);
+    fn(output(outputs, 0, self), self, other);
+  };
+  // A broadcast operand can be split too, but only when it covers the first
+  // dimension, which never happens in practice
+  if (!broadcast) {
+    op.batched_inputs = {true, true};
+  } else if (axis >= 1) {
+    op.batched_inputs = {true, false};
+  }
+  return op;
+}
+
+Operator add(Node* n) {
+  return pointwise(n, [](at::Tensor& out, const at::Tensor& self, const at::Tensor& other) {
+    at::add_out(out, self, other);
+  });
+}
+
+Operator sub(Node* n) {
+  return pointwise(n, [](at::Tensor& out, const at::Tensor& self, const at::Tensor& other) {
+    at::sub_out(out, self, other);
+  });
+}
+
+Operator mul(Node* n) {
+  return pointwise(n, [](at::Tensor& out, const at::Tensor& self, const at::Tensor& other) {
+    at::mul_out(out, self, other);
+  });
+}
+
+Operator div(Node* n) {
+  return pointwise(n, [](at::Tensor& out, const at::Tensor& self, const at::Tensor& other) {
+    at::div_out(out, self, other);
+  });
+}
+
+Operator unary(UnaryFn fn) {
+  Operator op;
+  op.run = [fn](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    fn(output(outputs, 0, self), self);
+  };
+  op.batched_inputs = {true};
+  return op;
+}
+
+Operator neg(Node* n) {
+  return unary([](at::Tensor& out, const at::Tensor& self) { at::neg_out(out, self); });
+}
+
+Operator sigmoid(Node* n) {
+  return unary([](at::Tensor& out, const at::Tensor& self) { at::sigmoid_out(out, self); });
+}
+
+Operator tanh(Node* n) {
+  return unary([](at::Tensor& out, const at::Tensor& self) { at::tanh_out(out, self); });
+}
+
+Operator log(Node* n) {
+  return unary([](at::Tensor& out, const at::Tensor& self) { at::log_out(out, self); });
+}
+
+Operator relu(Node* n) {
+  return unary([](at::Tensor& out, const at::Tensor& self) { at::threshold_out(out, self, 0, 0); });
+}
+
+Operator leaky_relu(Node* n) {
+  double alpha = floatAttr(n, "alpha", 0.01);
+  Operator op;
+  op.run = [alpha](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    at::leaky_relu_out(output(outputs, 0, self), self, alpha);
+  };
+  op.batched_inputs = {true};
+  return op;
+}
+
+Operator prelu(Node* n) {
+  Operator op;
+  op.run = [](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    at::prelu_out(output(outputs, 0, self), self, inputs.at(1));
+  };
+  op.batched_inputs = {true, false};
+  return op;
+}
+
+Operator scale(Node* n) {
+  double scale = floatAttr(n, "scale", 1.0);
+  Operator op;
+  op.run = [scale](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    at::mul_out(output(outputs, 0, self), self, scale);
+  };
+  op.batched_inputs = {true};
+  return op;
+}
+
+// Softmax of ONNX flattens the input into a matrix, whose rows are the
+// dimensions before 'axis'
+Operator softmax(Node* n) {
+  int64_t axis = intAttr(n, "axis", 1);
+  if (axis < 0)
+    unsupported(n, "negative axis");
+  Operator op;
+  op.run = [axis](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& self = inputs.at(0);
+    int64_t rows = 1;
+    for (int64_t i = 0; i < axis; ++i)
+      rows *= self.size(i);
+    int64_t columns = self.numel() / rows;
+    auto& out = output(outputs, 0, self);
+    out.resize_(self.sizes());
+    auto out_matrix = out.view({rows, columns});
+    at::softmax_out(out_matrix, self.contiguous().view({rows, columns}), 1);
+  };
+  if (axis >= 1)
+    op.batched_inputs = {true};
+  return op;
+}
+
+Operator gemm(Node* n) {
+  double alpha = floatAttr(n, "alpha", 1.0);
+  double beta = floatAttr(n, "beta", 1.0);
+  bool broadcast = intAttr(n, "broadcast", 0);
+  bool trans_a = intAttr(n, "transA", 0);
+  bool trans_b = intAttr(n, "transB", 0);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto a = trans_a ? inputs.at(0).t() : inputs.at(0);
+    auto b = trans_b ? inputs.at(1).t() : inputs.at(1);
+    auto c = inputs.at(2);
+    if (broadcast)
+      c = c.expand({a.size(0), b.size(1)});
+    at::addmm_out(output(outputs, 0, a), c, a, b, beta, alpha);
+  };
+  if (!trans_a)
+    op.batched_inputs = {true, false, !broadcast};
+  return op;
+}
+
+// im2col buffers of the convolutions and indices of the max poolings run by
+// a thread.  They are only used during a call, so they can be reused by all
+// the operators.
+struct Scratch {
+  at::Tensor finput;
+  at::Tensor fgrad_input;
+  at::Tensor indices;
+};
+
+Scratch& scratch(const at::Tensor& like) {
+  static thread_local Scratch scratch;
+  if (!scratch.finput.defined() || &scratch.finput.type() != &like.type()) {
+    scratch.finput = like.type().tensor();
+    scratch.fgrad_input = like.type().tensor();
+  }
+  if (!scratch.indices.defined())
+    scratch.indices = at::CPU(at::kLong).tensor();
+  return scratch;
+}
+
+Operator conv(Node* n) {
+  auto kernel_shape = intsAttr(n, "kernel_shape");
+  if (kernel_shape.size() != 2)
+    unsupported(n, "only 2d convolutions are supported");
+  auto strides = pairAttr(n, "strides", 1);
+  auto pads = pairAttr(n, "pads", 0);
+  auto dilations = pairAttr(n, "dilations", 1);
+  int64_t group = intAttr(n, "group", 1);
+  bool dilated = dilations[0] != 1 || dilations[1] != 1;
+
+  auto conv2d = [=](at::Tensor& out, const at::Tensor& input, const at::Tensor& weight,
+                    const at::Tensor& bias) {
+    if (dilated) {
+      at::conv_dilated2d_out(out, input, weight, kernel_shape, bias, strides, pads, dilations);
+    } else {
+      auto& buffers = scratch(input);
+      at::conv2d_forward_out(out, input, weight, kernel_shape, bias, strides, pads,
+                             buffers.finput, buffers.fgrad_input);
+    }
+  };
+
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    auto& weight = inputs.at(1);
+    at::Tensor bias = inputs.size() > 2 ? inputs[2] : at::Tensor();
+    auto& out = output(outputs, 0, input);
+    if (group == 1) {
+      conv2d(out, input, weight, bias);
+      return;
+    }
+
+    // THNN has no grouped convolutions, so every group is computed separately
+    int64_t in_channels = input.size(1) / group;
+    int64_t out_channels = weight.size(0) / group;
+    std::vector<int64_t> sizes {input.size(0), weight.size(0)};
+    for (int i = 0; i < 2; ++i) {
+      int64_t extent = dilations[i] * (kernel_shape[i] - 1) + 1;
+      sizes.push_back((input.size(i + 2) + 2 * pads[i] - extent) / strides[i] + 1);
+    }
+    out.resize_(sizes);
+    auto group_out = input.type().tensor();
+    for (int64_t g = 0; g < group; ++g) {
+      auto group_input = input.narrow(1, g * in_channels, in_channels).contiguous();
+      auto group_weight = weight.narrow(0, g * out_channels, out_channels);
+      auto group_bias = bias.defined() ? bias.narrow(0, g * out_channels, out_channels) : bias;
+      conv2d(group_out, group_input, group_weight, group_bias);
+      out.narrow(1, g * out_channels, out_channels).copy_(group_out);
+    }
+  };
+  op.batched_inputs = {true, false, false};
+  return op;
+}
+
+Operator batch_norm(Node* n) {
+  if (!intAttr(n, "is_test", 0))
+    unsupported(n, "batch normalization in training mode");
+  double eps = floatAttr(n, "epsilon", 1e-5);
+  double momentum = floatAttr(n, "momentum", 0.9);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    at::batch_norm_out(output(outputs, 0, input), input, inputs.at(1), inputs.at(2),
+                       inputs.at(3), inputs.at(4), false, momentum, eps);
+  };
+  op.batched_inputs = {true, false, false, false, false};
+  return op;
+}
+
+Operator max_pool(Node* n) {
+  auto kernel_shape = intsAttr(n, "kernel_shape");
+  if (kernel_shape.size() != 2)
+    unsupported(n, "only 2d pooling is supported");
+  auto strides = pairAttr(n, "strides", 1);
+  auto pads = pairAttr(n, "pads", 0);
+  auto dilations = pairAttr(n, "dilations", 1);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    at::max_pool2d_out(output(outputs, 0, input), scratch(input).indices, input,
+                       kernel_shape, strides, pads, dilations, false);
+  };
+  op.batched_inputs = {true};
+  return op;
+}
+
+Operator average_pool(Node* n) {
+  auto kernel_shape = intsAttr(n, "kernel_shape");
+  if (kernel_shape.size() != 2)
+    unsupported(n, "only 2d pooling is supported");
+  auto strides = pairAttr(n, "strides", 1);
+  auto pads = pairAttr(n, "pads", 0);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    // Like in ONNX, pads aren't counted in the averages
+    at::avg_pool2d_out(output(outputs, 0, input), input, kernel_shape, strides, pads,
+                       false, false);
+  };
+  op.batched_inputs = {true};
+  return op;
+}
+
+Operator concat(Node* n) {
+  int64_t axis = intAttr(n, "axis", 1);
+  Operator op;
+  op.run = [axis](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    at::cat_out(output(outputs, 0, inputs.at(0)), inputs, axis);
+  };
+  if (axis >= 1)
+    op.batched_inputs = std::vector<bool>(n->inputs().size(), true);
+  return op;
+}
+
+Operator pad(Node* n) {
+  if (stringAttr(n, "mode", "constant") != "constant")
+    unsupported(n, "only constant padding is supported");
+  // The exporter calls them paddings, newer versions of ONNX pads
+  auto pads = intsAttr(n, "paddings", intsAttr(n, "pads"));
+  double value = floatAttr(n, "value", 0);
+  if (std::any_of(pads.begin(), pads.end(), [](int64_t p) { return p < 0; }))
+    unsupported(n, "negative pads");
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    int64_t dim = input.dim();
+    if (static_cast<int64_t>(pads.size()) != 2 * dim)
+      throw std::runtime_error("Pad: the number of pads doesn't match the input");
+    std::vector<int64_t> sizes(dim);
+    for (int64_t i = 0; i < dim; ++i)
+      sizes[i] = pads[i] + input.size(i) + pads[i + dim];
+    auto& out = output(outputs, 0, input);
+    out.resize_(sizes);
+    out.fill_(value);
+    auto inner = out;
+    for (int64_t i = 0; i < dim; ++i)
+      inner = inner.narrow(i, pads[i], input.size(i));
+    inner.copy_(input);
+  };
+  if (pads.size() >= 2 && pads[0] == 0 && pads[pads.size() / 2] == 0)
+    op.batched_inputs = {true};
+  return op;
+}
+
+Operator reduce_mean(Node* n) {
+  auto axes = intsAttr(n, "axes");
+  bool keepdims = intAttr(n, "keepdims", 1);
+  Operator op;
+  op.run = [=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto result = inputs.at(0);
+    int64_t dim = result.dim();
+    auto dims = axes;
+    if (dims.empty()) {
+      for (int64_t i = 0; i < dim; ++i)
+        dims.push_back(i);
+    }
+    for (auto& d : dims) {
+      if (d < 0) d += dim;
+    }
+    // Reduce the last dimensions first, so that the others keep their indices
+    std::sort(dims.rbegin(), dims.rend());
+    for (auto d : dims)
+      result = result.mean(d, keepdims);
+    setOutput(outputs, 0, result);
+  };
+  if (!axes.empty() && std::all_of(axes.begin(), axes.end(), [](int64_t a) { return a >= 1; }))
+    op.batched_inputs = {true};
+  return op;
+}
+
+Operator viewOperator(Kernel kernel) {
+  Operator op;
+  op.run = std::move(kernel);
+  op.is_view = true;
+  return op;
+}
+
+Operator reshape(Node* n) {
+  auto shape = intsAttr(n, "shape");
+  return viewOperator([shape](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    auto sizes = shape;
+    // 0 keeps the size of the input, -1 is inferred by view
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      if (sizes[i] == 0)
+        sizes[i] = input.size(i);
+    }
+    outputs.at(0) = input.contiguous().view(sizes);
+  });
+}
+
+Operator transpose(Node* n) {
+  auto perm = intsAttr(n, "perm");
+  return viewOperator([perm](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    auto dims = perm;
+    // By default, the dimensions are reversed
+    if (dims.empty()) {
+      for (int64_t i = input.dim() - 1; i >= 0; --i)
+        dims.push_back(i);
+    }
+    outputs.at(0) = input.permute(dims);
+  });
+}
+
+Operator squeeze(Node* n) {
+  auto axes = intsAttr(n, "axes");
+  std::sort(axes.rbegin(), axes.rend());
+  return viewOperator([axes](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto result = inputs.at(0);
+    for (auto axis : axes)
+      result = result.squeeze(axis);
+    outputs.at(0) = result;
+  });
+}
+
+Operator slice(Node* n) {
+  auto starts = intsAttr(n, "starts");
+  auto ends = intsAttr(n, "ends");
+  auto axes = intsAttr(n, "axes");
+  if (starts.size() != ends.size() || (!axes.empty() && axes.size() != starts.size()))
+    unsupported(n, "starts, ends and axes have different lengths");
+  if (axes.empty()) {
+    for (size_t i = 0; i < starts.size(); ++i)
+      axes.push_back(i);
+  }
+  return viewOperator([=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto result = inputs.at(0);
+    for (size_t i = 0; i < axes.size(); ++i) {
+      int64_t size = result.size(axes[i]);
+      int64_t start = starts[i] < 0 ? starts[i] + size : starts[i];
+      int64_t end = ends[i] < 0 ? ends[i] + size : ends[i];
+      start = std::min(std::max<int64_t>(start, 0), size);
+      end = std::min(std::max(end, start), size);
+      result = result.narrow(axes[i], start, end - start);
+    }
+    outputs.at(0) = result;
+  });
+}
+
+Operator split(Node* n) {
+  int64_t axis = intAttr(n, "axis", 0);
+  auto split = intsAttr(n, "split");
+  return viewOperator([=](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    auto& input = inputs.at(0);
+    auto sizes = split;
+    // Without sizes, the input is split into equal parts
+    if (sizes.empty())
+      sizes.assign(outputs.size(), input.size(axis) / outputs.size());
+    if (sizes.size() != outputs.size())
+      throw std::runtime_error("Split: the number of parts doesn't match the outputs");
+    int64_t offset = 0;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      outputs[i] = input.narrow(axis, offset, sizes[i]);
+      offset += sizes[i];
+    }
+  });
+}
+
+Operator dropout(Node* n) {
+  if (!intAttr(n, "is_test", 0))
+    unsupported(n, "dropout in training mode");
+  // The mask isn't computed
+  return viewOperator([](const std::vector<at::Tensor>& inputs, std::vector<at::Tensor>& outputs) {
+    outputs.at(0) = inputs.at(0);
+  });
+}
+
+const std::unordered_map<Symbol, OperatorCreator>& operators() {
+  static std::unordered_map<Symbol, OperatorCreator> operators = {
+    {kAdd, add},
+    {kSub, sub},
+    {kMul, mul},
+    {kDiv, div},
+    {kNeg, neg},
+    {kSigmoid, sigmoid},
+    {kTanh, tanh},
+    {stringToSymbol("Log"), log},
+    {stringToSymbol("Relu"), relu},
+    {stringToSymbol("LeakyRelu"), leaky_relu},
+    {stringToSymbol("PRelu"), prelu},
+    {kScale, scale},
+    {stringToSymbol("Softmax"), softmax},
+    {kGemm, gemm},
+    {kConv, conv},
+    {kSpatialBN, batch_norm},
+    {stringToSymbol("MaxPool"), max_pool},
+    {stringToSymbol("AveragePool"), average_pool},
+    {stringToSymbol("Concat"), concat},
+    {stringToSymbol("Pad"), pad},
+    {stringToSymbol("ReduceMean"), reduce_mean},
+    {kReshape, reshape},
+    {kTranspose, transpose},
+    {kSqueeze, squeeze},
+    {kSlice, slice},
+    {stringToSymbol("Split"), split},
+    {stringToSymbol("Dropout"), dropout},
+  };
+  return operators;
+}
+
+} // anonymous namespace
+
+Operator getOperator(Node* n) {
+  auto& all_operators = operators();
+  auto it = all_operators.find(n->kind());
+  if (it == all_operators.end())
+    unsupported(n, "no kernel");
+  return it->second(n);
+}
+
+}}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+#include <functional>
+
+namespace torch { namespace jit {
+
+// Note [Preallocated outputs]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The runtime decides where the outputs of most operators are stored: once it
+// has seen the sizes of all values, it gives operators outputs which already
+// have the right type and size (e.g. a part of its memory arena).  A kernel
+// has to write such an output in place and never replace it.  Outputs which
+// are undefined are allocated by the kernel.
+//
+// Operators whose outputs are views of their inputs (e.g. Reshape) never get
+// preallocated outputs.
+using Kernel = std::function<void(const std::vector<at::Tensor>& inputs,
+                                  std::vector<at::Tensor>& outputs)>;
+
+struct Operator {
+  Kernel run;
+  // The outputs are views of the inputs.  See Note [Preallocated outputs]
+  bool is_view = false;
+  // The inputs which can be split along their first dimension into parts that
+  // are computed independently, each writing to the same part of the first
+  // dimension of the outputs.  Empty if the operator can't be split.
+  std::vector<bool> batched_inputs;
+};
+
+// Returns the kernel of an ONNX operator.  Attributes are read once, here.
+// Throws if the operator, or the particular form of it, isn't supported.
+Operator getOperator(Node* n);
+
+}}
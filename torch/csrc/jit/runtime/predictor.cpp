@@ -0,0 +1,393 @@
+#include "torch/csrc/jit/runtime/predictor.h"
+
+#include "torch/csrc/jit/passes/common_subexpression_elimination.h"
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+#include "torch/csrc/jit/passes/peephole.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// Buffers in the arena start at multiples of this many bytes
+constexpr size_t kArenaAlignment = 64;
+
+// Splitting an operator between threads only pays off when its outputs have
+// at least this many elements
+constexpr int64_t kMinParallelElements = 1 << 14;
+
+std::vector<int64_t> contiguousStrides(const std::vector<int64_t>& sizes) {
+  std::vector<int64_t> strides(sizes.size());
+  int64_t stride = 1;
+  for (size_t i = sizes.size(); i-- > 0;) {
+    strides[i] = stride;
+    stride *= sizes[i];
+  }
+  return strides;
+}
+
+// Returns the size of the first dimension of the inputs along which the
+// operator can be split, or 0 if it can't be split
+int64_t splitSize(const Operator& op, const std::vector<at::Tensor>& inputs,
+                  const std::vector<at::Tensor>& outputs) {
+  int64_t size = -1;
+  for (size_t i = 0; i < inputs.size() && i < op.batched_inputs.size(); ++i) {
+    if (!op.batched_inputs[i])
+      continue;
+    auto& input = inputs[i];
+    if (!input.defined() || input.dim() == 0)
+      return 0;
+    if (size < 0) {
+      size = input.size(0);
+    } else if (input.size(0) != size) {
+      return 0;
+    }
+  }
+  if (size < 2)
+    return 0;
+
+  // Parts of the outputs are written by different threads, so they have to be
+  // preallocated
+  int64_t elements = 0;
+  for (auto& output : outputs) {
+    if (!output.defined() || output.dim() == 0 || output.size(0) != size)
+      return 0;
+    elements += output.numel();
+  }
+  return elements >= kMinParallelElements ? size : 0;
+}
+
+} // anonymous namespace
+
+Program::Program(std::shared_ptr<Graph> graph_, std::vector<at::Tensor> initializers)
+  : graph(std::move(graph_)) {
+  PeepholeOptimize(graph);
+  EliminateCommonSubexpression(graph);
+  EliminateDeadCode(graph);
+  graph->lint();
+
+  std::unordered_map<Node*, size_t> registers;
+  auto newRegister = [&](Node* n) {
+    size_t r = registers.size();
+    registers[n] = r;
+    return r;
+  };
+
+  auto graph_inputs = graph->inputs();
+  if (initializers.size() > graph_inputs.size())
+    throw std::runtime_error("the graph has fewer inputs than initializers");
+  size_t num_inputs = graph_inputs.size() - initializers.size();
+  for (size_t i = 0; i < graph_inputs.size(); ++i) {
+    size_t r = newRegister(graph_inputs[i]);
+    if (i < num_inputs) {
+      inputs.push_back(r);
+    } else {
+      constants.emplace_back(r, initializers[i - num_inputs]);
+    }
+  }
+
+  for (auto n : graph->nodes()) {
+    // Selects get their registers with the nodes they select from
+    if (n->kind() == kSelect)
+      continue;
+    if (n->kind() == kConstant) {
+      constants.emplace_back(newRegister(n), n->t(kvalue));
+      continue;
+    }
+    if (n->kind() == kUndefined) {
+      constants.emplace_back(newRegister(n), at::Tensor());
+      continue;
+    }
+
+    Instruction instruction;
+    instruction.kind = n->kind();
+    instruction.op = getOperator(n);
+    for (auto input : n->inputs())
+      instruction.inputs.push_back(registers.at(input));
+    if (n->hasMultipleOutputs()) {
+      for (auto select : n->outputs()) {
+        size_t offset = select->offset();
+        if (instruction.outputs.size() <= offset)
+          instruction.outputs.resize(offset + 1, -1);
+        instruction.outputs[offset] = newRegister(select);
+      }
+    } else {
+      instruction.outputs.push_back(newRegister(n));
+    }
+    instructions.push_back(std::move(instruction));
+  }
+  for (auto output : graph->outputs())
+    outputs.push_back(registers.at(output));
+  num_registers = registers.size();
+
+  // Liveness of the registers and of their memory
+  owner.resize(num_registers);
+  std::iota(owner.begin(), owner.end(), 0);
+  first_use.assign(num_registers, 0);
+  last_use.assign(num_registers, 0);
+  escapes.assign(num_registers, false);
+  std::vector<int64_t> last_read(num_registers, -1);
+  std::vector<int64_t> defined_by(num_registers, -1);
+  for (size_t pc = 0; pc < instructions.size(); ++pc) {
+    auto& instruction = instructions[pc];
+    for (auto r : instruction.inputs) {
+      last_use[owner[r]] = std::max(last_use[owner[r]], pc);
+      last_read[r] = pc;
+    }
+    for (auto r : instruction.outputs) {
+      if (r < 0)
+        continue;
+      first_use[r] = last_use[r] = pc;
+      defined_by[r] = pc;
+      if (instruction.op.is_view)
+        owner[r] = owner[instruction.inputs.at(0)];
+    }
+  }
+  std::vector<bool> keep(num_registers, false);
+  for (auto r : outputs) {
+    keep[r] = true;
+    escapes[owner[r]] = true;
+  }
+  for (auto& constant : constants)
+    keep[constant.first] = true;
+
+  // Registers are cleared after their last use, or right after they're
+  // defined if they're never used.  Constants and outputs are kept.
+  for (size_t r = 0; r < num_registers; ++r) {
+    if (keep[r])
+      continue;
+    if (last_read[r] >= 0) {
+      instructions[last_read[r]].free.push_back(r);
+    } else if (defined_by[r] >= 0) {
+      instructions[defined_by[r]].free.push_back(r);
+    }
+  }
+}
+
+struct Predictor::MemoryPlan {
+  MemoryPlan(const std::vector<at::Tensor>& inputs, size_t num_registers)
+    : types(num_registers, nullptr)
+    , sizes(num_registers)
+    , buffers(num_registers) {
+    for (auto& input : inputs) {
+      input_types.push_back(&input.type());
+      input_sizes.push_back(input.sizes().vec());
+    }
+  }
+
+  bool matches(const std::vector<at::Tensor>& inputs) const {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto sizes = inputs[i].sizes();
+      if (&inputs[i].type() != input_types[i] ||
+          sizes.size() != input_sizes[i].size() ||
+          !std::equal(sizes.begin(), sizes.end(), input_sizes[i].begin()))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns the preallocated output for a register, if it has one
+  at::Tensor output(size_t r) const {
+    if (buffers[r].defined())
+      return buffers[r];
+    if (types[r])
+      return types[r]->tensor(sizes[r]);
+    return at::Tensor();
+  }
+
+  std::vector<const at::Type*> input_types;
+  std::vector<std::vector<int64_t>> input_sizes;
+  // Types and sizes of the outputs of the instructions, except for views.
+  // Those which aren't in the arena are allocated on every run, because
+  // they are returned to the caller.
+  std::vector<const at::Type*> types;
+  std::vector<std::vector<int64_t>> sizes;
+  // Views of the arenas
+  std::vector<at::Tensor> buffers;
+  // One arena per scalar type
+  std::vector<std::unique_ptr<at::Storage>> arenas;
+  size_t arena_bytes = 0;
+};
+
+Predictor::Predictor(std::shared_ptr<const Program> program, std::shared_ptr<ThreadPool> pool)
+  : program_(std::move(program))
+  , pool_(std::move(pool))
+  , registers_(program_->num_registers)
+  , is_constant_(program_->num_registers, false) {
+  for (auto& constant : program_->constants) {
+    registers_[constant.first] = constant.second;
+    is_constant_[constant.first] = true;
+  }
+}
+
+Predictor::~Predictor() {}
+
+size_t Predictor::arenaSize() const {
+  return plan_ ? plan_->arena_bytes : 0;
+}
+
+std::vector<at::Tensor> Predictor::run(const std::vector<at::Tensor>& inputs) {
+  auto& program = *program_;
+  if (inputs.size() != program.inputs.size()) {
+    throw std::runtime_error("expected " + std::to_string(program.inputs.size()) +
+                             " inputs, but got " + std::to_string(inputs.size()));
+  }
+  for (size_t i = 0; i < inputs.size(); ++i)
+    registers_[program.inputs[i]] = inputs[i];
+
+  // Without a plan for these sizes, the sizes of all values are recorded
+  MemoryPlan* plan = plan_ && plan_->matches(inputs) ? plan_.get() : nullptr;
+  std::unique_ptr<MemoryPlan> profile;
+  if (!plan)
+    profile.reset(new MemoryPlan(inputs, program.num_registers));
+
+  std::vector<at::Tensor> instruction_inputs;
+  std::vector<at::Tensor> instruction_outputs;
+  std::vector<void*> planned_data;
+  for (auto& instruction : program.instructions) {
+    bool preallocate = plan && !instruction.op.is_view;
+    instruction_inputs.clear();
+    for (auto r : instruction.inputs)
+      instruction_inputs.push_back(registers_[r]);
+    instruction_outputs.assign(instruction.outputs.size(), at::Tensor());
+    planned_data.assign(instruction.outputs.size(), nullptr);
+    if (preallocate) {
+      for (size_t i = 0; i < instruction.outputs.size(); ++i) {
+        if (instruction.outputs[i] < 0)
+          continue;
+        instruction_outputs[i] = plan->output(instruction.outputs[i]);
+        if (instruction_outputs[i].defined())
+          planned_data[i] = instruction_outputs[i].data_ptr();
+      }
+    }
+
+    execute(instruction, instruction_inputs, instruction_outputs);
+
+    for (size_t i = 0; i < instruction.outputs.size(); ++i) {
+      int64_t r = instruction.outputs[i];
+      if (r < 0)
+        continue;
+      auto& value = instruction_outputs[i];
+      // See Note [Preallocated outputs]
+      if (planned_data[i] && value.data_ptr() != planned_data[i]) {
+        throw std::runtime_error(std::string("the memory plan doesn't match the output of ") +
+                                 symbolToString(instruction.kind));
+      }
+      if (profile && !instruction.op.is_view && value.defined()) {
+        profile->types[r] = &value.type();
+        profile->sizes[r] = value.sizes().vec();
+      }
+      registers_[r] = std::move(value);
+    }
+    for (auto r : instruction.free)
+      registers_[r] = at::Tensor();
+  }
+
+  std::vector<at::Tensor> outputs;
+  for (auto r : program.outputs)
+    outputs.push_back(registers_[r]);
+  // Only the constants are kept between runs
+  for (auto r : program.inputs)
+    registers_[r] = at::Tensor();
+  for (auto r : program.outputs) {
+    if (!is_constant_[r])
+      registers_[r] = at::Tensor();
+  }
+
+  if (profile) {
+    planMemory(*profile);
+    plan_ = std::move(profile);
+  }
+  return outputs;
+}
+
+void Predictor::execute(const Program::Instruction& instruction,
+                        const std::vector<at::Tensor>& inputs,
+                        std::vector<at::Tensor>& outputs) {
+  auto& op = instruction.op;
+  int64_t size = pool_ && pool_->numThreads() > 1 ? splitSize(op, inputs, outputs) : 0;
+  if (size == 0) {
+    op.run(inputs, outputs);
+    return;
+  }
+
+  pool_->parallelFor(size, [&](int64_t begin, int64_t end) {
+    std::vector<at::Tensor> part_inputs(inputs);
+    std::vector<at::Tensor> part_outputs(outputs.size());
+    for (size_t i = 0; i < inputs.size() && i < op.batched_inputs.size(); ++i) {
+      if (op.batched_inputs[i])
+        part_inputs[i] = inputs[i].narrow(0, begin, end - begin);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i)
+      part_outputs[i] = outputs[i].narrow(0, begin, end - begin);
+    op.run(part_inputs, part_outputs);
+  });
+}
+
+// Places the values in the arenas.  Values which are alive at the same time
+// get disjoint parts of the arena: they are placed from the largest to the
+// smallest, each at the lowest offset where it doesn't overlap the values
+// placed before it that it is alive with.
+void Predictor::planMemory(MemoryPlan& plan) {
+  auto& program = *program_;
+  std::map<const at::Type*, std::vector<size_t>> values_by_type;
+  for (size_t r = 0; r < program.num_registers; ++r) {
+    if (plan.types[r] && program.owner[r] == r && !program.escapes[r])
+      values_by_type[plan.types[r]].push_back(r);
+  }
+
+  std::vector<size_t> offsets(program.num_registers);
+  std::vector<size_t> sizes(program.num_registers);
+  for (auto& entry : values_by_type) {
+    auto type = entry.first;
+    auto& values = entry.second;
+    size_t element_size = type->elementSizeInBytes();
+    size_t alignment = std::max<size_t>(kArenaAlignment / element_size, 1);
+    for (auto r : values) {
+      size_t numel = std::accumulate(plan.sizes[r].begin(), plan.sizes[r].end(),
+                                     size_t(1), std::multiplies<size_t>());
+      sizes[r] = (numel + alignment - 1) / alignment * alignment;
+    }
+    std::stable_sort(values.begin(), values.end(), [&](size_t a, size_t b) {
+      return sizes[a] > sizes[b];
+    });
+
+    size_t arena_size = 0;
+    std::vector<size_t> placed;
+    std::vector<std::pair<size_t, size_t>> conflicts;
+    for (auto r : values) {
+      conflicts.clear();
+      for (auto other : placed) {
+        if (program.first_use[other] <= program.last_use[r] &&
+            program.first_use[r] <= program.last_use[other])
+          conflicts.emplace_back(offsets[other], offsets[other] + sizes[other]);
+      }
+      std::sort(conflicts.begin(), conflicts.end());
+      size_t offset = 0;
+      for (auto& conflict : conflicts) {
+        if (offset + sizes[r] <= conflict.first)
+          break;
+        offset = std::max(offset, conflict.second);
+      }
+      offsets[r] = offset;
+      arena_size = std::max(arena_size, offset + sizes[r]);
+      placed.push_back(r);
+    }
+    if (arena_size == 0)
+      continue;
+
+    auto arena = type->storage(arena_size);
+    for (auto r : values) {
+      plan.buffers[r] = type->tensor(*arena, offsets[r], plan.sizes[r],
+                                     contiguousStrides(plan.sizes[r]));
+    }
+    plan.arena_bytes += arena_size * element_size;
+    plan.arenas.push_back(std::move(arena));
+  }
+}
+
+}}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/runtime/operators.h"
+#include "torch/csrc/jit/runtime/thread_pool.h"
+
+#include <memory>
+
+namespace torch { namespace jit {
+
+// A graph compiled for inference.  The graph is optimized and its nodes are
+// turned into instructions, which read and write numbered registers.  A
+// Program is never modified once it's built, so the predictors of many
+// threads can share it.
+struct Program {
+  // Runs the optimization passes on 'graph', which is modified, and binds
+  // 'initializers' to its last inputs (see ImportGraph).
+  Program(std::shared_ptr<Graph> graph, std::vector<at::Tensor> initializers);
+
+  struct Instruction {
+    Symbol kind;
+    Operator op;
+    std::vector<size_t> inputs;
+    // -1 for the outputs which aren't used
+    std::vector<int64_t> outputs;
+    // Registers which aren't used after this instruction
+    std::vector<size_t> free;
+  };
+
+  std::shared_ptr<Graph> graph;
+  std::vector<Instruction> instructions;
+  size_t num_registers;
+  std::vector<size_t> inputs;
+  std::vector<size_t> outputs;
+  // Initializers and Constant nodes, which are set once
+  std::vector<std::pair<size_t, at::Tensor>> constants;
+
+  // Liveness of the memory of the registers, used to plan the memory arena.
+  // The memory of a register is owned by the register it is a view of, or by
+  // itself.  The owners are in use from the instruction defining them to the
+  // last instruction using them or one of their views.
+  std::vector<size_t> owner;
+  std::vector<size_t> first_use;
+  std::vector<size_t> last_use;
+  // The memory is returned to the caller, so it can't be in the arena
+  std::vector<bool> escapes;
+};
+
+// Runs a Program.  The first run with inputs of new sizes records the sizes of
+// all values, which are then used to plan the memory of the next runs: the
+// values which don't outlive a run are placed in a single arena, where
+// values that are never alive at the same time share memory, and the
+// operators write to it in place.  Operators which can be split along the
+// batch dimension are run in parallel on the threads of the pool.
+//
+// A predictor isn't thread safe.  Serving threads should each use their own,
+// sharing the Program and possibly the pool.  The pool replaces the OpenMP
+// parallelism of TH, which should be limited to a single thread.
+struct Predictor {
+  explicit Predictor(std::shared_ptr<const Program> program,
+                     std::shared_ptr<ThreadPool> pool = nullptr);
+  ~Predictor();
+
+  std::vector<at::Tensor> run(const std::vector<at::Tensor>& inputs);
+
+  // Size of the memory arena in bytes, 0 until memory is planned
+  size_t arenaSize() const;
+
+private:
+  struct MemoryPlan;
+
+  void execute(const Program::Instruction& instruction,
+               const std::vector<at::Tensor>& inputs,
+               std::vector<at::Tensor>& outputs);
+  void planMemory(MemoryPlan& plan);
+
+  std::shared_ptr<const Program> program_;
+  std::shared_ptr<ThreadPool> pool_;
+  std::vector<at::Tensor> registers_;
+  std::vector<bool> is_constant_;
+  std::unique_ptr<MemoryPlan> plan_;
+};
+
+}}
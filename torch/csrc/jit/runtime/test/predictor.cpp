@@ -0,0 +1,215 @@
+#include "torch/csrc/jit/runtime/import.h"
+#include "torch/csrc/jit/runtime/predictor.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace torch::jit;
+
+// Writes the few parts of the protobuf wire format which ONNX models use
+struct ProtoWriter {
+  ProtoWriter& varint(uint32_t field, uint64_t value) {
+    key(field, 0);
+    rawVarint(value);
+    return *this;
+  }
+
+  ProtoWriter& float32(uint32_t field, float value) {
+    key(field, 5);
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    return *this;
+  }
+
+  ProtoWriter& bytes(uint32_t field, const std::string& value) {
+    key(field, 2);
+    rawVarint(value.size());
+    data += value;
+    return *this;
+  }
+
+  ProtoWriter& message(uint32_t field, const ProtoWriter& value) {
+    return bytes(field, value.data);
+  }
+
+  void key(uint32_t field, int wire_type) {
+    rawVarint((field << 3) | wire_type);
+  }
+
+  void rawVarint(uint64_t value) {
+    while (value >= 0x80) {
+      data.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+  }
+
+  std::string data;
+};
+
+ProtoWriter tensorProto(const std::string& name, const at::Tensor& tensor) {
+  ProtoWriter proto;
+  for (auto size : tensor.sizes())
+    proto.varint(1, size);
+  proto.varint(2, 1); // FLOAT
+  proto.bytes(8, name);
+  proto.bytes(9, std::string(static_cast<const char*>(tensor.data_ptr()),
+                             tensor.numel() * sizeof(float)));
+  return proto;
+}
+
+ProtoWriter valueInfo(const std::string& name, const std::vector<int64_t>& sizes) {
+  ProtoWriter shape;
+  for (auto size : sizes)
+    shape.message(1, ProtoWriter().varint(1, size));
+  ProtoWriter tensor_type;
+  tensor_type.varint(1, 1).message(2, shape);
+  ProtoWriter value_info;
+  value_info.bytes(1, name).message(2, ProtoWriter().message(1, tensor_type));
+  return value_info;
+}
+
+ProtoWriter intAttr(const std::string& name, int64_t value) {
+  return ProtoWriter().bytes(1, name).varint(3, value);
+}
+
+ProtoWriter intsAttr(const std::string& name, const std::vector<int64_t>& values) {
+  ProtoWriter attr;
+  attr.bytes(1, name);
+  for (auto value : values)
+    attr.varint(8, value);
+  return attr;
+}
+
+ProtoWriter node(const std::string& op_type, const std::vector<std::string>& inputs,
+                 const std::string& output, const std::vector<ProtoWriter>& attrs = {}) {
+  ProtoWriter proto;
+  for (auto& input : inputs)
+    proto.bytes(1, input);
+  proto.bytes(2, output);
+  proto.bytes(4, op_type);
+  for (auto& attr : attrs)
+    proto.message(5, attr);
+  return proto;
+}
+
+struct Model {
+  Model(int64_t batch_size)
+    : conv_weight(at::CPU(at::kFloat).randn({16, 3, 3, 3}))
+    , conv_bias(at::CPU(at::kFloat).randn({16}))
+    , fc_weight(at::CPU(at::kFloat).randn({10, 16 * 8 * 8}))
+    , fc_bias(at::CPU(at::kFloat).randn({10})) {
+    ProtoWriter graph;
+    graph.message(1, node("Conv", {"x", "conv_weight"}, "1", {
+      intsAttr("kernel_shape", {3, 3}), intsAttr("pads", {1, 1, 1, 1}),
+      intsAttr("strides", {1, 1}), intsAttr("dilations", {1, 1}), intAttr("group", 1)}));
+    graph.message(1, node("Add", {"1", "conv_bias"}, "2", {intAttr("broadcast", 1), intAttr("axis", 1)}));
+    // The same Relu twice, one of them is removed by CSE
+    graph.message(1, node("Relu", {"2"}, "3"));
+    graph.message(1, node("Relu", {"2"}, "4"));
+    graph.message(1, node("Add", {"3", "4"}, "5"));
+    graph.message(1, node("MaxPool", {"5"}, "6", {
+      intsAttr("kernel_shape", {2, 2}), intsAttr("strides", {2, 2}), intsAttr("pads", {0, 0, 0, 0})}));
+    graph.message(1, node("Reshape", {"6"}, "7", {intsAttr("shape", {0, -1})}));
+    graph.message(1, node("Gemm", {"7", "fc_weight", "fc_bias"}, "8", {
+      intAttr("transB", 1), intAttr("broadcast", 1)}));
+    graph.message(1, node("Softmax", {"8"}, "9"));
+    graph.message(5, tensorProto("conv_weight", conv_weight));
+    graph.message(5, tensorProto("conv_bias", conv_bias));
+    graph.message(5, tensorProto("fc_weight", fc_weight));
+    graph.message(5, tensorProto("fc_bias", fc_bias));
+    graph.message(11, valueInfo("x", {batch_size, 3, 16, 16}));
+    graph.message(11, valueInfo("conv_weight", conv_weight.sizes().vec()));
+    graph.message(11, valueInfo("conv_bias", conv_bias.sizes().vec()));
+    graph.message(11, valueInfo("fc_weight", fc_weight.sizes().vec()));
+    graph.message(11, valueInfo("fc_bias", fc_bias.sizes().vec()));
+    graph.message(12, valueInfo("9", {batch_size, 10}));
+    serialized = ProtoWriter().varint(1, 3).message(7, graph).data;
+  }
+
+  at::Tensor expected(const at::Tensor& x) {
+    auto conv = at::conv_dilated2d(x, conv_weight, {3, 3}, conv_bias, {1, 1}, {1, 1}, {1, 1});
+    auto relu = at::threshold(conv, 0, 0);
+    auto pool = std::get<0>(at::max_pool2d(relu + relu, {2, 2}, {2, 2}));
+    auto flat = pool.contiguous().view({x.size(0), -1});
+    auto fc = at::addmm(fc_bias.expand({x.size(0), 10}), flat, fc_weight.t());
+    return at::softmax(fc, 1);
+  }
+
+  at::Tensor conv_weight, conv_bias, fc_weight, fc_bias;
+  std::string serialized;
+};
+
+void assertClose(const at::Tensor& actual, const at::Tensor& expected) {
+  assert(actual.sizes().equals(expected.sizes()));
+  auto error = (actual - expected).abs().max().toDouble();
+  assert(error < 1e-5);
+}
+
+std::shared_ptr<Program> compile(Model& model) {
+  std::vector<at::Tensor> initializers;
+  auto graph = ImportGraph(model.serialized, initializers);
+  assert(graph->inputs().size() == 5);
+  assert(initializers.size() == 4);
+  return std::make_shared<Program>(graph, initializers);
+}
+
+void testOptimizations() {
+  Model model(4);
+  auto program = compile(model);
+  size_t num_relus = 0;
+  for (auto& instruction : program->instructions)
+    num_relus += instruction.kind == stringToSymbol("Relu");
+  assert(num_relus == 1);
+  assert(program->inputs.size() == 1);
+  assert(program->outputs.size() == 1);
+}
+
+void testRun(std::shared_ptr<ThreadPool> pool) {
+  Model model(4);
+  Predictor predictor(compile(model), pool);
+
+  // The first run records the sizes, the next ones use the memory plan
+  std::vector<at::Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    auto x = at::CPU(at::kFloat).randn({4, 3, 16, 16});
+    auto expected = model.expected(x);
+    auto previous = outputs;
+    outputs = predictor.run({x});
+    assert(outputs.size() == 1);
+    assertClose(outputs[0], expected);
+    assert(predictor.arenaSize() > 0);
+    // Outputs are never in the arena, so the next run doesn't overwrite them
+    if (!previous.empty())
+      assert(previous[0].data_ptr() != outputs[0].data_ptr());
+  }
+
+  // New sizes are profiled and planned again
+  for (int i = 0; i < 2; ++i) {
+    auto x = at::CPU(at::kFloat).randn({3, 3, 16, 16});
+    assertClose(predictor.run({x})[0], model.expected(x));
+  }
+  auto x = at::CPU(at::kFloat).randn({4, 3, 16, 16});
+  assertClose(predictor.run({x})[0], model.expected(x));
+}
+
+void testWrongInputs() {
+  Model model(4);
+  Predictor predictor(compile(model));
+  bool thrown = false;
+  try {
+    predictor.run({});
+  } catch (std::runtime_error& e) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+int main() {
+  testOptimizations();
+  testRun(nullptr);
+  testRun(std::make_shared<ThreadPool>(3));
+  testWrongInputs();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include "torch/csrc/jit/runtime/thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace torch { namespace jit {
+
+ThreadPool::ThreadPool(size_t num_threads)
+  : stop_(false) {
+  for (size_t i = 1; i < num_threads; ++i)
+    threads_.emplace_back(&ThreadPool::workerMain, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  task_available_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+void ThreadPool::workerMain() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+namespace {
+
+// Counts the ranges of a parallelFor which are still running
+struct Latch {
+  explicit Latch(size_t count) : count(count) {}
+
+  void done(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error && !first_error)
+      first_error = error;
+    if (--count == 0)
+      finished.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return count == 0; });
+    if (first_error)
+      std::rethrow_exception(first_error);
+  }
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t count;
+  std::exception_ptr first_error;
+};
+
+} // anonymous namespace
+
+void ThreadPool::parallelFor(int64_t size, const std::function<void(int64_t, int64_t)>& fn) {
+  int64_t num_ranges = std::min<int64_t>(size, numThreads());
+  if (num_ranges <= 1) {
+    if (size > 0)
+      fn(0, size);
+    return;
+  }
+
+  auto bounds = [&](int64_t i) {
+    return size * i / num_ranges;
+  };
+  Latch latch(num_ranges);
+  auto run = [&](int64_t i) {
+    std::exception_ptr error;
+    try {
+      fn(bounds(i), bounds(i + 1));
+    } catch (...) {
+      error = std::current_exception();
+    }
+    latch.done(error);
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int64_t i = 1; i < num_ranges; ++i)
+      tasks_.emplace_back([&run, i] { run(i); });
+  }
+  task_available_.notify_all();
+  run(0);
+  latch.wait();
+}
+
+}}
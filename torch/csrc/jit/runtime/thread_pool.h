@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// Runs the parts of single operators in parallel.  A pool can be shared by
+// predictors running on different threads: every call to parallelFor waits
+// only for its own parts.
+struct ThreadPool {
+  // 'num_threads' includes the threads calling parallelFor, so the pool
+  // starts num_threads - 1 threads of its own.
+  explicit ThreadPool(size_t num_threads);
+  ~ThreadPool();
+
+  size_t numThreads() const {
+    return threads_.size() + 1;
+  }
+
+  // Splits [0, size) into up to numThreads() ranges of similar sizes and calls
+  // fn(begin, end) on each of them, one of them on the calling thread.
+  // Returns when all of them are done, rethrowing the first exception.
+  void parallelFor(int64_t size, const std::function<void(int64_t, int64_t)>& fn);
+
+private:
+  void workerMain();
+
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::deque<std::function<void()>> tasks_;
+  bool stop_;
+  std::vector<std::thread> threads_;
+};
+
+}}
@@ -29,15 +29,59 @@ bool micropb_encode<Dimension, nullptr>(pb_ostream_t *stream, Dimension* arg) {
                               static_cast<void*>(arg));
 }
 
+bool micropb_encode_submessage(pb_ostream_t *stream, const pb_field_t fields[],
+                               const void *src_struct, size_t *size) {
+  if (*size == kUnknownSize) {
+    pb_ostream_t sizing_stream = PB_OSTREAM_SIZING;
+    if (!pb_encode(&sizing_stream, fields, src_struct)) {
+#ifndef PB_NO_ERRMSG
+      stream->errmsg = sizing_stream.errmsg;
+#endif
+      return false;
+    }
+    *size = sizing_stream.bytes_written;
+  }
+
+  if (!pb_encode_varint(stream, static_cast<uint64_t>(*size)))
+    return false;
+  if (stream->callback == nullptr)
+    return pb_write(stream, nullptr, *size); // just sizing
+
+  if (stream->bytes_written + *size > stream->max_size)
+    PB_RETURN_ERROR(stream, "stream full");
+
+  // The rest is the same as in pb_encode_submessage
+  pb_ostream_t substream;
+  substream.callback = stream->callback;
+  substream.state = stream->state;
+  substream.max_size = *size;
+  substream.bytes_written = 0;
+#ifndef PB_NO_ERRMSG
+  substream.errmsg = nullptr;
+#endif
+
+  bool status = pb_encode(&substream, fields, src_struct);
+
+  stream->bytes_written += substream.bytes_written;
+  stream->state = substream.state;
+#ifndef PB_NO_ERRMSG
+  stream->errmsg = substream.errmsg;
+#endif
+
+  if (substream.bytes_written != *size)
+    PB_RETURN_ERROR(stream, "submessage size changed");
+
+  return status;
+}
+
 // TODO: I'm not entirely sure why this can't be in the header...
 bool micropb_callback_string_from_tensor(pb_ostream_t *stream, const pb_field_t *field, void * const *arg) {
   at::Tensor* t = static_cast<at::Tensor*>(*arg);
   JIT_ASSERT(t->is_contiguous());
-  // Packed array format!
-  pb_encode_tag_for_field(stream, field);
-  pb_encode_string(stream, (pb_byte_t*)(t->data_ptr()),  t->type().elementSizeInBytes()*t->numel());
-
-  return true;
+  // Packed array format!  The data is passed to the stream straight from the
+  // tensor, without copying it.
+  if (!pb_encode_tag_for_field(stream, field)) return false;
+  return pb_encode_string(stream, (pb_byte_t*)(t->data_ptr()),  t->type().elementSizeInBytes()*t->numel());
 }
 
 GraphProto* AttributeProto::add_graphs() {
@@ -6,6 +6,7 @@
 #include <pb_encode.h>
 #include <ATen/ATen.h>
 
+#include <cstdint>
 #include <vector>
 #include <fstream>
 #include <memory>
@@ -27,11 +28,20 @@ using Dimension = onnx_TypeProto_TensorShapeProto_Dimension;
 template<typename T>
 using unique_vector = std::vector<std::unique_ptr<T>>;
 
+// Like pb_encode_submessage, but the size of the message is computed only the
+// first time it is encoded (when 'size' is kUnknownSize) and saved in 'size'.
+// pb_encode_submessage computes it every time, so every message would be
+// traversed once for every message it is nested in.
+constexpr size_t kUnknownSize = SIZE_MAX;
+bool micropb_encode_submessage(pb_ostream_t *stream, const pb_field_t fields[],
+                               const void *src_struct, size_t *size);
+
 // Helper function for encoding inside callbacks
 template<typename T, const pb_field_t* Field>
 bool micropb_encode(pb_ostream_t *stream, T* arg) {
   static_assert(Field != nullptr, "no overload in micropb_encode");
-  return pb_encode_submessage(stream, Field, static_cast<void*>(&arg->proto));
+  return micropb_encode_submessage(stream, Field, static_cast<void*>(&arg->proto),
+                                   &arg->encoded_size);
 }
 template <> bool micropb_encode<std::string, nullptr>(pb_ostream_t *stream, std::string* arg);
 template <> bool micropb_encode<int64_t, nullptr>(pb_ostream_t *stream, int64_t* arg);
@@ -69,11 +79,14 @@ template<typename T>
 struct MicroProto {
   // The actual nanopb generated protobuf struct we are filling.
   T proto;
+  // The size of the encoded message, see micropb_encode_submessage.  The
+  // message can't be modified after it's been encoded.
+  size_t encoded_size;
 
   // The constructor takes the protobuf struct by value for initialization
   // (since it is a C-style struct).  In the constructor you're
   // expected to call this with something like onnx_TensorProto_init_default
-  MicroProto(T proto) : proto(proto) {}
+  MicroProto(T proto) : proto(proto), encoded_size(kUnknownSize) {}
 
   // Usage:
   //    std::string owning_slot;
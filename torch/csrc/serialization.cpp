@@ -1,8 +1,45 @@
 #include <Python.h>
+#include <cerrno>
 #include <system_error>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#include <mutex>
+#endif
 
 #include "THP.h"
 
+#ifdef _WIN32
+// There is no pwrite on Windows. The seek and the write are done under a
+// lock, so that the threads of save_async don't move each other's position.
+static ssize_t pwrite(int fd, const void *buf, size_t count, int64_t offset)
+{
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (_lseeki64(fd, offset, SEEK_SET) < 0)
+    return -1;
+  return _write(fd, buf, (unsigned int) count);
+}
+#endif
+
+void THP_writeBuffer(int fd, const void *buf, int64_t nbytes, int64_t offset)
+{
+  const char *bytes = (const char *) buf;
+  while (nbytes > 0) {
+    // we write and read in 1GB blocks to avoid bugs on some OSes
+    size_t to_write = THMin(nbytes, 1073741824);
+    ssize_t result = offset < 0 ? write(fd, bytes, to_write) :
+                                  pwrite(fd, bytes, to_write, offset);
+    if (result < 0)
+      throw std::system_error(errno, std::system_category());
+    bytes += result;
+    nbytes -= result;
+    if (offset >= 0)
+      offset += result;
+  }
+}
+
 #include "generic/serialization.cpp"
 #include <TH/THGenerateAllTypes.h>
 
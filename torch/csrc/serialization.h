@@ -1,6 +1,12 @@
 #ifndef THP_SERIALIZATION_INC
 #define THP_SERIALIZATION_INC
 
+#include <cstdint>
+
+// Writes nbytes from buf to fd, at the given offset if it's non-negative
+// (without moving the file position), or at the current position otherwise.
+void THP_writeBuffer(int fd, const void *buf, int64_t nbytes, int64_t offset);
+
 #include "generic/serialization.h"
 #include <TH/THGenerateAllTypes.h>
 
@@ -105,6 +105,47 @@ class _DistributedRequest(object):
         torch._C._dist_request_wait(self.request)
 
 
+class Compressor(object):
+    """Compresses tensors reduced with :func:`all_reduce`.
+
+    The data is compressed by every process before it is sent, and summed
+    after it is decompressed. Supported methods are:
+
+    * ``'fp16'`` - IEEE half precision floats
+    * ``'bf16'`` - bfloat16 floats (float32 with the mantissa truncated to 7 bits)
+    * ``'topk'`` - only the ``ratio`` fraction of elements with the largest
+      magnitude, together with their indices
+    * ``'sign'`` - a bit per element, with the mean magnitude as a common scale
+
+    ``'fp16'`` and ``'bf16'`` payloads are summed in chunks (reduce-scatter
+    followed by all-gather), so the result is rounded to 16 bits as well.
+    ``'topk'`` and ``'sign'`` payloads are gathered whole by every process.
+
+    ``'topk'`` and ``'sign'`` keep the compression error and add it to the
+    data compressed next time (error feedback), so a compressor should be used
+    for a single tensor (e.g. a gradient of one parameter) only.
+
+    Arguments:
+        method (str): Compression method.
+        ratio (float, optional): Fraction of elements sent by ``'topk'``.
+    """
+
+    def __init__(self, method, ratio=0.01):
+        self.method = method
+        self.compressor = torch._C._dist_new_compressor(method, ratio)
+
+    @property
+    def stats(self):
+        """Number of bytes of data and of payloads compressed so far."""
+        return torch._C._dist_compressor_stats(self.compressor)
+
+    @property
+    def compression_ratio(self):
+        """Ratio of the size of data to the size of its compressed payloads."""
+        uncompressed, compressed = self.stats
+        return float(uncompressed) / compressed if compressed > 0 else 1.
+
+
 def get_rank():
     """Returns the rank of current process.
 
@@ -181,7 +222,13 @@ def recv(tensor, src=None):
     return torch._C._dist_recv(tensor, src)
 
 
-def broadcast(tensor, src, group=group.WORLD):
+def _collective_result(result):
+    if result is None:
+        return None
+    return _DistributedRequest(result)
+
+
+def broadcast(tensor, src, group=group.WORLD, async_op=False):
     """Broadcasts the tensor to the whole group.
 
     ``tensor`` must have the same number of elements in all processes
@@ -192,31 +239,53 @@ def broadcast(tensor, src, group=group.WORLD):
             process, and tensor to be used to save received data otherwise.
         src (int): Source rank.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return without waiting for the
+            collective to complete.
+
+    Returns:
+        A distributed request object if ``async_op`` is set, None otherwise.
+        Collectives are matched across processes in the order they were
+        issued, so all processes have to issue them in the same order, and
+        tensors must not be used before the request completes.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
-    return torch._C._dist_broadcast(tensor, src, group)
+    return _collective_result(torch._C._dist_broadcast(tensor, src, group, async_op))
 
 
-def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD):
+def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD, async_op=False,
+               compressor=None):
     """Reduces the tensor data across all machines in such a way that all get
     the final result.
 
     After the call ``tensor`` is going to be bitwise identical in all processes.
 
+    If a ``compressor`` is given, the data is compressed before it is sent. This
+    is supported for ``reduce_op.SUM`` of contiguous CPU float tensors only,
+    with the TCP and MPI backends, and can't be asynchronous.
+
     Arguments:
         tensor (Tensor): Input and output of the collective. The function
             operates in-place.
         op (optional): One of the values from ``torch.distributed.reduce_op``
             enum.  Specifies an operation used for element-wise reductions.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
+        compressor (Compressor, optional): Compressor used for this tensor.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
-    return torch._C._dist_all_reduce(tensor, op, group)
+    if compressor is not None:
+        if op is not reduce_op.SUM or async_op:
+            raise ValueError("compressed all_reduce supports only synchronous "
+                             "reduce_op.SUM")
+        torch._C._dist_all_reduce_compressed(tensor, compressor.compressor, group)
+        return None
+    return _collective_result(torch._C._dist_all_reduce(tensor, op, group, async_op))
 
 
-def reduce(tensor, dst, op=reduce_op.SUM, group=group.WORLD):
+def reduce(tensor, dst, op=reduce_op.SUM, group=group.WORLD, async_op=False):
     """Reduces the tensor data across all machines.
 
     Only the process with rank ``dst`` is going to receive the final result.
@@ -227,13 +296,15 @@ def reduce(tensor, dst, op=reduce_op.SUM, group=group.WORLD):
         op (optional): One of the values from ``torch.distributed.reduce_op``
             enum.  Specifies an operation used for element-wise reductions.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
-    return torch._C._dist_reduce(tensor, dst, op, group)
+    return _collective_result(torch._C._dist_reduce(tensor, dst, op, group, async_op))
 
 
-def all_gather(tensor_list, tensor, group=group.WORLD):
+def all_gather(tensor_list, tensor, group=group.WORLD, async_op=False):
     """Gathers tensors from the whole group in a list.
 
     Arguments:
@@ -241,10 +312,36 @@ def all_gather(tensor_list, tensor, group=group.WORLD):
             correctly-sized tensors to be used for output of the collective.
         tensor (Tensor): Tensor to be broadcast from current process.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
+    """
+    assert torch.distributed._initialized == _INITIALIZED_PG, \
+        "collective only supported in process-group mode"
+    return _collective_result(torch._C._dist_all_gather(tensor_list, tensor, group, async_op))
+
+
+def reduce_scatter(tensor, tensor_list, op=reduce_op.SUM, group=group.WORLD,
+                   async_op=False):
+    """Reduces a list of tensors across the whole group and scatters the
+    results, so that the process with rank ``i`` receives the reduction of
+    ``tensor_list[i]`` over all processes.
+
+    Every process sends and receives only a fraction of the data, which makes
+    it cheaper than an :func:`all_reduce` followed by picking one chunk.
+
+    Arguments:
+        tensor (Tensor): Output tensor.
+        tensor_list (list[Tensor]): List of tensors to reduce, one per process
+            of the group, each of the same size as ``tensor``.
+        op (optional): One of the values from ``torch.distributed.reduce_op``
+            enum.  Specifies an operation used for element-wise reductions.
+        group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
-    return torch._C._dist_all_gather(tensor_list, tensor, group)
+    return _collective_result(torch._C._dist_reduce_scatter(tensor_list, tensor, op, group, async_op))
 
 
 def gather(tensor, **kwargs):
@@ -257,6 +354,8 @@ def gather(tensor, **kwargs):
         gather_list (list[Tensor]): List of appropriately-sized tensors to
             use for received data. Required only in the receiving process.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
@@ -264,16 +363,17 @@ def gather(tensor, **kwargs):
     dst = kwargs.pop('dst', my_rank)
     gather_list = kwargs.pop('gather_list', None)
     _group = kwargs.pop('group', group.WORLD)
+    async_op = kwargs.pop('async_op', False)
     if kwargs:
         raise RuntimeError("got unexpected kwargs")
     if dst == my_rank:
         if gather_list is None:
             raise RuntimeError("gather_list is a required argument in gather destination")
-        return torch._C._dist_gather_recv(gather_list, tensor, _group)
+        return _collective_result(torch._C._dist_gather_recv(gather_list, tensor, _group, async_op))
     else:
         if gather_list:
             raise RuntimeError("non-empty gather_list can be given only to gather destination")
-        return torch._C._dist_gather_send(tensor, dst, _group)
+        return _collective_result(torch._C._dist_gather_send(tensor, dst, _group, async_op))
 
 
 def scatter(tensor, **kwargs):
@@ -289,6 +389,8 @@ def scatter(tensor, **kwargs):
         scatter_list (list[Tensor]): List of tensors to scatter. Required only
             in the process that is sending the data.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request instead of
+            waiting for the collective (see :func:`broadcast`).
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
@@ -296,29 +398,32 @@ def scatter(tensor, **kwargs):
     src = kwargs.pop('src', my_rank)
     scatter_list = kwargs.pop('scatter_list', None)
     _group = kwargs.pop('group', group.WORLD)
+    async_op = kwargs.pop('async_op', False)
     if kwargs:
         raise RuntimeError("got unexpected kwargs")
     if src == my_rank:
         if scatter_list is None:
             raise RuntimeError("scatter_list is a required argument in scatter source")
-        return torch._C._dist_scatter_send(scatter_list, tensor, _group)
+        return _collective_result(torch._C._dist_scatter_send(scatter_list, tensor, _group, async_op))
     else:
         if scatter_list:
             raise RuntimeError("non-empty can be given only to scatter source")
-        return torch._C._dist_scatter_recv(tensor, src, _group)
+        return _collective_result(torch._C._dist_scatter_recv(tensor, src, _group, async_op))
 
 
-def barrier(group=group.WORLD):
+def barrier(group=group.WORLD, async_op=False):
     """Synchronizes all processes.
 
     This collective blocks processes until the whole group enters this function.
 
     Arguments:
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether to return a request, which completes
+            once the whole group has entered the barrier, instead of blocking.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
-    return torch._C._dist_barrier(group)
+    return _collective_result(torch._C._dist_barrier(group, async_op))
 
 
 def new_group(ranks=None):
@@ -155,16 +155,47 @@ DLManagedTensor* toDLPack(const Tensor& src) {
 }
 
 
-Tensor fromDLPack(const DLManagedTensor* src) {
+Tensor fromDLPack(const DLManagedTensor* src, bool allow_copy) {
   Backend backend = getATenBackend(src->dlTensor.ctx);
   ScalarType stype = toScalarType(src->dlTensor.dtype);
+  auto & type = getType(backend, stype);
   auto deleter = [src](void * self) {
     src->destructor(const_cast<DLManagedTensor*>(src));
   };
-  return getType(backend, stype).tensorFromBlob(
-      src->dlTensor.data,
-      IntList(src->dlTensor.shape, src->dlTensor.ndim),
-      IntList(src->dlTensor.strides, src->dlTensor.ndim),
-      deleter);
+  int ndim = src->dlTensor.ndim;
+  IntList sizes(src->dlTensor.shape, ndim);
+  char * data = static_cast<char*>(src->dlTensor.data) + src->dlTensor.byte_offset;
+  // strides are optional, NULL means the tensor is compact and row-major
+  if (!src->dlTensor.strides) {
+    return type.tensorFromBlob(data, sizes, deleter);
+  }
+
+  // ATen tensors can't have negative strides, so these dimensions are
+  // described from their lowest address and reversed with index_select.
+  // That copies the whole tensor, so it's only done if the caller allows it.
+  std::vector<int64_t> strides(src->dlTensor.strides, src->dlTensor.strides + ndim);
+  std::vector<int64_t> reversed_dims;
+  bool empty = false;
+  for (int d = 0; d < ndim; d++) {
+    empty |= sizes[d] == 0;
+  }
+  for (int d = 0; d < ndim; d++) {
+    if (strides[d] < 0 && !empty) {
+      if (!allow_copy) {
+        throw std::logic_error("fromDLPack: tensors with negative strides "
+            "can't share memory with an ATen tensor (stride " +
+            std::to_string(strides[d]) + " of dimension " + std::to_string(d) + ")");
+      }
+      data += strides[d] * (sizes[d] - 1) * type.elementSizeInBytes();
+      strides[d] = -strides[d];
+      reversed_dims.push_back(d);
+    }
+  }
+  Tensor result = type.tensorFromBlob(data, sizes, strides, deleter);
+  for (auto d : reversed_dims) {
+    auto index = type.toScalarType(kLong).arange(sizes[d] - 1, -1, -1);
+    result = result.index_select(d, index);
+  }
+  return result;
 }
 } //namespace at
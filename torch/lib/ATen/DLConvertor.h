@@ -12,6 +12,8 @@ namespace at {
 
 AT_API ScalarType toScalarType(const DLDataType& dtype);
 AT_API DLManagedTensor * toDLPack(const Tensor& src);
-AT_API Tensor fromDLPack(const DLManagedTensor* src);
+// Tensors with negative strides can't share memory with src, so they are only
+// accepted (and copied) with allow_copy; fromDLPack throws otherwise.
+AT_API Tensor fromDLPack(const DLManagedTensor* src, bool allow_copy = false);
 
 } //namespace at
@@ -19,6 +19,54 @@ static void test() {
     ASSERT(a.equal(b));
     std::cout << "conversion was fine" << std::endl;
   }
+  {
+    std::cout << "dlconvertor: convert DLTensor with negative strides to ATen" << std::endl;
+    // a 3x4 matrix viewed with both dimensions reversed, i.e. m[::-1, ::-1]
+    Tensor m = CPU(at::kFloat).rand({3,4});
+    static int64_t shape[] = {3, 4};
+    static int64_t strides[] = {-4, -1};
+    static bool deleted;
+    deleted = false;
+    DLManagedTensor dlMTensor;
+    dlMTensor.dlTensor.data = m.data_ptr();
+    dlMTensor.dlTensor.ctx.device_type = DLDeviceType::kCPU;
+    dlMTensor.dlTensor.ctx.device_id = 0;
+    dlMTensor.dlTensor.ndim = 2;
+    dlMTensor.dlTensor.dtype.code = DLDataTypeCode::kFloat;
+    dlMTensor.dlTensor.dtype.bits = 32;
+    dlMTensor.dlTensor.dtype.lanes = 1;
+    dlMTensor.dlTensor.shape = shape;
+    dlMTensor.dlTensor.strides = strides;
+    // points to the last element
+    dlMTensor.dlTensor.byte_offset = 11 * sizeof(float);
+    dlMTensor.destructor = [](DLManagedTensor*) { deleted = true; };
+    // they can't be shared, so they're only copied when asked to
+    bool thrown = false;
+    try {
+      fromDLPack(&dlMTensor);
+    } catch (const std::logic_error& e) {
+      thrown = true;
+    }
+    ASSERT(thrown);
+    ASSERT(!deleted);
+    {
+      Tensor b = fromDLPack(&dlMTensor, /*allow_copy=*/true);
+      auto reverse = CPU(at::kLong).arange(3, -1, -1);
+      ASSERT(b.equal(m.index_select(0, reverse.narrow(0, 1, 3)).index_select(1, reverse)));
+    }
+    ASSERT(deleted);
+
+    std::cout << "dlconvertor: convert DLTensor without strides to ATen" << std::endl;
+    deleted = false;
+    dlMTensor.dlTensor.strides = NULL;
+    dlMTensor.dlTensor.byte_offset = 0;
+    {
+      Tensor b = fromDLPack(&dlMTensor);
+      ASSERT(b.equal(m));
+      ASSERT(b.data_ptr() == m.data_ptr());
+    }
+    ASSERT(deleted);
+  }
 
 }
 
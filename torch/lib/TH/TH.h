@@ -9,6 +9,7 @@
 #endif
 
 #include "THAtomic.h"
+#include "THParallel.h"
 #include "THVector.h"
 #include "THLogAdd.h"
 #include "THRandom.h"
@@ -39,6 +39,7 @@ struct THMapAllocatorContext_ {
   char *filename; /* file name */
   int flags;
   ptrdiff_t size; /* mapped size */
+  ptrdiff_t offset; /* offset of the mapping in the file */
 #ifdef _WIN32
   HANDLE handle;
 #else
@@ -63,6 +64,9 @@ THMapAllocatorContext *THMapAllocatorContext_new(const char *filename, int flags
   if ((flags ^ TH_ALLOCATOR_MAPPED_EXCLUSIVE) == 0)
     THError("TH_ALLOCATOR_MAPPED_EXCLUSIVE flag requires opening the file "
         "in shared mode");
+  if ((flags & TH_ALLOCATOR_MAPPED_READONLY) &&
+      (flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM)))
+    THError("TH_ALLOCATOR_MAPPED_READONLY flag can't be used with a shared mapping");
 
   if (filename) {
     ctx->filename = THAlloc(strlen(filename)+1);
@@ -72,6 +76,7 @@ THMapAllocatorContext *THMapAllocatorContext_new(const char *filename, int flags
   }
   ctx->flags = flags;
   ctx->size = 0;
+  ctx->offset = 0;
 #ifdef _WIN32
   ctx->handle = INVALID_HANDLE_VALUE;
 #else
@@ -93,6 +98,24 @@ THMapAllocatorContext *THMapAllocatorContext_newWithFd(const char *filename, int
 #endif
 }
 
+THMapAllocatorContext *THMapAllocatorContext_newWithOffset(const char *filename, int flags, ptrdiff_t offset)
+{
+#ifdef _WIN32
+  if (offset != 0)
+    THError("THMapAllocatorContext_newWithOffset is unsupported on Windows");
+  return THMapAllocatorContext_new(filename, flags);
+#else
+  THMapAllocatorContext *ctx;
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (offset < 0 || (page_size > 0 && offset % page_size != 0))
+    THError("mapping offset %td of file <%s> is not a multiple of the page size (%ld)",
+            offset, filename, page_size);
+  ctx = THMapAllocatorContext_new(filename, flags);
+  ctx->offset = offset;
+  return ctx;
+#endif
+}
+
 char * THMapAllocatorContext_filename(THMapAllocatorContext *ctx)
 {
   return ctx->filename;
@@ -298,13 +321,13 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
 
     if(size > 0)
     {
-      if(size > file_stat.st_size)
+      if(ctx->offset + size > file_stat.st_size)
       {
-        if(ctx->flags)
+        if(ctx->flags & ~TH_ALLOCATOR_MAPPED_READONLY)
         {
-          if(ftruncate(fd, size) == -1)
+          if(ftruncate(fd, ctx->offset + size) == -1)
             THError("unable to resize file <%s> to the right size", ctx->filename);
-          if(fstat(fd, &file_stat) == -1 || file_stat.st_size < size)
+          if(fstat(fd, &file_stat) == -1 || file_stat.st_size < ctx->offset + size)
           {
             close(fd);
             THError("unable to stretch file <%s> to the right size", ctx->filename);
@@ -328,15 +351,17 @@ static void *_map_alloc(void* ctx_, ptrdiff_t size)
       }
     }
     else
-      size = file_stat.st_size;
+      size = file_stat.st_size - ctx->offset;
 
     ctx->size = size; /* if we are here, it must be the right size */
 
     /* map it */
     if (ctx->flags & (TH_ALLOCATOR_MAPPED_SHARED | TH_ALLOCATOR_MAPPED_SHAREDMEM))
-      data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+      data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, ctx->offset);
+    else if (ctx->flags & TH_ALLOCATOR_MAPPED_READONLY)
+      data = mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, fd, ctx->offset);
     else
-      data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+      data = mmap(NULL, ctx->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, ctx->offset);
 
     if (ctx->flags & TH_ALLOCATOR_MAPPED_KEEPFD) {
       ctx->fd = fd;
@@ -427,6 +452,11 @@ THMapAllocatorContext *THMapAllocatorContext_new(const char *filename, int flags
   return NULL;
 }
 
+THMapAllocatorContext *THMapAllocatorContext_newWithOffset(const char *filename, int flags, ptrdiff_t offset) {
+  THError("file mapping not supported on your system");
+  return NULL;
+}
+
 void THMapAllocatorContext_free(THMapAllocatorContext *ctx) {
   THError("file mapping not supported on your system");
 }
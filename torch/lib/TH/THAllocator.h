@@ -10,6 +10,7 @@
 #define TH_ALLOCATOR_MAPPED_KEEPFD 16
 #define TH_ALLOCATOR_MAPPED_FROMFD 32
 #define TH_ALLOCATOR_MAPPED_UNLINK 64
+#define TH_ALLOCATOR_MAPPED_READONLY 128
 
 /* Custom allocator
  */
@@ -30,6 +31,9 @@ typedef struct THMapAllocatorContext_  THMapAllocatorContext;
 TH_API THMapAllocatorContext *THMapAllocatorContext_new(const char *filename, int flags);
 TH_API THMapAllocatorContext *THMapAllocatorContext_newWithFd(const char *filename,
     int fd, int flags);
+/* maps the file starting at offset, which must be a multiple of the page size */
+TH_API THMapAllocatorContext *THMapAllocatorContext_newWithOffset(const char *filename,
+    int flags, ptrdiff_t offset);
 TH_API char * THMapAllocatorContext_filename(THMapAllocatorContext *ctx);
 TH_API int THMapAllocatorContext_fd(THMapAllocatorContext *ctx);
 TH_API ptrdiff_t THMapAllocatorContext_size(THMapAllocatorContext *ctx);
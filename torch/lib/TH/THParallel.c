@@ -0,0 +1,142 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "THParallel.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#ifndef TH_HAVE_THREAD
+#define __thread
+#elif _MSC_VER
+#define __thread __declspec( thread )
+#endif
+
+static __thread int threadBudget = 0;
+/* the OpenMP thread count of this thread before a budget was set */
+static __thread int threadDefaultNumThreads = 0;
+
+#ifdef __linux__
+static void THPinCurrentThread(int core)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (core >= 0) {
+    CPU_SET(core, &set);
+  } else {
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    long i;
+    for (i = 0; i < ncpus && i < CPU_SETSIZE; i++)
+      CPU_SET(i, &set);
+  }
+  /* pid 0 is the calling thread */
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    THError("could not set the affinity of a thread to core %d", core);
+}
+#endif
+
+void THSetThreadBudget(int budget)
+{
+  THArgCheck(budget >= 0, 1, "thread budget must be non-negative, but got %d", budget);
+#ifdef _OPENMP
+  /* the nthreads ICV is per-thread, so this also caps raw omp pragmas
+     issued from this thread */
+  if (threadBudget == 0)
+    threadDefaultNumThreads = omp_get_max_threads();
+  omp_set_num_threads((budget > 0 && budget < threadDefaultNumThreads) ?
+                      budget : threadDefaultNumThreads);
+#endif
+  threadBudget = budget;
+}
+
+int THGetThreadBudget(void)
+{
+#ifdef _OPENMP
+  int max_threads = omp_get_max_threads();
+  return (threadBudget > 0 && threadBudget < max_threads) ? threadBudget : max_threads;
+#else
+  return 1;
+#endif
+}
+
+void THSetThreadAffinity(const int *cores, int ncores)
+{
+#ifdef __linux__
+  int i;
+  int nthreads;
+  long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+  THArgCheck(ncores >= 0, 2, "number of cores must be non-negative");
+  for (i = 0; i < ncores; i++)
+    THArgCheck(cores[i] >= 0 && cores[i] < ncpus, 1,
+               "core %d is out of range [0, %ld)", cores[i], ncpus);
+
+  if (ncores > 0 && threadBudget == 0)
+    THSetThreadBudget(ncores);
+  nthreads = THGetThreadBudget();
+
+#ifdef _OPENMP
+  /* the OpenMP runtime keeps reusing the same team of workers for a given
+     calling thread, so pinning them once here sticks */
+  #pragma omp parallel num_threads(nthreads)
+  {
+    int tid = omp_get_thread_num();
+    THPinCurrentThread(ncores > 0 ? cores[tid % ncores] : -1);
+  }
+#else
+  (void)nthreads;
+  THPinCurrentThread(ncores > 0 ? cores[0] : -1);
+#endif
+#else
+  if (ncores > 0)
+    THError("thread affinity is not supported on this platform");
+#endif
+}
+
+int THParallelNumThreads(ptrdiff_t range, ptrdiff_t grain_size)
+{
+#ifdef _OPENMP
+  ptrdiff_t nchunks;
+  int budget;
+  if (grain_size < 1)
+    grain_size = 1;
+  if (range <= grain_size || omp_in_parallel())
+    return 1;
+  budget = THGetThreadBudget();
+  nchunks = (range + grain_size - 1) / grain_size;
+  return nchunks < budget ? (int)nchunks : budget;
+#else
+  return 1;
+#endif
+}
+
+void THParallelFor(ptrdiff_t begin, ptrdiff_t end, ptrdiff_t grain_size,
+                   THParallelFunction fn, void *ctx)
+{
+  ptrdiff_t range = end - begin;
+  int nthreads;
+  if (range <= 0)
+    return;
+  nthreads = THParallelNumThreads(range, grain_size);
+  if (nthreads <= 1) {
+    fn(ctx, begin, end);
+    return;
+  }
+#ifdef _OPENMP
+  #pragma omp parallel num_threads(nthreads)
+  {
+    ptrdiff_t nteam = omp_get_num_threads();
+    ptrdiff_t chunk = (range + nteam - 1) / nteam;
+    ptrdiff_t chunk_begin = begin + omp_get_thread_num() * chunk;
+    ptrdiff_t chunk_end = THMin(end, chunk_begin + chunk);
+    if (chunk_begin < chunk_end)
+      fn(ctx, chunk_begin, chunk_end);
+  }
+#endif
+}
@@ -0,0 +1,57 @@
+#ifndef TH_PARALLEL_INC
+#define TH_PARALLEL_INC
+
+#include "THGeneral.h"
+
+/******************************************************************************
+ * Intra-op parallel runtime for TH
+ *
+ *  All intra-op parallelism in TH and THNN goes through this module, so the
+ *  number of threads an operator may use is decided in one place:
+ *  - each calling thread has its own thread budget (0 means no cap), which
+ *    lets several model replicas share one host without oversubscription
+ *  - each parallel loop passes a grain size: the minimum number of
+ *    iterations worth handing to one thread
+ *  - the worker threads of a calling thread can optionally be pinned to cores
+ ******************************************************************************/
+
+/* default grain size for cheap elementwise loops */
+#define TH_PARALLEL_GRAIN_SIZE 5000
+
+typedef void (*THParallelFunction)(void *ctx, ptrdiff_t begin, ptrdiff_t end);
+
+/*
+ * Caps the number of threads used by parallel regions started from the
+ * calling thread. The budget is thread-local; 0 removes the cap.
+*/
+TH_API void THSetThreadBudget(int budget);
+
+/*
+ * return the number of threads a parallel region started from the calling
+ * thread may use (the budget, or the OpenMP default if no budget is set)
+*/
+TH_API int THGetThreadBudget(void);
+
+/*
+ * Pins the calling thread and its worker threads to the given cores, worker i
+ * going to cores[i % ncores]. If no budget is set, the budget becomes ncores.
+ * Passing ncores == 0 removes the pinning.
+*/
+TH_API void THSetThreadAffinity(const int *cores, int ncores);
+
+/*
+ * return the number of threads to use for a loop of range iterations, each
+ * thread getting at least grain_size of them. Returns 1 when called from
+ * inside a parallel region or when range <= grain_size.
+ * Meant for the num_threads() clause of OpenMP pragmas.
+*/
+TH_API int THParallelNumThreads(ptrdiff_t range, ptrdiff_t grain_size);
+
+/*
+ * Calls fn(ctx, b, e) on disjoint sub-ranges [b, e) covering [begin, end),
+ * in parallel when the range is large enough compared to grain_size.
+*/
+TH_API void THParallelFor(ptrdiff_t begin, ptrdiff_t end, ptrdiff_t grain_size,
+                          THParallelFunction fn, void *ctx);
+
+#endif
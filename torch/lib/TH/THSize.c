@@ -24,3 +24,78 @@ ptrdiff_t THSize_nElement(int64_t dims, int64_t *size) {
     return nElement;
   }
 }
+
+static int THSize_isStrideOrderBefore(int64_t dims, int ntensors, const int64_t *strides, int64_t a, int64_t b) {
+  int t;
+  for(t = 0; t < ntensors; t++)
+  {
+    if(strides[t*dims + a] != strides[t*dims + b])
+      return strides[t*dims + a] > strides[t*dims + b];
+  }
+  return 0;
+}
+
+int THSize_coalesceStrides(int64_t dims, const int64_t *size, int ntensors,
+                           const int64_t **strides, int64_t *out_size, int64_t *out_strides) {
+  int64_t d, k, ndim = 0;
+  int t;
+
+  for(d = 0; d < dims; d++)
+  {
+    if(size[d] == 1)
+      continue;
+    out_size[ndim] = size[d];
+    for(t = 0; t < ntensors; t++)
+      out_strides[t*dims + ndim] = strides[t][d];
+    ndim++;
+  }
+  if(ndim == 0)
+  {
+    out_size[0] = 1;
+    for(t = 0; t < ntensors; t++)
+      out_strides[t*dims] = 1;
+    return 1;
+  }
+
+  // insertion sort by decreasing stride, so that the innermost loop runs
+  // along the smallest stride
+  for(d = 1; d < ndim; d++)
+  {
+    for(k = d; k > 0 && THSize_isStrideOrderBefore(dims, ntensors, out_strides, k, k-1); k--)
+    {
+      int64_t tmp = out_size[k];
+      out_size[k] = out_size[k-1];
+      out_size[k-1] = tmp;
+      for(t = 0; t < ntensors; t++)
+      {
+        tmp = out_strides[t*dims + k];
+        out_strides[t*dims + k] = out_strides[t*dims + k-1];
+        out_strides[t*dims + k-1] = tmp;
+      }
+    }
+  }
+
+  // merge each dimension into the previous one when it is contiguous with it
+  // in every tensor
+  k = 0;
+  for(d = 1; d < ndim; d++)
+  {
+    int mergeable = 1;
+    for(t = 0; t < ntensors && mergeable; t++)
+      mergeable = out_strides[t*dims + k] == out_strides[t*dims + d] * out_size[d];
+    if(mergeable)
+    {
+      out_size[k] *= out_size[d];
+      for(t = 0; t < ntensors; t++)
+        out_strides[t*dims + k] = out_strides[t*dims + d];
+    }
+    else
+    {
+      k++;
+      out_size[k] = out_size[d];
+      for(t = 0; t < ntensors; t++)
+        out_strides[t*dims + k] = out_strides[t*dims + d];
+    }
+  }
+  return (int)(k + 1);
+}
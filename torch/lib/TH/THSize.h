@@ -10,4 +10,13 @@
 TH_API int THSize_isSameSizeAs(const int64_t *sizeA, int64_t dimsA, const int64_t *sizeB, int64_t dimsB);
 TH_API ptrdiff_t THSize_nElement(int64_t dims, int64_t *size);
 
+// Computes a common iteration space for ntensors tensors sharing the same size.
+// Dimensions of size 1 are dropped, the others are ordered by decreasing stride
+// of the first tensor, and neighbours that are contiguous with each other in
+// every tensor are merged. strides[t] holds the strides of tensor t. On return
+// out_strides[t*dims + d] is the stride of tensor t along merged dimension d.
+// Returns the number of merged dimensions (at least 1).
+TH_API int THSize_coalesceStrides(int64_t dims, const int64_t *size, int ntensors,
+                                  const int64_t **strides, int64_t *out_size, int64_t *out_strides);
+
 #endif
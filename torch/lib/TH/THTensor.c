@@ -32,3 +32,6 @@
 
 #include "generic/THTensorLapack.c"
 #include "THGenerateFloatTypes.h"
+
+#include "generic/THTensorOptim.c"
+#include "THGenerateFloatTypes.h"
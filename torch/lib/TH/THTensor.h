@@ -39,4 +39,8 @@
 #include "generic/THTensorLapack.h"
 #include "THGenerateFloatTypes.h"
 
+/* fused optimizer steps */
+#include "generic/THTensorOptim.h"
+#include "THGenerateFloatTypes.h"
+
 #endif
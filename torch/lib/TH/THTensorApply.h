@@ -1,6 +1,9 @@
 #ifndef TH_TENSOR_APPLY_INC
 #define TH_TENSOR_APPLY_INC
 
+#include "THSize.h"
+#include "THParallel.h"
+
 /*
  * The basic strategy for apply is as follows:
  *
@@ -39,9 +42,7 @@
   for(TENSOR##_i = 0; TENSOR##_i < TENSOR->nDimension; TENSOR##_i++) \
     TENSOR##_n *= TENSOR->size[TENSOR##_i]; \
 \
-  if(TENSOR->nDimension == 0) \
-    TH_TENSOR_APPLY_hasFinished = 1; \
-  else \
+  if(TENSOR->nDimension != 0) \
   { \
     TENSOR##_data = TENSOR->storage->data+TENSOR->storageOffset; \
     TENSOR##_size = 1; \
@@ -146,7 +147,7 @@
 
 #define TH_TENSOR_APPLY3_D(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, DIM, CODE) \
 { \
-  int TH_TENSOR_APPLY_hasFinished = 0; \
+  int TH_TENSOR_APPLY_hasFinished = TENSOR1->nDimension == 0 || TENSOR2->nDimension == 0 || TENSOR3->nDimension == 0; \
   int64_t TH_TENSOR_dim_index = 0; \
   __TH_TENSOR_APPLYX_PREAMBLE(TYPE1, TENSOR1, DIM, 1) \
   __TH_TENSOR_APPLYX_PREAMBLE(TYPE2, TENSOR2, DIM, 1) \
@@ -193,7 +194,7 @@
 
 #define TH_TENSOR_APPLY2_D(TYPE1, TENSOR1, TYPE2, TENSOR2, DIM, CODE) \
 { \
-  int TH_TENSOR_APPLY_hasFinished = 0; \
+  int TH_TENSOR_APPLY_hasFinished = TENSOR1->nDimension == 0 || TENSOR2->nDimension == 0; \
   int64_t TH_TENSOR_dim_index = 0; \
   __TH_TENSOR_APPLYX_PREAMBLE(TYPE1, TENSOR1, DIM, 1) \
   __TH_TENSOR_APPLYX_PREAMBLE(TYPE2, TENSOR2, DIM, 1) \
@@ -226,7 +227,7 @@
 
 #define TH_TENSOR_APPLY_D(TYPE, TENSOR, DIM, CODE) \
 { \
-  int TH_TENSOR_APPLY_hasFinished = 0; \
+  int TH_TENSOR_APPLY_hasFinished = TENSOR->nDimension == 0; \
   int64_t TH_TENSOR_dim_index = 0; \
   __TH_TENSOR_APPLYX_PREAMBLE(TYPE, TENSOR, DIM, 0) \
 \
@@ -245,6 +246,216 @@
 #define TH_TENSOR_APPLY(TYPE, TENSOR, CODE) \
   TH_TENSOR_APPLY_D(TYPE, TENSOR, -1, CODE)
 
+/*
+ * Coalesced apply for elementwise operations on tensors of the same size,
+ * where the order in which elements are visited does not matter.
+ *
+ * The dimensions of all tensors are merged into a common iteration space
+ * (see THSize_coalesceStrides): size-1 dimensions are dropped, loops are
+ * ordered by stride and dimensions that are contiguous in every tensor are
+ * merged. The flattened iteration space is split between threads, and each
+ * thread walks it one run of the innermost dimension at a time. When that
+ * dimension has unit stride in every tensor, CONTIG_CODE is called on the run
+ * with TENSOR##_data pointing at its first element and TENSOR1##_len holding
+ * its length, so it can dispatch to a THVector kernel. Otherwise CODE is
+ * called per element, like in TH_TENSOR_APPLY2.
+ *
+ * Tensors with the same number of elements but different sizes fall back to
+ * TH_TENSOR_APPLY2/3.
+ */
+
+#ifdef _OPENMP
+#include <omp.h>
+#ifndef _WIN32
+#define __TH_TENSOR_APPLY_PRAGMA(P) _Pragma(#P)
+#else
+#define __TH_TENSOR_APPLY_PRAGMA(P) __pragma(P)
+#endif
+#define __TH_TENSOR_APPLY_PARALLEL(NTHREADS) __TH_TENSOR_APPLY_PRAGMA(omp parallel num_threads(NTHREADS))
+#define __TH_TENSOR_APPLY_THREAD_ID omp_get_thread_num()
+#define __TH_TENSOR_APPLY_NUM_THREADS omp_get_num_threads()
+#else
+#define __TH_TENSOR_APPLY_PARALLEL(NTHREADS)
+#define __TH_TENSOR_APPLY_THREAD_ID 0
+#define __TH_TENSOR_APPLY_NUM_THREADS 1
+#endif
+
+#define __TH_TENSOR_APPLYX_COALESCED_BEGIN(NTENSORS, TENSOR1) \
+  int64_t TH_APPLY_dims = TENSOR1->nDimension; \
+  int64_t *TH_APPLY_sizes = (int64_t*)THAlloc(sizeof(int64_t) * (NTENSORS+1) * TH_APPLY_dims); \
+  int64_t *TH_APPLY_strides = TH_APPLY_sizes + TH_APPLY_dims; \
+  const int64_t *TH_APPLY_inStrides[NTENSORS]; \
+  int TH_APPLY_ndim; \
+  ptrdiff_t TH_APPLY_n = THSize_nElement(TH_APPLY_dims, TENSOR1->size); \
+  ptrdiff_t TH_APPLY_inner; \
+  int TH_APPLY_nthreads = THParallelNumThreads(TH_APPLY_n, TH_TENSOR_APPLY_GRAIN_SIZE);
+
+#define __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE, TENSOR, INDEX) \
+  int64_t *TENSOR##_strides = TH_APPLY_strides + (INDEX) * TH_APPLY_dims; \
+  TYPE *TENSOR##_base = TENSOR->storage->data + TENSOR->storageOffset; \
+  int64_t TENSOR##_stride = TENSOR##_strides[TH_APPLY_ndim-1];
+
+/* position of the first element of this thread's chunk */
+#define __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR) \
+  ptrdiff_t TENSOR##_offset = 0; \
+  for (TH_APPLY_d = 0; TH_APPLY_d < TH_APPLY_ndim; TH_APPLY_d++) \
+    TENSOR##_offset += TH_APPLY_counter[TH_APPLY_d] * TENSOR##_strides[TH_APPLY_d];
+
+/* move TENSOR##_offset from the end of a run to the start of the next one */
+#define __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR) \
+  TENSOR##_offset += TH_APPLY_len * TENSOR##_stride; \
+  if (TH_APPLY_counter[TH_APPLY_ndim-1] + TH_APPLY_len == TH_APPLY_inner) { \
+    TENSOR##_offset -= TH_APPLY_inner * TENSOR##_stride; \
+    for (TH_APPLY_d = TH_APPLY_ndim-2; TH_APPLY_d >= 0; TH_APPLY_d--) { \
+      TENSOR##_offset += TENSOR##_strides[TH_APPLY_d]; \
+      if (TH_APPLY_counter[TH_APPLY_d] + 1 < TH_APPLY_sizes[TH_APPLY_d]) \
+        break; \
+      TENSOR##_offset -= TH_APPLY_sizes[TH_APPLY_d] * TENSOR##_strides[TH_APPLY_d]; \
+    } \
+  }
+
+#define __TH_TENSOR_APPLYX_COALESCED_STEP_COUNTER \
+  TH_APPLY_counter[TH_APPLY_ndim-1] += TH_APPLY_len; \
+  if (TH_APPLY_counter[TH_APPLY_ndim-1] == TH_APPLY_inner) { \
+    TH_APPLY_counter[TH_APPLY_ndim-1] = 0; \
+    for (TH_APPLY_d = TH_APPLY_ndim-2; TH_APPLY_d >= 0; TH_APPLY_d--) { \
+      if (++TH_APPLY_counter[TH_APPLY_d] < TH_APPLY_sizes[TH_APPLY_d]) \
+        break; \
+      TH_APPLY_counter[TH_APPLY_d] = 0; \
+    } \
+  }
+
+/* split [0, TH_APPLY_n) between threads and walk it run by run */
+#define __TH_TENSOR_APPLYX_COALESCED_LOOP(BODY) \
+  __TH_TENSOR_APPLY_PARALLEL(TH_APPLY_nthreads) \
+  { \
+    ptrdiff_t TH_APPLY_team = __TH_TENSOR_APPLY_NUM_THREADS; \
+    ptrdiff_t TH_APPLY_chunk = (TH_APPLY_n + TH_APPLY_team - 1) / TH_APPLY_team; \
+    ptrdiff_t TH_APPLY_index = __TH_TENSOR_APPLY_THREAD_ID * TH_APPLY_chunk; \
+    ptrdiff_t TH_APPLY_end = THMin(TH_APPLY_n, TH_APPLY_index + TH_APPLY_chunk); \
+    if (TH_APPLY_index < TH_APPLY_end) { \
+      int64_t *TH_APPLY_counter = (int64_t*)THAlloc(sizeof(int64_t) * TH_APPLY_ndim); \
+      ptrdiff_t TH_APPLY_quot = TH_APPLY_index; \
+      int TH_APPLY_d; \
+      for (TH_APPLY_d = TH_APPLY_ndim-1; TH_APPLY_d >= 0; TH_APPLY_d--) { \
+        TH_APPLY_counter[TH_APPLY_d] = TH_APPLY_quot % TH_APPLY_sizes[TH_APPLY_d]; \
+        TH_APPLY_quot /= TH_APPLY_sizes[TH_APPLY_d]; \
+      } \
+      BODY \
+      THFree(TH_APPLY_counter); \
+    } \
+  } \
+  THFree(TH_APPLY_sizes);
+
+#define TH_TENSOR_APPLY_GRAIN_SIZE TH_PARALLEL_GRAIN_SIZE
+
+#define TH_TENSOR_APPLY2_COALESCED(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE, CONTIG_CODE) \
+{ \
+  if (!THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR2->size, TENSOR2->nDimension)) { \
+    TH_TENSOR_APPLY2(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE); \
+  } else if (TENSOR1->nDimension > 0) { \
+    __TH_TENSOR_APPLYX_COALESCED_BEGIN(2, TENSOR1) \
+    TH_APPLY_inStrides[0] = TENSOR1->stride; \
+    TH_APPLY_inStrides[1] = TENSOR2->stride; \
+    TH_APPLY_ndim = THSize_coalesceStrides(TH_APPLY_dims, TENSOR1->size, 2, TH_APPLY_inStrides, \
+                                           TH_APPLY_sizes, TH_APPLY_strides); \
+    TH_APPLY_inner = TH_APPLY_sizes[TH_APPLY_ndim-1]; \
+    __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE1, TENSOR1, 0) \
+    __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE2, TENSOR2, 1) \
+    int TH_APPLY_innerContig = TENSOR1##_stride == 1 && TENSOR2##_stride == 1; \
+    __TH_TENSOR_APPLYX_COALESCED_LOOP( \
+      __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR1) \
+      __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR2) \
+      while (TH_APPLY_index < TH_APPLY_end) { \
+        ptrdiff_t TH_APPLY_len = THMin(TH_APPLY_inner - TH_APPLY_counter[TH_APPLY_ndim-1], \
+                                       TH_APPLY_end - TH_APPLY_index); \
+        TYPE1 *TENSOR1##_data = TENSOR1##_base + TENSOR1##_offset; \
+        TYPE2 *TENSOR2##_data = TENSOR2##_base + TENSOR2##_offset; \
+        if (TH_APPLY_innerContig) { \
+          ptrdiff_t TENSOR1##_len = TH_APPLY_len; \
+          CONTIG_CODE \
+        } else { \
+          ptrdiff_t TH_APPLY_i; \
+          for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+               TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride) { \
+            CODE \
+          } \
+        } \
+        __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR1) \
+        __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR2) \
+        __TH_TENSOR_APPLYX_COALESCED_STEP_COUNTER \
+        TH_APPLY_index += TH_APPLY_len; \
+      } \
+    ) \
+  } \
+}
+
+#define TH_TENSOR_APPLY3_COALESCED(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE, CONTIG_CODE) \
+{ \
+  if (!THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR2->size, TENSOR2->nDimension) || \
+      !THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR3->size, TENSOR3->nDimension)) { \
+    TH_TENSOR_APPLY3(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE); \
+  } else if (TENSOR1->nDimension > 0) { \
+    __TH_TENSOR_APPLYX_COALESCED_BEGIN(3, TENSOR1) \
+    TH_APPLY_inStrides[0] = TENSOR1->stride; \
+    TH_APPLY_inStrides[1] = TENSOR2->stride; \
+    TH_APPLY_inStrides[2] = TENSOR3->stride; \
+    TH_APPLY_ndim = THSize_coalesceStrides(TH_APPLY_dims, TENSOR1->size, 3, TH_APPLY_inStrides, \
+                                           TH_APPLY_sizes, TH_APPLY_strides); \
+    TH_APPLY_inner = TH_APPLY_sizes[TH_APPLY_ndim-1]; \
+    __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE1, TENSOR1, 0) \
+    __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE2, TENSOR2, 1) \
+    __TH_TENSOR_APPLYX_COALESCED_DECLARE(TYPE3, TENSOR3, 2) \
+    int TH_APPLY_innerContig = TENSOR1##_stride == 1 && TENSOR2##_stride == 1 && TENSOR3##_stride == 1; \
+    __TH_TENSOR_APPLYX_COALESCED_LOOP( \
+      __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR1) \
+      __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR2) \
+      __TH_TENSOR_APPLYX_COALESCED_OFFSET(TENSOR3) \
+      while (TH_APPLY_index < TH_APPLY_end) { \
+        ptrdiff_t TH_APPLY_len = THMin(TH_APPLY_inner - TH_APPLY_counter[TH_APPLY_ndim-1], \
+                                       TH_APPLY_end - TH_APPLY_index); \
+        TYPE1 *TENSOR1##_data = TENSOR1##_base + TENSOR1##_offset; \
+        TYPE2 *TENSOR2##_data = TENSOR2##_base + TENSOR2##_offset; \
+        TYPE3 *TENSOR3##_data = TENSOR3##_base + TENSOR3##_offset; \
+        if (TH_APPLY_innerContig) { \
+          ptrdiff_t TENSOR1##_len = TH_APPLY_len; \
+          CONTIG_CODE \
+        } else { \
+          ptrdiff_t TH_APPLY_i; \
+          for (TH_APPLY_i = 0; TH_APPLY_i < TH_APPLY_len; TH_APPLY_i++, \
+               TENSOR1##_data += TENSOR1##_stride, TENSOR2##_data += TENSOR2##_stride, \
+               TENSOR3##_data += TENSOR3##_stride) { \
+            CODE \
+          } \
+        } \
+        __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR1) \
+        __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR2) \
+        __TH_TENSOR_APPLYX_COALESCED_STEP(TENSOR3) \
+        __TH_TENSOR_APPLYX_COALESCED_STEP_COUNTER \
+        TH_APPLY_index += TH_APPLY_len; \
+      } \
+    ) \
+  } \
+}
+
+/* unit-stride inner loop for callers of the coalesced apply without a vector kernel */
+#define TH_TENSOR_APPLY2_CONTIG_LOOP(TENSOR1, TENSOR2, CODE) \
+{ \
+  ptrdiff_t TH_APPLY_j; \
+  for (TH_APPLY_j = 0; TH_APPLY_j < TENSOR1##_len; TH_APPLY_j++, TENSOR1##_data++, TENSOR2##_data++) { \
+    CODE \
+  } \
+}
+
+#define TH_TENSOR_APPLY3_CONTIG_LOOP(TENSOR1, TENSOR2, TENSOR3, CODE) \
+{ \
+  ptrdiff_t TH_APPLY_j; \
+  for (TH_APPLY_j = 0; TH_APPLY_j < TENSOR1##_len; TH_APPLY_j++, \
+       TENSOR1##_data++, TENSOR2##_data++, TENSOR3##_data++) { \
+    CODE \
+  } \
+}
+
 
 #ifdef _OPENMP
 
@@ -254,7 +465,7 @@
 #define PRAGMA(P) __pragma(P)
 #endif
 
-#define TH_OMP_OVERHEAD_THRESHOLD_OMP 5000
+#define TH_OMP_OVERHEAD_THRESHOLD_OMP TH_PARALLEL_GRAIN_SIZE
 #include <omp.h>
 #include <x86intrin.h>
 #include <stdio.h>
@@ -268,7 +479,7 @@
   ptrdiff_t iter = 0;\
   if(CONTIG1 && CONTIG2 && CONTIG3){                                                                    \
     if (rp != tp) { \
-      PRAGMA( omp parallel for if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) )  \
+      PRAGMA( omp parallel for num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) )  \
       PRAGMA(ivdep) \
       for (iter = 0; iter < SIZE; iter++) {\
         TYPE1 *TENSOR1##_data = rp+iter;\
@@ -277,7 +488,7 @@
         CODE                                \
       } \
     } else {\
-      PRAGMA( omp parallel for if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) )  \
+      PRAGMA( omp parallel for num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) )  \
       for (iter = 0; iter < SIZE; iter++) {\
         TYPE1 *TENSOR1##_data = rp+iter;\
         TYPE2 *TENSOR2##_data = tp+iter; \
@@ -285,13 +496,16 @@
         CODE                                \
       } \
     }\
+  } else if (THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR2->size, TENSOR2->nDimension) && \
+             THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR3->size, TENSOR3->nDimension)) { \
+    TH_TENSOR_APPLY3_COALESCED(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE, \
+                               TH_TENSOR_APPLY3_CONTIG_LOOP(TENSOR1, TENSOR2, TENSOR3, CODE)) \
   } else{              \
-    int TH_TENSOR_APPLY_hasFinished = 0;\
     int64_t TH_TENSOR_dim_index = 0;\
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE1, TENSOR1, -1, 1) \
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE2, TENSOR2, -1, 1) \
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE3, TENSOR3, -1, 1) \
-    PRAGMA(omp parallel if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) firstprivate(TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i, TENSOR2##_sizes, TENSOR2##_strides, TENSOR2##_dim, TENSOR2##_stride, TENSOR2##_size, TENSOR2##_i, TENSOR3##_sizes, TENSOR3##_strides, TENSOR3##_dim, TENSOR3##_stride, TENSOR3##_size, TENSOR3##_i))\
+    PRAGMA(omp parallel num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) firstprivate(TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i, TENSOR2##_sizes, TENSOR2##_strides, TENSOR2##_dim, TENSOR2##_stride, TENSOR2##_size, TENSOR2##_i, TENSOR3##_sizes, TENSOR3##_strides, TENSOR3##_dim, TENSOR3##_stride, TENSOR3##_size, TENSOR3##_i))\
     {\
       size_t num_threads = omp_get_num_threads();\
       size_t tid = omp_get_thread_num();\
@@ -375,7 +589,7 @@
   ptrdiff_t iter = 0;\
   if( CONTIG1 && CONTIG2 ){                                    \
     if(tp != rp) { \
-      PRAGMA( omp parallel for if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) firstprivate(rp, tp))  \
+      PRAGMA( omp parallel for num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) firstprivate(rp, tp))  \
       PRAGMA(ivdep) \
       for (iter = 0; iter < SIZE; iter++) {                             \
         TYPE2 *TENSOR2##_data = tp+iter;                                \
@@ -383,7 +597,7 @@
         CODE                                                            \
       }\
     } else {\
-      PRAGMA( omp parallel for if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) firstprivate(rp, tp) )  \
+      PRAGMA( omp parallel for num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) firstprivate(rp, tp) )  \
       PRAGMA(simd) \
       for (iter = 0; iter < SIZE; iter++) {\
         TYPE2* TENSOR2##_data = tp+iter;\
@@ -391,12 +605,14 @@
         CODE                                \
       }\
     }\
+  } else if (THSize_isSameSizeAs(TENSOR1->size, TENSOR1->nDimension, TENSOR2->size, TENSOR2->nDimension)) { \
+    TH_TENSOR_APPLY2_COALESCED(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE, \
+                               TH_TENSOR_APPLY2_CONTIG_LOOP(TENSOR1, TENSOR2, CODE)) \
   } else {              \
-    int TH_TENSOR_APPLY_hasFinished = 0; \
     int64_t TH_TENSOR_dim_index = 0; \
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE2, TENSOR2, -1, 1) \
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE1, TENSOR1, -1, 1) \
-    PRAGMA(omp parallel if (SIZE > TH_OMP_OVERHEAD_THRESHOLD_OMP) firstprivate(TENSOR2##_sizes, TENSOR2##_strides, TENSOR2##_dim, TENSOR2##_stride, TENSOR2##_size, TENSOR2##_i, TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i)) \
+    PRAGMA(omp parallel num_threads(THParallelNumThreads(SIZE, TH_OMP_OVERHEAD_THRESHOLD_OMP)) firstprivate(TENSOR2##_sizes, TENSOR2##_strides, TENSOR2##_dim, TENSOR2##_stride, TENSOR2##_size, TENSOR2##_i, TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i)) \
     {                                                                                                    \
       size_t num_threads = omp_get_num_threads();                                                        \
       size_t tid = omp_get_thread_num();                                                                 \
@@ -443,16 +659,15 @@
   ptrdiff_t iter = 0;\
   if(TENSOR1##Contg){                                    \
     TYPE1 *TENSOR1##_data = NULL;         \
-    PRAGMA( omp parallel for if (TENSOR1##Size > TH_OMP_OVERHEAD_THRESHOLD_OMP) private(TENSOR1##_data,  iter) reduction(OPERATION) ) \
+    PRAGMA( omp parallel for num_threads(THParallelNumThreads(TENSOR1##Size, TH_OMP_OVERHEAD_THRESHOLD_OMP)) private(TENSOR1##_data,  iter) reduction(OPERATION) ) \
     for (iter = 0; iter < TENSOR1##Size; iter++) {\
       TENSOR1##_data = rp+iter;\
       CODE                                \
     }\
   } else { \
-    int TH_TENSOR_APPLY_hasFinished = 0;\
     int64_t TH_TENSOR_dim_index = 0;\
     __TH_TENSOR_APPLYX_PREAMBLE(TYPE1, TENSOR1, -1, 1);\
-    PRAGMA(omp parallel if (TENSOR1##Size > TH_OMP_OVERHEAD_THRESHOLD_OMP) firstprivate(TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i) reduction(OPERATION))\
+    PRAGMA(omp parallel num_threads(THParallelNumThreads(TENSOR1##Size, TH_OMP_OVERHEAD_THRESHOLD_OMP)) firstprivate(TENSOR1##_sizes, TENSOR1##_strides, TENSOR1##_dim, TENSOR1##_stride, TENSOR1##_size, TENSOR1##_i) reduction(OPERATION))\
     {\
       size_t num_threads = omp_get_num_threads();\
       size_t tid = omp_get_thread_num();\
@@ -57,6 +57,22 @@ THStorage* THStorage_(newWithMapping)(const char *filename, ptrdiff_t size, int
   return storage;
 }
 
+THStorage* THStorage_(newWithMappingAtOffset)(const char *filename, ptrdiff_t offset, ptrdiff_t size, int flags)
+{
+  THMapAllocatorContext *ctx = THMapAllocatorContext_newWithOffset(filename, flags, offset);
+
+  THStorage *storage = THStorage_(newWithAllocator)(size,
+                                                    &THMapAllocator,
+                                                    ctx);
+
+  if(size <= 0)
+    storage->size = THMapAllocatorContext_size(ctx)/sizeof(real);
+
+  THStorage_(clearFlag)(storage, TH_STORAGE_RESIZABLE);
+
+  return storage;
+}
+
 THStorage* THStorage_(newWithSize1)(real data0)
 {
   THStorage *self = THStorage_(newWithSize)(1);
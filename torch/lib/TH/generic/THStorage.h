@@ -47,6 +47,7 @@ TH_API THStorage* THStorage_(newWithSize2)(real, real);
 TH_API THStorage* THStorage_(newWithSize3)(real, real, real);
 TH_API THStorage* THStorage_(newWithSize4)(real, real, real, real);
 TH_API THStorage* THStorage_(newWithMapping)(const char *filename, ptrdiff_t size, int flags);
+TH_API THStorage* THStorage_(newWithMappingAtOffset)(const char *filename, ptrdiff_t offset, ptrdiff_t size, int flags);
 
 /* takes ownership of data */
 TH_API THStorage* THStorage_(newWithData)(real *data, ptrdiff_t size);
@@ -8,8 +8,8 @@
 #define PRAGMA(P) __pragma(P)
 #endif
 
-#ifdef _OPENMP
 #define TH_OMP_OVERHEAD_THRESHOLD_COPY 20000
+#ifdef _OPENMP
 #include <omp.h>
 #endif
 
@@ -80,6 +80,17 @@ void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
   #undef MAX
 }
 
+/* ctx holds the destination and source data pointers */
+static void THTensor_(copyContiguousRange)(void *ctx, ptrdiff_t begin, ptrdiff_t end)
+{
+  real **ptrs = (real **)ctx;
+#ifndef TH_REAL_IS_HALF
+  THVector_(copy)(ptrs[0] + begin, ptrs[1] + begin, end - begin);
+#else
+  memcpy(ptrs[0] + begin, ptrs[1] + begin, (end - begin) * sizeof(real));
+#endif
+}
+
 void THTensor_(copy)(THTensor *tensor, THTensor *src)
 {
   if (tensor == src) return;
@@ -89,61 +100,24 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
   int srcContig = THTensor_(isContiguous)(src);
 
   int serial_path = 0;
-#ifdef _OPENMP
-  int inOMP = omp_in_parallel();
-#endif
   if (tensorSize == srcSize) {
     if ( tensorContig && srcContig) {
-      real *sp = THTensor_(data)(src);
-      real *rp = THTensor_(data)(tensor);
-#ifndef TH_REAL_IS_HALF
-#ifdef _OPENMP
-      #pragma omp parallel if ((tensorSize > TH_OMP_OVERHEAD_THRESHOLD_COPY)&&(!inOMP))
-      {
-        size_t num_threads = omp_get_num_threads();
-        size_t tid = omp_get_thread_num();
-        ptrdiff_t offset = tid * (tensorSize / num_threads);
-        ptrdiff_t end = tid == num_threads - 1? tensorSize : offset + tensorSize / num_threads;
-        ptrdiff_t len = end - offset;
-        real *tensorData = rp + offset;
-        real *srcData = sp + offset;
-        THVector_(copy)(tensorData, srcData, len);  
-      }
-#else
-        THVector_(copy)(rp, sp, srcSize);  
-#endif
-
-#else
-
-#ifdef _OPENMP
-      if ((srcSize > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!inOMP)) {
-        ptrdiff_t i;
-        #pragma omp parallel for private (i)
-        for(i=0; i<srcSize; i++){
-          rp[i] = sp[i];
-        }
-      } else {
-        memcpy(rp, sp, srcSize * sizeof(real));
-      }
-#else
-      memcpy(rp, sp, srcSize * sizeof(real));
-#endif
-
-#endif
-
+      real *ptrs[2];
+      ptrs[0] = THTensor_(data)(tensor);
+      ptrs[1] = THTensor_(data)(src);
+      THParallelFor(0, srcSize, TH_OMP_OVERHEAD_THRESHOLD_COPY,
+                    THTensor_(copyContiguousRange), ptrs);
 #ifndef TH_REAL_IS_HALF
     } else if (THTensor_(copyTransposeValid)(tensor, src)) {
       THTensor_(copyTranspose)(tensor, src);
 #endif
     } else {
-#ifdef _OPENMP
-      if (inOMP) {
-        serial_path = 1;
-      } else {
-        TH_TENSOR_APPLY2_OMP(srcSize, tensorContig, srcContig, real, tensor, real, src, *tensor_data = *src_data;)
-      }
+#ifndef TH_REAL_IS_HALF
+      TH_TENSOR_APPLY2_COALESCED(real, tensor, real, src, *tensor_data = *src_data;,
+                                 THVector_(copy)(tensor_data, src_data, tensor_len););
 #else
-      serial_path = 1;
+      TH_TENSOR_APPLY2_COALESCED(real, tensor, real, src, *tensor_data = *src_data;,
+                                 memcpy(tensor_data, src_data, tensor_len * sizeof(real)););
 #endif
     }
   } else {
@@ -158,25 +132,29 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
 #define IMPLEMENT_THTensor_COPY(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
-  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)(*src_data);) \
+  TH_TENSOR_APPLY2_COALESCED(real, tensor, TYPE_SRC, src, *tensor_data = (real)(*src_data);, \
+                             THVector_(copy##TYPENAMESRC)(tensor_data, src_data, tensor_len);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
- TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = TH_float2half((float)*src_data);) \
+  TH_TENSOR_APPLY2_COALESCED(real, tensor, TYPE_SRC, src, *tensor_data = TH_float2half((float)*src_data);, \
+                             TH##TYPENAMESRC##Vector_copyToHalf(tensor_data, src_data, tensor_len);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
- TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)TH_half2float(*src_data);) \
+  TH_TENSOR_APPLY2_COALESCED(real, tensor, TYPE_SRC, src, *tensor_data = (real)TH_half2float(*src_data);, \
+                             THVector_(copyHalf)(tensor_data, src_data, tensor_len);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
- TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;) \
+  TH_TENSOR_APPLY2_COALESCED(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;, \
+                             memcpy(tensor_data, src_data, tensor_len * sizeof(real));) \
 }
 
 #ifndef TH_REAL_IS_HALF
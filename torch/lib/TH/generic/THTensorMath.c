@@ -10,7 +10,7 @@
 #include <omp.h>
 #endif
 
-#define TH_OMP_OVERHEAD_THRESHOLD 5000
+#define TH_OMP_OVERHEAD_THRESHOLD TH_PARALLEL_GRAIN_SIZE
 
 #ifdef _OPENMP
 
@@ -23,7 +23,7 @@
 #define TH_TENSOR_APPLY_CONTIG(TYPE, TENSOR, CODE) \
 { \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
+  PRAGMA(omp parallel num_threads(THParallelNumThreads(TH_TENSOR_size, TH_OMP_OVERHEAD_THRESHOLD))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -47,9 +47,8 @@
 #ifdef _OPENMP
 #define TH_TENSOR_APPLY2_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, CODE) \
 { \
-  int inOmp = omp_in_parallel(); \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if ((TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD) && (!inOmp))) \
+  PRAGMA(omp parallel num_threads(THParallelNumThreads(TH_TENSOR_size, TH_OMP_OVERHEAD_THRESHOLD))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -76,7 +75,7 @@
 #define TH_TENSOR_APPLY3_CONTIG(TYPE1, TENSOR1, TYPE2, TENSOR2, TYPE3, TENSOR3, CODE) \
 { \
   ptrdiff_t TH_TENSOR_size = THTensor_(nElement)(TENSOR1); \
-  PRAGMA(omp parallel if (TH_TENSOR_size > TH_OMP_OVERHEAD_THRESHOLD)) \
+  PRAGMA(omp parallel num_threads(THParallelNumThreads(TH_TENSOR_size, TH_OMP_OVERHEAD_THRESHOLD))) \
   { \
     size_t num_threads = omp_get_num_threads(); \
     size_t tid = omp_get_thread_num(); \
@@ -280,11 +279,11 @@ void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTens
     }
 
     if (src->nDimension == 1) {
-      #pragma omp parallel for if(numel > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(numel, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<numel; i++)
         tensor_data[i] = src_data[index_data[i] - TH_INDEX_BASE];
     } else {
-      #pragma omp parallel for if(numel*rowsize > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(numel*rowsize, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<numel; i++)
         memcpy(tensor_data + i*rowsize, src_data + (index_data[i] - TH_INDEX_BASE)*rowsize, rowsize*sizeof(real));
     }
@@ -381,14 +380,14 @@ void THTensor_(take)(THTensor *r_, THTensor *src, THLongTensor *index)
   ptrdiff_t nIndices = THLongTensor_nElement(index);
   if (THTensor_(isContiguous)(src)) {
     ptrdiff_t i;
-    #pragma omp parallel for if(nIndices > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(nIndices, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i = 0; i < nIndices; i++) {
       int64_t linearIndex = THTensor_(wrapLinearIndex)(index_data[i], srcElements);
       dst_data[i] = src_data[linearIndex];
     }
   } else {
     ptrdiff_t i;
-    #pragma omp parallel for if(nIndices > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(nIndices, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i = 0; i < nIndices; i++) {
       int64_t linearIndex = THTensor_(wrapLinearIndex)(index_data[i], srcElements);
       int64_t dataOffset = THTensor_(dataOffset)(src, linearIndex);
@@ -768,26 +767,13 @@ accreal THTensor_(prodall)(THTensor *tensor)
 void THTensor_(add)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
-  int64_t r_Size = THTensor_(nElement)(r_);
   int r_Contig = THTensor_(isContiguous)(r_);
   int tContig = THTensor_(isContiguous)(t);
-  int serial_path = 0;
   if (r_Contig && tContig) {
     TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(adds)(r__data, t_data, value, r__len););
   } else {
-#ifdef _OPENMP
-    int inOMP = omp_in_parallel();
-    if (inOMP) {
-      serial_path = 1;
-    } else {
-      TH_TENSOR_APPLY2_OMP(r_Size, r_Contig, tContig, real, r_, real, t, *r__data = *t_data + value;)
-    }
-#else
-      serial_path = 1;
-#endif
-  }
-  if (serial_path) {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data + value;);
+    TH_TENSOR_APPLY2_COALESCED(real, r_, real, t, *r__data = *t_data + value;,
+                               THVector_(adds)(r__data, t_data, value, r__len););
   }
 }
 
@@ -809,52 +795,26 @@ void THTensor_(sub_scaled)(THTensor *r_, THTensor *t, real value, real alpha)
 void THTensor_(mul)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
-  int64_t r_Size = THTensor_(nElement)(r_);
   int r_Contig = THTensor_(isContiguous)(r_);
   int tContig = THTensor_(isContiguous)(t);
-  int serial_path = 0;
   if (r_Contig && tContig) {
     TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(muls)(r__data, t_data, value, r__len););
   } else {
-#ifdef _OPENMP
-    int inOMP = omp_in_parallel();
-    if (inOMP) {
-      serial_path = 1;
-    } else {
-      TH_TENSOR_APPLY2_OMP(r_Size, r_Contig, tContig, real, r_, real, t, *r__data = *t_data * value;)
-    }
-#else
-    serial_path = 1;
-#endif
-  }
-  if (serial_path) {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data * value;);
+    TH_TENSOR_APPLY2_COALESCED(real, r_, real, t, *r__data = *t_data * value;,
+                               THVector_(muls)(r__data, t_data, value, r__len););
   }
 }
 
 void THTensor_(div)(THTensor *r_, THTensor *t, real value)
 {
   THTensor_(resizeAs)(r_, t);
-  int64_t r_Size = THTensor_(nElement)(r_);
   int r_Contig = THTensor_(isContiguous)(r_);
   int tContig = THTensor_(isContiguous)(t);
-  int serial_path = 0;
   if (r_Contig && tContig) {
     TH_TENSOR_APPLY2_CONTIG(real, r_, real, t, THVector_(divs)(r__data, t_data, value, r__len););
   } else {
-#ifdef _OPENMP
-    int inOMP = omp_in_parallel();
-    if (inOMP) {
-      serial_path = 1;
-    } else {
-      TH_TENSOR_APPLY2_OMP(r_Size, r_Contig, tContig, real, r_, real, t, *r__data = *t_data / value;)
-    }
-#else
-    serial_path = 1;
-#endif
-  }
-  if (serial_path) {
-    TH_TENSOR_APPLY2(real, r_, real, t, *r__data = *t_data / value;);
+    TH_TENSOR_APPLY2_COALESCED(real, r_, real, t, *r__data = *t_data / value;,
+                               THVector_(divs)(r__data, t_data, value, r__len););
   }
 }
 
@@ -876,7 +836,7 @@ void THTensor_(lshift)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD * 100)) private(i)
     for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_BYTE)
       rp[i] = ((real) tp[i]) << value;
@@ -928,7 +888,7 @@ void THTensor_(rshift)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD * 100)) private(i)
     for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_BYTE)
       rp[i] = ((real) tp[i]) >> value;
@@ -973,7 +933,7 @@ void THTensor_(fmod)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       rp[i] = fmod(tp[i], value);
@@ -1017,7 +977,7 @@ void THTensor_(remainder)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
       rp[i] = (value == 0)? NAN : tp[i] - value * floor(tp[i] / value);
@@ -1071,7 +1031,7 @@ void THTensor_(bitand)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD * 100)) private(i)
     for (i=0; i<r_Size; i++) {
       rp[i] = tp[i] & value;
     }
@@ -1107,7 +1067,7 @@ void THTensor_(bitor)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD * 100)) private(i)
     for (i=0; i<r_Size; i++) {
       rp[i] = tp[i] | value;
     }
@@ -1143,7 +1103,7 @@ void THTensor_(bitxor)(THTensor *r_, THTensor *t, real value)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD * 100) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD * 100)) private(i)
     for (i=0; i<r_Size; i++) {
       rp[i] = tp[i] ^ value;
     }
@@ -1177,7 +1137,7 @@ void THTensor_(clamp)(THTensor *r_, THTensor *t, real min_value, real max_value)
     real *rp = THTensor_(data)(r_);
     /* real t_val; */
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i=0; i<r_Size; i++)
       rp[i] = (tp[i] < min_value) ? min_value : (tp[i] > max_value ? max_value : tp[i]);
   } else {
@@ -1214,16 +1174,8 @@ void THTensor_(cadd)(THTensor *r_, THTensor *t, real value, THTensor *src)
         TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cadd)(r__data, t_data, src_data, value, r__len););
       }
     } else {
-#if _OPENMP
-      int inOMP = omp_in_parallel();
-      if (inOMP) {
-        serial_path = 1;
-      } else {
-        TH_TENSOR_APPLY3_OMP(r_Size, r_Contig, tContig, srcContig, real, r_, real, t, real, src, *r__data = *t_data + value * *src_data;);
-      }
-#else
-      serial_path = 1;
-#endif
+      TH_TENSOR_APPLY3_COALESCED(real, r_, real, t, real, src, *r__data = *t_data + value * *src_data;,
+                                 THVector_(cadd)(r__data, t_data, src_data, value, r__len););
     }
   } else {
     serial_path = 1;
@@ -1251,16 +1203,8 @@ void THTensor_(cmul)(THTensor *r_, THTensor *t, THTensor *src)
     if (r_Contig && tContig && srcContig) {
       TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cmul)(r__data, t_data, src_data, r__len););
     } else {
-#if _OPENMP
-      int inOMP = omp_in_parallel();
-      if (inOMP) {
-        serial_path = 1;
-      } else {
-        TH_TENSOR_APPLY3_OMP(r_Size, r_Contig, tContig, srcContig, real, r_, real, t, real, src, *r__data = *t_data * *src_data;);
-      }
-#else
-      serial_path = 1;
-#endif
+      TH_TENSOR_APPLY3_COALESCED(real, r_, real, t, real, src, *r__data = *t_data * *src_data;,
+                                 THVector_(cmul)(r__data, t_data, src_data, r__len););
     }
   } else {
     serial_path = 1;
@@ -1285,7 +1229,7 @@ void THTensor_(cpow)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++)
         rp[i] = pow(tp[i], sp[i]);
     } else {
@@ -1321,16 +1265,8 @@ void THTensor_(cdiv)(THTensor *r_, THTensor *t, THTensor *src)
     if (r_Contig && tContig && srcContig) {
       TH_TENSOR_APPLY3_CONTIG(real, r_, real, t, real, src, THVector_(cdiv)(r__data, t_data, src_data, r__len););
     } else {
-#if _OPENMP
-      int inOMP = omp_in_parallel();
-      if (inOMP) {
-        serial_path = 1;
-      } else {
-        TH_TENSOR_APPLY3_OMP(r_Size, r_Contig, tContig, srcContig, real, r_, real, t, real, src, *r__data = *t_data / *src_data;);
-      }
-#else
-      serial_path = 1;
-#endif
+      TH_TENSOR_APPLY3_COALESCED(real, r_, real, t, real, src, *r__data = *t_data / *src_data;,
+                                 THVector_(cdiv)(r__data, t_data, src_data, r__len););
     }
   } else {
     serial_path = 1;
@@ -1358,7 +1294,7 @@ void THTensor_(clshift)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT)
         rp[i] = tp[i] * powf(2, sp[i]);
@@ -1424,7 +1360,7 @@ void THTensor_(crshift)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT)
         rp[i] = tp[i] / powf(2, sp[i]);
@@ -1487,7 +1423,7 @@ void THTensor_(cfmod)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
         rp[i] = fmod(tp[i], sp[i]);
@@ -1538,7 +1474,7 @@ void THTensor_(cremainder)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
         rp[i] = (sp[i] == 0)? NAN : tp[i] - sp[i] * floor(tp[i] / sp[i]);
@@ -1599,7 +1535,7 @@ void THTensor_(cbitand)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
         rp[i] = tp[i] & sp[i];
       }
@@ -1642,7 +1578,7 @@ void THTensor_(cbitor)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
         rp[i] = tp[i] | sp[i];
       }
@@ -1685,7 +1621,7 @@ void THTensor_(cbitxor)(THTensor *r_, THTensor *t, THTensor *src)
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(r_);
       int64_t i;
-      #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
       for (i=0; i<r_Size; i++) {
         rp[i] = tp[i] ^ sp[i];
       }
@@ -1721,7 +1657,7 @@ void THTensor_(tpow)(THTensor *r_, real value, THTensor *t)
     real *tp = THTensor_(data)(t);
     real *rp = THTensor_(data)(r_);
     int64_t i;
-    #pragma omp parallel for if(r_Size > TH_OMP_OVERHEAD_THRESHOLD) private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD)) private(i)
     for (i=0; i<r_Size; i++)
       rp[i] = pow(value, tp[i]);
   } else {
@@ -2359,7 +2295,7 @@ void THTensor_(sum)(THTensor *r_, THTensor *t, int dimension, int keepdim)
       ptrdiff_t iter = 0;
       ptrdiff_t r_Size = THTensor_(nElement)(r_);
       int r_Dim = r_->nDimension;
-      #pragma omp parallel for if ( r_Size > TH_OMP_OVERHEAD_THRESHOLD)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD))
       for (iter = 0; iter < r_Size; iter++) {
         int j;
         int64_t quot;
@@ -2438,7 +2374,7 @@ void THTensor_(prod)(THTensor *r_, THTensor *t, int dimension, int keepdim)
       ptrdiff_t iter = 0;
       ptrdiff_t r_Size = THTensor_(nElement)(r_);
       int r_Dim = r_->nDimension;
-      #pragma omp parallel for if ( r_Size > TH_OMP_OVERHEAD_THRESHOLD)
+      #pragma omp parallel for num_threads(THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD))
       for (iter = 0; iter < r_Size; iter++) {
         int j;
         int64_t quot;
@@ -3577,8 +3513,7 @@ TENSOR_IMPLEMENT_LOGICAL(ne,!=)
     ptrdiff_t r_Size = THTensor_(nElement)(r_);               \
     int r_Contig = THTensor_(isContiguous)(r_);               \
     int tContig = THTensor_(isContiguous)(t);                 \
-    int inOMP = omp_in_parallel();                            \
-    if( (r_Size > TH_OMP_OVERHEAD_THRESHOLD) && (!inOMP) ){   \
+    if (THParallelNumThreads(r_Size, TH_OMP_OVERHEAD_THRESHOLD) > 1) {            \
       TH_TENSOR_APPLY2_OMP(r_Size, r_Contig, tContig, real, r_, real, t, *r__data = CFUNC(*t_data););        \
     }                                                                                                        \
     else {                                                                                                   \
@@ -0,0 +1,151 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/THTensorOptim.c"
+#else
+
+/*
+ * The parameters of a model are usually many tensors of very different
+ * sizes. They are cut into pieces of at most TH_OPTIM_PIECE_SIZE elements
+ * so that a single parallel loop covers all of them, and each piece is
+ * updated in one pass by a THVector kernel.
+ */
+
+#ifndef TH_OPTIM_PIECE
+#define TH_OPTIM_PIECE
+
+#define TH_OPTIM_PIECE_SIZE 32768
+
+typedef struct {
+  int tensor;
+  ptrdiff_t offset;
+  ptrdiff_t size;
+} THOptimPiece;
+
+#endif
+
+static void THTensor_(optimCheck)(THTensor **params, THTensor **list, int n, int argNumber)
+{
+  int i;
+  if (!list)
+    return;
+  for (i = 0; i < n; i++) {
+    THArgCheck(THTensor_(isContiguous)(list[i]), argNumber, "tensor %d is not contiguous", i);
+    THArgCheck(THTensor_(nElement)(list[i]) == THTensor_(nElement)(params[i]), argNumber,
+               "tensor %d has %ld elements, but its parameter has %ld", i,
+               (long)THTensor_(nElement)(list[i]), (long)THTensor_(nElement)(params[i]));
+  }
+}
+
+static THOptimPiece* THTensor_(optimPieces)(THTensor **params, int n, ptrdiff_t *nPieces,
+                                            ptrdiff_t *total)
+{
+  int i;
+  ptrdiff_t count = 0, offset;
+  *total = 0;
+  for (i = 0; i < n; i++) {
+    ptrdiff_t size = THTensor_(nElement)(params[i]);
+    count += (size + TH_OPTIM_PIECE_SIZE - 1) / TH_OPTIM_PIECE_SIZE;
+    *total += size;
+  }
+
+  THOptimPiece *pieces = (THOptimPiece*)THAlloc(sizeof(THOptimPiece) * THMax(count, 1));
+  *nPieces = 0;
+  for (i = 0; i < n; i++) {
+    ptrdiff_t size = THTensor_(nElement)(params[i]);
+    for (offset = 0; offset < size; offset += TH_OPTIM_PIECE_SIZE) {
+      THOptimPiece *piece = &pieces[(*nPieces)++];
+      piece->tensor = i;
+      piece->offset = offset;
+      piece->size = THMin(TH_OPTIM_PIECE_SIZE, size - offset);
+    }
+  }
+  return pieces;
+}
+
+#define TH_OPTIM_DATA(LIST, PIECE) \
+  ((LIST) ? THTensor_(data)((LIST)[(PIECE)->tensor]) + (PIECE)->offset : NULL)
+
+void THTensor_(adamStep)(THTensor **params, THTensor **grads, THTensor **expAvgs,
+                         THTensor **expAvgSqs, int n, real stepSize, real beta1,
+                         real beta2, real eps, real weightDecay)
+{
+  ptrdiff_t nPieces, total, i;
+  THTensor_(optimCheck)(params, params, n, 1);
+  THTensor_(optimCheck)(params, grads, n, 2);
+  THTensor_(optimCheck)(params, expAvgs, n, 3);
+  THTensor_(optimCheck)(params, expAvgSqs, n, 4);
+  THOptimPiece *pieces = THTensor_(optimPieces)(params, n, &nPieces, &total);
+
+#pragma omp parallel for schedule(dynamic) num_threads(THParallelNumThreads(total, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nPieces; i++) {
+    THOptimPiece *piece = &pieces[i];
+    THVector_(adam)(TH_OPTIM_DATA(params, piece), TH_OPTIM_DATA(grads, piece),
+                    TH_OPTIM_DATA(expAvgs, piece), TH_OPTIM_DATA(expAvgSqs, piece),
+                    stepSize, beta1, beta2, eps, weightDecay, piece->size);
+  }
+  THFree(pieces);
+}
+
+void THTensor_(adagradStep)(THTensor **params, THTensor **grads, THTensor **sums, int n,
+                            real lr, real eps, real weightDecay)
+{
+  ptrdiff_t nPieces, total, i;
+  THTensor_(optimCheck)(params, params, n, 1);
+  THTensor_(optimCheck)(params, grads, n, 2);
+  THTensor_(optimCheck)(params, sums, n, 3);
+  THOptimPiece *pieces = THTensor_(optimPieces)(params, n, &nPieces, &total);
+
+#pragma omp parallel for schedule(dynamic) num_threads(THParallelNumThreads(total, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nPieces; i++) {
+    THOptimPiece *piece = &pieces[i];
+    THVector_(adagrad)(TH_OPTIM_DATA(params, piece), TH_OPTIM_DATA(grads, piece),
+                       TH_OPTIM_DATA(sums, piece), lr, eps, weightDecay, piece->size);
+  }
+  THFree(pieces);
+}
+
+void THTensor_(sgdStep)(THTensor **params, THTensor **grads, THTensor **momentumBuffers,
+                        int n, real lr, real momentum, real dampening, real weightDecay,
+                        int nesterov)
+{
+  ptrdiff_t nPieces, total, i;
+  THTensor_(optimCheck)(params, params, n, 1);
+  THTensor_(optimCheck)(params, grads, n, 2);
+  THTensor_(optimCheck)(params, momentumBuffers, n, 3);
+  THOptimPiece *pieces = THTensor_(optimPieces)(params, n, &nPieces, &total);
+
+#pragma omp parallel for schedule(dynamic) num_threads(THParallelNumThreads(total, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nPieces; i++) {
+    THOptimPiece *piece = &pieces[i];
+    THVector_(sgd)(TH_OPTIM_DATA(params, piece), TH_OPTIM_DATA(grads, piece),
+                   TH_OPTIM_DATA(momentumBuffers, piece), lr, momentum, dampening,
+                   weightDecay, nesterov, piece->size);
+  }
+  THFree(pieces);
+}
+
+void THTensor_(rmspropStep)(THTensor **params, THTensor **grads, THTensor **squareAvgs,
+                            THTensor **gradAvgs, THTensor **momentumBuffers, int n,
+                            real lr, real alpha, real eps, real weightDecay, real momentum)
+{
+  ptrdiff_t nPieces, total, i;
+  THTensor_(optimCheck)(params, params, n, 1);
+  THTensor_(optimCheck)(params, grads, n, 2);
+  THTensor_(optimCheck)(params, squareAvgs, n, 3);
+  THTensor_(optimCheck)(params, gradAvgs, n, 4);
+  THTensor_(optimCheck)(params, momentumBuffers, n, 5);
+  THOptimPiece *pieces = THTensor_(optimPieces)(params, n, &nPieces, &total);
+
+#pragma omp parallel for schedule(dynamic) num_threads(THParallelNumThreads(total, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nPieces; i++) {
+    THOptimPiece *piece = &pieces[i];
+    THVector_(rmsprop)(TH_OPTIM_DATA(params, piece), TH_OPTIM_DATA(grads, piece),
+                       TH_OPTIM_DATA(squareAvgs, piece), TH_OPTIM_DATA(gradAvgs, piece),
+                       TH_OPTIM_DATA(momentumBuffers, piece), lr, alpha, eps, weightDecay,
+                       momentum, piece->size);
+  }
+  THFree(pieces);
+}
+
+#undef TH_OPTIM_DATA
+
+#endif
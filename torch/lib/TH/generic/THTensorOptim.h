@@ -0,0 +1,21 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/THTensorOptim.h"
+#else
+
+/* Fused optimizer steps over lists of n parameters. Every tensor must be
+ * contiguous, and the i-th entry of each list must have as many elements as
+ * params[i]. Optional lists (momentumBuffers, gradAvgs) may be NULL. */
+TH_API void THTensor_(adamStep)(THTensor **params, THTensor **grads, THTensor **expAvgs,
+                                THTensor **expAvgSqs, int n, real stepSize, real beta1,
+                                real beta2, real eps, real weightDecay);
+TH_API void THTensor_(adagradStep)(THTensor **params, THTensor **grads, THTensor **sums, int n,
+                                   real lr, real eps, real weightDecay);
+/* like the unfused step, sgdStep adds the weight decay to grads in place */
+TH_API void THTensor_(sgdStep)(THTensor **params, THTensor **grads, THTensor **momentumBuffers,
+                               int n, real lr, real momentum, real dampening, real weightDecay,
+                               int nesterov);
+TH_API void THTensor_(rmspropStep)(THTensor **params, THTensor **grads, THTensor **squareAvgs,
+                                   THTensor **gradAvgs, THTensor **momentumBuffers, int n,
+                                   real lr, real alpha, real eps, real weightDecay, real momentum);
+
+#endif
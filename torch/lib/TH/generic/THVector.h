@@ -11,6 +11,18 @@ TH_API void THVector_(cdiv)(real *z, const real *x, const real *y, const ptrdiff
 TH_API void THVector_(divs)(real *y, const real *x, const real c, const ptrdiff_t n);
 TH_API void THVector_(copy)(real *y, const real *x, const ptrdiff_t n);
 
+/* converting copies, y[i] = (real)x[i] */
+TH_API void THVector_(copyByte)(real *y, const uint8_t *x, const ptrdiff_t n);
+TH_API void THVector_(copyChar)(real *y, const int8_t *x, const ptrdiff_t n);
+TH_API void THVector_(copyShort)(real *y, const int16_t *x, const ptrdiff_t n);
+TH_API void THVector_(copyInt)(real *y, const int32_t *x, const ptrdiff_t n);
+TH_API void THVector_(copyLong)(real *y, const int64_t *x, const ptrdiff_t n);
+TH_API void THVector_(copyFloat)(real *y, const float *x, const ptrdiff_t n);
+TH_API void THVector_(copyDouble)(real *y, const double *x, const ptrdiff_t n);
+TH_API void THVector_(copyHalf)(real *y, const THHalf *x, const ptrdiff_t n);
+/* there is no THHalfVector, so conversions to half live with the source type */
+TH_API void THVector_(copyToHalf)(THHalf *y, const real *x, const ptrdiff_t n);
+
 #if defined(TH_REAL_IS_SHORT) || defined(TH_REAL_IS_INT) || defined(TH_REAL_IS_LONG)
 TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 #endif
@@ -45,6 +57,23 @@ TH_API void THVector_(trunc)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(frac)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(cinv)(real *y, const real *x, const ptrdiff_t n);
 
+/* fused optimizer updates, applied in place to a contiguous run of a
+ * parameter p with gradient g and the matching run of its state buffers */
+TH_API void THVector_(adam)(real *p, const real *g, real *expAvg, real *expAvgSq, const real stepSize,
+                            const real beta1, const real beta2, const real eps, const real weightDecay,
+                            const ptrdiff_t n);
+TH_API void THVector_(adagrad)(real *p, const real *g, real *sum, const real lr, const real eps,
+                               const real weightDecay, const ptrdiff_t n);
+/* momentum is NULL when it is 0. Like the unfused step, the weight decay is
+ * added to g in place. */
+TH_API void THVector_(sgd)(real *p, real *g, real *momentumBuffer, const real lr,
+                           const real momentum, const real dampening, const real weightDecay,
+                           const int nesterov, const ptrdiff_t n);
+/* gradAvg is NULL when not centered, momentumBuffer when momentum is 0 */
+TH_API void THVector_(rmsprop)(real *p, const real *g, real *squareAvg, real *gradAvg,
+                               real *momentumBuffer, const real lr, const real alpha, const real eps,
+                               const real weightDecay, const real momentum, const ptrdiff_t n);
+
 #endif /* floating point only part */
 
 #ifndef TH_REAL_IS_BYTE
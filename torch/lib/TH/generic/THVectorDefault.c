@@ -17,6 +17,35 @@ void THVector_(copy_DEFAULT)(real *x, const real *y, const ptrdiff_t n) {
     x[i] = y[i];
 }
 
+#define THVECTOR_IMPLEMENT_COPY_DEFAULT(TYPENAMESRC, TYPE_SRC) \
+void THVector_(copy##TYPENAMESRC##_DEFAULT)(real *y, const TYPE_SRC *x, const ptrdiff_t n) { \
+  ptrdiff_t i = 0; \
+  for(; i < n; i++) \
+    y[i] = (real)x[i]; \
+}
+
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Byte, uint8_t)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Char, int8_t)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Short, int16_t)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Int, int32_t)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Long, int64_t)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Float, float)
+THVECTOR_IMPLEMENT_COPY_DEFAULT(Double, double)
+
+#undef THVECTOR_IMPLEMENT_COPY_DEFAULT
+
+void THVector_(copyHalf_DEFAULT)(real *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i = 0;
+  for(; i < n; i++)
+    y[i] = (real)TH_half2float(x[i]);
+}
+
+void THVector_(copyToHalf_DEFAULT)(THHalf *y, const real *x, const ptrdiff_t n) {
+  ptrdiff_t i = 0;
+  for(; i < n; i++)
+    y[i] = TH_float2half((float)x[i]);
+}
+
 void THVector_(fill_DEFAULT)(real *x, const real c, const ptrdiff_t n) {
   ptrdiff_t i = 0;
 
@@ -203,6 +232,77 @@ VECTOR_IMPLEMENT_FUNCTION(trunc,TH_MATH_NAME(trunc))
 VECTOR_IMPLEMENT_FUNCTION(frac,TH_MATH_NAME(TH_frac))
 VECTOR_IMPLEMENT_FUNCTION(cinv, TH_MATH_NAME(1.0) / )
 
+void THVector_(adam_DEFAULT)(real *p, const real *g, real *expAvg, real *expAvgSq, const real stepSize,
+                             const real beta1, const real beta2, const real eps, const real weightDecay,
+                             const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    real grad = g[i] + weightDecay * p[i];
+    expAvg[i] = beta1 * expAvg[i] + (1 - beta1) * grad;
+    expAvgSq[i] = beta2 * expAvgSq[i] + (1 - beta2) * grad * grad;
+    p[i] -= stepSize * expAvg[i] / (TH_MATH_NAME(sqrt)(expAvgSq[i]) + eps);
+  }
+}
+
+void THVector_(adagrad_DEFAULT)(real *p, const real *g, real *sum, const real lr, const real eps,
+                                const real weightDecay, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    real grad = g[i] + weightDecay * p[i];
+    sum[i] += grad * grad;
+    p[i] -= lr * grad / (TH_MATH_NAME(sqrt)(sum[i]) + eps);
+  }
+}
+
+void THVector_(sgd)(real *p, real *g, real *momentumBuffer, const real lr,
+                    const real momentum, const real dampening, const real weightDecay,
+                    const int nesterov, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  if (!momentumBuffer) {
+    for (i = 0; i < n; i++) {
+      real grad = g[i] + weightDecay * p[i];
+      if (weightDecay != 0)
+        g[i] = grad;
+      p[i] -= lr * grad;
+    }
+    return;
+  }
+  for (i = 0; i < n; i++) {
+    real grad = g[i] + weightDecay * p[i];
+    if (weightDecay != 0)
+      g[i] = grad;
+    real buf = momentum * momentumBuffer[i] + (1 - dampening) * grad;
+    momentumBuffer[i] = buf;
+    p[i] -= lr * (nesterov ? grad + momentum * buf : buf);
+  }
+}
+
+void THVector_(rmsprop)(real *p, const real *g, real *squareAvg, real *gradAvg,
+                        real *momentumBuffer, const real lr, const real alpha, const real eps,
+                        const real weightDecay, const real momentum, const ptrdiff_t n)
+{
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    real grad = g[i] + weightDecay * p[i];
+    real sq = alpha * squareAvg[i] + (1 - alpha) * grad * grad;
+    squareAvg[i] = sq;
+    if (gradAvg) {
+      real ga = alpha * gradAvg[i] + (1 - alpha) * grad;
+      gradAvg[i] = ga;
+      sq -= ga * ga;
+    }
+    real step = grad / (TH_MATH_NAME(sqrt)(sq) + eps);
+    if (momentumBuffer) {
+      momentumBuffer[i] = momentum * momentumBuffer[i] + step;
+      step = momentumBuffer[i];
+    }
+    p[i] -= lr * step;
+  }
+}
+
 #undef TH_MATH_NAME
 #endif /* floating point only part */
 
@@ -239,6 +239,151 @@ void THVector_(copy)(real *y, const real *x, const ptrdiff_t n) {
   THVector_(copy_DISPATCHPTR)(y, x, n);
 }
 
+static void (*THVector_(copyByte_DISPATCHPTR))(real *, const uint8_t *, const ptrdiff_t) = &THVector_(copyByte_DEFAULT);
+static FunctionDescription THVector_(copyByte_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copyByte_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyByte_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyByte)(real *y, const uint8_t *x, const ptrdiff_t n) {
+  THVector_(copyByte_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyChar_DISPATCHPTR))(real *, const int8_t *, const ptrdiff_t) = &THVector_(copyChar_DEFAULT);
+static FunctionDescription THVector_(copyChar_DISPATCHTABLE)[] = {
+  FUNCTION_IMPL(THVector_(copyChar_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyChar)(real *y, const int8_t *x, const ptrdiff_t n) {
+  THVector_(copyChar_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyShort_DISPATCHPTR))(real *, const int16_t *, const ptrdiff_t) = &THVector_(copyShort_DEFAULT);
+static FunctionDescription THVector_(copyShort_DISPATCHTABLE)[] = {
+  FUNCTION_IMPL(THVector_(copyShort_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyShort)(real *y, const int16_t *x, const ptrdiff_t n) {
+  THVector_(copyShort_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyInt_DISPATCHPTR))(real *, const int32_t *, const ptrdiff_t) = &THVector_(copyInt_DEFAULT);
+static FunctionDescription THVector_(copyInt_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copyInt_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyInt_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyInt)(real *y, const int32_t *x, const ptrdiff_t n) {
+  THVector_(copyInt_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyLong_DISPATCHPTR))(real *, const int64_t *, const ptrdiff_t) = &THVector_(copyLong_DEFAULT);
+static FunctionDescription THVector_(copyLong_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+    #if defined(TH_REAL_IS_INT)
+      FUNCTION_IMPL(THVector_(copyLong_AVX2), SIMDExtension_AVX2),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyLong_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyLong)(real *y, const int64_t *x, const ptrdiff_t n) {
+  THVector_(copyLong_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyFloat_DISPATCHPTR))(real *, const float *, const ptrdiff_t) = &THVector_(copyFloat_DEFAULT);
+static FunctionDescription THVector_(copyFloat_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_DOUBLE)
+      FUNCTION_IMPL(THVector_(copyFloat_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyFloat_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyFloat)(real *y, const float *x, const ptrdiff_t n) {
+  THVector_(copyFloat_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyDouble_DISPATCHPTR))(real *, const double *, const ptrdiff_t) = &THVector_(copyDouble_DEFAULT);
+static FunctionDescription THVector_(copyDouble_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copyDouble_AVX), SIMDExtension_AVX),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyDouble_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyDouble)(real *y, const double *x, const ptrdiff_t n) {
+  THVector_(copyDouble_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyHalf_DISPATCHPTR))(real *, const THHalf *, const ptrdiff_t) = &THVector_(copyHalf_DEFAULT);
+static FunctionDescription THVector_(copyHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_F16C)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copyHalf_F16C), SIMDExtension_F16C),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyHalf)(real *y, const THHalf *x, const ptrdiff_t n) {
+  THVector_(copyHalf_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(copyToHalf_DISPATCHPTR))(THHalf *, const real *, const ptrdiff_t) = &THVector_(copyToHalf_DEFAULT);
+static FunctionDescription THVector_(copyToHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_F16C)
+    #if defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(copyToHalf_F16C), SIMDExtension_F16C),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(copyToHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(copyToHalf)(THHalf *y, const real *x, const ptrdiff_t n) {
+  THVector_(copyToHalf_DISPATCHPTR)(y, x, n);
+}
+
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+static void (*THVector_(adam_DISPATCHPTR))(real *, const real *, real *, real *, const real, const real,
+                                           const real, const real, const real, const ptrdiff_t) = &THVector_(adam_DEFAULT);
+static FunctionDescription THVector_(adam_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(adam_AVX), SIMDExtension_AVX),
+  #endif
+
+  FUNCTION_IMPL(THVector_(adam_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(adam)(real *p, const real *g, real *expAvg, real *expAvgSq, const real stepSize,
+                     const real beta1, const real beta2, const real eps, const real weightDecay,
+                     const ptrdiff_t n) {
+  THVector_(adam_DISPATCHPTR)(p, g, expAvg, expAvgSq, stepSize, beta1, beta2, eps, weightDecay, n);
+}
+
+static void (*THVector_(adagrad_DISPATCHPTR))(real *, const real *, real *, const real, const real,
+                                              const real, const ptrdiff_t) = &THVector_(adagrad_DEFAULT);
+static FunctionDescription THVector_(adagrad_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX)
+    FUNCTION_IMPL(THVector_(adagrad_AVX), SIMDExtension_AVX),
+  #endif
+
+  FUNCTION_IMPL(THVector_(adagrad_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(adagrad)(real *p, const real *g, real *sum, const real lr, const real eps,
+                        const real weightDecay, const ptrdiff_t n) {
+  THVector_(adagrad_DISPATCHPTR)(p, g, sum, lr, eps, weightDecay, n);
+}
+#endif
+
 /* This needs to be called in order to initialize the dispatch pointers at runtime.
  * This function simply checks what SIMD extensions are available, and then walks the dispatch table
  * to choose the best function.
@@ -257,6 +402,19 @@ void THVector_(vectorDispatchInit)(void)
   INIT_DISPATCH_PTR(cdiv);
   INIT_DISPATCH_PTR(divs);
   INIT_DISPATCH_PTR(copy);
+  INIT_DISPATCH_PTR(copyByte);
+  INIT_DISPATCH_PTR(copyChar);
+  INIT_DISPATCH_PTR(copyShort);
+  INIT_DISPATCH_PTR(copyInt);
+  INIT_DISPATCH_PTR(copyLong);
+  INIT_DISPATCH_PTR(copyFloat);
+  INIT_DISPATCH_PTR(copyDouble);
+  INIT_DISPATCH_PTR(copyHalf);
+  INIT_DISPATCH_PTR(copyToHalf);
+#if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
+  INIT_DISPATCH_PTR(adam);
+  INIT_DISPATCH_PTR(adagrad);
+#endif
 }
 
 #endif
@@ -5,6 +5,8 @@
 #include <intrin.h>
 #endif
 
+#include <math.h>
+
 #include "AVX.h"
 
 void THDoubleVector_copy_AVX(double *y, const double *x, const ptrdiff_t n) {
@@ -271,4 +273,156 @@ void THFloatVector_adds_AVX(float *y, const float *x, const float c, const ptrdi
   }
 }
 
+void THDoubleVector_copyFloat_AVX(double *y, const float *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i=0; i<=((n)-8); i+=8) {
+    _mm256_storeu_pd(y+i, _mm256_cvtps_pd(_mm_loadu_ps(x+i)));
+    _mm256_storeu_pd(y+i+4, _mm256_cvtps_pd(_mm_loadu_ps(x+i+4)));
+  }
+  for (; i<(n); i++) {
+    y[i] = (double)x[i];
+  }
+}
+
+void THFloatVector_copyDouble_AVX(float *y, const double *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m128 XMM0, XMM1;
+  for (i=0; i<=((n)-8); i+=8) {
+    XMM0 = _mm256_cvtpd_ps(_mm256_loadu_pd(x+i));
+    XMM1 = _mm256_cvtpd_ps(_mm256_loadu_pd(x+i+4));
+    _mm256_storeu_ps(y+i, _mm256_insertf128_ps(_mm256_castps128_ps256(XMM0), XMM1, 1));
+  }
+  for (; i<(n); i++) {
+    y[i] = (float)x[i];
+  }
+}
+
+void THFloatVector_copyByte_AVX(float *y, const uint8_t *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m128i XMM0, XMM1, XMM2;
+  for (i=0; i<=((n)-8); i+=8) {
+    XMM0 = _mm_loadl_epi64((const __m128i *)(x+i));
+    XMM1 = _mm_cvtepu8_epi32(XMM0);
+    XMM2 = _mm_cvtepu8_epi32(_mm_srli_si128(XMM0, 4));
+    _mm256_storeu_ps(y+i, _mm256_cvtepi32_ps(
+      _mm256_insertf128_si256(_mm256_castsi128_si256(XMM1), XMM2, 1)));
+  }
+  for (; i<(n); i++) {
+    y[i] = (float)x[i];
+  }
+}
+
+void THFloatVector_copyInt_AVX(float *y, const int32_t *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i=0; i<=((n)-16); i+=16) {
+    _mm256_storeu_ps(y+i, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(x+i))));
+    _mm256_storeu_ps(y+i+8, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(x+i+8))));
+  }
+  for (; i<(n); i++) {
+    y[i] = (float)x[i];
+  }
+}
+
+void THDoubleVector_adam_AVX(double *p, const double *g, double *expAvg, double *expAvgSq,
+                             const double stepSize, const double beta1, const double beta2,
+                             const double eps, const double weightDecay, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m256d YMM_B1 = _mm256_set1_pd(beta1), YMM_C1 = _mm256_set1_pd(1 - beta1);
+  __m256d YMM_B2 = _mm256_set1_pd(beta2), YMM_C2 = _mm256_set1_pd(1 - beta2);
+  __m256d YMM_EPS = _mm256_set1_pd(eps), YMM_STEP = _mm256_set1_pd(stepSize);
+  __m256d YMM_WD = _mm256_set1_pd(weightDecay);
+  __m256d YMM0, YMM1, YMM2, YMM3;
+  for (i=0; i<=((n)-4); i+=4) {
+    YMM0 = _mm256_loadu_pd(p+i);
+    YMM1 = _mm256_add_pd(_mm256_loadu_pd(g+i), _mm256_mul_pd(YMM_WD, YMM0));
+    YMM2 = _mm256_add_pd(_mm256_mul_pd(YMM_B1, _mm256_loadu_pd(expAvg+i)), _mm256_mul_pd(YMM_C1, YMM1));
+    YMM3 = _mm256_add_pd(_mm256_mul_pd(YMM_B2, _mm256_loadu_pd(expAvgSq+i)),
+                         _mm256_mul_pd(YMM_C2, _mm256_mul_pd(YMM1, YMM1)));
+    _mm256_storeu_pd(expAvg+i, YMM2);
+    _mm256_storeu_pd(expAvgSq+i, YMM3);
+    YMM3 = _mm256_add_pd(_mm256_sqrt_pd(YMM3), YMM_EPS);
+    YMM0 = _mm256_sub_pd(YMM0, _mm256_div_pd(_mm256_mul_pd(YMM_STEP, YMM2), YMM3));
+    _mm256_storeu_pd(p+i, YMM0);
+  }
+  for (; i<(n); i++) {
+    double grad = g[i] + weightDecay * p[i];
+    expAvg[i] = beta1 * expAvg[i] + (1 - beta1) * grad;
+    expAvgSq[i] = beta2 * expAvgSq[i] + (1 - beta2) * grad * grad;
+    p[i] -= stepSize * expAvg[i] / (sqrt(expAvgSq[i]) + eps);
+  }
+}
+
+void THFloatVector_adam_AVX(float *p, const float *g, float *expAvg, float *expAvgSq,
+                            const float stepSize, const float beta1, const float beta2,
+                            const float eps, const float weightDecay, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m256 YMM_B1 = _mm256_set1_ps(beta1), YMM_C1 = _mm256_set1_ps(1 - beta1);
+  __m256 YMM_B2 = _mm256_set1_ps(beta2), YMM_C2 = _mm256_set1_ps(1 - beta2);
+  __m256 YMM_EPS = _mm256_set1_ps(eps), YMM_STEP = _mm256_set1_ps(stepSize);
+  __m256 YMM_WD = _mm256_set1_ps(weightDecay);
+  __m256 YMM0, YMM1, YMM2, YMM3;
+  for (i=0; i<=((n)-8); i+=8) {
+    YMM0 = _mm256_loadu_ps(p+i);
+    YMM1 = _mm256_add_ps(_mm256_loadu_ps(g+i), _mm256_mul_ps(YMM_WD, YMM0));
+    YMM2 = _mm256_add_ps(_mm256_mul_ps(YMM_B1, _mm256_loadu_ps(expAvg+i)), _mm256_mul_ps(YMM_C1, YMM1));
+    YMM3 = _mm256_add_ps(_mm256_mul_ps(YMM_B2, _mm256_loadu_ps(expAvgSq+i)),
+                         _mm256_mul_ps(YMM_C2, _mm256_mul_ps(YMM1, YMM1)));
+    _mm256_storeu_ps(expAvg+i, YMM2);
+    _mm256_storeu_ps(expAvgSq+i, YMM3);
+    YMM3 = _mm256_add_ps(_mm256_sqrt_ps(YMM3), YMM_EPS);
+    YMM0 = _mm256_sub_ps(YMM0, _mm256_div_ps(_mm256_mul_ps(YMM_STEP, YMM2), YMM3));
+    _mm256_storeu_ps(p+i, YMM0);
+  }
+  for (; i<(n); i++) {
+    float grad = g[i] + weightDecay * p[i];
+    expAvg[i] = beta1 * expAvg[i] + (1 - beta1) * grad;
+    expAvgSq[i] = beta2 * expAvgSq[i] + (1 - beta2) * grad * grad;
+    p[i] -= stepSize * expAvg[i] / (sqrtf(expAvgSq[i]) + eps);
+  }
+}
+
+void THDoubleVector_adagrad_AVX(double *p, const double *g, double *sum, const double lr,
+                                const double eps, const double weightDecay, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m256d YMM_LR = _mm256_set1_pd(lr), YMM_EPS = _mm256_set1_pd(eps);
+  __m256d YMM_WD = _mm256_set1_pd(weightDecay);
+  __m256d YMM0, YMM1, YMM2;
+  for (i=0; i<=((n)-4); i+=4) {
+    YMM0 = _mm256_loadu_pd(p+i);
+    YMM1 = _mm256_add_pd(_mm256_loadu_pd(g+i), _mm256_mul_pd(YMM_WD, YMM0));
+    YMM2 = _mm256_add_pd(_mm256_loadu_pd(sum+i), _mm256_mul_pd(YMM1, YMM1));
+    _mm256_storeu_pd(sum+i, YMM2);
+    YMM2 = _mm256_add_pd(_mm256_sqrt_pd(YMM2), YMM_EPS);
+    YMM0 = _mm256_sub_pd(YMM0, _mm256_div_pd(_mm256_mul_pd(YMM_LR, YMM1), YMM2));
+    _mm256_storeu_pd(p+i, YMM0);
+  }
+  for (; i<(n); i++) {
+    double grad = g[i] + weightDecay * p[i];
+    sum[i] += grad * grad;
+    p[i] -= lr * grad / (sqrt(sum[i]) + eps);
+  }
+}
+
+void THFloatVector_adagrad_AVX(float *p, const float *g, float *sum, const float lr,
+                               const float eps, const float weightDecay, const ptrdiff_t n) {
+  ptrdiff_t i;
+  __m256 YMM_LR = _mm256_set1_ps(lr), YMM_EPS = _mm256_set1_ps(eps);
+  __m256 YMM_WD = _mm256_set1_ps(weightDecay);
+  __m256 YMM0, YMM1, YMM2;
+  for (i=0; i<=((n)-8); i+=8) {
+    YMM0 = _mm256_loadu_ps(p+i);
+    YMM1 = _mm256_add_ps(_mm256_loadu_ps(g+i), _mm256_mul_ps(YMM_WD, YMM0));
+    YMM2 = _mm256_add_ps(_mm256_loadu_ps(sum+i), _mm256_mul_ps(YMM1, YMM1));
+    _mm256_storeu_ps(sum+i, YMM2);
+    YMM2 = _mm256_add_ps(_mm256_sqrt_ps(YMM2), YMM_EPS);
+    YMM0 = _mm256_sub_ps(YMM0, _mm256_div_ps(_mm256_mul_ps(YMM_LR, YMM1), YMM2));
+    _mm256_storeu_ps(p+i, YMM0);
+  }
+  for (; i<(n); i++) {
+    float grad = g[i] + weightDecay * p[i];
+    sum[i] += grad * grad;
+    p[i] -= lr * grad / (sqrtf(sum[i]) + eps);
+  }
+}
+
 #endif // defined(__AVX__)
@@ -2,6 +2,7 @@
 #define TH_AVX_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 void THDoubleVector_copy_AVX(double *y, const double *x, const ptrdiff_t n);
 void THDoubleVector_fill_AVX(double *x, const double c, const ptrdiff_t n);
@@ -19,5 +20,19 @@ void THFloatVector_cmul_AVX(float *z, const float *x, const float *y, const ptrd
 void THFloatVector_muls_AVX(float *y, const float *x, const float c, const ptrdiff_t n);
 void THFloatVector_cadd_AVX(float *z, const float *x, const float *y, const float c, const ptrdiff_t n);
 void THFloatVector_adds_AVX(float *y, const float *x, const float c, const ptrdiff_t n);
+void THDoubleVector_copyFloat_AVX(double *y, const float *x, const ptrdiff_t n);
+void THFloatVector_copyDouble_AVX(float *y, const double *x, const ptrdiff_t n);
+void THFloatVector_copyByte_AVX(float *y, const uint8_t *x, const ptrdiff_t n);
+void THFloatVector_copyInt_AVX(float *y, const int32_t *x, const ptrdiff_t n);
+void THDoubleVector_adam_AVX(double *p, const double *g, double *expAvg, double *expAvgSq,
+                             const double stepSize, const double beta1, const double beta2,
+                             const double eps, const double weightDecay, const ptrdiff_t n);
+void THFloatVector_adam_AVX(float *p, const float *g, float *expAvg, float *expAvgSq,
+                            const float stepSize, const float beta1, const float beta2,
+                            const float eps, const float weightDecay, const ptrdiff_t n);
+void THDoubleVector_adagrad_AVX(double *p, const double *g, double *sum, const double lr,
+                                const double eps, const double weightDecay, const ptrdiff_t n);
+void THFloatVector_adagrad_AVX(float *p, const float *g, float *sum, const float lr,
+                               const float eps, const float weightDecay, const ptrdiff_t n);
 
 #endif
@@ -44,4 +44,20 @@ void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const flo
   }
 }
 
+void THIntVector_copyLong_AVX2(int32_t *y, const int64_t *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  /* gathers the low 32 bits of each 64-bit lane into the low 128 bits */
+  __m256i YMM15 = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
+  __m256i YMM0, YMM1;
+  for (i=0; i<=((n)-8); i+=8) {
+    YMM0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(x+i)), YMM15);
+    YMM1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(x+i+4)), YMM15);
+    YMM0 = _mm256_inserti128_si256(YMM0, _mm256_castsi256_si128(YMM1), 1);
+    _mm256_storeu_si256((__m256i *)(y+i), YMM0);
+  }
+  for (; i<(n); i++) {
+    y[i] = (int32_t)x[i];
+  }
+}
+
 #endif // defined(__AVX2__)
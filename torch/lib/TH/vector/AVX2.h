@@ -2,8 +2,10 @@
 #define TH_AVX2_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 void THDoubleVector_cadd_AVX2(double *z, const double *x, const double *y, const double c, const ptrdiff_t n);
 void THFloatVector_cadd_AVX2(float *z, const float *x, const float *y, const float c, const ptrdiff_t n);
+void THIntVector_copyLong_AVX2(int32_t *y, const int64_t *x, const ptrdiff_t n);
 
 #endif
@@ -0,0 +1,10 @@
+#ifndef TH_F16C_H
+#define TH_F16C_H
+
+#include <stddef.h>
+#include "../THHalf.h"
+
+void THFloatVector_copyHalf_F16C(float *y, const THHalf *x, const ptrdiff_t n);
+void THFloatVector_copyToHalf_F16C(THHalf *y, const float *x, const ptrdiff_t n);
+
+#endif
@@ -343,6 +343,10 @@ int THCSTensor_(isCoalesced)(THCState *state, const THCSTensor *self) {
   return self->coalesced;
 }
 
+void THCSTensor_(markCoalesced)(THCState *state, THCSTensor *self) {
+  self->coalesced = 1;
+}
+
 void THCSTensor_(free)(THCState *state, THCSTensor *self)
 {
   if(!self)
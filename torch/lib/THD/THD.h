@@ -9,9 +9,11 @@
 #ifndef _THD_CORE
 #include "base/TensorDescriptor.h"
 #include "base/DataChannelRequest.h"
+#include "process_group/Compression.h"
 #else
 #include "base/TensorDescriptor.hpp"
 #include "base/DataChannelRequest.hpp"
+#include "process_group/Compression.hpp"
 #endif
 #include "base/ChannelType.h"
 #include "base/Cuda.h"
@@ -6,6 +6,7 @@
 #include <netinet/tcp.h>
 #include <sys/poll.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 #include <cstring>
 #include <memory>
@@ -16,7 +17,12 @@
 namespace thd {
 namespace {
 
-constexpr int LISTEN_QUEUE_SIZE = 64;
+constexpr int LISTEN_QUEUE_SIZE = 1024; // the store accepts connections of all processes at once
+#ifdef IOV_MAX
+constexpr std::size_t MAX_IOV_COUNT = IOV_MAX;
+#else
+constexpr std::size_t MAX_IOV_COUNT = 1024;
+#endif // IOV_MAX
 
 void setSocketNoDelay(int socket) {
   int flag = 1;
@@ -41,6 +47,20 @@ port_type getSocketPort(int fd) {
   return listen_port;
 }
 
+// Skips `bytes` transferred bytes and the buffers which are already complete.
+void advanceIovec(struct iovec*& iov, std::size_t& count, std::size_t bytes) {
+  while (count > 0 && bytes >= iov->iov_len) {
+    bytes -= iov->iov_len;
+    ++iov;
+    --count;
+  }
+
+  if (bytes > 0) {
+    iov->iov_base = reinterpret_cast<std::uint8_t*>(iov->iov_base) + bytes;
+    iov->iov_len -= bytes;
+  }
+}
+
 } // anonymous namespace
 
 std::pair<std::string, std::string> splitAddress(const std::string &addr) {
@@ -253,4 +273,38 @@ std::tuple<int, std::string> accept(int listen_socket, int timeout) {
   return std::make_tuple(socket, sockaddrToString(reinterpret_cast<struct sockaddr*>(&addr)));
 }
 
+void send_iovec(int socket, struct iovec* iov, std::size_t count) {
+  advanceIovec(iov, count, 0);
+  while (count > 0) {
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = std::min(count, MAX_IOV_COUNT);
+
+    ssize_t bytes_sent;
+    SYSCHECK(bytes_sent = ::sendmsg(socket, &message, 0))
+    if (bytes_sent == 0)
+      throw std::system_error(ECONNRESET, std::system_category());
+
+    advanceIovec(iov, count, bytes_sent);
+  }
+}
+
+void recv_iovec(int socket, struct iovec* iov, std::size_t count) {
+  advanceIovec(iov, count, 0);
+  while (count > 0) {
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = std::min(count, MAX_IOV_COUNT);
+
+    ssize_t bytes_received;
+    SYSCHECK(bytes_received = ::recvmsg(socket, &message, MSG_WAITALL))
+    if (bytes_received == 0)
+      throw std::system_error(ECONNRESET, std::system_category());
+
+    advanceIovec(iov, count, bytes_received);
+  }
+}
+
 } // namespace thd
@@ -3,6 +3,7 @@
 #include <ATen/ATen.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <cstdlib>
 #include <cstdint>
 #include <functional>
@@ -144,6 +145,11 @@ int connect(const std::string& address, port_type port, bool wait = true, int ti
 std::tuple<int, std::string> accept(int listen_socket, int timeout = -1);
 
 std::string sockaddrToString(struct sockaddr *addr);
+
+/* send/receive all bytes described by `count` buffers, batching them into as
+ * few `sendmsg`/`recvmsg` calls as possible; `iov` is consumed in the process */
+void send_iovec(int socket, struct iovec* iov, std::size_t count);
+void recv_iovec(int socket, struct iovec* iov, std::size_t count);
 std::pair<std::string, std::string> splitAddress(const std::string &addr);
 
 /* send a string's length and data */
@@ -77,6 +77,8 @@ struct DataChannel {
 
   virtual rank_type getRank() = 0;
   virtual rank_type getNumProcesses() = 0;
+  // Throws `std::out_of_range` if there is no group with `group_id`
+  virtual const Group& getGroup(THDGroup group_id) = 0;
 
   virtual void allGather(std::vector<at::Tensor>& output, at::Tensor& input,
                          THDGroup group_id = THDGroupWORLD) = 0;
@@ -90,6 +92,14 @@ struct DataChannel {
                       rank_type dst_rank, THDGroup group_id = THDGroupWORLD) = 0;
   virtual void broadcast(at::Tensor& data, rank_type src_rank,
                          THDGroup group_id = THDGroupWORLD) = 0;
+  /*
+   * Reduces `input[i]` over all processes of the group and stores the result
+   * in `output` of the process with group rank `i`. `input` holds one tensor
+   * per process of the group, each of the same size and type as `output`.
+   */
+  virtual void reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                             THDReduceOp operation,
+                             THDGroup group_id = THDGroupWORLD) = 0;
   virtual void send(Scalar& value, rank_type src_rank) = 0;
   virtual void send(at::Tensor& data, rank_type dst_rank) = 0;
   virtual void receive(Scalar& value, rank_type src_rank) = 0;
@@ -100,6 +110,30 @@ struct DataChannel {
 
   virtual void barrier(THDGroup group_id = THDGroupWORLD) = 0;
 
+  /*
+   * Non-blocking variants of the collectives. They return once the operation
+   * has been started and the tensors must not be used until the returned
+   * request completes. Collectives are matched across processes in the order
+   * they were issued, so every process of a group has to issue the same
+   * sequence of blocking and non-blocking collectives.
+   */
+  virtual Request* iallGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                              THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* igather(std::vector<at::Tensor>& output, at::Tensor& input,
+                           rank_type dst_rank, THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* iscatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                            rank_type src_rank, THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* iallReduce(at::Tensor& data, THDReduceOp operation,
+                              THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* ireduce(at::Tensor& data, THDReduceOp operation,
+                           rank_type dst_rank, THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* ibroadcast(at::Tensor& data, rank_type src_rank,
+                              THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* ireduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                                  THDReduceOp operation,
+                                  THDGroup group_id = THDGroupWORLD) = 0;
+  virtual Request* ibarrier(THDGroup group_id = THDGroupWORLD) = 0;
+
   virtual THDGroup newGroup(const std::vector<rank_type>& ranks) = 0;
 
   static DataChannel* newChannel(THDChannelType type, std::string init_method,
@@ -65,6 +65,7 @@ DataChannelGloo::DataChannelGloo(InitMethod::Config config)
   : _rank(config.rank)
   , _listen_socket(-1)
   , _cache(nullptr)
+  , _leaders_group(THDGroupWORLD)
 {
   _num_processes = config.world_size;
 
@@ -100,10 +101,62 @@ bool DataChannelGloo::init() {
     THDGroupWORLD,
     Group(_addr, _port, ranks, _num_processes - 1, _rank == 0 ? _listen_socket : Store::CLIENT_ONLY)
   });
+
+  _initHierarchicalAllReduce();
   return true;
 }
 
 
+void DataChannelGloo::_initHierarchicalAllReduce() {
+  /*
+   * Every process publishes its description (the identity of its host and
+   * whether it is enabled) in the store of the world group and reads those
+   * of all the others. Leaders of hosts publish the names of their shared
+   * memory segments the same way.
+   */
+
+  auto& store = *_groups.at(THDGroupWORLD)._store;
+  std::string description = HierarchicalAllReduce::describe(_hierarchical_options);
+  store.set("thd_host/" + std::to_string(_rank),
+            std::vector<char>(description.begin(), description.end()));
+
+  std::vector<std::string> host_keys;
+  for (rank_type rank = 0; rank < _num_processes; ++rank)
+    host_keys.push_back("thd_host/" + std::to_string(rank));
+
+  std::vector<std::string> descriptions;
+  for (const auto& value : store.multiGet(host_keys))
+    descriptions.emplace_back(value.begin(), value.end());
+
+  _hierarchical.reset(new HierarchicalAllReduce(descriptions, _rank, _hierarchical_options));
+  if (!_hierarchical->enabled()) {
+    _hierarchical.reset();
+    return;
+  }
+
+  // created by all processes in the same order, so it has the same id everywhere
+  _leaders_group = static_cast<THDGroup>(_groups.size());
+  _groups.insert({
+    _leaders_group,
+    Group(_addr, _port, _hierarchical->leaders(), _num_processes - 1, Store::CLIENT_ONLY)
+  });
+
+  const auto& local_ranks = _hierarchical->localRanks();
+  if (local_ranks.size() == 1)
+    return;
+
+  std::string segment_key = "thd_shm_segment/" + std::to_string(local_ranks[0]);
+  if (_hierarchical->isLeader()) {
+    std::string segment_name = _hierarchical->createSegment();
+    store.set(segment_key, std::vector<char>(segment_name.begin(), segment_name.end()));
+  } else {
+    auto value = store.get(segment_key);
+    _hierarchical->openSegment(std::string(value.begin(), value.end()));
+  }
+  _hierarchical->join();
+}
+
+
 rank_type DataChannelGloo::getRank() {
   return _rank;
 }
@@ -114,6 +167,11 @@ rank_type DataChannelGloo::getNumProcesses() {
 }
 
 
+const DataChannel::Group& DataChannelGloo::getGroup(THDGroup group_id) {
+  return _groups.at(group_id);
+}
+
+
 template<typename T>
 void DataChannelGloo::allGatherT(std::vector<at::Tensor>& output,
                                  at::Tensor& input, THDGroup group_id) {
@@ -142,8 +200,8 @@ void DataChannelGloo::allGatherT(std::vector<at::Tensor>& output,
 
 }
 
-void DataChannelGloo::allGather(std::vector<at::Tensor>& output,
-                                at::Tensor& input, THDGroup group_id) {
+void DataChannelGloo::_allGather(std::vector<at::Tensor>& output,
+                                 at::Tensor& input, THDGroup group_id) {
   RETURN_IF_NOT_IN_GROUP
 
   if (output.size() != _groups.at(group_id).size())
@@ -187,8 +245,17 @@ void DataChannelGloo::allReduceT(at::Tensor& t, THDReduceOp operation,
   }
 }
 
-void DataChannelGloo::allReduce(at::Tensor& data, THDReduceOp operation,
-                                THDGroup group_id) {
+void DataChannelGloo::_allReduce(at::Tensor& data, THDReduceOp operation,
+                                 THDGroup group_id) {
+  // processes on the same host reduce through shared memory, and only
+  // leaders of hosts run the Gloo algorithm
+  if (group_id == THDGroupWORLD && _hierarchical && _hierarchical->supports(data)) {
+    _hierarchical->allReduce(data, operation, [this, operation](at::Tensor& reduced) {
+      this->_allReduce(reduced, operation, this->_leaders_group);
+    });
+    return;
+  }
+
   RETURN_IF_NOT_IN_GROUP
   GENERATE_ALL_TYPES(data.type().scalarType(), allReduceT, data, operation, group_id)
 }
@@ -225,13 +292,59 @@ void DataChannelGloo::broadcastT(at::Tensor& data, rank_type src_rank,
 }
 
 
-void DataChannelGloo::broadcast(at::Tensor& data, rank_type src_rank,
-                                THDGroup group_id) {
+void DataChannelGloo::_broadcast(at::Tensor& data, rank_type src_rank,
+                                 THDGroup group_id) {
   RETURN_IF_NOT_IN_GROUP
   GENERATE_ALL_TYPES(data.type().scalarType(), broadcastT, data, src_rank, group_id)
 }
 
 
+template<typename T>
+void DataChannelGloo::reduceScatterT(std::vector<at::Tensor>& input,
+                                     at::Tensor& output, THDReduceOp operation,
+                                     THDGroup group_id) {
+  /*
+   * Gloo has no reduce-scatter algorithm, so all inputs are reduced with the
+   * cached ring allreduce over their concatenation and every process keeps
+   * its own chunk of the result.
+   */
+  const auto& group = _groups.at(group_id);
+  std::uint64_t tensor_bytes = output.type().elementSizeInBytes() * output.numel();
+  auto ret = _cache->getAlgorithm<CollectiveType::ALL_REDUCE, T>(
+    group_id, group, getDeviceType(output), tensor_bytes * input.size(),
+    output.numel() * input.size(), operation);
+
+  {
+    std::lock_guard<std::mutex> lock(*GlooCache::mutex(ret));
+    for (std::size_t i = 0; i < input.size(); i++) {
+      std::memcpy(GlooCache::input_buffer(ret).get() + (i * tensor_bytes),
+                  input.at(i).data_ptr(), tensor_bytes);
+    }
+    GlooCache::algorithm(ret)->run();
+    std::memcpy(output.data_ptr(),
+                GlooCache::output_buffer(ret).get() + (group.mustGetGroupRank(_rank) * tensor_bytes),
+                tensor_bytes);
+  }
+}
+
+void DataChannelGloo::_reduceScatter(std::vector<at::Tensor>& input,
+                                     at::Tensor& output, THDReduceOp operation,
+                                     THDGroup group_id) {
+  RETURN_IF_NOT_IN_GROUP
+
+  if (input.size() != _groups.at(group_id).size())
+    throw std::logic_error("reduceScatter: number of input tensors and group size does not match");
+
+  for (auto in_tensor : input)
+    assertSameSizeAndType(in_tensor, output, "reduceScatter");
+
+  if (getDeviceType(output) != DeviceType::CPU)
+    throw std::runtime_error("DataChannelGloo supports reduceScatter only for CPU tensors");
+
+  GENERATE_ALL_TYPES(output.type().scalarType(), reduceScatterT, input, output, operation, group_id)
+}
+
+
 void DataChannelGloo::send(Scalar& data, rank_type dst_rank) {
   throw std::runtime_error("DataChannelGloo does not support send");
 }
@@ -267,7 +380,7 @@ auto DataChannelGloo::ireceive(at::Tensor& data, rank_type src_rank) -> RequestG
 }
 
 
-void DataChannelGloo::barrier(THDGroup group_id) {
+void DataChannelGloo::_barrier(THDGroup group_id) {
   RETURN_IF_NOT_IN_GROUP
   auto ret = _cache->getAlgorithm<CollectiveType::BARRIER, void>(
     group_id, _groups.at(group_id));
@@ -278,11 +391,127 @@ void DataChannelGloo::barrier(THDGroup group_id) {
 }
 
 
-THDGroup DataChannelGloo::newGroup(const std::vector<rank_type>& ranks) {
-  auto new_group = DataChannelGloo::Group(_addr, _port, ranks, _num_processes - 1, Store::CLIENT_ONLY);
-  THDGroup new_group_id = static_cast<THDGroup>(_groups.size());
+auto DataChannelGloo::_collective(std::function<void ()>&& collective) -> RequestGloo* {
+#ifdef WITH_CUDA
+  // the current device is per thread, run the collective on the caller's one
+  int device;
+  THCudaCheck(cudaGetDevice(&device));
+  return new RequestGloo(_collective_worker.push([device, collective] {
+    THCudaCheck(cudaSetDevice(device));
+    collective();
+  }));
+#else
+  return new RequestGloo(_collective_worker.push(std::move(collective)));
+#endif
+}
 
-  _groups.insert({new_group_id, new_group});
+
+/*
+ * Collectives capture their tensors by value, which keeps them alive until
+ * the queued collective has run. Blocking collectives go through the same
+ * queue and wait for their request.
+ */
+
+void DataChannelGloo::allGather(std::vector<at::Tensor>& output,
+                                at::Tensor& input, THDGroup group_id) {
+  req_ptr(iallGather(output, input, group_id))->wait();
+}
+
+
+void DataChannelGloo::allReduce(at::Tensor& data, THDReduceOp operation,
+                                THDGroup group_id) {
+  req_ptr(iallReduce(data, operation, group_id))->wait();
+}
+
+
+void DataChannelGloo::broadcast(at::Tensor& data, rank_type src_rank,
+                                THDGroup group_id) {
+  req_ptr(ibroadcast(data, src_rank, group_id))->wait();
+}
+
+
+void DataChannelGloo::reduceScatter(std::vector<at::Tensor>& input,
+                                    at::Tensor& output, THDReduceOp operation,
+                                    THDGroup group_id) {
+  req_ptr(ireduceScatter(input, output, operation, group_id))->wait();
+}
+
+
+void DataChannelGloo::barrier(THDGroup group_id) {
+  req_ptr(ibarrier(group_id))->wait();
+}
+
+
+auto DataChannelGloo::iallGather(std::vector<at::Tensor>& output,
+                                 at::Tensor& input, THDGroup group_id) -> RequestGloo* {
+  return _collective([this, output, input, group_id]() mutable {
+    this->_allGather(output, input, group_id);
+  });
+}
+
+
+auto DataChannelGloo::igather(std::vector<at::Tensor>& output,
+                              at::Tensor& input, rank_type dst_rank,
+                              THDGroup group_id) -> RequestGloo* {
+  throw std::runtime_error("DataChannelGloo doesn't support gather");
+}
+
+
+auto DataChannelGloo::iscatter(std::vector<at::Tensor>& input,
+                               at::Tensor& output, rank_type src_rank,
+                               THDGroup group_id) -> RequestGloo* {
+  throw std::runtime_error("DataChannelGloo does not support scatter");
+}
+
+
+auto DataChannelGloo::iallReduce(at::Tensor& data, THDReduceOp operation,
+                                 THDGroup group_id) -> RequestGloo* {
+  return _collective([this, data, operation, group_id]() mutable {
+    this->_allReduce(data, operation, group_id);
+  });
+}
+
+
+auto DataChannelGloo::ireduce(at::Tensor& data, THDReduceOp operation,
+                              rank_type dst_rank, THDGroup group_id) -> RequestGloo* {
+  throw std::runtime_error("DataChannelGloo does not support reduce");
+}
+
+
+auto DataChannelGloo::ibroadcast(at::Tensor& data, rank_type src_rank,
+                                 THDGroup group_id) -> RequestGloo* {
+  return _collective([this, data, src_rank, group_id]() mutable {
+    this->_broadcast(data, src_rank, group_id);
+  });
+}
+
+
+auto DataChannelGloo::ireduceScatter(std::vector<at::Tensor>& input,
+                                     at::Tensor& output, THDReduceOp operation,
+                                     THDGroup group_id) -> RequestGloo* {
+  return _collective([this, input, output, operation, group_id]() mutable {
+    this->_reduceScatter(input, output, operation, group_id);
+  });
+}
+
+
+auto DataChannelGloo::ibarrier(THDGroup group_id) -> RequestGloo* {
+  return _collective([this, group_id] {
+    this->_barrier(group_id);
+  });
+}
+
+
+THDGroup DataChannelGloo::newGroup(const std::vector<rank_type>& ranks) {
+  // queued behind pending collectives, which may still read `_groups`
+  THDGroup new_group_id;
+  req_ptr(_collective([this, &ranks, &new_group_id] {
+    auto new_group = DataChannelGloo::Group(this->_addr, this->_port, ranks,
+                                            this->_num_processes - 1, Store::CLIENT_ONLY);
+    new_group_id = static_cast<THDGroup>(this->_groups.size());
+
+    this->_groups.insert({new_group_id, new_group});
+  }))->wait();
   return new_group_id;
 }
 
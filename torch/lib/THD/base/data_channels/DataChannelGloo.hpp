@@ -3,11 +3,15 @@
 #include "../ChannelUtils.hpp"
 #include "../DataChannel.hpp"
 #include "DataChannelUtils.hpp"
+#include "HierarchicalAllReduce.hpp"
+#include "Store.hpp"
 
 #include "gloo/rendezvous/store.h"
 #include "gloo/transport/device.h"
 
+#include <functional>
 #include <map>
+#include <memory>
 
 
 namespace thd {
@@ -33,7 +37,7 @@ struct DataChannelGloo : DataChannel {
               std::vector<rank_type> ranks, rank_type max_rank,
               int store_socket);
 
-    std::shared_ptr<store_type> _store;
+    std::shared_ptr<Store> _store;
   };
 
   DataChannelGloo(InitMethod::Config config);
@@ -44,6 +48,7 @@ struct DataChannelGloo : DataChannel {
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  const DataChannel::Group& getGroup(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output, at::Tensor& input,
                  THDGroup group_id = THDGroupWORLD) override;
@@ -57,6 +62,8 @@ struct DataChannelGloo : DataChannel {
               THDGroup group_id = THDGroupWORLD) override;
   void broadcast(at::Tensor& data, rank_type src_id,
                  THDGroup group_id = THDGroupWORLD) override;
+  void reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                     THDReduceOp operation, THDGroup group_id = THDGroupWORLD) override;
   void send(Scalar& data, rank_type dst_id) override;
   void send(at::Tensor& data, rank_type dst_id) override;
   void receive(Scalar& data, rank_type src_id) override;
@@ -67,9 +74,40 @@ struct DataChannelGloo : DataChannel {
 
   void barrier(THDGroup group_id = THDGroupWORLD) override;
 
+  RequestGloo* iallGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                          THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* igather(std::vector<at::Tensor>& output, at::Tensor& input,
+                       rank_type dst_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* iscatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                        rank_type src_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* iallReduce(at::Tensor& data, THDReduceOp operation,
+                          THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* ireduce(at::Tensor& data, THDReduceOp operation, rank_type dst_rank,
+                       THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* ibroadcast(at::Tensor& data, rank_type src_rank,
+                          THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* ireduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                              THDReduceOp operation,
+                              THDGroup group_id = THDGroupWORLD) override;
+  RequestGloo* ibarrier(THDGroup group_id = THDGroupWORLD) override;
+
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
 
 private:
+  using req_ptr = std::unique_ptr<RequestGloo>;
+
+  void _initHierarchicalAllReduce();
+
+  // Collectives, always run on `_collective_worker`
+  void _allGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                  THDGroup group_id);
+  void _allReduce(at::Tensor& data, THDReduceOp operation, THDGroup group_id);
+  void _broadcast(at::Tensor& data, rank_type src_rank, THDGroup group_id);
+  void _reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                      THDReduceOp operation, THDGroup group_id);
+  void _barrier(THDGroup group_id);
+
+  RequestGloo* _collective(std::function<void ()>&& collective);
 
   template<typename T>
   void allGatherT(std::vector<at::Tensor>& output,
@@ -83,6 +121,10 @@ private:
   void broadcastT(at::Tensor& data, rank_type src_rank,
                   THDGroup group_id = THDGroupWORLD);
 
+  template<typename T>
+  void reduceScatterT(std::vector<at::Tensor>& input, at::Tensor& output,
+                      THDReduceOp operation, THDGroup group_id);
+
   rank_type _rank; // Current process' rank
   std::string _addr;
   port_type _port;
@@ -93,8 +135,18 @@ private:
 
   std::unique_ptr<GlooCache> _cache;
 
+  // Reduces `THDGroupWORLD` through shared memory between processes on the
+  // same host, nullptr if disabled. Leaders of hosts form `_leaders_group`.
+  HierarchicalAllReduce::Options _hierarchical_options; // read from the environment
+  std::unique_ptr<HierarchicalAllReduce> _hierarchical;
+  THDGroup _leaders_group;
+
   // Workers
   QueueWorker _send_worker, _receive_worker;
+  // Runs all collectives one after another, in the order they were issued,
+  // so that blocking and non-blocking collectives are matched the same way
+  // on every process
+  QueueWorker _collective_worker;
 };
 
 } // namespace thd
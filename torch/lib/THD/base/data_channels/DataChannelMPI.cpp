@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -32,13 +33,26 @@ std::unordered_map<at::ScalarType, MPI_Datatype> mpi_datatype = {
 	{at::kShort, MPI_SHORT},
 };
 
+// Allocates a temporary buffer which can be kept alive by a request.
+std::shared_ptr<std::uint8_t> new_buffer(std::uint64_t bytes) {
+  return std::shared_ptr<std::uint8_t>(new std::uint8_t[bytes],
+                                       std::default_delete<std::uint8_t[]>());
+}
+
 } // namespace
 
 
-DataChannelMPI::RequestMPI::RequestMPI() {}
+DataChannelMPI::RequestMPI::RequestMPI()
+  : _collective(false) {}
 
 
 DataChannelMPI::RequestMPI::~RequestMPI() {
+  if (_collective) {
+    // active nonblocking collectives cannot be freed, they have to complete
+    wait();
+    return;
+  }
+
   for (auto& request : _requests) {
     if (request != MPI_REQUEST_NULL)
       MPI_Request_free(&request);
@@ -49,12 +63,30 @@ DataChannelMPI::RequestMPI::~RequestMPI() {
 bool DataChannelMPI::RequestMPI::isCompleted() {
   int flag;
   MPI_Testall(_requests.size(), _requests.data(), &flag, MPI_STATUSES_IGNORE);
+  if (flag)
+    _complete();
   return static_cast<bool>(flag);
 }
 
 
 void DataChannelMPI::RequestMPI::wait() {
   MPI_Waitall(_requests.size(), _requests.data(), MPI_STATUSES_IGNORE);
+  _complete();
+}
+
+
+void DataChannelMPI::RequestMPI::collective(std::function<void ()>&& on_completion) {
+  _collective = true;
+  _on_completion = std::move(on_completion);
+}
+
+
+void DataChannelMPI::RequestMPI::_complete() {
+  if (_on_completion) {
+    auto on_completion = std::move(_on_completion);
+    _on_completion = nullptr;
+    on_completion();
+  }
 }
 
 
@@ -129,6 +161,11 @@ rank_type DataChannelMPI::getNumProcesses() {
 }
 
 
+const DataChannel::Group& DataChannelMPI::getGroup(THDGroup group_id) {
+  return _groups.at(group_id).second;
+}
+
+
 void DataChannelMPI::allGather(std::vector<at::Tensor>& output,
                                at::Tensor& input, THDGroup group_id) {
   const auto& group_pair = _groups.at(group_id);
@@ -314,6 +351,33 @@ void DataChannelMPI::broadcast(at::Tensor& data, rank_type src_rank,
 }
 
 
+void DataChannelMPI::reduceScatter(std::vector<at::Tensor>& input,
+                                   at::Tensor& output, THDReduceOp operation,
+                                   THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return;
+
+  if (input.size() != group_pair.second.size())
+    throw std::logic_error("reduceScatter: number of input tensors and group size does not match");
+
+  for (auto in_tensor : input)
+    assertSameSizeAndType(in_tensor, output, "reduceScatter");
+
+  std::uint64_t tensor_bytes = output.type().elementSizeInBytes() * output.numel();
+  std::uint64_t all_tensors_bytes = tensor_bytes * input.size();
+  std::unique_ptr<std::uint8_t[]> tmp_data(new std::uint8_t[all_tensors_bytes]);
+
+  for (std::size_t i = 0; i < input.size(); ++i)
+    memcpy(tmp_data.get() + (i * tensor_bytes), input.at(i).data_ptr(), tensor_bytes);
+
+  MPI_Reduce_scatter_block(tmp_data.get(), output.data_ptr(), output.numel(),
+                           mpi_datatype.at(output.type().scalarType()),
+                           mpi_op.at(operation), comm);
+}
+
+
 void DataChannelMPI::send(Scalar& data, rank_type dst_rank) {
   std::uint64_t scalar_bytes = data.elementSize();
   MPI_Send(&scalar_bytes, 1, MPI_UINT64_T, dst_rank, 0, MPI_COMM_WORLD);
@@ -465,6 +529,229 @@ DataChannelMPI::RequestMPI* DataChannelMPI::ireceive(at::Tensor& data,
   return request;
 }
 
+/*
+ * Nonblocking collectives use the MPI-3 nonblocking collective operations.
+ * Tensors and temporary buffers are kept alive by the request, and results
+ * gathered into a temporary buffer are copied out once the request completes.
+ */
+
+DataChannelMPI::RequestMPI* DataChannelMPI::iallGather(std::vector<at::Tensor>& output,
+                                                       at::Tensor& input,
+                                                       THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  if (output.size() != group_pair.second.size())
+    throw std::logic_error("allGather: number of output tensors and group size does not match");
+
+  for (auto out_tensor : output)
+    assertSameSizeAndType(out_tensor, input, "allGather");
+
+  std::uint64_t tensor_bytes = input.type().elementSizeInBytes() * input.numel();
+  auto tmp_data = new_buffer(tensor_bytes * output.size());
+
+  RequestMPI* request = new RequestMPI();
+  request->steal_tensor_buffer(input);
+  MPI_Iallgather(
+    input.data_ptr(), input.numel(), mpi_datatype.at(input.type().scalarType()),
+    tmp_data.get(), input.numel(), mpi_datatype.at(input.type().scalarType()),
+    comm, &request->new_request()
+  );
+  request->collective([output, tmp_data, tensor_bytes] {
+    for (std::size_t i = 0; i < output.size(); ++i)
+      memcpy(output.at(i).data_ptr(), tmp_data.get() + (i * tensor_bytes), tensor_bytes);
+  });
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::igather(std::vector<at::Tensor>& output,
+                                                    at::Tensor& input,
+                                                    rank_type dst_rank,
+                                                    THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  if (_rank != dst_rank) {
+    if (output.size() > 0)
+      throw std::logic_error("gather: number of input tensors should be 0 for non root");
+  } else {
+    if (output.size() != group_pair.second.size())
+      throw std::logic_error("gather: number of output tensors and group size does not match");
+
+    for (auto out_tensor : output)
+      assertSameSizeAndType(out_tensor, input, "gather");
+  }
+
+  rank_type group_dst_rank = group_pair.second.mustGetGroupRank(dst_rank);
+  std::uint64_t tensor_bytes = input.type().elementSizeInBytes() * input.numel();
+  auto tmp_data = new_buffer(tensor_bytes * output.size());
+
+  RequestMPI* request = new RequestMPI();
+  request->steal_tensor_buffer(input);
+  MPI_Igather(
+    input.data_ptr(), input.numel(), mpi_datatype.at(input.type().scalarType()),
+    tmp_data.get(), input.numel(), mpi_datatype.at(input.type().scalarType()),
+    group_dst_rank, comm, &request->new_request()
+  );
+  request->collective([output, tmp_data, tensor_bytes] {
+    for (std::size_t i = 0; i < output.size(); ++i)
+      memcpy(output.at(i).data_ptr(), tmp_data.get() + (i * tensor_bytes), tensor_bytes);
+  });
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::iscatter(std::vector<at::Tensor>& input,
+                                                     at::Tensor& output,
+                                                     rank_type src_rank,
+                                                     THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  if (_rank != src_rank) {
+    if (input.size() > 0)
+      throw std::logic_error("scatter: number of input tensors should be 0 for non root");
+  } else {
+    if (input.size() != group_pair.second.size())
+      throw std::logic_error("scatter: number of input tensors and group size does not match");
+
+    for (auto in_tensor : input)
+      assertSameSizeAndType(in_tensor, output, "scatter");
+  }
+
+  rank_type group_src_rank = group_pair.second.mustGetGroupRank(src_rank);
+  std::uint64_t tensor_bytes = output.type().elementSizeInBytes() * output.numel();
+  auto tmp_data = new_buffer(tensor_bytes * input.size());
+
+  for (std::size_t i = 0; i < input.size(); ++i)
+    memcpy(tmp_data.get() + (i * tensor_bytes), input.at(i).data_ptr(), tensor_bytes);
+
+  RequestMPI* request = new RequestMPI();
+  request->steal_buffer(tmp_data);
+  request->steal_tensor_buffer(output);
+  MPI_Iscatter(
+    tmp_data.get(), output.numel(), mpi_datatype.at(output.type().scalarType()),
+    output.data_ptr(), output.numel(), mpi_datatype.at(output.type().scalarType()),
+    group_src_rank, comm, &request->new_request()
+  );
+  request->collective([]{});
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::iallReduce(at::Tensor& data,
+                                                       THDReduceOp operation,
+                                                       THDGroup group_id) {
+  const auto& comm = _groups.at(group_id).first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  RequestMPI* request = new RequestMPI();
+  request->steal_tensor_buffer(data);
+  MPI_Iallreduce(MPI_IN_PLACE, data.data_ptr(), data.numel(),
+                 mpi_datatype.at(data.type().scalarType()), mpi_op.at(operation),
+                 comm, &request->new_request());
+  request->collective([]{});
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::ireduce(at::Tensor& data,
+                                                    THDReduceOp operation,
+                                                    rank_type dst_rank,
+                                                    THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  auto group_dst_rank = group_pair.second.mustGetGroupRank(dst_rank);
+  RequestMPI* request = new RequestMPI();
+  // receive buffer is significant only at dst_rank, which reduces in place
+  request->steal_tensor_buffer(data);
+  MPI_Ireduce(_rank == dst_rank ? MPI_IN_PLACE : data.data_ptr(), data.data_ptr(),
+              data.numel(), mpi_datatype.at(data.type().scalarType()),
+              mpi_op.at(operation), group_dst_rank, comm, &request->new_request());
+  request->collective([]{});
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::ibroadcast(at::Tensor& data,
+                                                       rank_type src_rank,
+                                                       THDGroup group_id) {
+  /*
+   * In contrast to `broadcast` sizes are not exchanged before the data, so
+   * tensors have to be of the same size on all processes.
+   */
+
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  rank_type group_src_rank = group_pair.second.mustGetGroupRank(src_rank);
+  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  RequestMPI* request = new RequestMPI();
+  request->steal_tensor_buffer(data);
+  MPI_Ibcast(data.data_ptr(), tensor_bytes, MPI_UINT8_T, group_src_rank, comm,
+             &request->new_request());
+  request->collective([]{});
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::ireduceScatter(std::vector<at::Tensor>& input,
+                                                           at::Tensor& output,
+                                                           THDReduceOp operation,
+                                                           THDGroup group_id) {
+  const auto& group_pair = _groups.at(group_id);
+  const auto& comm = group_pair.first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  if (input.size() != group_pair.second.size())
+    throw std::logic_error("reduceScatter: number of input tensors and group size does not match");
+
+  for (auto in_tensor : input)
+    assertSameSizeAndType(in_tensor, output, "reduceScatter");
+
+  std::uint64_t tensor_bytes = output.type().elementSizeInBytes() * output.numel();
+  auto tmp_data = new_buffer(tensor_bytes * input.size());
+
+  for (std::size_t i = 0; i < input.size(); ++i)
+    memcpy(tmp_data.get() + (i * tensor_bytes), input.at(i).data_ptr(), tensor_bytes);
+
+  RequestMPI* request = new RequestMPI();
+  request->steal_buffer(tmp_data);
+  request->steal_tensor_buffer(output);
+  MPI_Ireduce_scatter_block(tmp_data.get(), output.data_ptr(), output.numel(),
+                            mpi_datatype.at(output.type().scalarType()),
+                            mpi_op.at(operation), comm, &request->new_request());
+  request->collective([]{});
+  return request;
+}
+
+
+DataChannelMPI::RequestMPI* DataChannelMPI::ibarrier(THDGroup group_id) {
+  const auto& comm = _groups.at(group_id).first;
+  if (comm == MPI_COMM_NULL)
+    return new RequestMPI();
+
+  RequestMPI* request = new RequestMPI();
+  MPI_Ibarrier(comm, &request->new_request());
+  request->collective([]{});
+  return request;
+}
+
+
 THDGroup DataChannelMPI::newGroup(const std::vector<rank_type>& ranks) {
   MPI_Group world_group;
   MPI_Comm_group(MPI_COMM_WORLD, &world_group);
@@ -3,6 +3,7 @@
 #include "../DataChannel.hpp"
 
 #include <mpi.h>
+#include <functional>
 #include <memory>
 #include <utility>
 #include <unordered_map>
@@ -25,10 +26,19 @@ struct DataChannelMPI : DataChannel {
     void steal_buffer(std::shared_ptr<T> ptr);
     void steal_tensor_buffer(at::Tensor& t);
     MPI_Request& new_request();
+    /*
+     * Marks request as a nonblocking collective. `on_completion` is run once
+     * all MPI requests have completed, eg. to copy results out of a
+     * temporary buffer.
+     */
+    void collective(std::function<void ()>&& on_completion);
+    void _complete();
 
     std::vector<std::shared_ptr<void>> _buffers;
     std::vector<at::Tensor> _tensor_buffers;
     std::vector<MPI_Request> _requests;
+    bool _collective;
+    std::function<void ()> _on_completion;
   };
 
   DataChannelMPI();
@@ -38,6 +48,7 @@ struct DataChannelMPI : DataChannel {
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  const DataChannel::Group& getGroup(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output, at::Tensor& input,
                  THDGroup group_id = THDGroupWORLD) override;
@@ -51,6 +62,8 @@ struct DataChannelMPI : DataChannel {
               THDGroup group_id = THDGroupWORLD) override;
   void broadcast(at::Tensor& data, rank_type src_rank,
                  THDGroup group_id = THDGroupWORLD) override;
+  void reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                     THDReduceOp operation, THDGroup group_id = THDGroupWORLD) override;
   void send(Scalar& data, rank_type dst_rank) override;
   void send(at::Tensor& data, rank_type dst_rank) override;
   void receive(Scalar& data, rank_type src_rank) override;
@@ -60,6 +73,24 @@ struct DataChannelMPI : DataChannel {
   RequestMPI* ireceive(at::Tensor& data, rank_type src_rank) override;
 
   void barrier(THDGroup group_id = THDGroupWORLD) override;
+
+  RequestMPI* iallGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* igather(std::vector<at::Tensor>& output, at::Tensor& input,
+                      rank_type dst_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* iscatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                       rank_type src_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* iallReduce(at::Tensor& data, THDReduceOp operation,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* ireduce(at::Tensor& data, THDReduceOp operation, rank_type dst_rank,
+                      THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* ibroadcast(at::Tensor& data, rank_type src_rank,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* ireduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                             THDReduceOp operation,
+                             THDGroup group_id = THDGroupWORLD) override;
+  RequestMPI* ibarrier(THDGroup group_id = THDGroupWORLD) override;
+
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
 
 private:
@@ -6,7 +6,10 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <future>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -16,6 +19,66 @@
 namespace thd {
 namespace {
 
+constexpr char SOCKETS_PER_PEER_ENV[] = "THD_TCP_SOCKETS_PER_PEER";
+constexpr char CHUNK_SIZE_ENV[] = "THD_TCP_CHUNK_SIZE";
+constexpr std::uint32_t DEFAULT_SOCKETS_PER_PEER = 1;
+constexpr std::uint64_t DEFAULT_CHUNK_SIZE = 1 << 18; // 256 KB
+
+template<typename T>
+T loadPositiveEnv(const char* env_name, T default_value) {
+  const char* env_value = std::getenv(env_name);
+  if (env_value == nullptr)
+    return default_value;
+
+  auto value = std::stoll(env_value);
+  if (value <= 0 || static_cast<std::uint64_t>(value) > std::numeric_limits<T>::max())
+    throw std::domain_error(std::string(env_name) + " should be a positive integer");
+
+  return static_cast<T>(value);
+}
+
+/*
+ * Tensors larger than a single chunk are split into chunks of `chunk_size`
+ * bytes, which are dealt round-robin to the `stripes` connections to a peer.
+ * Returns the buffers of all chunks which go through connection `stripe`.
+ */
+std::vector<struct iovec> stripeChunks(std::uint8_t* data, std::uint64_t bytes,
+                                       std::uint64_t chunk_size,
+                                       std::size_t stripe, std::size_t stripes) {
+  std::vector<struct iovec> chunks;
+  for (std::uint64_t offset = stripe * chunk_size; offset < bytes;
+       offset += stripes * chunk_size) {
+    chunks.push_back({data + offset, std::min(chunk_size, bytes - offset)});
+  }
+  return chunks;
+}
+
+/*
+ * Transfers the first stripe on the calling thread while the other ones are
+ * transferred by `requests`. All of them are waited for even if one fails,
+ * because they all use the same buffer.
+ */
+void transferStripes(std::vector<QueueWorker::Request>& requests,
+                     const std::function<void ()>& transfer) {
+  std::exception_ptr error;
+  try {
+    transfer();
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  for (auto& request : requests) {
+    try {
+      request.wait();
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
 inline std::uint32_t log2ceil(std::uint32_t value) {
   std::uint32_t dim = 0;
 #if defined(__GNUC__)
@@ -67,29 +130,34 @@ DataChannelTCP::DataChannelTCP(InitMethod::Config config, int timeout)
   : _socket(-1)
   , _port(0)
   , _timeout(timeout)
+  , _sockets_per_peer(loadPositiveEnv(SOCKETS_PER_PEER_ENV, DEFAULT_SOCKETS_PER_PEER))
+  , _chunk_size(loadPositiveEnv(CHUNK_SIZE_ENV, DEFAULT_CHUNK_SIZE))
   , _processes(config.world_size)
   , _poll_events(nullptr)
+  , _leaders_group(THDGroupWORLD)
 {
   _rank = config.rank;
 
+  for (rank_type rank = 0; rank < _processes.size(); ++rank) {
+    auto& process = _processes[rank];
+    process.rank = rank;
+    process.port = 0;
+    process.socket = -1;
+    process.stripe_sockets.assign(_sockets_per_peer - 1, -1);
+  }
+
+  for (std::uint32_t stripe = 1; stripe < _sockets_per_peer; ++stripe) {
+    _stripe_send_workers.emplace_back(new QueueWorker());
+    _stripe_receive_workers.emplace_back(new QueueWorker());
+  }
+
   if (_rank == 0) { // MASTER
     _socket = config.master.listen_socket;
     _port = config.master.listen_port;
-
-    _processes[0] = {
-      .rank = 0,
-      .address = "",
-      .port = 0,
-      .socket = -1,
-    };
   } else { // WORKER
     // add master
-    _processes[0] = {
-      .rank = 0,
-      .address = config.worker.master_addr,
-      .port = config.worker.master_port,
-      .socket = -1,
-    };
+    _processes[0].address = config.worker.master_addr;
+    _processes[0].port = config.worker.master_port;
   }
 }
 
@@ -100,20 +168,71 @@ DataChannelTCP::~DataChannelTCP()
     ::close(_socket);
 
   for (const auto& process : _processes) {
-    if ((process.rank != _rank) && (process.socket != -1))
+    if (process.rank == _rank)
+      continue;
+
+    if (process.socket != -1)
       ::close(process.socket);
+
+    for (auto socket : process.stripe_sockets) {
+      if (socket != -1)
+        ::close(socket);
+    }
+  }
+}
+
+
+void DataChannelTCP::_addConnection(rank_type rank, std::uint32_t stripe,
+                                    int socket) {
+  if (rank >= _processes.size() || rank == _rank) {
+    throw std::out_of_range(
+      "process' rank(" + std::to_string(rank) + ") is out "
+      "of range: [0, " + std::to_string(_processes.size() - 1) + "] "
+      "or the same as the current process'"
+    );
   }
+
+  if (stripe >= _sockets_per_peer) {
+    throw std::logic_error(
+      "process " + std::to_string(rank) + " opened more connections than "
+      "the " + std::to_string(_sockets_per_peer) + " set by " + SOCKETS_PER_PEER_ENV
+    );
+  }
+
+  auto& process = _processes[rank];
+  int& process_socket = (stripe == 0) ? process.socket : process.stripe_sockets[stripe - 1];
+  if (process_socket != -1) {
+    throw std::logic_error(
+      "two processes reported a rank of " + std::to_string(rank)
+    );
+  }
+
+  process_socket = socket;
 }
 
 
 bool DataChannelTCP::initWorker() {
   auto& master = _processes[0];
-  master.socket = connect(master.address, master.port);
-
   std::tie(_socket, _port) = listen();
 
-  send_value<rank_type>(master.socket, _rank, true);
-  send_value<port_type>(master.socket, _port); // send listening port to master
+  /*
+   * Every connection starts with the rank of the connecting process and the
+   * index of the connection (stripe). The first connection to the master
+   * also carries the listening port, the number of connections per peer and
+   * the chunk size, which both have to be the same for all processes.
+   */
+  for (std::uint32_t stripe = 0; stripe < _sockets_per_peer; ++stripe) {
+    int socket = connect(master.address, master.port);
+    _addConnection(0, stripe, socket);
+
+    send_value<rank_type>(socket, _rank, true);
+    send_value<std::uint32_t>(socket, stripe, stripe == 0);
+    if (stripe == 0) {
+      send_value<port_type>(socket, _port, true); // send listening port to master
+      send_value<std::uint32_t>(socket, _sockets_per_peer, true);
+      send_value<std::uint64_t>(socket, _chunk_size);
+    }
+  }
 
   // get all metadata of other processes in network
   for (std::size_t i = 1; i < _processes.size(); ++i) {
@@ -121,12 +240,8 @@ bool DataChannelTCP::initWorker() {
     port_type p_port = recv_value<port_type>(master.socket);
     std::string p_address = recv_string(master.socket);
 
-    _processes[p_rank] = {
-      .rank = p_rank,
-      .address = p_address,
-      .port = p_port,
-      .socket = -1,
-    };
+    _processes.at(p_rank).address = p_address;
+    _processes.at(p_rank).port = p_port;
   }
 
   /*
@@ -139,19 +254,26 @@ bool DataChannelTCP::initWorker() {
 
   for (rank_type r = 1; r < _rank; ++r) {
     auto& process = _processes[r];
-    process.socket = connect(process.address, process.port);
+    for (std::uint32_t stripe = 0; stripe < _sockets_per_peer; ++stripe) {
+      int socket = connect(process.address, process.port);
+      _addConnection(r, stripe, socket);
 
-    // send rank to tell to the accepting process who we are
-    send_value<rank_type>(process.socket, _rank);
+      // send rank to tell to the accepting process who we are
+      send_value<rank_type>(socket, _rank, true);
+      send_value<std::uint32_t>(socket, stripe);
+    }
   }
 
   for (rank_type i = _rank + 1; i < _processes.size(); ++i) {
-    int socket;
-    std::tie(socket, std::ignore) = accept(_socket, _timeout);
-
-    // get rank of process we have just accepted
-    rank_type p_rank = recv_value<rank_type>(socket);
-    _processes[p_rank].socket = socket;
+    for (std::uint32_t j = 0; j < _sockets_per_peer; ++j) {
+      int socket;
+      std::tie(socket, std::ignore) = accept(_socket, _timeout);
+
+      // get rank of process we have just accepted
+      rank_type p_rank = recv_value<rank_type>(socket);
+      auto p_stripe = recv_value<std::uint32_t>(socket);
+      _addConnection(p_rank, p_stripe, socket);
+    }
   }
 
   // close socket for listening, we will not use it anymore
@@ -163,35 +285,40 @@ bool DataChannelTCP::initWorker() {
 
 
 bool DataChannelTCP::initMaster() {
-  // wait for all workers to connect
-  for (std::size_t i = 1; i < _processes.size(); ++i) {
+  // wait for all workers to open all their connections
+  for (std::size_t i = 0; i < (_processes.size() - 1) * _sockets_per_peer; ++i) {
     std::string p_address;
     int p_socket;
     std::tie(p_socket, p_address) = accept(_socket, _timeout);
 
     rank_type p_rank = recv_value<rank_type>(p_socket);
-    port_type p_port = recv_value<port_type>(p_socket);
+    auto p_stripe = recv_value<std::uint32_t>(p_socket);
+    _addConnection(p_rank, p_stripe, p_socket);
+    if (p_stripe != 0)
+      continue;
 
-    if (p_rank >= _processes.size()) {
-      throw std::out_of_range(
-        "worker's rank(" + std::to_string(p_rank) + ") is out"
-        "of range: [0, " + std::to_string(_processes.size() - 1) + "]"
+    port_type p_port = recv_value<port_type>(p_socket);
+    auto p_sockets_per_peer = recv_value<std::uint32_t>(p_socket);
+    if (p_sockets_per_peer != _sockets_per_peer) {
+      throw std::logic_error(
+        "worker " + std::to_string(p_rank) + " uses " +
+        std::to_string(p_sockets_per_peer) + " connections per peer but the "
+        "master uses " + std::to_string(_sockets_per_peer) + "; " +
+        SOCKETS_PER_PEER_ENV + " has to be the same for all processes"
       );
     }
-
-    if (_processes[p_rank].rank == p_rank) {
+    auto p_chunk_size = recv_value<std::uint64_t>(p_socket);
+    if (p_chunk_size != _chunk_size) {
       throw std::logic_error(
-        "two processes (" + _processes[p_rank].address + ", " + p_address + ") "
-        "reported a rank of " + std::to_string(p_rank)
+        "worker " + std::to_string(p_rank) + " uses chunks of " +
+        std::to_string(p_chunk_size) + " bytes but the master uses " +
+        std::to_string(_chunk_size) + "; " + CHUNK_SIZE_ENV +
+        " has to be the same for all processes"
       );
     }
 
-    _processes[p_rank] = {
-      .rank = p_rank,
-      .address = p_address,
-      .port = p_port,
-      .socket = p_socket,
-    };
+    _processes[p_rank].address = p_address;
+    _processes[p_rank].port = p_port;
   }
 
   // send informations about processes to all workers
@@ -227,12 +354,66 @@ bool DataChannelTCP::init() {
       THDGroupWORLD,
       DataChannel::Group(ranks, _processes.size() - 1)
     });
+
+    _initHierarchicalAllReduce();
   }
 
   return ok;
 }
 
 
+void DataChannelTCP::_initHierarchicalAllReduce() {
+  /*
+   * The master collects descriptions (identities of hosts and whether it is
+   * enabled) of all processes and sends them back to every worker, the same
+   * way as it does with their addresses. Then leaders of hosts send the name
+   * of their shared memory segment to the other processes on their host.
+   */
+
+  std::vector<std::string> descriptions(_processes.size());
+  descriptions[_rank] = HierarchicalAllReduce::describe(_hierarchical_options);
+  if (_rank == 0) {
+    for (rank_type rank = 1; rank < _processes.size(); ++rank)
+      descriptions[rank] = recv_string(_processes[rank].socket);
+
+    for (rank_type rank = 1; rank < _processes.size(); ++rank) {
+      for (const auto& description : descriptions)
+        send_string(_processes[rank].socket, description);
+    }
+  } else {
+    send_string(_processes[0].socket, descriptions[_rank]);
+    for (auto& description : descriptions)
+      description = recv_string(_processes[0].socket);
+  }
+
+  _hierarchical.reset(new HierarchicalAllReduce(descriptions, _rank, _hierarchical_options));
+  if (!_hierarchical->enabled()) {
+    _hierarchical.reset();
+    return;
+  }
+
+  // created by all processes in the same order, so it has the same id everywhere
+  _leaders_group = static_cast<THDGroup>(_groups.size());
+  _groups.insert({
+    _leaders_group,
+    DataChannel::Group(_hierarchical->leaders(), _processes.size() - 1)
+  });
+
+  const auto& local_ranks = _hierarchical->localRanks();
+  if (local_ranks.size() == 1)
+    return;
+
+  if (_hierarchical->isLeader()) {
+    std::string segment_name = _hierarchical->createSegment();
+    for (std::size_t i = 1; i < local_ranks.size(); ++i)
+      send_string(_processes[local_ranks[i]].socket, segment_name);
+  } else {
+    _hierarchical->openSegment(recv_string(_processes[local_ranks[0]].socket));
+  }
+  _hierarchical->join();
+}
+
+
 rank_type DataChannelTCP::getRank() {
   return _rank;
 }
@@ -243,8 +424,13 @@ rank_type DataChannelTCP::getNumProcesses() {
 }
 
 
-void DataChannelTCP::allGather(std::vector<at::Tensor>& output,
-                               at::Tensor& input, THDGroup group_id) {
+const DataChannel::Group& DataChannelTCP::getGroup(THDGroup group_id) {
+  return _groups.at(group_id);
+}
+
+
+void DataChannelTCP::_allGather(std::vector<at::Tensor>& output,
+                                at::Tensor& input, THDGroup group_id) {
   /*
    * Allgather algorithm is simple ring algorithm. This algorithm perfroms
    * well on large data (> 512 KB) and generalize well on large group of nodes.
@@ -287,8 +473,8 @@ void DataChannelTCP::allGather(std::vector<at::Tensor>& output,
 }
 
 
-void DataChannelTCP::gather(std::vector<at::Tensor>& output,
-                            at::Tensor& input, rank_type dst_rank, THDGroup group_id) {
+void DataChannelTCP::_gather(std::vector<at::Tensor>& output,
+                             at::Tensor& input, rank_type dst_rank, THDGroup group_id) {
   std::lock_guard<std::mutex> lock(_mutex);
 
   const auto& group = _groups.at(group_id);
@@ -321,9 +507,9 @@ void DataChannelTCP::gather(std::vector<at::Tensor>& output,
 }
 
 
-void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
-                             at::Tensor& output, rank_type src_rank,
-                             THDGroup group_id) {
+void DataChannelTCP::_scatter(std::vector<at::Tensor>& input,
+                              at::Tensor& output, rank_type src_rank,
+                              THDGroup group_id) {
   std::lock_guard<std::mutex> lock(_mutex);
 
   const auto& group = _groups.at(group_id);
@@ -356,8 +542,8 @@ void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
 }
 
 
-void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
-                               THDGroup group_id) {
+void DataChannelTCP::_allReduce(at::Tensor& data, THDReduceOp operation,
+                                THDGroup group_id) {
   /*
    * Allreduce implementation is recursive doubling algorithm. It is good
    * algorithm for small sizes of message but other (theoratically better)
@@ -372,6 +558,15 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
    *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
    */
 
+  // processes on the same host reduce through shared memory, and only
+  // leaders of hosts take part in the algorithm below
+  if (group_id == THDGroupWORLD && _hierarchical && _hierarchical->supports(data)) {
+    _hierarchical->allReduce(data, operation, [this, operation](at::Tensor& reduced) {
+      this->_allReduce(reduced, operation, this->_leaders_group);
+    });
+    return;
+  }
+
   std::lock_guard<std::mutex> lock(_mutex);
 
   const auto& group = _groups.at(group_id);
@@ -383,7 +578,7 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
     return;
 
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  auto tmp_tensor = data.clone();
+  auto tmp_tensor = data.type().tensor(data.sizes());
 
   auto pof2 = pow2(group.size());
   int rem = group.size() - pof2;
@@ -403,25 +598,31 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
   }
 
   if (newrank != -1) {
+    // `result` and `buffer` swap roles instead of copying every partial
+    // result back into `data`
+    at::Tensor result = data, buffer = tmp_tensor;
     int mask = 0x1;
     while (mask < pof2) {
       int newdst = newrank ^ mask;
       int dst = (newdst < rem) ? (newdst * 2 + 1) : (newdst + rem);
 
       auto dst_global_rank = group.mustGetGlobalRank(dst);
-      req_ptr send_request {isend(data, dst_global_rank)};
-      receive(tmp_tensor, dst_global_rank);
+      req_ptr send_request {isend(result, dst_global_rank)};
+      receive(buffer, dst_global_rank);
       send_request->wait();
 
       if (dst < group_rank) {
-        _reduce(data, tmp_tensor, operation);
+        _reduce(result, buffer, operation);
       } else {
-        _reduce(tmp_tensor, data, operation);
-        std::memcpy(data.data_ptr(), tmp_tensor.data_ptr(), tensor_bytes);
+        _reduce(buffer, result, operation);
+        std::swap(result, buffer);
       }
 
       mask <<= 1;
     }
+
+    if (result.data_ptr() != data.data_ptr())
+      std::memcpy(data.data_ptr(), result.data_ptr(), tensor_bytes);
   }
 
   if (group_rank < 2 * rem) {
@@ -434,8 +635,8 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
-void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
-                            rank_type dst_rank, THDGroup group_id) {
+void DataChannelTCP::_reduce(at::Tensor& data, THDReduceOp operation,
+                             rank_type dst_rank, THDGroup group_id) {
   /*
    * Idea of this algorithm is similar to broadcast but with reversed
    * order and direction of communication.
@@ -478,8 +679,8 @@ void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
-void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
-                               THDGroup group_id) {
+void DataChannelTCP::_broadcast(at::Tensor& data, rank_type src_rank,
+                                THDGroup group_id) {
   /*
    * General idea of this algorithm is to send data in `d` dimensional
    * hypercube where vertices are nodes (processes) and edges are
@@ -523,6 +724,62 @@ void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
 }
 
 
+void DataChannelTCP::_reduceScatter(std::vector<at::Tensor>& input,
+                                    at::Tensor& output, THDReduceOp operation,
+                                    THDGroup group_id) {
+  /*
+   * Reduce-scatter is a ring algorithm. In each of `size - 1` steps every
+   * process sends a partially reduced chunk to its right neighbour and reduces
+   * its own part of the chunk received from the left one, so each process
+   * transfers only `(size - 1) / size` of the data.
+   *
+   * Chunks travel shifted by one so that the process with group rank `i`
+   * receives the fully reduced chunk `i` in the last step. Receive buffers
+   * alternate between a temporary tensor and `output`, with `output` used in
+   * the last step.
+   */
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const auto& group = _groups.at(group_id);
+  rank_type group_rank;
+  bool exists;
+
+  std::tie(group_rank, exists) = group.getGroupRank(_rank);
+  if (!exists)
+    return;
+
+  if (input.size() != group.size())
+    throw std::logic_error("reduceScatter: number of input tensors and group size does not match");
+
+  for (auto in_tensor : input)
+    assertSameSizeAndType(in_tensor, output, "reduceScatter");
+
+  if (group.size() == 1) {
+    std::memcpy(output.data_ptr(), input[0].data_ptr(),
+                output.type().elementSizeInBytes() * output.numel());
+    return;
+  }
+
+  rank_type left = (group.size() + group_rank - 1) % group.size();
+  rank_type right = (group_rank + 1) % group.size();
+
+  auto tmp_tensor = output.clone();
+  at::Tensor send_tensor = input[left];
+  for (rank_type step = 0; step < group.size() - 1; ++step) {
+    rank_type chunk = (2 * group.size() + group_rank - step - 2) % group.size();
+    auto& recv_tensor = ((group.size() - step) % 2 == 0) ? output : tmp_tensor;
+
+    req_ptr send_request {isend(send_tensor, group.mustGetGlobalRank(right))};
+    receive(recv_tensor, group.mustGetGlobalRank(left));
+    send_request->wait();
+
+    _reduce(recv_tensor, input[chunk], operation);
+    send_tensor = recv_tensor;
+  }
+}
+
+
 void DataChannelTCP::send(Scalar& data, rank_type dst_rank) {
   auto request = _send_worker.push([this, &data, dst_rank]{
     this->_send(data, dst_rank);
@@ -611,7 +868,7 @@ DataChannelTCP::RequestTCP* DataChannelTCP::ireceive(at::Tensor& data,
 }
 
 
-void DataChannelTCP::barrier(THDGroup group_id) {
+void DataChannelTCP::_barrier(THDGroup group_id) {
   /*
    * Barrier is implementation of Bruck algorithm. All processes send to
    * other processes with rank (i + 2^k) and recv from process with rank (i - 2^k)
@@ -649,11 +906,143 @@ void DataChannelTCP::barrier(THDGroup group_id) {
 }
 
 
-THDGroup DataChannelTCP::newGroup(const std::vector<rank_type>& ranks) {
-  auto new_group = DataChannel::Group(ranks, _processes.size() - 1);
-  THDGroup new_group_id = static_cast<THDGroup>(_groups.size());
+DataChannelTCP::RequestTCP* DataChannelTCP::_collective(
+    std::function<void ()>&& collective) {
+  return new DataChannelTCP::RequestTCP(_collective_worker.push(std::move(collective)));
+}
+
+
+/*
+ * Collectives capture their tensors by value, which keeps them alive until
+ * the queued collective has run. Blocking collectives go through the same
+ * queue and wait for their request.
+ */
+
+void DataChannelTCP::allGather(std::vector<at::Tensor>& output,
+                               at::Tensor& input, THDGroup group_id) {
+  req_ptr(iallGather(output, input, group_id))->wait();
+}
+
+
+void DataChannelTCP::gather(std::vector<at::Tensor>& output,
+                            at::Tensor& input, rank_type dst_rank, THDGroup group_id) {
+  req_ptr(igather(output, input, dst_rank, group_id))->wait();
+}
+
+
+void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
+                             at::Tensor& output, rank_type src_rank,
+                             THDGroup group_id) {
+  req_ptr(iscatter(input, output, src_rank, group_id))->wait();
+}
+
+
+void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
+                               THDGroup group_id) {
+  req_ptr(iallReduce(data, operation, group_id))->wait();
+}
+
+
+void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
+                            rank_type dst_rank, THDGroup group_id) {
+  req_ptr(ireduce(data, operation, dst_rank, group_id))->wait();
+}
+
+
+void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
+                               THDGroup group_id) {
+  req_ptr(ibroadcast(data, src_rank, group_id))->wait();
+}
+
+
+void DataChannelTCP::reduceScatter(std::vector<at::Tensor>& input,
+                                   at::Tensor& output, THDReduceOp operation,
+                                   THDGroup group_id) {
+  req_ptr(ireduceScatter(input, output, operation, group_id))->wait();
+}
+
 
-  _groups.insert({new_group_id, new_group});
+void DataChannelTCP::barrier(THDGroup group_id) {
+  req_ptr(ibarrier(group_id))->wait();
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::iallGather(
+    std::vector<at::Tensor>& output, at::Tensor& input, THDGroup group_id) {
+  return _collective([this, output, input, group_id]() mutable {
+    this->_allGather(output, input, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::igather(
+    std::vector<at::Tensor>& output, at::Tensor& input, rank_type dst_rank,
+    THDGroup group_id) {
+  return _collective([this, output, input, dst_rank, group_id]() mutable {
+    this->_gather(output, input, dst_rank, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::iscatter(
+    std::vector<at::Tensor>& input, at::Tensor& output, rank_type src_rank,
+    THDGroup group_id) {
+  return _collective([this, input, output, src_rank, group_id]() mutable {
+    this->_scatter(input, output, src_rank, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::iallReduce(
+    at::Tensor& data, THDReduceOp operation, THDGroup group_id) {
+  return _collective([this, data, operation, group_id]() mutable {
+    this->_allReduce(data, operation, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::ireduce(
+    at::Tensor& data, THDReduceOp operation, rank_type dst_rank,
+    THDGroup group_id) {
+  return _collective([this, data, operation, dst_rank, group_id]() mutable {
+    this->_reduce(data, operation, dst_rank, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::ibroadcast(
+    at::Tensor& data, rank_type src_rank, THDGroup group_id) {
+  return _collective([this, data, src_rank, group_id]() mutable {
+    this->_broadcast(data, src_rank, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::ireduceScatter(
+    std::vector<at::Tensor>& input, at::Tensor& output, THDReduceOp operation,
+    THDGroup group_id) {
+  return _collective([this, input, output, operation, group_id]() mutable {
+    this->_reduceScatter(input, output, operation, group_id);
+  });
+}
+
+
+DataChannelTCP::RequestTCP* DataChannelTCP::ibarrier(THDGroup group_id) {
+  return _collective([this, group_id] {
+    this->_barrier(group_id);
+  });
+}
+
+
+THDGroup DataChannelTCP::newGroup(const std::vector<rank_type>& ranks) {
+  // queued behind pending collectives, which may still read `_groups`
+  THDGroup new_group_id;
+  req_ptr(_collective([this, &ranks, &new_group_id] {
+    auto new_group = DataChannel::Group(ranks, this->_processes.size() - 1);
+    new_group_id = static_cast<THDGroup>(this->_groups.size());
+
+    this->_groups.insert({new_group_id, new_group});
+  }))->wait();
   return new_group_id;
 }
 
@@ -694,13 +1083,10 @@ void DataChannelTCP::_send(const at::Tensor& data, rank_type dst_rank) {
   if (!data.is_contiguous())
     throw std::logic_error("tensor to send is not contiguous");
 
-  // send size of tensor data in bytes
+  // send size of tensor data in bytes followed by data (bytes)
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  send_bytes<std::uint64_t>(process_dst.socket, &tensor_bytes, 1, true);
-
-  // send data (bytes)
-  send_bytes<std::uint8_t>(
-    process_dst.socket,
+  _sendStriped(
+    process_dst,
     reinterpret_cast<const std::uint8_t*>(data.data_ptr()),
     tensor_bytes
   );
@@ -756,19 +1142,89 @@ void DataChannelTCP::_receive(const at::Tensor& data, rank_type src_rank) {
 
   std::uint64_t actual_tensor_bytes = data.type().elementSizeInBytes() * data.numel();
   if (actual_tensor_bytes == tensor_bytes) {
-    recv_bytes<std::uint8_t>(
-      process_src.socket,
+    _receiveStriped(
+      process_src,
       reinterpret_cast<std::uint8_t*>(data.data_ptr()),
       tensor_bytes
     );
   } else {
-    // remove invalid data from recv buffer
+    // remove invalid data from recv buffers
     std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[tensor_bytes]);
-    recv_bytes<std::uint8_t>(process_src.socket, bytes.get(), tensor_bytes);
+    _receiveStriped(process_src, bytes.get(), tensor_bytes);
     throw std::logic_error("tensor sizes do not match");
   }
 }
 
+
+int DataChannelTCP::_stripeSocket(const Process& process, std::size_t stripe) const {
+  return (stripe == 0) ? process.socket : process.stripe_sockets.at(stripe - 1);
+}
+
+
+std::size_t DataChannelTCP::_numStripes(std::uint64_t bytes) const {
+  std::uint64_t chunks = (bytes + _chunk_size - 1) / _chunk_size;
+  return std::max<std::uint64_t>(1, std::min<std::uint64_t>(chunks, _sockets_per_peer));
+}
+
+
+void DataChannelTCP::_sendStriped(const Process& process, const std::uint8_t* data,
+                                  std::uint64_t bytes) {
+  /*
+   * Sends `bytes` and then the data, striped across the connections to
+   * `process`. Every stripe is sent straight from `data` with scatter-gather
+   * I/O by its own worker, and the size goes in front of the first stripe.
+   */
+
+  auto buffer = const_cast<std::uint8_t*>(data);
+  auto stripes = _numStripes(bytes);
+  auto chunk_size = _chunk_size;
+
+  std::vector<QueueWorker::Request> requests;
+  for (std::size_t stripe = 1; stripe < stripes; ++stripe) {
+    int socket = _stripeSocket(process, stripe);
+    requests.push_back(_stripe_send_workers[stripe - 1]->push(
+      [socket, buffer, bytes, chunk_size, stripe, stripes] {
+        auto chunks = stripeChunks(buffer, bytes, chunk_size, stripe, stripes);
+        send_iovec(socket, chunks.data(), chunks.size());
+      }
+    ));
+  }
+
+  transferStripes(requests, [&] {
+    auto chunks = stripeChunks(buffer, bytes, chunk_size, 0, stripes);
+    chunks.insert(chunks.begin(), {&bytes, sizeof(bytes)});
+    send_iovec(process.socket, chunks.data(), chunks.size());
+  });
+}
+
+
+void DataChannelTCP::_receiveStriped(const Process& process, std::uint8_t* data,
+                                     std::uint64_t bytes) {
+  /*
+   * Receives data sent by `_sendStriped`, after its size has already been
+   * received from the first connection.
+   */
+
+  auto stripes = _numStripes(bytes);
+  auto chunk_size = _chunk_size;
+
+  std::vector<QueueWorker::Request> requests;
+  for (std::size_t stripe = 1; stripe < stripes; ++stripe) {
+    int socket = _stripeSocket(process, stripe);
+    requests.push_back(_stripe_receive_workers[stripe - 1]->push(
+      [socket, data, bytes, chunk_size, stripe, stripes] {
+        auto chunks = stripeChunks(data, bytes, chunk_size, stripe, stripes);
+        recv_iovec(socket, chunks.data(), chunks.size());
+      }
+    ));
+  }
+
+  transferStripes(requests, [&] {
+    auto chunks = stripeChunks(data, bytes, chunk_size, 0, stripes);
+    recv_iovec(process.socket, chunks.data(), chunks.size());
+  });
+}
+
 void DataChannelTCP::_reduce(at::Tensor& result, at::Tensor& data,
                              THDReduceOp operation) const {
   assertSameSizeAndType(result, data, "reduce");
@@ -2,9 +2,11 @@
 
 #include "../DataChannel.hpp"
 #include "DataChannelUtils.hpp"
+#include "HierarchicalAllReduce.hpp"
 
 #include <sys/poll.h>
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -34,6 +36,7 @@ struct DataChannelTCP : DataChannel {
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  const DataChannel::Group& getGroup(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output, at::Tensor& input,
                  THDGroup group_id = THDGroupWORLD) override;
@@ -47,6 +50,8 @@ struct DataChannelTCP : DataChannel {
               THDGroup group_id = THDGroupWORLD) override;
   void broadcast(at::Tensor& data, rank_type src_id,
                  THDGroup group_id = THDGroupWORLD) override;
+  void reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                     THDReduceOp operation, THDGroup group_id = THDGroupWORLD) override;
   void send(Scalar& data, rank_type dst_id) override;
   void send(at::Tensor& data, rank_type dst_id) override;
   void receive(Scalar& data, rank_type src_id) override;
@@ -57,6 +62,23 @@ struct DataChannelTCP : DataChannel {
 
   void barrier(THDGroup group_id = THDGroupWORLD) override;
 
+  RequestTCP* iallGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* igather(std::vector<at::Tensor>& output, at::Tensor& input,
+                      rank_type dst_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* iscatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                       rank_type src_rank, THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* iallReduce(at::Tensor& data, THDReduceOp operation,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* ireduce(at::Tensor& data, THDReduceOp operation, rank_type dst_rank,
+                      THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* ibroadcast(at::Tensor& data, rank_type src_rank,
+                         THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* ireduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                             THDReduceOp operation,
+                             THDGroup group_id = THDGroupWORLD) override;
+  RequestTCP* ibarrier(THDGroup group_id = THDGroupWORLD) override;
+
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
 
 private:
@@ -66,11 +88,20 @@ private:
     rank_type rank;
     std::string address;
     port_type port;
-    int socket;
+    int socket; // carries all headers and small messages
+    std::vector<int> stripe_sockets; // additional connections for large tensors
   };
 
   bool initMaster();
   bool initWorker();
+  void _initHierarchicalAllReduce();
+  void _addConnection(rank_type rank, std::uint32_t stripe, int socket);
+  int _stripeSocket(const Process& process, std::size_t stripe) const;
+  std::size_t _numStripes(std::uint64_t bytes) const;
+  void _sendStriped(const Process& process, const std::uint8_t* data,
+                    std::uint64_t bytes);
+  void _receiveStriped(const Process& process, std::uint8_t* data,
+                       std::uint64_t bytes);
 
   void _send(const Scalar& data, rank_type dst_id);
   void _send(const at::Tensor& data, rank_type dst_id);
@@ -79,11 +110,29 @@ private:
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
 
+  // Collective algorithms, always run on `_collective_worker`
+  void _allGather(std::vector<at::Tensor>& output, at::Tensor& input,
+                  THDGroup group_id);
+  void _gather(std::vector<at::Tensor>& output, at::Tensor& input,
+               rank_type dst_rank, THDGroup group_id);
+  void _scatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                rank_type src_rank, THDGroup group_id);
+  void _allReduce(at::Tensor& data, THDReduceOp operation, THDGroup group_id);
+  void _reduce(at::Tensor& data, THDReduceOp operation, rank_type dst_rank,
+               THDGroup group_id);
+  void _broadcast(at::Tensor& data, rank_type src_rank, THDGroup group_id);
+  void _reduceScatter(std::vector<at::Tensor>& input, at::Tensor& output,
+                      THDReduceOp operation, THDGroup group_id);
+  void _barrier(THDGroup group_id);
+
+  RequestTCP* _collective(std::function<void ()>&& collective);
 
   rank_type _rank; // Rank of current process, range: [0.._processes.size()-1]
   int _socket; // Socket on which process is listening
   port_type _port; // Port on which process is listening
   int _timeout; // Accept waiting timeout in milliseconds (it is optional, default = infinity)
+  std::uint32_t _sockets_per_peer; // Number of connections to every other process
+  std::uint64_t _chunk_size; // Tensors are striped across connections in chunks of this many bytes
 
   std::vector<Process> _processes; // Other processes in network
   std::unique_ptr<struct pollfd[]> _poll_events; // Events array for `poll`
@@ -94,8 +143,23 @@ private:
   // Existing groups of processes and corresponding group ids
   std::unordered_map<THDGroup, DataChannel::Group> _groups;
 
+  // Reduces `THDGroupWORLD` through shared memory between processes on the
+  // same host, nullptr if disabled. Leaders of hosts form `_leaders_group`.
+  HierarchicalAllReduce::Options _hierarchical_options; // read from the environment
+  std::unique_ptr<HierarchicalAllReduce> _hierarchical;
+  THDGroup _leaders_group;
+
   // Workers
+  // One worker per additional connection, so that stripes of a tensor are
+  // transferred in parallel. They are used by `_send_worker` and
+  // `_receive_worker`, so they are declared before them to outlive them.
+  std::vector<std::unique_ptr<QueueWorker>> _stripe_send_workers, _stripe_receive_workers;
   QueueWorker _send_worker, _receive_worker;
+  // Runs all collectives one after another, in the order they were issued,
+  // so that blocking and non-blocking collectives are matched the same way
+  // on every process. Declared last because it has to be stopped before the
+  // send and receive workers its collectives use.
+  QueueWorker _collective_worker;
 };
 
 } // namespace thd
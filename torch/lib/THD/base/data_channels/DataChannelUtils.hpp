@@ -58,8 +58,7 @@ private:
 
     void wait() {
       std::unique_lock<std::mutex> ulock(_mutex);
-      if (!_completed)
-        _cond.wait(ulock);
+      _cond.wait(ulock, [this] { return this->_completed.load(); });
 
       _validate();
     }
@@ -93,7 +92,12 @@ public:
   }
 
   ~QueueWorker() {
-    _exiting = true;
+    {
+      // set under the lock, so the runner cannot miss the notification
+      // between checking the queue and going to sleep
+      std::lock_guard<std::mutex> guard(_mutex);
+      _exiting = true;
+    }
     _cond.notify_one();
     _main_thread.join();
   }
@@ -109,8 +113,7 @@ public:
 private:
   std::shared_ptr<Task> _pop() {
     std::unique_lock<std::mutex> ulock(_mutex);
-    if (_queue.empty())
-      _cond.wait(ulock);
+    _cond.wait(ulock, [this] { return this->_exiting || !this->_queue.empty(); });
 
     if (_exiting) // check if we were woken up by destructor
       return nullptr;
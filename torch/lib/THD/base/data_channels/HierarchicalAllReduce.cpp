@@ -0,0 +1,403 @@
+#include "HierarchicalAllReduce.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace thd {
+namespace {
+
+constexpr char ENABLED_ENV[] = "THD_SHM_ALLREDUCE";
+constexpr char BUFFER_SIZE_ENV[] = "THD_SHM_BUFFER_SIZE";
+constexpr char HOST_ID_ENV[] = "THD_HOST_ID";
+constexpr char TIMEOUT_ENV[] = "THD_SHM_TIMEOUT";
+constexpr std::size_t DEFAULT_BUFFER_SIZE = 1 << 22; // 4 MB per process
+constexpr double DEFAULT_TIMEOUT = 1800; // in seconds
+constexpr std::size_t ALIGNMENT = 64; // keeps slots on separate cache lines
+constexpr int SPINS_BEFORE_YIELD = 1000;
+
+inline std::size_t alignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool loadEnabled() {
+  const char* env_value = std::getenv(ENABLED_ENV);
+  return env_value == nullptr || std::string(env_value) != "0";
+}
+
+std::size_t loadBufferSize() {
+  const char* env_value = std::getenv(BUFFER_SIZE_ENV);
+  if (env_value == nullptr)
+    return DEFAULT_BUFFER_SIZE;
+
+  auto value = std::stoll(env_value);
+  if (value < static_cast<long long>(ALIGNMENT))
+    throw std::domain_error(std::string(BUFFER_SIZE_ENV) + " should be at least " +
+                            std::to_string(ALIGNMENT));
+  return alignUp(static_cast<std::size_t>(value), ALIGNMENT);
+}
+
+int loadTimeout() {
+  const char* env_value = std::getenv(TIMEOUT_ENV);
+  double seconds = env_value == nullptr ? DEFAULT_TIMEOUT : std::stod(env_value);
+  if (seconds < 0)
+    throw std::domain_error(std::string(TIMEOUT_ENV) + " can't be negative");
+  if (seconds == 0 || seconds * 1000 > std::numeric_limits<int>::max())
+    return -1;
+  return std::max(static_cast<int>(seconds * 1000), 1);
+}
+
+template<typename T>
+void reduceIntoT(void* result_ptr, const void* data_ptr, std::size_t numel,
+                 THDReduceOp operation) {
+  auto result = reinterpret_cast<T*>(result_ptr);
+  auto data = reinterpret_cast<const T*>(data_ptr);
+  switch (operation) {
+    case THDReduceSUM:
+      for (std::size_t i = 0; i < numel; ++i) result[i] += data[i];
+      break;
+    case THDReducePRODUCT:
+      for (std::size_t i = 0; i < numel; ++i) result[i] *= data[i];
+      break;
+    case THDReduceMIN:
+      for (std::size_t i = 0; i < numel; ++i) result[i] = std::min(result[i], data[i]);
+      break;
+    case THDReduceMAX:
+      for (std::size_t i = 0; i < numel; ++i) result[i] = std::max(result[i], data[i]);
+      break;
+    default:
+      throw std::logic_error("unsupported reduce operation");
+  }
+}
+
+void reduceInto(at::ScalarType type, void* result, const void* data,
+                std::size_t numel, THDReduceOp operation) {
+  switch (type) {
+    case at::kByte: reduceIntoT<std::uint8_t>(result, data, numel, operation); break;
+    case at::kChar: reduceIntoT<std::int8_t>(result, data, numel, operation); break;
+    case at::kShort: reduceIntoT<std::int16_t>(result, data, numel, operation); break;
+    case at::kInt: reduceIntoT<std::int32_t>(result, data, numel, operation); break;
+    case at::kLong: reduceIntoT<std::int64_t>(result, data, numel, operation); break;
+    case at::kFloat: reduceIntoT<float>(result, data, numel, operation); break;
+    case at::kDouble: reduceIntoT<double>(result, data, numel, operation); break;
+    default:
+      throw std::logic_error("unsupported tensor type in shared memory allReduce");
+  }
+}
+
+} // anonymous namespace
+
+
+HierarchicalAllReduce::Options::Options()
+  : enabled(loadEnabled())
+  , buffer_size(loadBufferSize())
+  , timeout(loadTimeout())
+  , host(hostIdentity())
+{}
+
+
+std::string HierarchicalAllReduce::describe(const Options& options) {
+  return (options.enabled ? "1" : "0") + options.host;
+}
+
+
+HierarchicalAllReduce::HierarchicalAllReduce(const std::vector<std::string>& descriptions,
+                                             rank_type rank, const Options& options)
+  : _local_rank(0)
+  , _enabled(false)
+  , _buffer_size(options.buffer_size)
+  , _timeout(options.timeout)
+  , _segment(nullptr)
+  , _segment_size(0)
+  , _header(nullptr)
+  , _slot_bytes(0)
+{
+  /*
+   * Processes which disagree on whether it is enabled would wait for each
+   * other in different collectives, so all of them have to fail instead.
+   */
+  std::vector<std::string> hosts;
+  for (rank_type r = 0; r < descriptions.size(); ++r) {
+    const auto& description = descriptions[r];
+    if (description.empty() || description[0] != descriptions[0][0]) {
+      throw std::logic_error(
+        "the shared memory allReduce is " +
+        std::string(descriptions[0][0] == '1' ? "enabled" : "disabled") +
+        " in process 0 but not in process " + std::to_string(r) + "; " +
+        ENABLED_ENV + " has to be the same for all processes"
+      );
+    }
+    hosts.push_back(description.substr(1));
+  }
+
+  // the first process of every host becomes its leader
+  bool shared_host = false;
+  for (rank_type r = 0; r < hosts.size(); ++r) {
+    auto first = std::find(hosts.begin(), hosts.end(), hosts[r]);
+    if (first == hosts.begin() + r) {
+      _leaders.push_back(r);
+    } else {
+      shared_host = true;
+    }
+
+    if (hosts[r] == hosts.at(rank)) {
+      if (r == rank)
+        _local_rank = _local_ranks.size();
+      _local_ranks.push_back(r);
+    }
+  }
+
+  _enabled = shared_host && options.enabled;
+}
+
+
+HierarchicalAllReduce::~HierarchicalAllReduce() {
+  if (_segment != nullptr)
+    ::munmap(_segment, _segment_size);
+  if (!_segment_name.empty())
+    ::shm_unlink(_segment_name.c_str());
+}
+
+
+bool HierarchicalAllReduce::enabled() const {
+  return _enabled;
+}
+
+
+bool HierarchicalAllReduce::isLeader() const {
+  return _local_rank == 0;
+}
+
+
+const std::vector<rank_type>& HierarchicalAllReduce::localRanks() const {
+  return _local_ranks;
+}
+
+
+const std::vector<rank_type>& HierarchicalAllReduce::leaders() const {
+  return _leaders;
+}
+
+
+std::string HierarchicalAllReduce::createSegment() {
+  static std::atomic<std::uint64_t> segment_counter(0);
+
+  if (!isLeader())
+    throw std::logic_error("only the leader of a host can create its segment");
+
+  std::string name = "/thd_" + std::to_string(::getpid()) + "_" +
+                     std::to_string(segment_counter++);
+  int fd;
+  SYSCHECK(fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600))
+  _segment_name = name;
+
+  _slot_bytes = _buffer_size;
+  std::size_t size = alignUp(sizeof(Header), ALIGNMENT) + _local_ranks.size() * _slot_bytes;
+  if (::ftruncate(fd, size) == -1) {
+    ::close(fd);
+    throw std::system_error(errno, std::system_category());
+  }
+  _map(fd, size);
+
+  _header = new (_segment) Header();
+  _header->arrived = 0;
+  _header->generation = 0;
+  _header->slot_bytes = _slot_bytes;
+  return name;
+}
+
+
+void HierarchicalAllReduce::openSegment(const std::string& name) {
+  if (isLeader())
+    throw std::logic_error("the leader of a host has to create its segment");
+
+  int fd;
+  SYSCHECK(fd = ::shm_open(name.c_str(), O_RDWR, 0600))
+
+  struct stat segment_stat;
+  if (::fstat(fd, &segment_stat) == -1) {
+    ::close(fd);
+    throw std::system_error(errno, std::system_category());
+  }
+  _map(fd, segment_stat.st_size);
+
+  _header = reinterpret_cast<Header*>(_segment);
+  _slot_bytes = _header->slot_bytes;
+  if (alignUp(sizeof(Header), ALIGNMENT) + _local_ranks.size() * _slot_bytes > _segment_size)
+    throw std::runtime_error("shared memory segment " + name + " is too small");
+}
+
+
+void HierarchicalAllReduce::_map(int fd, std::size_t size) {
+  void* segment = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (segment == MAP_FAILED)
+    throw std::system_error(error, std::system_category());
+
+  _segment = segment;
+  _segment_size = size;
+}
+
+
+void HierarchicalAllReduce::join() {
+  _barrier();
+
+  // nobody else is going to open it, so it can be removed right away
+  if (isLeader()) {
+    SYSCHECK(::shm_unlink(_segment_name.c_str()))
+    _segment_name.clear();
+  }
+}
+
+
+void HierarchicalAllReduce::_barrier() {
+  std::uint32_t generation = _header->generation.load(std::memory_order_acquire);
+  std::uint32_t arrived = _header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1;
+  if (arrived == _local_ranks.size()) {
+    _header->arrived.store(0, std::memory_order_relaxed);
+    _header->generation.fetch_add(1, std::memory_order_release);
+    return;
+  }
+
+  /*
+   * A process which died or never calls the collective would keep the others
+   * here forever. After a timeout the counters can't be trusted anymore, so
+   * the segment is not usable afterwards.
+   */
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeout);
+  int spins = 0;
+  while (_header->generation.load(std::memory_order_acquire) == generation) {
+    if (spins < SPINS_BEFORE_YIELD) {
+      ++spins;
+      continue;
+    }
+
+    std::this_thread::yield();
+    if (_timeout >= 0 && std::chrono::steady_clock::now() > deadline) {
+      throw std::runtime_error(
+        "timed out waiting for processes on the same host in the shared memory "
+        "allReduce (" + std::string(TIMEOUT_ENV) + ")"
+      );
+    }
+  }
+}
+
+
+std::uint8_t* HierarchicalAllReduce::_slot(rank_type local_rank) const {
+  return reinterpret_cast<std::uint8_t*>(_segment) +
+         alignUp(sizeof(Header), ALIGNMENT) + local_rank * _slot_bytes;
+}
+
+
+bool HierarchicalAllReduce::supports(at::Tensor& data) const {
+  if (getDeviceType(data) != DeviceType::CPU || !data.is_contiguous())
+    return false;
+
+  switch (data.type().scalarType()) {
+    case at::kByte: case at::kChar: case at::kShort: case at::kInt:
+    case at::kLong: case at::kFloat: case at::kDouble:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+void HierarchicalAllReduce::allReduce(at::Tensor& data, THDReduceOp operation,
+                                      const inter_host_type& inter_host) {
+  /*
+   * Tensors are processed in chunks that fit in a slot. Every process copies
+   * its chunk to its own slot and reduces a part of all slots into the slot
+   * of the leader, always in the order of local ranks, so the result doesn't
+   * depend on how the work was split. Leaders then reduce the whole tensor
+   * between hosts and write it back to their slot chunk by chunk, from where
+   * it is copied by the other processes.
+   */
+
+  bool one_host = _leaders.size() == 1;
+  if (_local_ranks.size() == 1) {
+    if (!one_host)
+      inter_host(data);
+    return;
+  }
+
+  auto type = data.type().scalarType();
+  std::size_t element_size = data.type().elementSizeInBytes();
+  std::size_t numel = data.numel();
+  std::size_t chunk_numel = _slot_bytes / element_size;
+  std::size_t local_size = _local_ranks.size();
+  auto bytes = reinterpret_cast<std::uint8_t*>(data.data_ptr());
+  std::uint8_t* result_slot = _slot(0);
+
+  for (std::size_t offset = 0; offset < numel; offset += chunk_numel) {
+    std::size_t count = std::min(chunk_numel, numel - offset);
+    std::uint8_t* chunk = bytes + offset * element_size;
+    std::memcpy(_slot(_local_rank), chunk, count * element_size);
+    _barrier();
+
+    std::size_t part = alignUp((count + local_size - 1) / local_size,
+                               std::max<std::size_t>(ALIGNMENT / element_size, 1));
+    std::size_t begin = std::min(count, _local_rank * part);
+    std::size_t end = std::min(count, begin + part);
+    for (rank_type r = 1; r < local_size; ++r) {
+      reduceInto(type, result_slot + begin * element_size,
+                 _slot(r) + begin * element_size, end - begin, operation);
+    }
+    _barrier();
+
+    if (one_host) {
+      std::memcpy(chunk, result_slot, count * element_size);
+      _barrier(); // the slot of the leader is overwritten by the next chunk
+    } else if (isLeader()) {
+      std::memcpy(chunk, result_slot, count * element_size);
+    }
+  }
+
+  if (one_host)
+    return;
+
+  if (isLeader())
+    inter_host(data);
+
+  for (std::size_t offset = 0; offset < numel; offset += chunk_numel) {
+    std::size_t count = std::min(chunk_numel, numel - offset);
+    std::uint8_t* chunk = bytes + offset * element_size;
+    if (isLeader())
+      std::memcpy(result_slot, chunk, count * element_size);
+    _barrier();
+
+    if (!isLeader())
+      std::memcpy(chunk, result_slot, count * element_size);
+    _barrier();
+  }
+}
+
+
+std::string hostIdentity() {
+  const char* env_value = std::getenv(HOST_ID_ENV);
+  if (env_value != nullptr)
+    return env_value;
+
+  char hostname[256] = {0};
+  SYSCHECK(::gethostname(hostname, sizeof(hostname) - 1))
+
+  // distinguishes hosts that were given the same name
+  std::string boot_id;
+  std::ifstream boot_id_file("/proc/sys/kernel/random/boot_id");
+  std::getline(boot_id_file, boot_id);
+  return std::string(hostname) + "/" + boot_id;
+}
+
+} // namespace thd
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../ChannelUtils.hpp"
+#include "../DataChannel.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace thd {
+
+/*
+ * Hierarchical allReduce for processes sharing a host.
+ *
+ * Processes on the same host reduce their data through a shared memory
+ * segment, one leader per host (its lowest rank) runs the allReduce between
+ * hosts, and the result is broadcast back through the same segment. Only
+ * the leaders send data over the network, so the traffic between hosts drops
+ * by the number of processes per host.
+ *
+ * The data channel discovers which processes share a host (by exchanging
+ * `describe()` of all processes), creates the segment on the leader and
+ * passes its name to the other local processes, which have to open it before
+ * `join` is called by all of them.
+ */
+struct HierarchicalAllReduce {
+  using inter_host_type = std::function<void (at::Tensor&)>;
+
+  /*
+   * Settings of a process. Data channels read them from the environment
+   * when they are created, like their other settings.
+   */
+  struct Options {
+    Options();
+
+    bool enabled; // THD_SHM_ALLREDUCE
+    std::size_t buffer_size; // THD_SHM_BUFFER_SIZE
+    int timeout; // THD_SHM_TIMEOUT, in milliseconds, -1 waits forever
+    std::string host; // hostIdentity()
+  };
+
+  // What a process sends to all the others: its host and whether it is enabled.
+  static std::string describe(const Options& options);
+
+  /*
+   * `descriptions` has to contain `describe()` of all processes, indexed by
+   * their ranks. Throws if some processes have it disabled and others don't.
+   */
+  HierarchicalAllReduce(const std::vector<std::string>& descriptions, rank_type rank,
+                        const Options& options);
+  ~HierarchicalAllReduce();
+
+  HierarchicalAllReduce(const HierarchicalAllReduce&) = delete;
+  HierarchicalAllReduce& operator=(const HierarchicalAllReduce&) = delete;
+
+  /*
+   * Returns `true` if it is enabled (`THD_SHM_ALLREDUCE`) and at least one
+   * host runs more than one process. The result is the same on all processes.
+   */
+  bool enabled() const;
+
+  bool isLeader() const;
+  const std::vector<rank_type>& localRanks() const; // leader first
+  const std::vector<rank_type>& leaders() const; // in the order of hosts
+
+  // Creates a new segment (leader only) and returns its name.
+  std::string createSegment();
+  // Opens a segment created by the leader (non-leaders only).
+  void openSegment(const std::string& name);
+  /*
+   * Waits until all local processes have mapped the segment. Collective.
+   * Like `allReduce`, throws if they don't all arrive within the timeout.
+   */
+  void join();
+
+  // Returns `true` if `data` can be reduced through shared memory.
+  bool supports(at::Tensor& data) const;
+
+  /*
+   * Reduces `data` of all processes. `inter_host` is called by leaders with
+   * the data reduced within their host and has to reduce it between the
+   * leaders. It is not called when all processes run on one host.
+   */
+  void allReduce(at::Tensor& data, THDReduceOp operation,
+                 const inter_host_type& inter_host);
+
+private:
+  struct Header {
+    std::atomic<std::uint32_t> arrived;
+    std::atomic<std::uint32_t> generation;
+    std::uint64_t slot_bytes;
+  };
+
+  void _map(int fd, std::size_t size);
+  void _barrier();
+  std::uint8_t* _slot(rank_type local_rank) const;
+
+  rank_type _local_rank;
+  std::vector<rank_type> _local_ranks;
+  std::vector<rank_type> _leaders;
+  bool _enabled;
+  std::size_t _buffer_size;
+  int _timeout;
+
+  std::string _segment_name; // empty once unlinked
+  void* _segment;
+  std::size_t _segment_size;
+  Header* _header;
+  std::size_t _slot_bytes;
+};
+
+/*
+ * Returns a string identifying the host of this process, which is the same
+ * for processes able to share memory. Can be overriden with `THD_HOST_ID`.
+ */
+std::string hostIdentity();
+
+} // namespace thd
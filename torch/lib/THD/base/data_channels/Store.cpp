@@ -1,9 +1,15 @@
 #include "Store.hpp"
 #include "../ChannelUtils.hpp"
 
-#include <poll.h>
-#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
 
 namespace thd {
 
@@ -13,134 +19,395 @@ enum class QueryType : std::uint8_t {
   SET,
   GET,
   WAIT,
-  STOP_WAITING
+  STOP_WAITING,
+  ADD,
+  COMPARE_SET,
+  MULTI_GET
 };
 
+constexpr char THREADS_ENV[] = "THD_STORE_THREADS";
+constexpr std::size_t DEFAULT_MAX_THREADS = 4;
+constexpr std::size_t NUM_SHARDS = 64;
+constexpr int MAX_EVENTS = 64;
+
+std::size_t loadNumWorkers() {
+  const char* env_value = std::getenv(THREADS_ENV);
+  if (env_value != nullptr) {
+    auto value = std::stoll(env_value);
+    if (value <= 0)
+      throw std::domain_error(std::string(THREADS_ENV) + " should be a positive integer");
+    return static_cast<std::size_t>(value);
+  }
+
+  std::size_t hardware_threads = std::thread::hardware_concurrency();
+  return std::max<std::size_t>(1, std::min(DEFAULT_MAX_THREADS, hardware_threads));
+}
+
+// Parses the whole string as a decimal integer.
+bool parseInt64(const std::string& str, std::int64_t& value) {
+  try {
+    std::size_t end;
+    value = std::stoll(str, &end);
+    return end == str.size();
+  } catch (const std::invalid_argument& e) {
+    return false;
+  } catch (const std::out_of_range& e) {
+    return false;
+  }
+}
+
+void epollAdd(int epoll_fd, int fd) {
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  SYSCHECK(::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event))
+}
+
+std::vector<std::string> recv_keys(int socket) {
+  size_type nkeys;
+  recv_bytes<size_type>(socket, &nkeys, 1);
+  std::vector<std::string> keys(nkeys);
+  for (auto& key : keys)
+    key = recv_string(socket);
+  return keys;
+}
+
+void send_keys(int socket, const std::vector<std::string>& keys) {
+  size_type nkeys = keys.size();
+  send_bytes<size_type>(socket, &nkeys, 1, (nkeys > 0));
+  for (std::size_t i = 0; i < nkeys; i++) {
+    send_string(socket, keys[i], (i != (nkeys - 1)));
+  }
+}
+
 } // anonymous namespace
 
+struct Store::StoreDeamon::Connection {
+  Connection(int socket) : socket(socket) {}
+  ~Connection() { ::close(socket); }
+
+  int socket;
+  // responses to waiters are sent by threads which set their keys
+  std::mutex send_mutex;
+  // the query blocked until its keys are set, if any; it is only accessed
+  // by the worker serving this connection
+  std::weak_ptr<Waiter> waiter;
+};
+
+/*
+ * A query waiting for its keys to be set. It is registered for every key
+ * missing when it arrived, and it is answered when `missing` drops to zero.
+ */
+struct Store::StoreDeamon::Waiter {
+  QueryType type;
+  std::shared_ptr<Connection> connection;
+  std::vector<std::string> keys;
+  std::atomic<std::size_t> missing;
+};
+
+struct Store::StoreDeamon::Shard {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::vector<char>> values;
+  std::unordered_map<std::string, std::vector<std::shared_ptr<Waiter>>> waiting;
+};
+
+struct Store::StoreDeamon::Worker {
+  int epoll_fd;
+  std::thread thread;
+  // connections are added by the thread which accepts them
+  std::mutex mutex;
+  std::unordered_map<int, std::shared_ptr<Connection>> connections;
+};
+
 Store::StoreDeamon::StoreDeamon(int listen_socket)
  : _listen_socket(listen_socket)
- , _keys_awaited()
- , _sockets()
+ , _stop_event(-1)
+ , _next_worker(0)
 {
-  _deamon = std::thread(&Store::StoreDeamon::deamon, this);
+  for (std::size_t i = 0; i < NUM_SHARDS; ++i)
+    _shards.emplace_back(new Shard());
+
+  SYSCHECK(_stop_event = ::eventfd(0, 0))
+  std::size_t num_workers = loadNumWorkers();
+  for (std::size_t i = 0; i < num_workers; ++i) {
+    std::unique_ptr<Worker> worker(new Worker());
+    SYSCHECK(worker->epoll_fd = ::epoll_create1(0))
+    epollAdd(worker->epoll_fd, _stop_event);
+    _workers.push_back(std::move(worker));
+  }
+  // the first worker accepts all connections
+  epollAdd(_workers[0]->epoll_fd, _listen_socket);
+
+  for (std::size_t i = 0; i < num_workers; ++i)
+    _workers[i]->thread = std::thread(&Store::StoreDeamon::deamon, this, i);
 }
 
 Store::StoreDeamon::~StoreDeamon()
 {
+  join();
   ::close(_listen_socket);
-  for (auto socket : _sockets) {
-    if (socket != -1)
-      ::close(socket);
-  }
+  for (auto& worker : _workers)
+    ::close(worker->epoll_fd);
+  ::close(_stop_event);
 }
 
 void Store::StoreDeamon::join() {
-  _deamon.join();
+  std::uint64_t stop = 1;
+  SYSCHECK(::write(_stop_event, &stop, sizeof(stop)))
+  for (auto& worker : _workers) {
+    if (worker->thread.joinable())
+      worker->thread.join();
+  }
 }
 
-void Store::StoreDeamon::deamon() {
-  std::vector<struct pollfd> fds;
-  fds.push_back({ .fd = _listen_socket, .events = POLLIN });
+void Store::StoreDeamon::deamon(std::size_t worker_id) {
+  auto& worker = *_workers[worker_id];
+  struct epoll_event events[MAX_EVENTS];
 
-  // receive the queries
-  bool finished = false;
-  while (!finished) {
-    for (std::size_t i = 0; i < _sockets.size(); i++) {
-      fds[i].revents = 0;
+  while (true) {
+    int num_events = ::epoll_wait(worker.epoll_fd, events, MAX_EVENTS, -1);
+    if (num_events == -1) {
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::system_category());
     }
 
-    SYSCHECK(::poll(fds.data(), fds.size(), -1));
-    if (fds[0].revents != 0) {
-      if (fds[0].revents ^ POLLIN)
-        throw std::system_error(ECONNABORTED, std::system_category());
+    for (int i = 0; i < num_events; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == _stop_event)
+        return;
 
-      int sock_fd = std::get<0>(accept(_listen_socket));
-      _sockets.push_back(sock_fd);
-      _keys_awaited.push_back(0);
-      fds.push_back({ .fd = sock_fd, .events = POLLIN });
-    }
-    for (std::size_t rank = 0; rank < _sockets.size(); rank++) {
-      if (fds[rank + 1].revents == 0)
+      if (fd == _listen_socket) {
+        if (events[i].events ^ EPOLLIN)
+          throw std::system_error(ECONNABORTED, std::system_category());
+
+        accept();
         continue;
+      }
 
-      if (fds[rank + 1].revents ^ POLLIN)
-        throw std::system_error(ECONNABORTED, std::system_category());
+      std::shared_ptr<Connection> connection;
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        connection = worker.connections.at(fd);
+      }
 
       try {
-        query(rank);
+        query(connection);
       } catch (...) {
-        // There was an error when processing query. Probably an exception occurred in
-        // recv/send what would indicate that socket on the other side has been closed.
-        // If the closing was due to normal exit, then the store should exit too.
-        // Otherwise, if it was different exception, other processes will get
-        // an exception once they try to use the store.
-        finished = true;
-        break;
+        // There was an error when processing query. Probably an exception
+        // occurred in recv/send what would indicate that socket on the other
+        // side has been closed. Other clients are still served.
+        closeConnection(worker, fd);
       }
     }
   }
 }
 
+void Store::StoreDeamon::accept() {
+  int socket = std::get<0>(thd::accept(_listen_socket));
+  auto& worker = *_workers[_next_worker++ % _workers.size()];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.connections.emplace(socket, std::make_shared<Connection>(socket));
+  }
+  epollAdd(worker.epoll_fd, socket);
+}
+
+void Store::StoreDeamon::closeConnection(Worker& worker, int socket) {
+  ::epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, socket, nullptr);
+  std::shared_ptr<Connection> connection;
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto it = worker.connections.find(socket);
+    if (it == worker.connections.end())
+      return;
+    connection = std::move(it->second);
+    worker.connections.erase(it);
+  }
+
+  // Unregisters the pending query, so that the keys it waits for don't keep
+  // the connection open. The socket is closed once the threads which are
+  // already answering it, if any, are done.
+  auto waiter = connection->waiter.lock();
+  if (!waiter)
+    return;
+  for (const auto& key : waiter->keys) {
+    auto& key_shard = shard(key);
+    std::lock_guard<std::mutex> lock(key_shard.mutex);
+    auto waiting = key_shard.waiting.find(key);
+    if (waiting == key_shard.waiting.end())
+      continue;
+    auto& waiters = waiting->second;
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+    if (waiters.empty())
+      key_shard.waiting.erase(waiting);
+  }
+}
+
+Store::StoreDeamon::Shard& Store::StoreDeamon::shard(const std::string& key) {
+  return *_shards[std::hash<std::string>()(key) % _shards.size()];
+}
+
 /*
  * query communicates with the worker. The format
  * of the query is as follows:
  * type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
- * or, in the case of wait
+ * or, in the case of wait and multi get
  * type of query | number of args | size of arg1 | arg1 | ...
  */
-void Store::StoreDeamon::query(rank_type rank) {
-  int socket = _sockets[rank];
+void Store::StoreDeamon::query(const std::shared_ptr<Connection>& connection) {
+  int socket = connection->socket;
   QueryType qt;
   recv_bytes<QueryType>(socket, &qt, 1);
   if (qt == QueryType::SET) {
     std::string key = recv_string(socket);
-    _store[key] = recv_vector<char>(socket);
-    // On "set", wake up all of the processes that wait
-    // for keys already in the store
-    auto to_wake = _waiting.find(key);
-    if (to_wake != _waiting.end()) {
-      for (int proc : to_wake->second) {
-        if (--_keys_awaited[proc] == 0)
-          send_value<QueryType>(_sockets[proc], QueryType::STOP_WAITING);
-      }
-      _waiting.erase(to_wake);
+    auto value = recv_vector<char>(socket);
+
+    auto& key_shard = shard(key);
+    std::unique_lock<std::mutex> lock(key_shard.mutex);
+    key_shard.values[key] = std::move(value);
+    notify(key, key_shard, lock);
+  } else if (qt == QueryType::GET || qt == QueryType::WAIT ||
+             qt == QueryType::MULTI_GET) {
+    auto waiter = std::make_shared<Waiter>();
+    waiter->type = qt;
+    waiter->connection = connection;
+    if (qt == QueryType::GET) {
+      waiter->keys.push_back(recv_string(socket));
+    } else {
+      waiter->keys = recv_keys(socket);
     }
-  } else if (qt == QueryType::GET) {
+    connection->waiter = waiter;
+    addWaiter(waiter);
+  } else if (qt == QueryType::ADD) {
     std::string key = recv_string(socket);
-    std::vector<char> data = _store.at(key);
-    send_vector(socket, data);
-  } else if (qt == QueryType::WAIT) {
-    size_type nargs;
-    recv_bytes<size_type>(socket, &nargs, 1);
-    std::vector<std::string> keys(nargs);
-    for (std::size_t i = 0; i < nargs; i++) {
-      keys[i] = recv_string(socket);
+    auto increment = recv_value<std::int64_t>(socket);
+
+    /*
+     * A value which is not an integer, or a result which overflows, is an
+     * error of this query only: the client gets the message and the
+     * connection stays open.
+     */
+    auto& key_shard = shard(key);
+    std::unique_lock<std::mutex> lock(key_shard.mutex);
+    auto& value = key_shard.values[key];
+    std::int64_t current = 0;
+    std::string error;
+    if (!value.empty() && !parseInt64(std::string(value.begin(), value.end()), current)) {
+      error = "value of key " + key + " is not an integer";
+    } else if ((increment > 0 && current > std::numeric_limits<std::int64_t>::max() - increment) ||
+               (increment < 0 && current < std::numeric_limits<std::int64_t>::min() - increment)) {
+      error = "adding " + std::to_string(increment) + " to key " + key + " overflows";
     }
-    if (checkAndUpdate(keys)) {
-      send_value<QueryType>(socket, QueryType::STOP_WAITING);
-    } else {
-      for (auto& key : keys) {
-        _waiting[key].push_back(rank);
-      }
-      _keys_awaited[rank] = keys.size();
+
+    std::int64_t result = current;
+    if (error.empty()) {
+      result += increment;
+      std::string result_str = std::to_string(result);
+      value.assign(result_str.begin(), result_str.end());
+      notify(key, key_shard, lock);
+    }
+    if (lock.owns_lock())
+      lock.unlock();
+
+    std::lock_guard<std::mutex> send_lock(connection->send_mutex);
+    send_string(socket, error, error.empty());
+    if (error.empty())
+      send_value<std::int64_t>(socket, result);
+  } else if (qt == QueryType::COMPARE_SET) {
+    std::string key = recv_string(socket);
+    auto expected = recv_vector<char>(socket);
+    auto desired = recv_vector<char>(socket);
+
+    auto& key_shard = shard(key);
+    std::unique_lock<std::mutex> lock(key_shard.mutex);
+    auto it = key_shard.values.find(key);
+    std::vector<char> result;
+    if (it == key_shard.values.end() ? expected.empty() : it->second == expected) {
+      result = desired;
+      key_shard.values[key] = std::move(desired);
+      notify(key, key_shard, lock);
+    } else if (it != key_shard.values.end()) {
+      result = it->second;
     }
+    if (lock.owns_lock())
+      lock.unlock();
+
+    std::lock_guard<std::mutex> send_lock(connection->send_mutex);
+    send_vector(socket, result);
   } else {
     throw std::runtime_error("expected a query type");
   }
 }
 
-bool Store::StoreDeamon::checkAndUpdate(std::vector<std::string>& keys) const {
-  bool ret = true;
-  for (auto it = keys.begin(); it != keys.end();) {
-    if (_store.count(*it) == 0) {
-      ret = false;
-      it++;
+/*
+ * Wakes up waiters of a key which has just been set. Expects the lock of
+ * its shard, which is released before they are answered.
+ */
+void Store::StoreDeamon::notify(const std::string& key, Shard& shard,
+                                std::unique_lock<std::mutex>& shard_lock) {
+  auto to_wake = shard.waiting.find(key);
+  if (to_wake == shard.waiting.end())
+    return;
+
+  auto waiters = std::move(to_wake->second);
+  shard.waiting.erase(to_wake);
+  shard_lock.unlock();
+
+  for (auto& waiter : waiters) {
+    if (--waiter->missing == 0)
+      respond(*waiter);
+  }
+}
+
+void Store::StoreDeamon::addWaiter(const std::shared_ptr<Waiter>& waiter) {
+  // one more than the number of keys, so that it can't be answered by
+  // another thread before it is registered for all of them
+  waiter->missing = waiter->keys.size() + 1;
+  for (const auto& key : waiter->keys) {
+    auto& key_shard = shard(key);
+    std::lock_guard<std::mutex> lock(key_shard.mutex);
+    if (key_shard.values.count(key) > 0) {
+      --waiter->missing;
     } else {
-      it = keys.erase(it);
+      key_shard.waiting[key].push_back(waiter);
     }
   }
-  return ret;
+
+  if (--waiter->missing == 0)
+    respond(*waiter);
+}
+
+void Store::StoreDeamon::respond(Waiter& waiter) {
+  // A value of `get` is sent as it is. Values of `multiGet` are sent in one
+  // vector, each of them preceded by its size.
+  std::vector<char> response;
+  for (const auto& key : waiter.keys) {
+    if (waiter.type == QueryType::WAIT)
+      break;
+
+    auto& key_shard = shard(key);
+    std::lock_guard<std::mutex> lock(key_shard.mutex);
+    const auto& value = key_shard.values.at(key);
+    if (waiter.type == QueryType::MULTI_GET) {
+      size_type size = value.size();
+      auto size_bytes = reinterpret_cast<const char*>(&size);
+      response.insert(response.end(), size_bytes, size_bytes + sizeof(size));
+    }
+    response.insert(response.end(), value.begin(), value.end());
+  }
+
+  // It can be called by a thread serving a different client, so errors are
+  // left to the thread serving this one, which is going to notice them too.
+  try {
+    int socket = waiter.connection->socket;
+    std::lock_guard<std::mutex> lock(waiter.connection->send_mutex);
+    if (waiter.type == QueryType::WAIT) {
+      send_value<QueryType>(socket, QueryType::STOP_WAITING);
+    } else {
+      send_vector(socket, response);
+    }
+  } catch (...) {}
 }
 
 
@@ -164,32 +431,31 @@ Store::Store(const std::string& addr,
 Store::~Store() {
   ::close(_socket);
 
-  // Store deamon should end because of closed connection.
+  // Store deamon is stopped together with the process that runs it.
   if (_store_thread) {
     _store_thread->join();
   }
 }
 
 void Store::set(const std::string& key, const std::vector<char>& data) {
-  send_value<QueryType>(_socket, QueryType::SET);
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::SET, true);
   send_string(_socket, key, true);
   send_vector<char>(_socket, data);
 }
 
 std::vector<char> Store::get(const std::string& key) {
-  wait({key});
-  send_value<QueryType>(_socket, QueryType::GET);
+  // answered once the key is set
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::GET, true);
   send_string(_socket, key);
   return recv_vector<char>(_socket);
 }
 
 void Store::wait(const std::vector<std::string>& keys) {
-  send_value<QueryType>(_socket, QueryType::WAIT);
-  size_type nkeys = keys.size();
-  send_bytes<size_type>(_socket, &nkeys, 1, (nkeys > 0));
-  for (std::size_t i = 0; i < nkeys; i++) {
-    send_string(_socket, keys[i], (i != (nkeys - 1)));
-  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::WAIT, true);
+  send_keys(_socket, keys);
   // after sending the query, wait for a 'stop_waiting' response
   QueryType qr;
   recv_bytes<QueryType>(_socket, &qr, 1);
@@ -197,4 +463,44 @@ void Store::wait(const std::vector<std::string>& keys) {
     throw std::runtime_error("stop_waiting response expected");
 }
 
+std::vector<std::vector<char>> Store::multiGet(const std::vector<std::string>& keys) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::MULTI_GET, true);
+  send_keys(_socket, keys);
+
+  auto response = recv_vector<char>(_socket);
+  std::vector<std::vector<char>> values;
+  values.reserve(keys.size());
+  for (auto it = response.begin(); it != response.end();) {
+    size_type size;
+    std::copy(it, it + sizeof(size), reinterpret_cast<char*>(&size));
+    it += sizeof(size);
+    values.emplace_back(it, it + size);
+    it += size;
+  }
+  return values;
+}
+
+std::int64_t Store::add(const std::string& key, std::int64_t value) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::ADD, true);
+  send_string(_socket, key, true);
+  send_value<std::int64_t>(_socket, value);
+  std::string error = recv_string(_socket);
+  if (!error.empty())
+    throw std::runtime_error("Store::add: " + error);
+  return recv_value<std::int64_t>(_socket);
+}
+
+std::vector<char> Store::compareSet(const std::string& key,
+                                    const std::vector<char>& expected,
+                                    const std::vector<char>& desired) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  send_value<QueryType>(_socket, QueryType::COMPARE_SET, true);
+  send_string(_socket, key, true);
+  send_vector<char>(_socket, expected, true);
+  send_vector<char>(_socket, desired);
+  return recv_vector<char>(_socket);
+}
+
 } // namespace thd
@@ -3,7 +3,10 @@
 #include "../ChannelUtils.hpp"
 #include "gloo/rendezvous/store.h"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -13,6 +16,14 @@ namespace thd {
 
 struct Store : public ::gloo::rendezvous::Store {
 private:
+  /*
+   * Serves all clients with a few threads, each of them waiting for queries
+   * on its own share of connections with epoll. Keys are split between
+   * shards with separate locks, so queries for different keys don't wait for
+   * each other. Queries which need keys that are not set yet (`get`,
+   * `multiGet` and `wait`) register a waiter and are answered by the thread
+   * which sets the last of them.
+   */
   struct StoreDeamon {
     StoreDeamon() = delete;
     StoreDeamon(int listen_socket);
@@ -21,19 +32,28 @@ private:
     void join();
 
   private:
-    using store_type = std::unordered_map<std::string, std::vector<char>>;
+    struct Connection;
+    struct Waiter;
+    struct Shard;
+    struct Worker;
 
-    void deamon();
-    void query(rank_type rank);
-    bool checkAndUpdate(std::vector<std::string>& keys) const;
+    void deamon(std::size_t worker_id);
+    void accept();
+    void query(const std::shared_ptr<Connection>& connection);
+    void respond(Waiter& waiter);
+    void addWaiter(const std::shared_ptr<Waiter>& waiter);
+    void notify(const std::string& key, Shard& shard,
+                std::unique_lock<std::mutex>& shard_lock);
+
+    Shard& shard(const std::string& key);
+    void closeConnection(Worker& worker, int socket);
 
     int _listen_socket;
+    int _stop_event; // eventfd which stops all workers
+    std::atomic<std::size_t> _next_worker; // assigned to the next connection
 
-    std::thread _deamon;
-    store_type _store;
-    std::unordered_map<std::string, std::vector<rank_type>> _waiting;
-    std::vector<std::size_t> _keys_awaited;
-    std::vector<int> _sockets;
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::vector<std::unique_ptr<Worker>> _workers;
   };
 
 public:
@@ -43,13 +63,32 @@ public:
   Store(const std::string& addr, port_type port, int listen_socket = CLIENT_ONLY);
   ~Store();
 
+  // Blocking queries (`get`, `multiGet` and `wait`) hold the connection
+  // until they are answered, other threads using the same `Store` wait.
   void set(const std::string& key, const std::vector<char>& data) override;
   std::vector<char> get(const std::string& key) override;
   void wait(const std::vector<std::string>& keys) override;
 
+  // Returns values of all `keys`, waiting until all of them are set.
+  std::vector<std::vector<char>> multiGet(const std::vector<std::string>& keys);
+  /*
+   * Atomically adds `value` to the integer stored under `key` (as a decimal
+   * string, 0 if it is not set) and returns the result. Throws, leaving the
+   * key unchanged, if its value is not an integer or the result overflows.
+   */
+  std::int64_t add(const std::string& key, std::int64_t value);
+  /*
+   * Atomically sets `key` to `desired` if its value is `expected` (an empty
+   * `expected` matches a key that is not set). Returns the value of `key`
+   * after the operation, so the swap succeeded if it is equal to `desired`.
+   */
+  std::vector<char> compareSet(const std::string& key,
+                               const std::vector<char>& expected,
+                               const std::vector<char>& desired);
+
 private:
-  int _listen_socket;
   int _socket;
+  std::mutex _mutex; // one query at a time on `_socket`
   std::string _store_addr;
   port_type _store_port;
   std::unique_ptr<StoreDeamon> _store_thread; // it is initialised only in a selected process
@@ -0,0 +1,102 @@
+/*
+ * Measures the throughput of DataChannelTCP over loopback for a range of
+ * tensor sizes and numbers of connections per peer. All processes run as
+ * threads of this process.
+ *
+ * Usage: data_channel_tcp_throughput [world_size] [min_bytes_log2] [max_bytes_log2]
+ *
+ * The chunk size is read from THD_TCP_CHUNK_SIZE, like in the data channel.
+ */
+
+#include "../base/data_channels/DataChannelTCP.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int MASTER_PORT = 45690;
+constexpr std::uint64_t BYTES_PER_SIZE = 1ull << 31; // transferred per measurement
+const std::vector<int> SOCKETS_PER_PEER = {1, 2, 4, 8};
+
+struct Result {
+  double send; // MB/s from rank 0 to rank 1
+  double all_reduce; // MB/s of reduced data per process
+};
+
+template<typename F>
+double measure(thd::DataChannel& channel, int iterations, F&& f) {
+  channel.barrier();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+    f();
+  channel.barrier();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void run(int rank, int world_size, std::uint64_t bytes, Result* result) {
+  thd::DataChannelTCP channel(thd::getInitConfig("env://", world_size, "", rank));
+  channel.init();
+
+  auto tensor = at::CPU(at::kFloat).tensor({static_cast<int64_t>(bytes / sizeof(float))});
+  int iterations = std::max<std::uint64_t>(BYTES_PER_SIZE / bytes, 4);
+
+  double send_time = measure(channel, iterations, [&] {
+    if (rank == 0) {
+      channel.send(tensor, 1);
+    } else if (rank == 1) {
+      channel.receive(tensor, 0);
+    }
+  });
+
+  double all_reduce_time = measure(channel, std::max(iterations / 8, 2), [&] {
+    channel.allReduce(tensor, THDReduceOp::THDReduceSUM);
+  });
+
+  if (rank == 0) {
+    double megabytes = static_cast<double>(bytes) / (1 << 20);
+    result->send = megabytes * iterations / send_time;
+    result->all_reduce = megabytes * std::max(iterations / 8, 2) / all_reduce_time;
+  }
+}
+
+int main(int argc, char** argv) {
+  int world_size = argc > 1 ? std::atoi(argv[1]) : 2;
+  int min_bytes_log2 = argc > 2 ? std::atoi(argv[2]) : 16;
+  int max_bytes_log2 = argc > 3 ? std::atoi(argv[3]) : 28;
+  if (world_size < 2) {
+    std::fprintf(stderr, "world_size has to be at least 2\n");
+    return 1;
+  }
+
+  setenv("MASTER_ADDR", "127.0.0.1", 1);
+  setenv("MASTER_PORT", std::to_string(MASTER_PORT).data(), 1);
+
+  std::printf("%8s\t%11s\t%12s\t%17s\n", "sockets", "MB", "send MB/s", "allReduce MB/s");
+  for (int sockets : SOCKETS_PER_PEER) {
+    // read by every data channel when it is created
+    setenv("THD_TCP_SOCKETS_PER_PEER", std::to_string(sockets).data(), 1);
+
+    for (int log2 = min_bytes_log2; log2 <= max_bytes_log2; ++log2) {
+      std::uint64_t bytes = 1ull << log2;
+      Result result;
+      std::vector<std::thread> processes;
+      for (int rank = 0; rank < world_size; ++rank)
+        processes.emplace_back(run, rank, world_size, bytes, &result);
+      for (auto& process : processes)
+        process.join();
+
+      std::printf("%8d\t%11.3f\t%12.1f\t%17.1f\n", sockets,
+                  static_cast<double>(bytes) / (1 << 20), result.send,
+                  result.all_reduce);
+      std::fflush(stdout);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Measures how fast typical THDTensor commands are packed, unpacked and sent
+ * from the master to workers over loopback:
+ *   cadd    - tensorCadd(self, src1, src2, value),
+ *   add     - tensorAdd(self, src, value),
+ *   new     - tensorNewWithSize(type, self, size, stride) of a 4d tensor,
+ *   free    - tensorFree(self).
+ * The channel phase sends these commands in turns, on a small set of tensors.
+ *
+ * Usage: rpc_messages [messages] [workers]
+ */
+
+#include "../master_worker/common/CommandChannel.hpp"
+#include "../master_worker/common/Functions.hpp"
+#include "../base/init_methods/InitMethod.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace thd;
+using namespace thd::rpc;
+
+constexpr std::size_t NUM_TENSORS = 64;
+
+struct Command {
+  const char* name;
+  std::function<std::unique_ptr<RPCMessage>(std::size_t)> pack;
+  std::function<void(RPCMessage&)> unpack;
+};
+
+std::vector<THDFloatTensor> tensors(NUM_TENSORS);
+THLongStorage* size = nullptr;
+THLongStorage* stride = nullptr;
+
+THDFloatTensor* tensor(std::size_t i) {
+  return &tensors[i % NUM_TENSORS];
+}
+
+std::vector<Command> commands() {
+  return {
+    {"cadd",
+     [](std::size_t i) {
+       return packMessage(Functions::tensorCadd, tensor(i), tensor(i + 1), tensor(i + 2), 2.0);
+     },
+     [](RPCMessage& msg) {
+       unpackFunctionId(msg);
+       unpackTensor(msg); unpackTensor(msg); unpackTensor(msg);
+       unpackFloat(msg);
+     }},
+    {"add",
+     [](std::size_t i) {
+       return packMessage(Functions::tensorAdd, tensor(i), tensor(i + 1), 2.0);
+     },
+     [](RPCMessage& msg) {
+       unpackFunctionId(msg);
+       unpackTensor(msg); unpackTensor(msg);
+       unpackFloat(msg);
+     }},
+    {"new",
+     [](std::size_t i) {
+       return packMessage(Functions::tensorNewWithSize, RPCType::FLOAT, tensor(i), size, stride);
+     },
+     [](RPCMessage& msg) {
+       unpackFunctionId(msg);
+       unpackType(msg);
+       unpackTensor(msg);
+       THLongStorage_free(unpackTHLongStorage(msg));
+       THLongStorage_free(unpackTHLongStorage(msg));
+     }},
+    {"free",
+     [](std::size_t i) {
+       return packMessage(Functions::tensorFree, tensor(i));
+     },
+     [](RPCMessage& msg) {
+       unpackFunctionId(msg);
+       unpackTensor(msg);
+     }},
+  };
+}
+
+double elapsed(std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  return seconds.count();
+}
+
+void benchmarkSerialization(std::size_t num_messages) {
+  std::printf("%-8s %12s %12s %10s\n", "command", "pack msg/s", "unpack msg/s", "bytes/msg");
+  for (auto& command : commands()) {
+    std::vector<std::unique_ptr<RPCMessage>> messages(num_messages);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_messages; ++i)
+      messages[i] = command.pack(i);
+    double pack_time = elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    for (auto& message : messages)
+      command.unpack(*message);
+    double unpack_time = elapsed(start);
+
+    std::printf("%-8s %12.0f %12.0f %10zu\n", command.name,
+                num_messages / pack_time, num_messages / unpack_time,
+                messages[0]->bytes().length());
+  }
+}
+
+void worker(int rank, int world_size, std::size_t num_messages) {
+  WorkerCommandChannel channel(getInitConfig("env://", world_size, "", rank));
+  if (!channel.init()) {
+    std::fprintf(stderr, "worker %d: failed to connect to the master\n", rank);
+    std::exit(1);
+  }
+
+  auto all_commands = commands();
+  for (std::size_t i = 0; i < num_messages; ++i) {
+    auto message = channel.recvMessage();
+    all_commands[i % all_commands.size()].unpack(*message);
+  }
+}
+
+void benchmarkChannel(std::size_t num_messages, int num_workers) {
+  int world_size = num_workers + 1;
+  std::vector<std::thread> workers;
+  for (int rank = 1; rank < world_size; ++rank)
+    workers.emplace_back(worker, rank, world_size, num_messages);
+
+  auto all_commands = commands();
+  {
+    MasterCommandChannel channel(getInitConfig("env://", world_size, "", 0));
+    if (!channel.init()) {
+      std::fprintf(stderr, "master: failed to connect to workers\n");
+      std::exit(1);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_messages; ++i) {
+      for (int rank = 1; rank < world_size; ++rank)
+        channel.sendMessage(all_commands[i % all_commands.size()].pack(i), rank);
+    }
+    for (auto& thread : workers)
+      thread.join();
+    double time = elapsed(start);
+
+    std::printf("channel: %d workers, %.0f msg/s\n", num_workers,
+                num_messages * num_workers / time);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::size_t num_messages = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  int num_workers = argc > 2 ? std::stoi(argv[2]) : 1;
+
+  for (std::size_t i = 0; i < NUM_TENSORS; ++i)
+    tensors[i].tensor_id = 1000 + i;
+  size = THLongStorage_newWithSize4(32, 3, 224, 224);
+  stride = THLongStorage_newWithSize4(3 * 224 * 224, 224 * 224, 224, 1);
+
+  setenv("MASTER_ADDR", "127.0.0.1", 0);
+  setenv("MASTER_PORT", "29510", 0);
+
+  benchmarkSerialization(num_messages);
+  benchmarkChannel(num_messages, num_workers);
+
+  THLongStorage_free(size);
+  THLongStorage_free(stride);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Stresses the rendezvous Store with many clients connected over loopback,
+ * all of them running as threads of this process. Every phase is timed
+ * separately:
+ *   set      - every client sets its own keys,
+ *   multiGet - every client reads the keys of all clients in one query,
+ *   add      - all clients increment one shared counter,
+ *   wait     - clients wait for keys set by their neighbours.
+ *
+ * Usage: store_stress [clients] [keys_per_client]
+ *
+ * The number of threads of the store is read from THD_STORE_THREADS.
+ */
+
+#include "../base/data_channels/Store.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int ADDS_PER_CLIENT = 100;
+
+struct Barrier {
+  Barrier(int count) : _count(count), _arrived(0), _generation(0) {}
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    int generation = _generation;
+    if (++_arrived == _count) {
+      _arrived = 0;
+      _generation++;
+      _cv.notify_all();
+    } else {
+      _cv.wait(lock, [&] { return _generation != generation; });
+    }
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  int _count;
+  int _arrived;
+  int _generation;
+};
+
+std::string key(int client, int index) {
+  return "key/" + std::to_string(client) + "/" + std::to_string(index);
+}
+
+int main(int argc, char** argv) {
+  int clients = argc > 1 ? std::atoi(argv[1]) : 256;
+  int keys_per_client = argc > 2 ? std::atoi(argv[2]) : 4;
+  const std::vector<const char*> phases = {"set", "multiGet", "add", "wait"};
+
+  int listen_socket;
+  thd::port_type port;
+  std::tie(listen_socket, port) = thd::listen();
+  thd::Store master_store("127.0.0.1", port, listen_socket);
+
+  // the main thread measures the time between barriers
+  Barrier barrier(clients + 1);
+  std::vector<std::thread> threads;
+  for (int id = 0; id < clients; ++id) {
+    threads.emplace_back([&, id] {
+      thd::Store store("127.0.0.1", port);
+      std::vector<char> value(64, 'x');
+      barrier.wait();
+
+      for (int i = 0; i < keys_per_client; ++i)
+        store.set(key(id, i), value);
+      barrier.wait();
+
+      std::vector<std::string> all_keys;
+      for (int c = 0; c < clients; ++c) {
+        for (int i = 0; i < keys_per_client; ++i)
+          all_keys.push_back(key(c, i));
+      }
+      store.multiGet(all_keys);
+      barrier.wait();
+
+      for (int i = 0; i < ADDS_PER_CLIENT; ++i)
+        store.add("counter", 1);
+      barrier.wait();
+
+      // the key of the next client is set only after this one waits for it
+      if (id > 0)
+        store.wait({"wait/" + std::to_string(id)});
+      store.set("wait/" + std::to_string(id + 1), value);
+      barrier.wait();
+    });
+  }
+
+  barrier.wait();
+  std::printf("%d clients, %d keys per client\n", clients, keys_per_client);
+  for (auto phase : phases) {
+    auto start = std::chrono::steady_clock::now();
+    barrier.wait();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-10s %10.3f ms\n", phase, elapsed.count() * 1000);
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  if (master_store.add("counter", 0) != static_cast<std::int64_t>(clients) * ADDS_PER_CLIENT) {
+    std::fprintf(stderr, "lost updates of the counter\n");
+    return 1;
+  }
+  return 0;
+}
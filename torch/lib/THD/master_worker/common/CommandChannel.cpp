@@ -1,12 +1,15 @@
 #include "CommandChannel.hpp"
 #include "Functions.hpp"
+#include "Varint.hpp"
 #include "../../base/ChannelUtils.hpp"
 
+#include <sys/uio.h>
 #include <unistd.h>
 #include <climits>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <limits>
 #include <memory>
 #include <string>
 #include <stdexcept>
@@ -16,31 +19,71 @@
 namespace thd {
 namespace {
 
-void sendMessage(int socket, std::unique_ptr<rpc::RPCMessage> msg) {
-  auto& bytes = msg.get()->bytes();
-  std::uint64_t msg_length = static_cast<std::uint64_t>(bytes.length());
+// sendMessage waits when this many messages are queued for one worker
+constexpr std::size_t MAX_QUEUED_MESSAGES = 4096;
+constexpr std::size_t RECV_BUFFER_SIZE = 1 << 16;
+constexpr std::size_t OBJECT_CACHE_SIZE = 256;
+
+/*
+ * Every message is sent as a header followed by its bytes. The header
+ * consists of varints: the length of the message, the number of objects
+ * passed to it and their ids, encoded with the ObjectCache of the connection.
+ */
+void sendMessages(int socket, std::vector<std::unique_ptr<rpc::RPCMessage>>& messages,
+                  ObjectCache& cache) {
+  std::size_t headers_size = 0;
+  for (auto& message : messages)
+    headers_size += (2 + message->objects().size()) * rpc::MAX_VARINT_SIZE;
+
+  std::unique_ptr<char[]> headers(new char[headers_size]);
+  std::vector<struct iovec> iov;
+  iov.reserve(2 * messages.size());
+  char* header_end = headers.get();
+  for (auto& message : messages) {
+    auto& bytes = message->bytes();
+    auto& objects = message->objects();
+    char* header = header_end;
+    header_end = rpc::writeVarint(header_end, bytes.length());
+    header_end = rpc::writeVarint(header_end, objects.size());
+    for (auto object : objects)
+      header_end = rpc::writeVarint(header_end, cache.encode(object));
+
+    iov.push_back({header, static_cast<std::size_t>(header_end - header)});
+    iov.push_back({const_cast<char*>(bytes.data()), bytes.length()});
+  }
 
-  send_bytes<std::uint64_t>(socket, &msg_length, 1, true);
-  send_bytes<std::uint8_t>(
-    socket,
-    reinterpret_cast<const std::uint8_t*>(bytes.data()),
-    msg_length
-  );
+  send_iovec(socket, iov.data(), iov.size());
 }
 
-std::unique_ptr<rpc::RPCMessage> receiveMessage(int socket) {
-  std::uint64_t msg_length;
-  recv_bytes<std::uint64_t>(socket, &msg_length, 1);
+} // anonymous namespace
+
+ObjectCache::ObjectCache()
+  : _ids(OBJECT_CACHE_SIZE, std::numeric_limits<object_id_type>::max())
+{}
 
-  std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[msg_length]);
-  recv_bytes<std::uint8_t>(socket, bytes.get(), msg_length);
+std::uint64_t ObjectCache::encode(object_id_type id) {
+  // the lowest bit tells if it is a position in the cache or an id
+  std::size_t position = id % _ids.size();
+  if (_ids[position] == id)
+    return (static_cast<std::uint64_t>(position) << 1) | 1;
 
-  return std::unique_ptr<rpc::RPCMessage>(
-    new rpc::RPCMessage(reinterpret_cast<char*>(bytes.get()), msg_length)
-  );
+  _ids[position] = id;
+  return static_cast<std::uint64_t>(id) << 1;
+}
+
+object_id_type ObjectCache::decode(std::uint64_t code) {
+  if (code & 1) {
+    std::size_t position = code >> 1;
+    if (position >= _ids.size())
+      throw std::invalid_argument("invalid object in the message header");
+    return _ids[position];
+  }
+
+  object_id_type id = code >> 1;
+  _ids[id % _ids.size()] = id;
+  return id;
 }
 
-} // anonymous namespace
 
 MasterCommandChannel::MasterCommandChannel(InitMethod::Config config)
   : _rank(0)
@@ -48,9 +91,10 @@ MasterCommandChannel::MasterCommandChannel(InitMethod::Config config)
   , _poll_events(nullptr)
   , _error_pipe(-1)
   , _error(nullptr)
-  , _mutexes(config.world_size)
 {
   _sockets[0] = config.master.listen_socket;
+  for (std::size_t i = 0; i < _sockets.size(); ++i)
+    _outboxes.emplace_back(new Outbox());
 }
 
 MasterCommandChannel::~MasterCommandChannel() {
@@ -65,14 +109,23 @@ MasterCommandChannel::~MasterCommandChannel() {
 
   auto world_size = _sockets.size();
   for (std::size_t i = 0; i < world_size; ++i) {
+    auto& outbox = *_outboxes[i];
+    if (outbox.sender.joinable()) {
+      // queued messages are sent before the worker is told to exit
+      {
+        std::lock_guard<std::mutex> lock(outbox.mutex);
+        if (!outbox.closed)
+          outbox.messages.push_back(rpc::packMessage(Functions::exit));
+        outbox.closed = true;
+      }
+      outbox.changed.notify_all();
+      outbox.sender.join();
+    }
+
     auto socket = _sockets[i];
     if (socket == -1) continue;
-    try {
-      sendMessage(rpc::packMessage(Functions::exit), i);
-    } catch(...) {}
     ::close(socket);
   }
-
 }
 
 bool MasterCommandChannel::init() {
@@ -100,6 +153,9 @@ bool MasterCommandChannel::init() {
   _sockets[0] = fd[0];
   _error_pipe = fd[1];
   _error_thread = std::thread(&MasterCommandChannel::errorHandler, this);
+
+  for (std::size_t i = 1; i < _sockets.size(); ++i)
+    _outboxes[i]->sender = std::thread(&MasterCommandChannel::sender, this, i);
   return true;
 }
 
@@ -110,24 +166,74 @@ void MasterCommandChannel::errorHandler() {
       return;
     }
 
-    _error.reset(new std::string(
-      "error (rank " + std::to_string(std::get<0>(error)) + "): " + std::get<1>(error)
-    ));
+    setError(std::get<0>(error), std::get<1>(error));
+  }
+}
+
+void MasterCommandChannel::setError(rank_type rank, const std::string& error) {
+  std::lock_guard<std::mutex> lock(_error_mutex);
+  _error.reset(new std::string(
+    "error (rank " + std::to_string(rank) + "): " + error
+  ));
+}
+
+void MasterCommandChannel::sender(rank_type rank) {
+  auto& outbox = *_outboxes[rank];
+  std::vector<std::unique_ptr<rpc::RPCMessage>> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(outbox.mutex);
+      outbox.changed.wait(lock, [&outbox] {
+        return !outbox.messages.empty() || outbox.closed;
+      });
+      if (outbox.messages.empty())
+        return;
+
+      std::swap(batch, outbox.messages);
+    }
+    outbox.changed.notify_all();
+
+    try {
+      sendMessages(_sockets[rank], batch, outbox.cache);
+    } catch (const std::exception& e) {
+      setError(rank, "send: " + std::string(e.what()));
+      {
+        std::lock_guard<std::mutex> lock(outbox.mutex);
+        outbox.messages.clear();
+        outbox.closed = true;
+      }
+      outbox.changed.notify_all();
+      return;
+    }
+    batch.clear();
   }
 }
 
 void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
   // Throw error received from a worker.
-  if (_error) {
-    throw std::runtime_error(*_error);
+  {
+    std::lock_guard<std::mutex> lock(_error_mutex);
+    if (_error) {
+      throw std::runtime_error(*_error);
+    }
   }
 
   if ((rank <= 0) || (rank >= _sockets.size())) {
     throw std::domain_error("sendMessage received invalid rank as parameter");
   }
 
-  std::lock_guard<std::mutex> guard(_mutexes[rank]);
-  ::thd::sendMessage(_sockets[rank], std::move(msg));
+  auto& outbox = *_outboxes[rank];
+  {
+    std::unique_lock<std::mutex> lock(outbox.mutex);
+    outbox.changed.wait(lock, [&outbox] {
+      return outbox.messages.size() < MAX_QUEUED_MESSAGES || outbox.closed;
+    });
+    if (outbox.closed)
+      throw std::runtime_error("connection with worker " + std::to_string(rank) +
+                               " has been closed");
+    outbox.messages.push_back(std::move(msg));
+  }
+  outbox.changed.notify_all();
 }
 
 std::tuple<rank_type, std::string> MasterCommandChannel::recvError() {
@@ -183,6 +289,9 @@ WorkerCommandChannel::WorkerCommandChannel(InitMethod::Config config)
   , _socket(-1)
   , _master_addr(config.worker.master_addr)
   , _master_port(config.worker.master_port)
+  , _buffer(RECV_BUFFER_SIZE)
+  , _buffer_begin(0)
+  , _buffer_end(0)
 {}
 
 WorkerCommandChannel::~WorkerCommandChannel() {
@@ -199,8 +308,59 @@ bool WorkerCommandChannel::init() {
   return true;
 }
 
+void WorkerCommandChannel::fill(std::size_t length) {
+  if (_buffer_end - _buffer_begin >= length)
+    return;
+
+  if (_buffer_begin + length > _buffer.size()) {
+    std::memmove(_buffer.data(), _buffer.data() + _buffer_begin, _buffer_end - _buffer_begin);
+    _buffer_end -= _buffer_begin;
+    _buffer_begin = 0;
+    if (length > _buffer.size())
+      _buffer.resize(length);
+  }
+
+  // receives everything that has already arrived, not only `length` bytes
+  while (_buffer_end - _buffer_begin < length) {
+    ssize_t bytes_received;
+    SYSCHECK(bytes_received = ::recv(_socket, _buffer.data() + _buffer_end,
+                                     _buffer.size() - _buffer_end, 0))
+    if (bytes_received == 0)
+      throw std::system_error(ECONNRESET, std::system_category());
+    _buffer_end += bytes_received;
+  }
+}
+
+std::uint64_t WorkerCommandChannel::recvVarint() {
+  // the last byte of a varint doesn't have the highest bit set
+  std::size_t length = 1;
+  for (; length < rpc::MAX_VARINT_SIZE; ++length) {
+    fill(length);
+    if ((_buffer[_buffer_begin + length - 1] & 0x80) == 0)
+      break;
+  }
+
+  fill(length);
+  const char* begin = _buffer.data() + _buffer_begin;
+  std::uint64_t value = rpc::readVarint(begin, begin + length);
+  _buffer_begin += length;
+  return value;
+}
+
 std::unique_ptr<rpc::RPCMessage> WorkerCommandChannel::recvMessage() {
-  return ::thd::receiveMessage(_socket);
+  std::size_t length = recvVarint();
+  std::size_t num_objects = recvVarint();
+  std::vector<object_id_type> objects(num_objects);
+  for (auto& object : objects)
+    object = _cache.decode(recvVarint());
+
+  fill(length);
+  std::unique_ptr<rpc::RPCMessage> msg(
+    new rpc::RPCMessage(_buffer.data() + _buffer_begin, length)
+  );
+  _buffer_begin += length;
+  msg->objects() = std::move(objects);
+  return msg;
 }
 
 void WorkerCommandChannel::sendError(const std::string& error) {
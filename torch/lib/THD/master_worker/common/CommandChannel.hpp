@@ -4,6 +4,8 @@
 
 #include <sys/poll.h>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -13,26 +15,63 @@
 
 namespace thd {
 
+/*
+ * Ids of objects recently sent over a connection. Both of its ends update it
+ * in the same way, so an id found in it is sent as its (short) position.
+ */
+struct ObjectCache {
+  ObjectCache();
+
+  // Returns the code of `id` and remembers it.
+  std::uint64_t encode(object_id_type id);
+  // Returns the id encoded by `encode` as `code`.
+  object_id_type decode(std::uint64_t code);
+
+private:
+  std::vector<object_id_type> _ids; // indexed by id modulo their number
+};
+
 struct MasterCommandChannel {
   MasterCommandChannel(InitMethod::Config config);
   ~MasterCommandChannel();
 
   bool init();
 
+  /*
+   * Queues `msg` to be sent to worker `rank` and returns without waiting for
+   * it to be sent. Messages queued while the previous ones are being sent are
+   * sent together, in the order in which they were queued. Commands whose
+   * result the master reads still block it until the worker sends the value
+   * back (see receiveValueFromWorker).
+   */
   void sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank);
 
 private:
+  struct Outbox {
+    Outbox() : closed(false) {}
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::unique_ptr<rpc::RPCMessage>> messages;
+    bool closed;
+    std::thread sender;
+    ObjectCache cache; // used only by the sender
+  };
+
   std::tuple<rank_type, std::string> recvError();
   void errorHandler();
+  void setError(rank_type rank, const std::string& error);
+  void sender(rank_type rank);
 
   rank_type _rank;
   std::vector<int> _sockets;
   std::unique_ptr<struct pollfd[]> _poll_events;
 
   int _error_pipe; // informs error handler thread that we are exiting
+  std::mutex _error_mutex;
   std::unique_ptr<std::string> _error;
   std::thread _error_thread;
-  std::vector<std::mutex> _mutexes;
+  std::vector<std::unique_ptr<Outbox>> _outboxes;
 };
 
 struct WorkerCommandChannel {
@@ -45,11 +84,20 @@ struct WorkerCommandChannel {
   void sendError(const std::string& error);
 
 private:
+  void fill(std::size_t length);
+  std::uint64_t recvVarint();
+
   rank_type _rank;
   int _socket;
 
   std::string _master_addr;
   port_type _master_port;
+
+  // messages arrive in batches, so they are received in large blocks
+  std::vector<char> _buffer;
+  std::size_t _buffer_begin;
+  std::size_t _buffer_end;
+  ObjectCache _cache;
 };
 
 } // namespace thd
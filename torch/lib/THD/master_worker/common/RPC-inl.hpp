@@ -1,55 +1,94 @@
+#include <algorithm>
 #include <cstdint>
 #include "TH/THStorage.h"
 #include "Traits.hpp"
+#include "Varint.hpp"
 
 namespace thd { namespace rpc { namespace detail {
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr size_t INITIAL_BUFFER_SIZE = 256;
+/*
+ * Every argument is preceded by its type. Integers are written as varints
+ * (zigzag encoded if their type is signed) and floating point values as they
+ * are. Tensors, storages and generators are written as their positions in
+ * the list of objects of the message, which is sent before it.
+ *
+ * The buffer is allocated once, with the size computed by `_dataSize`, which
+ * is an upper bound of the size of every argument.
+ */
+struct MessageBuilder {
+  MessageBuilder(std::size_t capacity) : bytes(capacity) {}
+
+  void appendType(RPCType _type) {
+    char type = static_cast<char>(_type);
+    bytes.append(&type, sizeof(type));
+  }
+
+  void appendVarint(std::uint64_t value) {
+    char buffer[MAX_VARINT_SIZE];
+    bytes.append(buffer, writeVarint(buffer, value) - buffer);
+  }
+
+  template<typename T>
+  void appendRaw(T value) {
+    bytes.append(reinterpret_cast<char*>(&value), sizeof(value));
+  }
+
+  void appendObject(RPCType type, object_id_type id) {
+    appendType(type);
+    // an object passed more than once is listed once
+    std::size_t position = std::find(objects.begin(), objects.end(), id) - objects.begin();
+    if (position == objects.size())
+      objects.push_back(id);
+    appendVarint(position);
+  }
+
+  ByteArray bytes;
+  std::vector<object_id_type> objects;
+};
 
 template<typename real,
          typename = typename std::enable_if<std::is_arithmetic<real>::value>::type>
-inline void _appendScalar(ByteArray& str, real data) {
-  str.append(reinterpret_cast<char*>(&data), sizeof(data));
-}
-
-inline void _appendType(ByteArray& str, RPCType _type) {
-  char type = static_cast<char>(_type);
-  str.append(&type, sizeof(type));
+inline void _appendScalar(MessageBuilder& builder, real data) {
+  constexpr RPCType type = type_traits<real>::type;
+  builder.appendType(type);
+  if (isFloat(type)) {
+    builder.appendRaw<real>(data);
+  } else if (isSigned(type)) {
+    builder.appendVarint(zigzagEncode(static_cast<std::int64_t>(data)));
+  } else {
+    builder.appendVarint(static_cast<std::uint64_t>(data));
+  }
 }
 
 template<typename T>
-inline void __appendData(ByteArray& str, const T& arg,
+inline void __appendData(MessageBuilder& builder, const T& arg,
     std::false_type is_generator, std::false_type is_tensor, std::false_type is_storage) {
-  _appendType(str, type_traits<T>::type);
-  _appendScalar<T>(str, arg);
+  _appendScalar<T>(builder, arg);
 }
 
 template<typename T>
-inline void __appendData(ByteArray& str, const T& arg,
+inline void __appendData(MessageBuilder& builder, const T& arg,
     std::true_type is_generator, std::false_type is_tensor, std::false_type is_storage) {
-  _appendType(str, RPCType::GENERATOR);
-  _appendScalar<object_id_type>(str, arg->generator_id);
+  builder.appendObject(RPCType::GENERATOR, arg->generator_id);
 }
 
 template<typename T>
-inline void __appendData(ByteArray& str, const T& arg,
+inline void __appendData(MessageBuilder& builder, const T& arg,
     std::false_type is_generator, std::true_type is_tensor, std::false_type is_storage) {
-  _appendType(str, RPCType::TENSOR);
-  _appendScalar<object_id_type>(str, arg->tensor_id);
+  builder.appendObject(RPCType::TENSOR, arg->tensor_id);
 }
 
 template<typename T>
-inline void __appendData(ByteArray& str, const T& arg,
+inline void __appendData(MessageBuilder& builder, const T& arg,
     std::false_type is_generator, std::false_type is_tensor, std::true_type is_storage) {
-  _appendType(str, RPCType::STORAGE);
-  _appendScalar<object_id_type>(str, arg->storage_id);
+  builder.appendObject(RPCType::STORAGE, arg->storage_id);
 }
 
 template<typename T>
-inline void _appendData(ByteArray& str, const T& arg) {
+inline void _appendData(MessageBuilder& builder, const T& arg) {
   __appendData(
-      str,
+      builder,
       arg,
       is_any_of<T, THDGeneratorPtrTypes>(),
       is_any_of<T, THDTensorPtrTypes>(),
@@ -57,22 +96,22 @@ inline void _appendData(ByteArray& str, const T& arg) {
   );
 }
 
-inline void _appendData(ByteArray& str, THLongStorage* arg) {
-  _appendType(str, RPCType::LONG_STORAGE);
-  _appendScalar<char>(str, arg == NULL);
+inline void _appendData(MessageBuilder& builder, THLongStorage* arg) {
+  builder.appendType(RPCType::LONG_STORAGE);
+  // 0 stands for NULL
+  builder.appendVarint(arg == NULL ? 0 : static_cast<std::uint64_t>(arg->size) + 1);
   if (!arg) return;
-  _appendScalar<ptrdiff_t>(str, arg->size);
   for (ptrdiff_t i = 0; i < arg->size; i++)
-    _appendScalar<int64_t>(str, arg->data[i]);
+    builder.appendVarint(zigzagEncode(arg->data[i]));
 }
 
 template<typename T>
-inline void _appendData(ByteArray& str, const std::vector<T>& arg) {
+inline void _appendData(MessageBuilder& builder, const std::vector<T>& arg) {
   int l = arg.size();
-  _appendData(str, l);
+  _appendData(builder, l);
   for (std::size_t i = 0; i < l; i++)
     __appendData(
-        str,
+        builder,
         arg[i],
         is_any_of<T, THDGeneratorPtrTypes>(),
         is_any_of<T, THDTensorPtrTypes>(),
@@ -80,16 +119,49 @@ inline void _appendData(ByteArray& str, const std::vector<T>& arg) {
     );
 }
 
-inline void _appendData(ByteArray& str, RPCType type) {
-  _appendType(str, type);
+inline void _appendData(MessageBuilder& builder, RPCType type) {
+  builder.appendType(type);
+}
+
+inline void _packIntoString(MessageBuilder& builder) {};
+
+template <typename T, typename ...Args>
+inline void _packIntoString(MessageBuilder& builder, const T& arg, const Args&... args) {
+  _appendData(builder, arg);
+  _packIntoString(builder, args...);
 }
 
-inline void _packIntoString(ByteArray& str) {};
+////////////////////////////////////////////////////////////////////////////////
+
+// A scalar or an object: its type and at most MAX_VARINT_SIZE bytes.
+template<typename T>
+inline std::size_t _dataSize(const T& arg) {
+  return sizeof(RPCType) + MAX_VARINT_SIZE;
+}
+
+inline std::size_t _dataSize(THLongStorage* arg) {
+  std::size_t size = sizeof(RPCType) + MAX_VARINT_SIZE;
+  if (arg)
+    size += arg->size * MAX_VARINT_SIZE;
+  return size;
+}
+
+template<typename T>
+inline std::size_t _dataSize(const std::vector<T>& arg) {
+  return (arg.size() + 1) * (sizeof(RPCType) + MAX_VARINT_SIZE);
+}
+
+inline std::size_t _dataSize(RPCType type) {
+  return sizeof(RPCType);
+}
+
+inline std::size_t _packedSize() {
+  return 0;
+}
 
 template <typename T, typename ...Args>
-inline void _packIntoString(ByteArray& str, const T& arg, const Args&... args) {
-  _appendData(str, arg);
-  _packIntoString(str, args...);
+inline std::size_t _packedSize(const T& arg, const Args&... args) {
+  return _dataSize(arg) + _packedSize(args...);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -100,10 +172,16 @@ inline std::unique_ptr<RPCMessage> packMessage(
     function_id_type fid,
     const Args&... args
 ) {
-  ByteArray msg(detail::INITIAL_BUFFER_SIZE);
-  detail::_appendScalar<function_id_type>(msg, fid);
-  detail::_packIntoString(msg, args...);
-  return std::unique_ptr<RPCMessage>(new RPCMessage(std::move(msg)));
+  detail::MessageBuilder builder(sizeof(function_id_type) + detail::_packedSize(args...));
+  // every argument is at most one object, unless it's a vector
+  builder.objects.reserve(sizeof...(args));
+  builder.appendRaw<function_id_type>(fid);
+  detail::_packIntoString(builder, args...);
+
+  std::unique_ptr<RPCMessage> message(new RPCMessage(std::move(builder.bytes)));
+  // lets workers run commands on unrelated objects concurrently
+  message->objects() = std::move(builder.objects);
+  return message;
 }
 
 }} // namespace rpc, thd
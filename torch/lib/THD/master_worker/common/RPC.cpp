@@ -1,5 +1,6 @@
 #include "RPC.hpp"
 #include "ByteArray.hpp"
+#include "Varint.hpp"
 
 #include <cstdarg>
 #include <cstring>
@@ -45,6 +46,10 @@ RPCMessage::size_type RPCMessage::remaining() const {
   return _msg.length() - _offset;
 }
 
+std::vector<object_id_type>& RPCMessage::objects() {
+  return _objects;
+}
+
 const char* RPCMessage::read(std::size_t num_bytes) {
   if (_offset + num_bytes > _msg.length())
     throw std::out_of_range("invalid access: out of bounds");
@@ -62,6 +67,27 @@ inline T unpackScalar(RPCMessage& raw_message) {
   return *reinterpret_cast<const T*>(raw_message.read(sizeof(T)));
 }
 
+std::uint64_t unpackVarint(RPCMessage& raw_message) {
+  const char* begin = raw_message.data();
+  const char* end = begin;
+  std::uint64_t value = readVarint(end, begin + raw_message.remaining());
+  raw_message.read(end - begin);
+  return value;
+}
+
+object_id_type unpackObject(RPCMessage& raw_message, RPCType expected_type,
+                            const char* error) {
+  RPCType type = unpackType(raw_message);
+  if (type != expected_type)
+    throw std::invalid_argument(error);
+
+  auto position = unpackVarint(raw_message);
+  auto& objects = raw_message.objects();
+  if (position >= objects.size())
+    throw std::out_of_range("invalid object in the raw message");
+  return objects[position];
+}
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -82,6 +108,12 @@ function_id_type unpackFunctionId(RPCMessage& raw_message) {
   return unpackScalar<function_id_type>(raw_message);
 }
 
+function_id_type peekFunctionId(RPCMessage& raw_message) {
+  if (raw_message.remaining() < sizeof(function_id_type))
+    throw std::out_of_range("invalid access: out of bounds");
+  return *reinterpret_cast<const function_id_type*>(raw_message.data());
+}
+
 double unpackFloat(RPCMessage& raw_message) {
   RPCType type = unpackType(raw_message);
   if (type == RPCType::DOUBLE)
@@ -94,56 +126,44 @@ double unpackFloat(RPCMessage& raw_message) {
 
 int64_t unpackInteger(RPCMessage& raw_message) {
   RPCType type = unpackType(raw_message);
-  if (type == RPCType::CHAR)
-    return unpackScalar<int8_t>(raw_message);
-  else if (type == RPCType::SHORT)
-    return unpackScalar<int16_t>(raw_message);
-  else if (type == RPCType::INT)
-    return unpackScalar<int32_t>(raw_message);
-  else if (type == RPCType::LONG)
-    return unpackScalar<int64_t>(raw_message);
-  else if (type == RPCType::LONG_LONG)
-    return unpackScalar<int64_t>(raw_message);
+  if (!isInteger(type)) {
+    throw std::invalid_argument(std::string("wrong integer type in the raw message (") +
+            std::to_string(static_cast<char>(type)) + ")");
+  }
 
-  throw std::invalid_argument(std::string("wrong integer type in the raw message (") +
-          std::to_string(static_cast<char>(type)) + ")");
+  std::uint64_t value = unpackVarint(raw_message);
+  if (isSigned(type))
+    return zigzagDecode(value);
+  return static_cast<int64_t>(value);
 }
 
 object_id_type unpackTensor(RPCMessage& raw_message) {
-  RPCType type = unpackType(raw_message);
-  if (type == RPCType::TENSOR)
-    return unpackScalar<object_id_type>(raw_message);
-  throw std::invalid_argument("expected tensor in the raw message");
+  return unpackObject(raw_message, RPCType::TENSOR, "expected tensor in the raw message");
 }
 
 object_id_type unpackStorage(RPCMessage& raw_message) {
-  RPCType type = unpackType(raw_message);
-  if (type == RPCType::STORAGE)
-    return unpackScalar<object_id_type>(raw_message);
-  throw std::invalid_argument("expected storage in the raw message");
+  return unpackObject(raw_message, RPCType::STORAGE, "expected storage in the raw message");
 }
 
 object_id_type unpackGenerator(RPCMessage& raw_message) {
-  RPCType type = unpackType(raw_message);
-  if (type == RPCType::GENERATOR) {
-    return unpackScalar<object_id_type>(raw_message);
-  }
-  throw std::invalid_argument("expected generator in the raw message");
+  return unpackObject(raw_message, RPCType::GENERATOR, "expected generator in the raw message");
 }
 
 THLongStorage* unpackTHLongStorage(RPCMessage& raw_message) {
   RPCType type = unpackType(raw_message);
   if (type != RPCType::LONG_STORAGE)
     throw std::invalid_argument("expected THLongStorage in the raw message");
-  char is_null = unpackScalar<char>(raw_message);
-  if (is_null) return NULL;
-  ptrdiff_t size = unpackScalar<ptrdiff_t>(raw_message);
+  std::uint64_t size_code = unpackVarint(raw_message);
+  if (size_code == 0) return NULL;
+  ptrdiff_t size = static_cast<ptrdiff_t>(size_code - 1);
+  if (static_cast<std::size_t>(size) > raw_message.remaining())
+    throw std::out_of_range("invalid access: out of bounds");
   THLongStorage* storage = THLongStorage_newWithSize(size);
   int64_t* data = storage->data;
 
   try {
     for (int i = 0; i < size; i++) {
-      data[i] = unpackScalar<int64_t>(raw_message);
+      data[i] = zigzagDecode(unpackVarint(raw_message));
     }
   } catch (std::exception& e) {
     THLongStorage_free(storage);
@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace thd {
 
@@ -29,10 +30,13 @@ public:
   bool isEmpty() const;
   size_type remaining() const; // Length of the msg left to read.
   const char* read(std::size_t num_bytes);
+  // Ids of tensors, storages and generators passed as arguments.
+  std::vector<object_id_type>& objects();
 
 private:
   ByteArray _msg;
   std::size_t _offset;
+  std::vector<object_id_type> _objects;
 };
 
 template <typename ...Args>
@@ -42,6 +46,7 @@ RPCType unpackType(RPCMessage& raw_message);
 RPCType peekType(RPCMessage& raw_message);
 double unpackFloat(RPCMessage& raw_message);
 function_id_type unpackFunctionId(RPCMessage& raw_message);
+function_id_type peekFunctionId(RPCMessage& raw_message);
 int64_t unpackInteger(RPCMessage& raw_message);
 object_id_type unpackGenerator(RPCMessage& raw_message);
 object_id_type unpackTensor(RPCMessage& raw_message);
@@ -46,6 +46,11 @@ inline bool isInteger(RPCType t) {
           t == RPCType::LONG_LONG || t == RPCType::ULONG_LONG);
 }
 
+inline bool isSigned(RPCType t) {
+  return (t == RPCType::CHAR || t == RPCType::SHORT || t == RPCType::INT ||
+          t == RPCType::LONG || t == RPCType::LONG_LONG);
+}
+
 inline const char* toString(RPCType t) {
   switch (t) {
     case RPCType::CHAR: return "Char";
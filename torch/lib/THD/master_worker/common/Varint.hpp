@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace thd { namespace rpc {
+
+/*
+ * Variable length encoding of integers: 7 bits per byte, least significant
+ * first, with the highest bit set in all bytes but the last one. Signed
+ * values are zigzag encoded first, so small negative values are short too.
+ */
+
+constexpr std::size_t MAX_VARINT_SIZE = 10;
+
+inline std::size_t varintSize(std::uint64_t value) {
+  std::size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+// Writes `value` to `out` and returns the end of written bytes.
+inline char* writeVarint(char* out, std::uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<char>(value);
+  return out;
+}
+
+// Reads a value from [`in`, `end`) and moves `in` past it.
+inline std::uint64_t readVarint(const char*& in, const char* end) {
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (in == end)
+      throw std::out_of_range("invalid access: out of bounds");
+
+    auto byte = static_cast<std::uint8_t>(*in++);
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return value;
+  }
+  throw std::invalid_argument("malformed varint in the raw message");
+}
+
+inline std::uint64_t zigzagEncode(std::int64_t value) {
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzagDecode(std::uint64_t value) {
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+}} // namespace rpc, thd
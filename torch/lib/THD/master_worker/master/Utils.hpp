@@ -2,6 +2,8 @@
 
 #include "process_group/General.hpp"
 
+// Blocks until the worker has run every command queued for it before the one
+// producing the value, so each read costs a full round trip.
 template<typename T>
 T receiveValueFromWorker(int worker_id) {
   thd::RPCType type = thd::type_traits<T>::type;
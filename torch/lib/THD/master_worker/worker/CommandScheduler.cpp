@@ -0,0 +1,236 @@
+#include "CommandScheduler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace thd {
+namespace worker {
+namespace {
+
+constexpr char THREADS_ENV[] = "THD_WORKER_THREADS";
+constexpr std::size_t DEFAULT_MAX_THREADS = 4;
+
+std::size_t loadNumThreads() {
+  const char* env_value = std::getenv(THREADS_ENV);
+  if (env_value != nullptr) {
+    auto value = std::stoll(env_value);
+    if (value <= 0)
+      throw std::domain_error(std::string(THREADS_ENV) + " should be a positive integer");
+    return static_cast<std::size_t>(value);
+  }
+
+  std::size_t hardware_threads = std::thread::hardware_concurrency();
+  return std::max<std::size_t>(1, std::min(DEFAULT_MAX_THREADS, hardware_threads));
+}
+
+} // anonymous namespace
+
+struct CommandScheduler::Task {
+  Task(command_type command) : command(std::move(command)), pending(0), done(false) {}
+
+  command_type command;
+  std::size_t pending; // number of unfinished tasks it waits for
+  std::vector<std::shared_ptr<Task>> dependents;
+  bool done;
+};
+
+struct CommandScheduler::Family {
+  std::vector<object_id_type> members;
+  std::shared_ptr<Task> last; // the last task using this family
+};
+
+
+CommandScheduler::CommandScheduler(execute_type execute, error_type on_error)
+  : _execute(std::move(execute))
+  , _on_error(std::move(on_error))
+  , _in_flight(0)
+  , _error(nullptr)
+  , _stop(false)
+{
+  std::size_t num_threads = loadNumThreads();
+  if (num_threads == 1)
+    return;
+
+  for (std::size_t i = 0; i < num_threads; ++i)
+    _threads.emplace_back(&CommandScheduler::worker, this);
+}
+
+
+CommandScheduler::~CommandScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _ready_changed.notify_all();
+  for (auto& thread : _threads)
+    thread.join();
+}
+
+
+void CommandScheduler::schedule(command_type command, CommandKind kind) {
+  if (_threads.empty()) {
+    _execute(std::move(command));
+    return;
+  }
+
+  auto objects = command->objects();
+  if (kind != CommandKind::CONCURRENT || objects.empty()) {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (kind == CommandKind::RELEASE) {
+        release(objects);
+      } else {
+        merge(objects);
+      }
+    }
+    _execute(std::move(command));
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_error && !_on_error)
+    std::rethrow_exception(_error);
+
+  auto task = std::make_shared<Task>(std::move(command));
+  for (auto object : objects) {
+    auto& object_family = family(object);
+    auto& last = object_family->last;
+    if (last == task) // another object of the same family
+      continue;
+
+    if (last && !last->done) {
+      last->dependents.push_back(task);
+      task->pending++;
+    }
+    last = task;
+  }
+
+  _in_flight++;
+  if (task->pending == 0) {
+    _ready.push(task);
+    lock.unlock();
+    _ready_changed.notify_one();
+  }
+}
+
+
+void CommandScheduler::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [this] { return _in_flight == 0; });
+  if (_error && !_on_error)
+    std::rethrow_exception(_error);
+}
+
+
+void CommandScheduler::worker() {
+  while (true) {
+    std::shared_ptr<Task> task;
+    bool failed;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _ready_changed.wait(lock, [this] { return _stop || !_ready.empty(); });
+      if (_ready.empty())
+        return;
+
+      task = _ready.front();
+      _ready.pop();
+      failed = static_cast<bool>(_error);
+    }
+
+    // Commands scheduled after a failed one are skipped, the worker is going
+    // to report the error and exit anyway.
+    if (!failed) {
+      try {
+        _execute(std::move(task->command));
+      } catch (...) {
+        bool first;
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          first = !_error;
+          if (first)
+            _error = std::current_exception();
+        }
+        // before the task finishes, so `wait` doesn't return in the meantime
+        if (first && _on_error)
+          _on_error(std::current_exception());
+      }
+    }
+    task->command.reset();
+
+    finish(*task);
+  }
+}
+
+
+void CommandScheduler::finish(Task& task) {
+  std::size_t num_ready = 0;
+  bool idle;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    task.done = true;
+    for (auto& dependent : task.dependents) {
+      if (--dependent->pending == 0) {
+        _ready.push(dependent);
+        num_ready++;
+      }
+    }
+    task.dependents.clear();
+    idle = --_in_flight == 0;
+  }
+
+  for (std::size_t i = 0; i < num_ready; ++i)
+    _ready_changed.notify_one();
+  if (idle)
+    _idle.notify_all();
+}
+
+
+std::shared_ptr<CommandScheduler::Family>& CommandScheduler::family(object_id_type object) {
+  auto& object_family = _families[object];
+  if (!object_family) {
+    object_family = std::make_shared<Family>();
+    object_family->members.push_back(object);
+  }
+  return object_family;
+}
+
+
+void CommandScheduler::merge(const std::vector<object_id_type>& objects) {
+  if (objects.empty())
+    return;
+
+  auto target = family(objects[0]);
+  for (auto object : objects) {
+    auto source = family(object);
+    if (source == target)
+      continue;
+
+    if (source->members.size() > target->members.size())
+      std::swap(source, target);
+    for (auto member : source->members) {
+      target->members.push_back(member);
+      _families[member] = target;
+    }
+  }
+  // all tasks have finished
+  target->last.reset();
+}
+
+
+void CommandScheduler::release(const std::vector<object_id_type>& objects) {
+  for (auto object : objects) {
+    auto it = _families.find(object);
+    if (it == _families.end())
+      continue;
+
+    auto& members = it->second->members;
+    members.erase(std::remove(members.begin(), members.end(), object), members.end());
+    _families.erase(it);
+  }
+}
+
+} // namespace worker
+} // namespace thd
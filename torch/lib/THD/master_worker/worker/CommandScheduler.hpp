@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../common/RPC.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace thd {
+namespace worker {
+
+enum class CommandKind {
+  CONCURRENT, // only reads and modifies objects passed as its arguments
+  EXCLUSIVE, // can create objects, make them share data or talk to the master
+  RELEASE, // frees objects passed as its arguments
+};
+
+/*
+ * Runs commands received from the master on a pool of threads.
+ *
+ * Objects that can share data (e.g. a tensor and its view) belong to the same
+ * family. A concurrent command waits only for earlier commands using objects
+ * of its families, so commands on unrelated tensors run in parallel, while
+ * commands on related ones run in the order in which they were sent.
+ * Exclusive commands wait for all earlier commands and run in the thread
+ * that schedules them; objects they use are merged into one family, as they
+ * could have been made to share data.
+ *
+ * The number of threads is read from `THD_WORKER_THREADS`. With a single
+ * thread all commands run in the thread that schedules them.
+ */
+struct CommandScheduler {
+  using command_type = std::unique_ptr<rpc::RPCMessage>;
+  using execute_type = std::function<void (command_type)>;
+  using error_type = std::function<void (std::exception_ptr)>;
+
+  /*
+   * `on_error` is called with the first exception thrown by a command that
+   * runs in another thread, right when it is thrown and in that thread.
+   * Commands scheduled after it are skipped.
+   */
+  CommandScheduler(execute_type execute, error_type on_error = nullptr);
+  ~CommandScheduler();
+
+  CommandScheduler(const CommandScheduler&) = delete;
+  CommandScheduler& operator=(const CommandScheduler&) = delete;
+
+  /*
+   * Runs `command` or queues it. Rethrows the first exception thrown by a
+   * command that has run in another thread, unless `on_error` has handled
+   * it already.
+   */
+  void schedule(command_type command, CommandKind kind);
+  // Waits until all scheduled commands finish. Rethrows like `schedule`.
+  void wait();
+
+private:
+  struct Task;
+  struct Family;
+
+  void worker();
+  void finish(Task& task);
+  std::shared_ptr<Family>& family(object_id_type object);
+  void merge(const std::vector<object_id_type>& objects);
+  void release(const std::vector<object_id_type>& objects);
+
+  execute_type _execute;
+  error_type _on_error;
+
+  std::mutex _mutex;
+  std::condition_variable _ready_changed;
+  std::condition_variable _idle;
+  std::queue<std::shared_ptr<Task>> _ready;
+  std::size_t _in_flight;
+  std::exception_ptr _error;
+  bool _stop;
+
+  std::unordered_map<object_id_type, std::shared_ptr<Family>> _families;
+  std::vector<std::thread> _threads;
+};
+
+} // namespace worker
+} // namespace thd
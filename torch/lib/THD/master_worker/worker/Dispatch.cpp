@@ -1,6 +1,7 @@
 #include <TH/THStorage.h>
 #include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -10,6 +11,7 @@
 #include "../common/Functions.hpp"
 #include "../common/RPC.hpp"
 #include "../master/Master.hpp"
+#include "Dispatch.hpp"
 #include "Worker.hpp"
 
 namespace thd {
@@ -276,8 +278,83 @@ static const std::unordered_map<rpc::function_id_type, dispatch_fn> functions {
     {Functions::exit, exitWorker}
 };
 
+/*
+ * Functions which create objects, make them share data or communicate with
+ * other processes. All other functions are CommandKind::CONCURRENT.
+ */
+static const std::unordered_set<rpc::function_id_type> exclusive_functions {
+    Functions::generatorNew,
+    Functions::generatorSeed,
+
+    Functions::tensorCopyFromMaster,
+    Functions::tensorCopyFromWorker,
+
+    Functions::tensorNew,
+    Functions::tensorNewWithSize,
+    Functions::tensorNewWithStorage,
+    Functions::tensorNewWithTensor,
+    Functions::tensorNewClone,
+    Functions::tensorSet,
+    Functions::tensorSetStorage,
+    Functions::tensorSetStorage1d,
+    Functions::tensorSetStorage2d,
+    Functions::tensorSetStorage3d,
+    Functions::tensorSetStorage4d,
+    Functions::tensorNarrow,
+    Functions::tensorSelect,
+    Functions::tensorTranspose,
+    Functions::tensorUnfold,
+    Functions::tensorSqueeze,
+    Functions::tensorSqueeze1d,
+
+    Functions::tensorDot,
+    Functions::tensorMinall,
+    Functions::tensorMaxall,
+    Functions::tensorMedianall,
+    Functions::tensorSumall,
+    Functions::tensorProdall,
+    Functions::tensorTrace,
+    Functions::tensorNonzero,
+    Functions::tensorEqual,
+    Functions::tensorDist,
+    Functions::tensorMeanall,
+    Functions::tensorVarall,
+    Functions::tensorStdall,
+    Functions::tensorNormall,
+    Functions::tensorLogicalall,
+    Functions::tensorLogicalany,
+
+    Functions::storageGet,
+    Functions::storageNew,
+    Functions::storageNewWithSize,
+    Functions::storageNewWithSize1,
+    Functions::storageNewWithSize2,
+    Functions::storageNewWithSize3,
+    Functions::storageNewWithSize4,
+
+    Functions::sendTensor,
+    Functions::sendStorage,
+
+    Functions::exit
+};
+
+static const std::unordered_set<rpc::function_id_type> releasing_functions {
+    Functions::generatorFree,
+    Functions::tensorFree,
+    Functions::storageFree
+};
+
 } // namespace detail
 
+CommandKind commandKind(rpc::RPCMessage& raw_message) {
+  rpc::function_id_type fid = rpc::peekFunctionId(raw_message);
+  if (detail::releasing_functions.count(fid) > 0)
+    return CommandKind::RELEASE;
+  if (detail::exclusive_functions.count(fid) > 0)
+    return CommandKind::EXCLUSIVE;
+  return CommandKind::CONCURRENT;
+}
+
 /* On fail throws exceptions which should be caught in worker's loop and reported
  * to master.
  */
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "../common/RPC.hpp"
+#include "CommandScheduler.hpp"
 
 #include <memory>
 
 namespace thd {
 namespace worker {
 
+// Tells how `raw_message` can be scheduled, without reading it.
+CommandKind commandKind(rpc::RPCMessage& raw_message);
 void execute(std::unique_ptr<rpc::RPCMessage> raw_message_ptr);
 
 } // namespace worker
@@ -21,6 +21,16 @@ std::unordered_map<object_id_type, std::unique_ptr<at::Generator>> workerGenerat
 using namespace thd::rpc;
 using namespace thd::worker;
 
+namespace {
+
+void reportError(const std::exception& e) {
+  std::cerr << "WORKER ERROR: " << e.what() << std::endl;
+  workerCommandChannel->sendError(e.what());
+  ::exit(1);
+}
+
+} // anonymous namespace
+
 void THDWorkerMain(std::string init_method, int world_size,
                    std::string group_name, int rank) {
   auto config = thd::getInitConfig(init_method, world_size, group_name, rank);
@@ -30,14 +40,22 @@ void THDWorkerMain(std::string init_method, int world_size,
     return;
   }
 
+  // commands on unrelated objects run concurrently, and errors of the ones
+  // running in other threads are reported while this one waits for commands
+  thd::worker::CommandScheduler scheduler(execute, [](std::exception_ptr error) {
+    try {
+      std::rethrow_exception(error);
+    } catch (std::exception& e) {
+      reportError(e);
+    }
+  });
   while (true) {
     command = workerCommandChannel->recvMessage();
     try {
-      execute(std::move(command));
+      auto kind = commandKind(*command);
+      scheduler.schedule(std::move(command), kind);
     } catch (std::exception& e) {
-      std::cerr << "WORKER ERROR: " << e.what() << std::endl;
-      workerCommandChannel->sendError(e.what());
-      ::exit(1);
+      reportError(e);
     }
   }
 }
@@ -2,6 +2,9 @@
 #include "General.hpp"
 #include "../base/ChannelUtils.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
 #include <vector>
 
 using namespace thd;
@@ -23,6 +26,110 @@ void THDReduce(THDTensorDescriptor& desc, THDReduceOp operation,
   dataChannel->reduce(desc, operation, convertToRank(dst_rank), group);
 }
 
+namespace {
+
+void allReduceElementwise(float* data, std::size_t numel,
+                          ElementwiseCompressor* compressor,
+                          const DataChannel::Group& group_desc,
+                          rank_type group_rank, THDGroup group) {
+  /*
+   * Reduce-scatter followed by an all-gather of the encoded data, padded to
+   * one chunk per process. Process i receives chunk i of every payload (one
+   * scatter per process), sums them in the order of group ranks and encodes
+   * the sum, and the encoded sums are all-gathered. Each process sends and
+   * receives 2 * (size - 1) / size of a payload instead of receiving
+   * size - 1 whole payloads.
+   */
+
+  rank_type size = group_desc.size();
+  std::size_t chunk = (numel + size - 1) / size;
+  int64_t chunk_bytes = compressor->payloadSize(chunk);
+
+  auto payload = at::CPU(at::kByte).tensor({chunk_bytes * size});
+  auto payload_data = reinterpret_cast<std::uint8_t*>(payload.data_ptr());
+  std::vector<float> padding(chunk * size - numel, 0.f);
+  compressor->compress(data, numel, payload_data);
+  compressor->encode(padding.data(), padding.size(),
+                     payload_data + compressor->payloadSize(numel));
+
+  auto received = at::CPU(at::kByte).tensor({chunk_bytes * size});
+  std::vector<at::Tensor> payload_chunks, received_chunks;
+  for (rank_type i = 0; i < size; ++i) {
+    payload_chunks.push_back(payload.narrow(0, i * chunk_bytes, chunk_bytes));
+    received_chunks.push_back(received.narrow(0, i * chunk_bytes, chunk_bytes));
+  }
+  for (rank_type i = 0; i < size; ++i) {
+    std::vector<at::Tensor> input;
+    if (i == group_rank)
+      input = payload_chunks;
+    dataChannel->scatter(input, received_chunks[i], group_desc.mustGetGlobalRank(i), group);
+  }
+
+  std::vector<float> sum(chunk, 0.f);
+  for (auto& received_chunk : received_chunks) {
+    compressor->decodeAdd(reinterpret_cast<const std::uint8_t*>(received_chunk.data_ptr()),
+                          chunk, sum.data());
+  }
+  auto encoded_sum = at::CPU(at::kByte).tensor({chunk_bytes});
+  compressor->encode(sum.data(), chunk,
+                     reinterpret_cast<std::uint8_t*>(encoded_sum.data_ptr()));
+
+  dataChannel->allGather(received_chunks, encoded_sum, group);
+  std::fill(data, data + numel, 0.f);
+  compressor->decodeAdd(reinterpret_cast<const std::uint8_t*>(received.data_ptr()),
+                        numel, data);
+}
+
+} // anonymous namespace
+
+void THDAllReduceCompressed(THDTensorDescriptor& desc, THDCompressor* compressor,
+                            THDGroup group) {
+  /*
+   * Every process compresses its own data. Payloads of elementwise
+   * compressors (fp16, bf16) are reduce-scattered and all-gathered in chunks,
+   * so the sums are rounded once more. The other payloads can't be summed
+   * before they are decoded, so they are exchanged with allGather, and all
+   * processes decompress and sum them. Sums are always taken in the order of
+   * group ranks, which gives the same result everywhere.
+   */
+
+  if (desc.type().scalarType() != at::kFloat || desc.type().isCuda() ||
+      !desc.is_contiguous()) {
+    throw std::invalid_argument("compressed allReduce supports only contiguous "
+                                "CPU float tensors");
+  }
+
+  const auto& group_desc = dataChannel->getGroup(group);
+  rank_type group_rank;
+  bool exists;
+  std::tie(group_rank, exists) = group_desc.getGroupRank(dataChannel->getRank());
+  if (!exists)
+    return;
+
+  auto data = reinterpret_cast<float*>(desc.data_ptr());
+  std::size_t numel = desc.numel();
+  auto elementwise = dynamic_cast<ElementwiseCompressor*>(compressor);
+  if (elementwise) {
+    allReduceElementwise(data, numel, elementwise, group_desc, group_rank, group);
+    return;
+  }
+
+  int64_t payload_size = compressor->payloadSize(numel);
+  auto payload = at::CPU(at::kByte).tensor({payload_size});
+  compressor->compress(data, numel, reinterpret_cast<std::uint8_t*>(payload.data_ptr()));
+
+  std::vector<at::Tensor> payloads;
+  for (rank_type i = 0; i < group_desc.size(); ++i)
+    payloads.push_back(at::CPU(at::kByte).tensor({payload_size}));
+  dataChannel->allGather(payloads, payload, group);
+
+  std::fill(data, data + numel, 0.f);
+  for (auto& gathered : payloads) {
+    compressor->decompressAdd(reinterpret_cast<const std::uint8_t*>(gathered.data_ptr()),
+                              numel, data);
+  }
+}
+
 void THDBroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group) {
   dataChannel->broadcast(desc, convertToRank(src_rank), group);
 }
@@ -78,10 +185,73 @@ void THDScatterRecv(THDTensorDescriptor& output, int src_rank, THDGroup group) {
   dataChannel->scatter(v_input, output, convertToRank(src_rank), group);
 }
 
+void THDReduceScatter(THDTensorDescriptor* input, size_t len,
+                      THDTensorDescriptor& output, THDReduceOp operation,
+                      THDGroup group) {
+  std::vector<at::Tensor> v_input(input, input + len);
+  dataChannel->reduceScatter(v_input, output, operation, group);
+}
+
 void THDBarrier(THDGroup group) {
   dataChannel->barrier(group);
 }
 
+THDRequest* THDIallReduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                          THDGroup group) {
+  return dataChannel->iallReduce(desc, operation, group);
+}
+
+THDRequest* THDIreduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                       int dst_rank, THDGroup group) {
+  return dataChannel->ireduce(desc, operation, convertToRank(dst_rank), group);
+}
+
+THDRequest* THDIbroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group) {
+  return dataChannel->ibroadcast(desc, convertToRank(src_rank), group);
+}
+
+THDRequest* THDIallGather(THDTensorDescriptor* output, size_t len,
+                          THDTensorDescriptor& input, THDGroup group) {
+  std::vector<at::Tensor> v_output(output, output + len);
+  return dataChannel->iallGather(v_output, input, group);
+}
+
+THDRequest* THDIgatherSend(THDTensorDescriptor& input, int dst_rank, THDGroup group) {
+  std::vector<at::Tensor> v_output;
+  return dataChannel->igather(v_output, input, convertToRank(dst_rank), group);
+}
+
+THDRequest* THDIgatherRecv(THDTensorDescriptor* output, size_t len,
+                           THDTensorDescriptor& input, THDGroup group) {
+  std::vector<at::Tensor> v_output(output, output + len);
+  return dataChannel->igather(v_output, input, dataChannel->getRank(), group);
+}
+
+THDRequest* THDIscatterSend(THDTensorDescriptor* input, size_t len,
+                            THDTensorDescriptor& output, THDGroup group) {
+  std::vector<at::Tensor> v_input(input, input + len);
+  return dataChannel->iscatter(v_input, output, dataChannel->getRank(), group);
+}
+
+THDRequest* THDIscatterRecv(THDTensorDescriptor& output, int src_rank, THDGroup group) {
+  if (src_rank < 0)
+    throw std::domain_error("src_rank should not be negative");
+
+  std::vector<at::Tensor> v_input;
+  return dataChannel->iscatter(v_input, output, convertToRank(src_rank), group);
+}
+
+THDRequest* THDIreduceScatter(THDTensorDescriptor* input, size_t len,
+                              THDTensorDescriptor& output, THDReduceOp operation,
+                              THDGroup group) {
+  std::vector<at::Tensor> v_input(input, input + len);
+  return dataChannel->ireduceScatter(v_input, output, operation, group);
+}
+
+THDRequest* THDIbarrier(THDGroup group) {
+  return dataChannel->ibarrier(group);
+}
+
 THDGroup THDNewGroup(const int *ranks, size_t len) {
   std::vector<rank_type> v_ranks(len);
   for (std::size_t i = 0; i < len; ++i) {
@@ -2,6 +2,7 @@
 
 #include "../THD.h"
 #include "../base/DataChannel.h"
+#include "Compression.h"
 
 THD_API int THDGetRank();
 THD_API int THDGetNumProcesses();
@@ -9,6 +10,12 @@ THD_API void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
                           THDGroup group);
 THD_API void THDReduce(THDTensorDescriptor& desc, THDReduceOp operation,
                        int dst_rank, THDGroup group);
+/*
+ * Sums `desc` over the group, sending it compressed by `compressor`. Only
+ * supports contiguous CPU float tensors.
+ */
+THD_API void THDAllReduceCompressed(THDTensorDescriptor& desc, THDCompressor* compressor,
+                                    THDGroup group);
 THD_API void THDBroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group);
 THD_API THDRequest* THDIsend(THDTensorDescriptor& desc, int dst_rank);
 THD_API THDRequest* THDIrecv(THDTensorDescriptor& desc, int src_rank);
@@ -23,7 +30,30 @@ THD_API void THDGatherRecv(THDTensorDescriptor* output, size_t len,
 THD_API void THDScatterSend(THDTensorDescriptor* input, size_t len,
                             THDTensorDescriptor& output, THDGroup group);
 THD_API void THDScatterRecv(THDTensorDescriptor& output, int src_rank, THDGroup group);
+THD_API void THDReduceScatter(THDTensorDescriptor* input, size_t len,
+                              THDTensorDescriptor& output, THDReduceOp operation,
+                              THDGroup group);
 THD_API void THDBarrier(THDGroup group);
+THD_API THDRequest* THDIallReduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                                  THDGroup group);
+THD_API THDRequest* THDIreduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                               int dst_rank, THDGroup group);
+THD_API THDRequest* THDIbroadcast(THDTensorDescriptor& desc, int src_rank,
+                                  THDGroup group);
+THD_API THDRequest* THDIallGather(THDTensorDescriptor* output, size_t len,
+                                  THDTensorDescriptor& input, THDGroup group);
+THD_API THDRequest* THDIgatherSend(THDTensorDescriptor& input, int dst_rank,
+                                   THDGroup group);
+THD_API THDRequest* THDIgatherRecv(THDTensorDescriptor* output, size_t len,
+                                   THDTensorDescriptor& input, THDGroup group);
+THD_API THDRequest* THDIscatterSend(THDTensorDescriptor* input, size_t len,
+                                    THDTensorDescriptor& output, THDGroup group);
+THD_API THDRequest* THDIscatterRecv(THDTensorDescriptor& output, int src_rank,
+                                    THDGroup group);
+THD_API THDRequest* THDIreduceScatter(THDTensorDescriptor* input, size_t len,
+                                      THDTensorDescriptor& output,
+                                      THDReduceOp operation, THDGroup group);
+THD_API THDRequest* THDIbarrier(THDGroup group);
 THD_API THDGroup THDNewGroup(const int* ranks, size_t len);
 THD_API bool THDRequest_isCompleted(THDRequest* request);
 THD_API void THDRequest_wait(THDRequest* request);
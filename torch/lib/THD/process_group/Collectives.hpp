@@ -1,4 +1,5 @@
 #pragma once
 
 #include "base/TensorDescriptor.hpp"
+#include "Compression.hpp"
 #include "Collectives.h"
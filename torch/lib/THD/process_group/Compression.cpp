@@ -0,0 +1,367 @@
+#include "Compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif // defined(__F16C__)
+
+namespace thd {
+namespace {
+
+/*
+ * Scalar conversions. floatToHalf and halfToFloat branch on infinities, NaNs
+ * and subnormals, so the half loops are only vectorized where F16C provides
+ * the conversion instructions. The bfloat16 ones are bit operations and a
+ * select, which compilers vectorize.
+ */
+
+inline std::uint32_t floatBits(float value) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float bitsFloat(std::uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Rounds to nearest even, including for subnormal results
+inline std::uint16_t floatToHalf(float value) {
+  const std::uint32_t f32_infinity = 255u << 23;
+  const std::uint32_t f16_overflow = (127u + 16) << 23;
+  const std::uint32_t denorm_magic_bits = ((127u - 15) + (23 - 10) + 1) << 23;
+
+  std::uint32_t bits = floatBits(value);
+  std::uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+
+  std::uint16_t half;
+  if (bits >= f16_overflow) { // infinity or NaN
+    half = (bits > f32_infinity) ? 0x7e00 : 0x7c00;
+  } else if (bits < (113u << 23)) { // subnormal or zero
+    float shifted = bitsFloat(bits) + bitsFloat(denorm_magic_bits);
+    half = static_cast<std::uint16_t>(floatBits(shifted) - denorm_magic_bits);
+  } else {
+    std::uint32_t mantissa_odd = (bits >> 13) & 1;
+    bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfff + mantissa_odd;
+    half = static_cast<std::uint16_t>(bits >> 13);
+  }
+  return half | static_cast<std::uint16_t>(sign >> 16);
+}
+
+inline float halfToFloat(std::uint16_t half) {
+  const std::uint32_t shifted_exponent = 0x7c00u << 13;
+  const float denorm_magic = bitsFloat(113u << 23);
+
+  std::uint32_t bits = (half & 0x7fffu) << 13;
+  std::uint32_t exponent = bits & shifted_exponent;
+  bits += (127u - 15) << 23;
+  if (exponent == shifted_exponent) { // infinity or NaN
+    bits += (128u - 16) << 23;
+  } else if (exponent == 0) { // subnormal or zero
+    bits = floatBits(bitsFloat(bits + (1u << 23)) - denorm_magic);
+  }
+  return bitsFloat(bits | (static_cast<std::uint32_t>(half & 0x8000u) << 16));
+}
+
+// Rounds to nearest even and keeps NaNs quiet
+inline std::uint16_t floatToBFloat16(float value) {
+  std::uint32_t bits = floatBits(value);
+  std::uint32_t rounded = (bits + 0x7fffu + ((bits >> 16) & 1)) >> 16;
+  std::uint32_t nan = (bits >> 16) | 0x40u;
+  return static_cast<std::uint16_t>(std::isnan(value) ? nan : rounded);
+}
+
+inline float bFloat16ToFloat(std::uint16_t value) {
+  return bitsFloat(static_cast<std::uint32_t>(value) << 16);
+}
+
+// Adds `data` to `residual`, resetting it first if it has a different size
+void accumulateResidual(std::vector<float>& residual, const float* data,
+                        std::size_t numel) {
+  if (residual.size() != numel)
+    residual.assign(numel, 0);
+
+  float* accumulated = residual.data();
+  for (std::size_t i = 0; i < numel; ++i)
+    accumulated[i] += data[i];
+}
+
+} // anonymous namespace
+
+
+Compressor::Compressor()
+  : _uncompressed_bytes(0)
+  , _compressed_bytes(0)
+{}
+
+
+Compressor::~Compressor() {}
+
+
+void Compressor::recordStats(std::size_t numel) {
+  _uncompressed_bytes += numel * sizeof(float);
+  _compressed_bytes += payloadSize(numel);
+}
+
+
+std::uint64_t Compressor::uncompressedBytes() const {
+  return _uncompressed_bytes;
+}
+
+
+std::uint64_t Compressor::compressedBytes() const {
+  return _compressed_bytes;
+}
+
+
+std::size_t ElementwiseCompressor::payloadSize(std::size_t numel) const {
+  return numel * elementSize();
+}
+
+
+void ElementwiseCompressor::compress(const float* data, std::size_t numel,
+                                     std::uint8_t* payload) {
+  encode(data, numel, payload);
+  recordStats(numel);
+}
+
+
+void ElementwiseCompressor::decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                                          float* result) const {
+  decodeAdd(payload, numel, result);
+}
+
+
+std::size_t HalfCompressor::elementSize() const {
+  return sizeof(std::uint16_t);
+}
+
+
+void HalfCompressor::encode(const float* data, std::size_t numel,
+                            std::uint8_t* payload) const {
+  auto half = reinterpret_cast<std::uint16_t*>(payload);
+  std::size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= numel; i += 8) {
+    __m128i converted = _mm256_cvtps_ph(_mm256_loadu_ps(data + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(half + i), converted);
+  }
+#endif // defined(__F16C__)
+  for (; i < numel; ++i)
+    half[i] = floatToHalf(data[i]);
+}
+
+
+void HalfCompressor::decodeAdd(const std::uint8_t* payload, std::size_t numel,
+                               float* result) const {
+  auto half = reinterpret_cast<const std::uint16_t*>(payload);
+  std::size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= numel; i += 8) {
+    __m256 converted = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half + i)));
+    _mm256_storeu_ps(result + i, _mm256_add_ps(_mm256_loadu_ps(result + i), converted));
+  }
+#endif // defined(__F16C__)
+  for (; i < numel; ++i)
+    result[i] += halfToFloat(half[i]);
+}
+
+
+std::size_t BFloat16Compressor::elementSize() const {
+  return sizeof(std::uint16_t);
+}
+
+
+void BFloat16Compressor::encode(const float* data, std::size_t numel,
+                                std::uint8_t* payload) const {
+  auto bfloat16 = reinterpret_cast<std::uint16_t*>(payload);
+  for (std::size_t i = 0; i < numel; ++i)
+    bfloat16[i] = floatToBFloat16(data[i]);
+}
+
+
+void BFloat16Compressor::decodeAdd(const std::uint8_t* payload, std::size_t numel,
+                                   float* result) const {
+  auto bfloat16 = reinterpret_cast<const std::uint16_t*>(payload);
+  for (std::size_t i = 0; i < numel; ++i)
+    result[i] += bFloat16ToFloat(bfloat16[i]);
+}
+
+
+TopKCompressor::TopKCompressor(double ratio)
+  : _ratio(ratio)
+{
+  if (!(ratio > 0 && ratio <= 1))
+    throw std::domain_error("top-k compression ratio should be in range (0, 1]");
+}
+
+
+std::size_t TopKCompressor::_numSelected(std::size_t numel) const {
+  if (numel == 0)
+    return 0;
+
+  auto selected = static_cast<std::size_t>(std::ceil(_ratio * numel));
+  return std::min(std::max<std::size_t>(selected, 1), numel);
+}
+
+
+std::size_t TopKCompressor::payloadSize(std::size_t numel) const {
+  // indices followed by values
+  return _numSelected(numel) * (sizeof(std::uint32_t) + sizeof(float));
+}
+
+
+void TopKCompressor::compress(const float* data, std::size_t numel,
+                              std::uint8_t* payload) {
+  /*
+   * Selects the k elements of data + residual with the largest magnitude.
+   * The k-th largest magnitude is found with a linear time selection, then
+   * the elements above it (and as many equal to it as needed) are taken in
+   * the order of their indices. Selected elements are cleared from the
+   * residual, the others are carried over to the next call.
+   */
+
+  if (numel > std::numeric_limits<std::uint32_t>::max())
+    throw std::length_error("top-k compression supports tensors with up to 2^32 - 1 elements");
+
+  accumulateResidual(_residual, data, numel);
+  std::size_t k = _numSelected(numel);
+  auto indices = reinterpret_cast<std::uint32_t*>(payload);
+  auto values = reinterpret_cast<float*>(payload + k * sizeof(std::uint32_t));
+  if (k == 0)
+    return;
+
+  // NaNs are always selected, and do not break the ordering
+  float* accumulated = _residual.data();
+  _magnitudes.resize(numel);
+  for (std::size_t i = 0; i < numel; ++i) {
+    float magnitude = std::fabs(accumulated[i]);
+    _magnitudes[i] = std::isnan(magnitude) ? std::numeric_limits<float>::infinity() : magnitude;
+  }
+
+  _selection = _magnitudes;
+  std::nth_element(_selection.begin(), _selection.begin() + (k - 1), _selection.end(),
+                   std::greater<float>());
+  float threshold = _selection[k - 1];
+
+  std::size_t above = 0;
+  for (std::size_t i = 0; i < numel; ++i)
+    above += _magnitudes[i] > threshold;
+
+  std::size_t selected = 0, ties = k - above;
+  for (std::size_t i = 0; i < numel && selected < k; ++i) {
+    bool take = _magnitudes[i] > threshold;
+    if (!take && _magnitudes[i] == threshold && ties > 0) {
+      take = true;
+      --ties;
+    }
+
+    if (take) {
+      indices[selected] = static_cast<std::uint32_t>(i);
+      values[selected] = accumulated[i];
+      accumulated[i] = 0;
+      ++selected;
+    }
+  }
+
+  recordStats(numel);
+}
+
+
+void TopKCompressor::decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                                   float* result) const {
+  std::size_t k = _numSelected(numel);
+  auto indices = reinterpret_cast<const std::uint32_t*>(payload);
+  auto values = reinterpret_cast<const float*>(payload + k * sizeof(std::uint32_t));
+  for (std::size_t i = 0; i < k; ++i) {
+    if (indices[i] >= numel)
+      throw std::out_of_range("top-k payload contains an index out of range");
+    result[indices[i]] += values[i];
+  }
+}
+
+
+std::size_t SignCompressor::payloadSize(std::size_t numel) const {
+  // scale followed by a bit per element
+  return sizeof(float) + (numel + 7) / 8;
+}
+
+
+void SignCompressor::compress(const float* data, std::size_t numel,
+                              std::uint8_t* payload) {
+  /*
+   * Every element is encoded as +scale or -scale, where scale is the mean
+   * magnitude of data + residual, which keeps the norm of the decoded data
+   * close to the original one. The difference goes to the residual.
+   */
+
+  accumulateResidual(_residual, data, numel);
+  float* accumulated = _residual.data();
+
+  double magnitude_sum = 0;
+  for (std::size_t i = 0; i < numel; ++i)
+    magnitude_sum += std::fabs(accumulated[i]);
+  float scale = numel > 0 ? static_cast<float>(magnitude_sum / numel) : 0;
+
+  std::memcpy(payload, &scale, sizeof(scale));
+  std::uint8_t* signs = payload + sizeof(scale);
+  std::memset(signs, 0, (numel + 7) / 8);
+  for (std::size_t i = 0; i < numel; ++i) {
+    bool positive = accumulated[i] >= 0;
+    signs[i / 8] |= static_cast<std::uint8_t>(positive) << (i % 8);
+    accumulated[i] -= positive ? scale : -scale;
+  }
+
+  recordStats(numel);
+}
+
+
+void SignCompressor::decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                                   float* result) const {
+  float scale;
+  std::memcpy(&scale, payload, sizeof(scale));
+  const std::uint8_t* signs = payload + sizeof(scale);
+  for (std::size_t i = 0; i < numel; ++i) {
+    bool positive = (signs[i / 8] >> (i % 8)) & 1;
+    result[i] += positive ? scale : -scale;
+  }
+}
+
+} // namespace thd
+
+
+using namespace thd;
+
+THDCompressor* THDCompressor_new(THDCompression compression, double ratio) {
+  switch (compression) {
+    case THDCompressionFP16:
+      return new HalfCompressor();
+    case THDCompressionBF16:
+      return new BFloat16Compressor();
+    case THDCompressionTOPK:
+      return new TopKCompressor(ratio);
+    case THDCompressionSIGN:
+      return new SignCompressor();
+    default:
+      throw std::invalid_argument("unsupported compression method");
+  }
+}
+
+void THDCompressor_free(THDCompressor* compressor) {
+  delete compressor;
+}
+
+void THDCompressor_stats(THDCompressor* compressor, uint64_t* uncompressed_bytes,
+                         uint64_t* compressed_bytes) {
+  *uncompressed_bytes = compressor->uncompressedBytes();
+  *compressed_bytes = compressor->compressedBytes();
+}
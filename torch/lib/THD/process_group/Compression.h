@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../THD.h"
+
+#include <stdint.h>
+
+enum THDCompression {
+  THDCompressionFP16 = 0,
+  THDCompressionBF16,
+  THDCompressionTOPK,
+  THDCompressionSIGN,
+};
+
+#ifndef _THD_CORE
+struct _THDCompressor;
+typedef struct _THDCompressor THDCompressor;
+#endif
+
+/*
+ * `ratio` is the fraction of elements kept by top-k compression and is
+ * ignored by the other methods.
+ */
+THD_API THDCompressor* THDCompressor_new(THDCompression compression, double ratio);
+THD_API void THDCompressor_free(THDCompressor* compressor);
+/* Total number of bytes passed to and produced by the compressor so far */
+THD_API void THDCompressor_stats(THDCompressor* compressor, uint64_t* uncompressed_bytes,
+                                 uint64_t* compressed_bytes);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace thd {
+
+/*
+ * Lossy encoding of float tensors used by compressed collectives. Every
+ * process compresses its own data, so the encoding has a fixed size which only
+ * depends on the number of elements, and the payloads of all processes can be
+ * exchanged with any data channel.
+ *
+ * Compressors which drop information keep it in a residual which is added to
+ * the data compressed next time (error feedback), so a compressor should be
+ * used for a single tensor, e.g. the gradient of one parameter.
+ */
+struct Compressor {
+  Compressor();
+  virtual ~Compressor();
+
+  // Size in bytes of the payload of `numel` elements
+  virtual std::size_t payloadSize(std::size_t numel) const = 0;
+  // Encodes `numel` elements of `data` into `payload`
+  virtual void compress(const float* data, std::size_t numel, std::uint8_t* payload) = 0;
+  // Adds the decoded `numel` elements of `payload` to `result`
+  virtual void decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                             float* result) const = 0;
+
+  void recordStats(std::size_t numel);
+  std::uint64_t uncompressedBytes() const;
+  std::uint64_t compressedBytes() const;
+
+private:
+  std::uint64_t _uncompressed_bytes;
+  std::uint64_t _compressed_bytes;
+};
+
+/*
+ * Compressor without residual encoding every element on its own, in
+ * `elementSize()` bytes. The payload of a range of elements is the same range
+ * of the payload, so payloads can be split into chunks, and chunks summed and
+ * encoded again, which lets allReduce reduce-scatter them instead of
+ * gathering whole payloads.
+ */
+struct ElementwiseCompressor : Compressor {
+  std::size_t payloadSize(std::size_t numel) const override;
+  void compress(const float* data, std::size_t numel, std::uint8_t* payload) override;
+  void decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                     float* result) const override;
+
+  virtual std::size_t elementSize() const = 0;
+  // Same as compress and decompressAdd, but not counted in the stats
+  virtual void encode(const float* data, std::size_t numel,
+                      std::uint8_t* payload) const = 0;
+  virtual void decodeAdd(const std::uint8_t* payload, std::size_t numel,
+                         float* result) const = 0;
+};
+
+// Rounds to the nearest IEEE half precision value
+struct HalfCompressor : ElementwiseCompressor {
+  std::size_t elementSize() const override;
+  void encode(const float* data, std::size_t numel, std::uint8_t* payload) const override;
+  void decodeAdd(const std::uint8_t* payload, std::size_t numel,
+                 float* result) const override;
+};
+
+// Rounds to the nearest bfloat16 value (float with 8 bits of mantissa)
+struct BFloat16Compressor : ElementwiseCompressor {
+  std::size_t elementSize() const override;
+  void encode(const float* data, std::size_t numel, std::uint8_t* payload) const override;
+  void decodeAdd(const std::uint8_t* payload, std::size_t numel,
+                 float* result) const override;
+};
+
+// Keeps the `ratio` fraction of elements with the largest magnitude
+struct TopKCompressor : Compressor {
+  TopKCompressor(double ratio);
+
+  std::size_t payloadSize(std::size_t numel) const override;
+  void compress(const float* data, std::size_t numel, std::uint8_t* payload) override;
+  void decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                     float* result) const override;
+
+private:
+  std::size_t _numSelected(std::size_t numel) const;
+
+  double _ratio;
+  std::vector<float> _residual;
+  std::vector<float> _magnitudes;
+  std::vector<float> _selection;
+};
+
+// Keeps the sign of every element, all scaled by the mean magnitude
+struct SignCompressor : Compressor {
+  std::size_t payloadSize(std::size_t numel) const override;
+  void compress(const float* data, std::size_t numel, std::uint8_t* payload) override;
+  void decompressAdd(const std::uint8_t* payload, std::size_t numel,
+                     float* result) const override;
+
+private:
+  std::vector<float> _residual;
+};
+
+} // namespace thd
+
+using THDCompressor = thd::Compressor;
+
+#include "Compression.h"
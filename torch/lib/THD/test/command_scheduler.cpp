@@ -0,0 +1,136 @@
+#include "../master_worker/worker/CommandScheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace thd;
+using namespace thd::worker;
+
+constexpr std::int64_t COMMANDS_NUM = 10000;
+constexpr object_id_type OBJECTS_NUM = 64;
+constexpr std::int64_t FAILING_COMMAND = -1;
+
+std::mutex g_mutex;
+std::unordered_map<object_id_type, std::int64_t> g_last_command;
+std::unordered_map<object_id_type, int> g_users;
+
+std::unique_ptr<rpc::RPCMessage> buildCommand(std::int64_t number,
+                                              const std::vector<object_id_type>& objects) {
+  rpc::ByteArray bytes(reinterpret_cast<char*>(&number), sizeof(number));
+  std::unique_ptr<rpc::RPCMessage> command(new rpc::RPCMessage(std::move(bytes)));
+  command->objects() = objects;
+  return command;
+}
+
+void execute(std::unique_ptr<rpc::RPCMessage> command) {
+  std::int64_t number;
+  std::memcpy(&number, command->bytes().data(), sizeof(number));
+  if (number == FAILING_COMMAND)
+    throw std::runtime_error("failing command");
+
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto object : command->objects()) {
+      // commands using the same object can't overlap or be reordered
+      assert(g_users[object]++ == 0);
+      assert(g_last_command[object] < number);
+      g_last_command[object] = number;
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(20));
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto object : command->objects())
+      g_users[object]--;
+  }
+}
+
+void test_order() {
+  CommandScheduler scheduler(execute);
+  std::mt19937 generator(0);
+  for (std::int64_t number = 1; number <= COMMANDS_NUM; ++number) {
+    std::vector<object_id_type> objects;
+    for (int i = 0; i < 3; ++i) {
+      object_id_type object = generator() % OBJECTS_NUM;
+      if (std::find(objects.begin(), objects.end(), object) == objects.end())
+        objects.push_back(object);
+    }
+
+    auto kind = CommandKind::CONCURRENT;
+    if (number % 50 == 0) {
+      kind = CommandKind::EXCLUSIVE;
+    } else if (number % 101 == 0) {
+      kind = CommandKind::RELEASE;
+    }
+    scheduler.schedule(buildCommand(number, objects), kind);
+  }
+  scheduler.wait();
+}
+
+void test_error() {
+  CommandScheduler scheduler(execute);
+  bool thrown = false;
+  try {
+    scheduler.schedule(buildCommand(FAILING_COMMAND, {0}), CommandKind::CONCURRENT);
+    scheduler.wait();
+  } catch (const std::runtime_error& e) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+void test_error_handler(bool threads) {
+  std::mutex mutex;
+  std::condition_variable handled;
+  int errors = 0;
+  CommandScheduler scheduler(execute, [&](std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    errors++;
+    handled.notify_all();
+  });
+
+  bool thrown = false;
+  try {
+    scheduler.schedule(buildCommand(FAILING_COMMAND, {0}), CommandKind::CONCURRENT);
+  } catch (const std::runtime_error& e) {
+    thrown = true;
+  }
+  // a command running in the scheduling thread throws from `schedule`
+  assert(thrown == !threads);
+  if (!threads)
+    return;
+
+  // reported without any other call to the scheduler
+  std::unique_lock<std::mutex> lock(mutex);
+  assert(handled.wait_for(lock, std::chrono::seconds(10), [&] { return errors > 0; }));
+  lock.unlock();
+
+  scheduler.schedule(buildCommand(FAILING_COMMAND, {1}), CommandKind::CONCURRENT);
+  scheduler.wait();
+  assert(errors == 1);
+}
+
+int main() {
+  for (auto threads : {"1", "4"}) {
+    setenv("THD_WORKER_THREADS", threads, 1);
+    g_last_command.clear();
+    test_order();
+    test_error();
+    test_error_handler(std::string(threads) != "1");
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
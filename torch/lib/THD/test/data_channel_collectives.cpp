@@ -215,6 +215,54 @@ void test_barrier(std::shared_ptr<thd::DataChannel> data_channel) {
   }
 }
 
+void test_reduceScatter(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  std::vector<std::shared_ptr<thpp::IntTensor>> tensors;
+  std::vector<thpp::Tensor*> raw_tensors;
+  for (std::size_t i = 0; i < data_channel->getNumProcesses(); ++i) {
+    tensors.push_back(buildTensor<int>({1, 2, 3, 4, 5}, data_channel->getRank() + i));
+    raw_tensors.push_back(tensors.back().get());
+  }
+
+  // chunk `rank` is reduced over rank + j for all processes j
+  auto rank = data_channel->getRank();
+  auto int_tensor = buildTensor<int>({1, 2, 3, 4, 5}, -1);
+  data_channel->reduceScatter(raw_tensors, *int_tensor, THDReduceOp::THDReduceSUM);
+  ASSERT_TENSOR_VALUE(int, *int_tensor, (workers + 1) * rank + workers * (workers + 1) / 2)
+  data_channel->reduceScatter(raw_tensors, *int_tensor, THDReduceOp::THDReduceMAX);
+  ASSERT_TENSOR_VALUE(int, *int_tensor, rank + workers)
+  for (std::size_t i = 0; i < tensors.size(); ++i)
+    ASSERT_TENSOR_VALUE(int, *(tensors[i]), rank + i)
+}
+
+void test_async_collectives(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  using request_ptr = std::unique_ptr<thd::DataChannel::Request>;
+  auto rank = data_channel->getRank();
+  auto sum_tensor = buildTensor<int>({1, 2, 3, 4, 5}, rank);
+  auto bcast_tensor = buildTensor<int>({1, 2, 3, 4, 5}, rank == 0 ? 7 : -1);
+  std::vector<std::shared_ptr<thpp::IntTensor>> tensors;
+  std::vector<thpp::Tensor*> raw_tensors;
+  for (std::size_t i = 0; i < data_channel->getNumProcesses(); ++i) {
+    tensors.push_back(buildTensor<int>({1, 2, 3, 4, 5}, -1));
+    raw_tensors.push_back(tensors.back().get());
+  }
+
+  // all collectives are in flight at the same time and complete in order
+  std::vector<request_ptr> requests;
+  requests.emplace_back(data_channel->iallReduce(*sum_tensor, THDReduceOp::THDReduceSUM));
+  requests.emplace_back(data_channel->ibroadcast(*bcast_tensor, 0));
+  requests.emplace_back(data_channel->iallGather(raw_tensors, *bcast_tensor));
+  requests.emplace_back(data_channel->ibarrier());
+  for (auto& request : requests) {
+    request->wait();
+    assert(request->isCompleted());
+  }
+
+  ASSERT_TENSOR_VALUE(int, *sum_tensor, workers * (workers + 1) / 2)
+  ASSERT_TENSOR_VALUE(int, *bcast_tensor, 7)
+  for (std::size_t i = 0; i < tensors.size(); ++i)
+    ASSERT_TENSOR_VALUE(int, *(tensors[i]), 7)
+}
+
 void test_isend(std::shared_ptr<thd::DataChannel> data_channel) {
   if (g_data_channel_type == "gloo") {
     return; // XXX: Gloo does not support isend
@@ -622,6 +670,8 @@ void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers)
   test_gather(data_channel);
   test_allGather(data_channel);
   test_barrier(data_channel);
+  test_reduceScatter(data_channel, workers);
+  test_async_collectives(data_channel, workers);
   test_isend(data_channel);
   test_irecv(data_channel);
   test_interlaces(data_channel);
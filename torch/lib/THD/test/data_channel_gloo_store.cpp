@@ -0,0 +1,121 @@
+#include "../base/data_channels/Store.hpp"
+#include "../base/ChannelUtils.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cassert>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int CLIENTS_NUM = 16;
+constexpr int ADDS_PER_CLIENT = 100;
+
+std::vector<char> toVector(const std::string& str) {
+  return std::vector<char>(str.begin(), str.end());
+}
+
+void client(thd::port_type port, int id) {
+  thd::Store store("127.0.0.1", port);
+  std::string my_key = "key/" + std::to_string(id);
+
+  store.set(my_key, toVector(std::to_string(id)));
+
+  for (int i = 0; i < ADDS_PER_CLIENT; ++i)
+    store.add("counter", 1);
+
+  // only one of the clients wins
+  auto winner = store.compareSet("winner", {}, toVector(std::to_string(id)));
+  assert(!winner.empty());
+
+  // waits for keys of all clients
+  std::vector<std::string> keys;
+  for (int i = 0; i < CLIENTS_NUM; ++i)
+    keys.push_back("key/" + std::to_string(i));
+  store.wait(keys);
+  auto values = store.multiGet(keys);
+  assert(values.size() == CLIENTS_NUM);
+  for (int i = 0; i < CLIENTS_NUM; ++i)
+    assert(values[i] == toVector(std::to_string(i)));
+
+  store.set("done/" + std::to_string(id), {});
+  // `get` waits until the key is set
+  assert(store.get("finished") == toVector("yes"));
+}
+
+// A client which disconnects while its `get` is pending must not keep its
+// connection open until the key is set.
+void disconnecting_client(thd::port_type port) {
+  int socket = thd::connect("127.0.0.1", port);
+  std::uint8_t get_query = 1; // QueryType::GET
+  thd::send_bytes<std::uint8_t>(socket, &get_query, 1, true);
+  thd::send_string(socket, "never_set");
+  ::shutdown(socket, SHUT_WR);
+
+  // the deamon closes its end, which reads as the end of the stream
+  struct pollfd poll_fd = {socket, POLLIN, 0};
+  assert(::poll(&poll_fd, 1, 10000) == 1);
+  char byte;
+  assert(::recv(socket, &byte, 1, 0) == 0);
+  ::close(socket);
+}
+
+int main() {
+  int listen_socket;
+  thd::port_type port;
+  std::tie(listen_socket, port) = thd::listen();
+  thd::Store master_store("127.0.0.1", port, listen_socket);
+
+  std::vector<std::thread> clients;
+  for (int id = 0; id < CLIENTS_NUM; ++id)
+    clients.emplace_back(client, port, id);
+
+  std::vector<std::string> done_keys;
+  for (int id = 0; id < CLIENTS_NUM; ++id)
+    done_keys.push_back("done/" + std::to_string(id));
+  master_store.wait(done_keys);
+
+  assert(master_store.add("counter", 0) == CLIENTS_NUM * ADDS_PER_CLIENT);
+  auto winner = master_store.get("winner");
+  // a failed swap returns the current value
+  assert(master_store.compareSet("winner", toVector("none"), toVector("x")) == winner);
+  assert(master_store.compareSet("winner", winner, toVector("x")) == toVector("x"));
+
+  // adding to a value which is not an integer fails only this query
+  for (auto& value : {"x", "12x", "99999999999999999999"}) {
+    master_store.set("not_a_number", toVector(value));
+    bool thrown = false;
+    try {
+      master_store.add("not_a_number", 1);
+    } catch (const std::runtime_error& e) {
+      thrown = true;
+    }
+    assert(thrown);
+    assert(master_store.get("not_a_number") == toVector(value));
+  }
+  master_store.set("large", toVector(std::to_string(std::numeric_limits<std::int64_t>::max())));
+  bool thrown = false;
+  try {
+    master_store.add("large", 1);
+  } catch (const std::runtime_error& e) {
+    thrown = true;
+  }
+  assert(thrown);
+  assert(master_store.add("counter", 1) == CLIENTS_NUM * ADDS_PER_CLIENT + 1);
+
+  disconnecting_client(port);
+  // nobody is waiting for the key any more
+  master_store.set("never_set", toVector("x"));
+
+  master_store.set("finished", toVector("yes"));
+  for (auto& client_thread : clients)
+    client_thread.join();
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include "../base/data_channels/DataChannelTCP.hpp"
+#ifdef WITH_GLOO
+#include "../base/data_channels/DataChannelGloo.hpp"
+#endif // WITH_GLOO
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int MASTER_PORT = 45681;
+
+// hosts of processes, indexed by their ranks; leaders are not always first
+const std::vector<std::string> HOSTS = {"a", "b", "a", "b", "a", "c"};
+
+std::mutex g_mutex;
+
+template<typename DataChannelType>
+std::shared_ptr<thd::DataChannel> create_channel(int rank, int world_size,
+                                                 const std::string& host,
+                                                 const std::string& enabled) {
+  // waits for all processes, so it can't hold the lock
+  auto config = thd::getInitConfig("env://", world_size, "", rank);
+
+  std::lock_guard<std::mutex> lock(g_mutex);
+  setenv("THD_HOST_ID", host.data(), 1);
+  setenv("THD_SHM_ALLREDUCE", enabled.data(), 1);
+  setenv("THD_SHM_BUFFER_SIZE", "256", 1); // larger tensors are reduced in chunks
+  setenv("THD_SHM_TIMEOUT", "0.5", 1);
+  return std::make_shared<DataChannelType>(config); // reads the THD_SHM_* variables
+}
+
+template<typename DataChannelType>
+void test_all_reduce(int rank) {
+  auto channel = create_channel<DataChannelType>(rank, HOSTS.size(), HOSTS[rank], "1");
+  assert(channel->init());
+
+  for (int numel : {1, 63, 1000}) {
+    auto tensor = at::CPU(at::kFloat).tensor({numel}).fill_(rank + 1);
+    channel->allReduce(tensor, THDReduceOp::THDReduceSUM);
+    assert(tensor.equal(at::CPU(at::kFloat).tensor({numel}).fill_(21))); // 1 + ... + 6
+
+    auto longs = at::CPU(at::kLong).tensor({numel}).fill_(rank);
+    channel->allReduce(longs, THDReduceOp::THDReduceMAX);
+    assert(longs.equal(at::CPU(at::kLong).tensor({numel}).fill_(5)));
+  }
+}
+
+template<typename DataChannelType>
+void test_inconsistent_setting(int rank) {
+  // every process has to fail, not only the one with a different setting
+  auto channel = create_channel<DataChannelType>(rank, HOSTS.size(), HOSTS[rank],
+                                                 rank == 3 ? "0" : "1");
+  bool thrown = false;
+  try {
+    channel->init();
+  } catch (const std::logic_error& e) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+template<typename DataChannelType>
+void test_timeout(int rank) {
+  auto channel = create_channel<DataChannelType>(rank, 2, "a", "1");
+  assert(channel->init());
+  if (rank == 1)
+    return; // never takes part in the allReduce
+
+  auto tensor = at::CPU(at::kFloat).ones({10});
+  bool thrown = false;
+  try {
+    channel->allReduce(tensor, THDReduceOp::THDReduceSUM);
+  } catch (const std::runtime_error& e) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+void run(void (*test)(int), int world_size) {
+  std::vector<std::thread> processes;
+  for (int rank = 0; rank < world_size; ++rank)
+    processes.emplace_back(test, rank);
+  for (auto& process : processes)
+    process.join();
+}
+
+template<typename DataChannelType>
+void run_all_tests() {
+  run(test_all_reduce<DataChannelType>, HOSTS.size());
+  run(test_inconsistent_setting<DataChannelType>, HOSTS.size());
+  run(test_timeout<DataChannelType>, 2);
+}
+
+int main() {
+  setenv("MASTER_ADDR", "127.0.0.1", 1);
+  setenv("MASTER_PORT", std::to_string(MASTER_PORT).data(), 1);
+
+  run_all_tests<thd::DataChannelTCP>();
+  std::cout << "TCP - OK" << std::endl;
+#ifdef WITH_GLOO
+  run_all_tests<thd::DataChannelGloo>();
+  std::cout << "Gloo - OK" << std::endl;
+#endif // WITH_GLOO
+  return 0;
+}
@@ -5,8 +5,6 @@
 #include <typeinfo>
 #include <vector>
 
-#include <THPP/Type.hpp>
-
 #include "../master_worker/common/RPC.hpp"
 #include "TH/THStorage.h"
 
@@ -17,6 +15,47 @@ using namespace thd::rpc;
 constexpr ptrdiff_t STORAGE_SIZE = 10;
 constexpr size_t VEC_SIZE = 3;
 
+void test_objects() {
+  THDFloatTensor tensor1, tensor2;
+  tensor1.tensor_id = 1ul << 40;
+  tensor2.tensor_id = 3;
+  std::unique_ptr<RPCMessage> msg_ptr =
+    packMessage(2, &tensor1, &tensor2, &tensor1);
+
+  // every object is sent once, arguments refer to its position
+  assert(msg_ptr->objects().size() == 2);
+  assert(unpackFunctionId(*msg_ptr) == 2);
+  assert(unpackTensor(*msg_ptr) == tensor1.tensor_id);
+  assert(unpackTensor(*msg_ptr) == tensor2.tensor_id);
+  assert(unpackTensor(*msg_ptr) == tensor1.tensor_id);
+  assert(msg_ptr->isEmpty());
+
+  msg_ptr = packMessage(3, &tensor1);
+  msg_ptr->objects().clear();
+  unpackFunctionId(*msg_ptr);
+  try {
+    unpackTensor(*msg_ptr);
+    assert(false);
+  } catch (out_of_range &e) {}
+}
+
+void test_varints() {
+  std::vector<int64_t> values = {0, 1, -1, 127, 128, -129, INT_MAX, LLONG_MAX, LLONG_MIN};
+  for (auto value : values) {
+    std::unique_ptr<RPCMessage> msg_ptr =
+      packMessage(4, value, static_cast<uint64_t>(value));
+    auto &msg = *msg_ptr;
+    unpackFunctionId(msg);
+    assert(unpackInteger(msg) == value);
+    assert(static_cast<uint64_t>(unpackInteger(msg)) == static_cast<uint64_t>(value));
+    assert(msg.isEmpty());
+  }
+
+  // small values fit in a single byte
+  assert(packMessage(5, 3l)->bytes().length() ==
+         sizeof(function_id_type) + sizeof(RPCType) + 1);
+}
+
 int main() {
   THLongStorage *storage1 = THLongStorage_newWithSize(STORAGE_SIZE);
   int64_t *data = storage1->data;
@@ -30,23 +69,23 @@ int main() {
   uint16_t fid = unpackFunctionId(msg);
   assert(fid == 1);
 
-  assert(peekType(msg) == thpp::Type::FLOAT);
+  assert(peekType(msg) == RPCType::FLOAT);
   double arg1 = unpackFloat(msg);
   assert(arg1 == 1.0);
 
-  assert(peekType(msg) == thpp::Type::LONG);
+  assert(peekType(msg) == RPCType::LONG);
   int64_t arg2 = unpackInteger(msg);
   assert(arg2 == 100);
 
-  assert(peekType(msg) == thpp::Type::INT);
+  assert(peekType(msg) == RPCType::INT);
   int64_t arg3 = unpackInteger(msg);
   assert(arg3 == -12);
 
-  assert(peekType(msg) == thpp::Type::LONG_LONG);
+  assert(peekType(msg) == RPCType::LONG_LONG);
   int64_t arg4 = unpackInteger(msg);
   assert(arg4 == LLONG_MAX);
 
-  assert(peekType(msg) == thpp::Type::LONG_STORAGE);
+  assert(peekType(msg) == RPCType::LONG_STORAGE);
   THLongStorage *storage2 = unpackTHLongStorage(msg);
   assert(storage2->size == STORAGE_SIZE);
   for (int64_t i = 0; i < STORAGE_SIZE; i++)
@@ -54,14 +93,17 @@ int main() {
   
   int vec_size = unpackInteger(msg);
   assert(vec_size == VEC_SIZE);
-  for (int i = 0; i < VEC_SIZE; i++)
+  for (size_t i = 0; i < VEC_SIZE; i++)
     assert(unpackInteger(msg) == 7);
 
   assert(msg.isEmpty());
   try {
-    double arg6 = unpackFloat(msg);
+    unpackFloat(msg);
     assert(false);
   } catch (exception &e) {}
+
+  test_objects();
+  test_varints();
   std::cout << "OK" << std::endl;
   return 0;
 }
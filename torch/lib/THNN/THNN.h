@@ -27,6 +27,19 @@ typedef void THNNState;
   } \
   THLongStorage_free(size2);
 
+/* algorithms of the non-dilated CPU SpatialConvolutionMM forward pass */
+typedef enum {
+  THNN_CONV_ALGO_DEFAULT = -1,
+  THNN_CONV_ALGO_MM,
+  THNN_CONV_ALGO_WINOGRAD,
+  THNN_CONV_ALGO_DIRECT
+} THNNConvAlgorithm;
+
+/* forces the algorithm used by the calling thread's next convolutions;
+   THNN_CONV_ALGO_DEFAULT goes back to the built-in heuristics */
+TH_API void THNN_SpatialConvolution_setAlgorithm(THNNConvAlgorithm algorithm);
+TH_API THNNConvAlgorithm THNN_SpatialConvolution_getAlgorithm(void);
+
 #include "generic/THNN.h"
 #include <THGenerateFloatTypes.h>
 
@@ -14,7 +14,7 @@ void THNN_(BatchNormalization_updateOutput)(
   int64_t f;
   ptrdiff_t n = THTensor_(nElement)(input) / nInput;
 
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(THParallelNumThreads(nInput, TH_PARALLEL_GRAIN_SIZE / THMax(n, 1)))
   for (f = 0; f < nInput; ++f) {
     THTensor *in = THTensor_(newSelect)(input, 1, f);
     THTensor *out = THTensor_(newSelect)(output, 1, f);
@@ -81,7 +81,7 @@ void THNN_(BatchNormalization_backward)(
     THTensor_(resizeAs)(gradInput, input);
   }
 
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(THParallelNumThreads(nInput, TH_PARALLEL_GRAIN_SIZE / THMax(n, 1)))
   for (f = 0; f < nInput; ++f) {
     THTensor *in = THTensor_(newSelect)(input, 1, f);
     THTensor *gradOut = THTensor_(newSelect)(gradOutput, 1, f);
@@ -35,7 +35,7 @@ void THNN_(ClassNLLCriterion_updateOutput)(
     THTensor_(resize1d)(output, batch_size);
 
     int i;
-    #pragma omp parallel for private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(batch_size, TH_PARALLEL_GRAIN_SIZE)) private(i)
     for (i = 0; i < batch_size; i++) {
       int cur_target = THTensor_fastGet1d(target, i) - TH_INDEX_BASE;
       if (cur_target == ignore_index) {
@@ -144,7 +144,7 @@ void THNN_(ClassNLLCriterion_updateGradInput)(
     THNN_CHECK_DIM_SIZE(gradOutput, 1, 0, batch_size);
 
     int i;
-    #pragma omp parallel for private(i)
+    #pragma omp parallel for num_threads(THParallelNumThreads(batch_size, TH_PARALLEL_GRAIN_SIZE)) private(i)
     for (i = 0; i < batch_size; i++) {
       int cur_target = THTensor_fastGet1d(target, i) - TH_INDEX_BASE;
       if (cur_target == ignore_index) {
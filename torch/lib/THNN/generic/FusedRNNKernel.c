@@ -2,6 +2,35 @@
 #define TH_GENERIC_FILE "generic/FusedRNNKernel.c"
 #else
 
+/*
+ * The gate tensors are (batch x factor*hsz), with the gates of a sample next
+ * to each other, and the state tensors are (batch x hsz). factor is 3 for GRU
+ * and 4 for LSTM. Every kernel makes a single pass over each sample, and the
+ * samples are processed in parallel.
+ */
+
+static void THNN_(FusedRNN_checkSizes)(int factor, THTensor *input, THTensor *hidden,
+                                       THTensor *bias1, THTensor *bias2, THTensor *state)
+{
+  THArgCheck(THTensor_(nElement)(input) == THTensor_(nElement)(hidden), 3,
+             "Input and Hidden tensor sizes should be the same.");
+  THArgCheck(THTensor_(nElement)(input) == THTensor_(nElement)(state) * factor, 3,
+             "A pointwise tensor was not the right size, should have 1/%d the "
+             "elements of input/hidden tensor.", factor);
+  if (bias1) {
+    THArgCheck(bias2 != NULL, 5, "both biases must be given, or none");
+    THArgCheck(THTensor_(nElement)(bias1) == THTensor_(size)(state, state->nDimension - 1) * factor &&
+               THTensor_(nElement)(bias2) == THTensor_(nElement)(bias1), 4,
+               "bias should have %d times the hidden size elements", factor);
+  }
+}
+
+/* number of threads for a loop over batch samples of work elements each */
+static int THNN_(FusedRNN_numThreads)(int64_t batch, int64_t work)
+{
+  return THParallelNumThreads(batch, TH_PARALLEL_GRAIN_SIZE / THMax(work, 1));
+}
+
 void THNN_(GRUFused_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -12,7 +41,63 @@ void THNN_(GRUFused_updateOutput)(
           THTensor *hy,
           THTensor *storage)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(hy, hx);
+  THNN_(FusedRNN_checkSizes)(3, input, hidden, bias1, bias2, hx);
+  THArgCheck(THTensor_(nElement)(storage) == THTensor_(nElement)(hx) * 5, 8,
+             "Storage tensor for fused kernel was not sized correctly.");
+  THArgCheck(THTensor_(isContiguous)(storage), 8, "storage must be contiguous");
+
+  int64_t hsz = THTensor_(size)(hx, hx->nDimension - 1);
+  int64_t batch = THTensor_(nElement)(hx) / THMax(hsz, 1);
+  input = THTensor_(newContiguous)(input);
+  hidden = THTensor_(newContiguous)(hidden);
+  hx = THTensor_(newContiguous)(hx);
+  bias1 = bias1 ? THTensor_(newContiguous)(bias1) : NULL;
+  bias2 = bias2 ? THTensor_(newContiguous)(bias2) : NULL;
+
+  real *input_data = THTensor_(data)(input);
+  real *hidden_data = THTensor_(data)(hidden);
+  real *hx_data = THTensor_(data)(hx);
+  real *hy_data = THTensor_(data)(hy);
+  real *storage_data = THTensor_(data)(storage);
+  real *bias1_data = bias1 ? THTensor_(data)(bias1) : NULL;
+  real *bias2_data = bias2 ? THTensor_(data)(bias2) : NULL;
+
+  int64_t b;
+#pragma omp parallel for num_threads(THNN_(FusedRNN_numThreads)(batch, 5 * hsz)) private(b)
+  for (b = 0; b < batch; b++) {
+    const real *in = input_data + b * 3 * hsz;
+    const real *hn = hidden_data + b * 3 * hsz;
+    const real *h = hx_data + b * hsz;
+    real *out = hy_data + b * hsz;
+    /* saved for backward: resetgate, inputgate, newgate, hx, hidden newgate */
+    real *rg = storage_data + b * 5 * hsz;
+    real *ig = rg + hsz;
+    real *ng = rg + 2 * hsz;
+    real *hxs = rg + 3 * hsz;
+    real *hns = rg + 4 * hsz;
+    int64_t j;
+
+    for (j = 0; j < 2 * hsz; j++)
+      rg[j] = in[j] + hn[j] + (bias1_data ? bias1_data[j] + bias2_data[j] : 0);
+    THVector_(sigmoid)(rg, rg, 2 * hsz);
+    for (j = 0; j < hsz; j++) {
+      hxs[j] = h[j];
+      hns[j] = hn[2 * hsz + j] + (bias2_data ? bias2_data[2 * hsz + j] : 0);
+      ng[j] = in[2 * hsz + j] + (bias1_data ? bias1_data[2 * hsz + j] : 0) + rg[j] * hns[j];
+    }
+    THVector_(tanh)(ng, ng, hsz);
+    for (j = 0; j < hsz; j++)
+      out[j] = ng[j] + ig[j] * (h[j] - ng[j]);
+  }
+
+  THTensor_(free)(input);
+  THTensor_(free)(hidden);
+  THTensor_(free)(hx);
+  if (bias1) {
+    THTensor_(free)(bias1);
+    THTensor_(free)(bias2);
+  }
 }
 
 void THNN_(GRUFused_updateGradInput)(
@@ -23,7 +108,53 @@ void THNN_(GRUFused_updateGradInput)(
           THTensor *gradInputHx,
           THTensor *storage)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(gradInputHx, gradOutput);
+  THNN_(FusedRNN_checkSizes)(3, gradInInput, gradInHidden, NULL, NULL, gradOutput);
+  THArgCheck(THTensor_(nElement)(storage) == THTensor_(nElement)(gradOutput) * 5, 6,
+             "Storage tensor for fused kernel was not sized correctly.");
+  THArgCheck(THTensor_(isContiguous)(storage), 6, "storage must be contiguous");
+  THArgCheck(THTensor_(isContiguous)(gradInInput) && THTensor_(isContiguous)(gradInHidden), 2,
+             "gate gradients must be contiguous");
+
+  int64_t hsz = THTensor_(size)(gradOutput, gradOutput->nDimension - 1);
+  int64_t batch = THTensor_(nElement)(gradOutput) / THMax(hsz, 1);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+
+  real *gradInInput_data = THTensor_(data)(gradInInput);
+  real *gradInHidden_data = THTensor_(data)(gradInHidden);
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *gradInputHx_data = THTensor_(data)(gradInputHx);
+  real *storage_data = THTensor_(data)(storage);
+
+  int64_t b;
+#pragma omp parallel for num_threads(THNN_(FusedRNN_numThreads)(batch, 11 * hsz)) private(b)
+  for (b = 0; b < batch; b++) {
+    const real *rg = storage_data + b * 5 * hsz;
+    const real *ig = rg + hsz;
+    const real *ng = rg + 2 * hsz;
+    const real *hx = rg + 3 * hsz;
+    const real *hn = rg + 4 * hsz;
+    const real *go = gradOutput_data + b * hsz;
+    real *gi = gradInInput_data + b * 3 * hsz;
+    real *gh = gradInHidden_data + b * 3 * hsz;
+    real *ghx = gradInputHx_data + b * hsz;
+    int64_t j;
+
+    for (j = 0; j < hsz; j++) {
+      real gig = go[j] * (hx[j] - ng[j]) * (1 - ig[j]) * ig[j];
+      real gin = go[j] * (1 - ig[j]) * (1 - ng[j] * ng[j]);
+      real grg = gin * hn[j] * (1 - rg[j]) * rg[j];
+      ghx[j] = go[j] * ig[j];
+      gi[j] = grg;
+      gi[hsz + j] = gig;
+      gi[2 * hsz + j] = gin;
+      gh[j] = grg;
+      gh[hsz + j] = gig;
+      gh[2 * hsz + j] = gin * rg[j];
+    }
+  }
+
+  THTensor_(free)(gradOutput);
 }
 
 void THNN_(LSTMFused_updateOutput)(
@@ -36,7 +167,60 @@ void THNN_(LSTMFused_updateOutput)(
           THTensor *hy,
           THTensor *cy)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(hy, cx);
+  THTensor_(resizeAs)(cy, cx);
+  THNN_(FusedRNN_checkSizes)(4, input, hidden, bias1, bias2, cx);
+
+  int64_t hsz = THTensor_(size)(cx, cx->nDimension - 1);
+  int64_t batch = THTensor_(nElement)(cx) / THMax(hsz, 1);
+  /* the activated gates are written back to input for the backward pass */
+  THTensor *gates = THTensor_(newContiguous)(input);
+  hidden = THTensor_(newContiguous)(hidden);
+  cx = THTensor_(newContiguous)(cx);
+  bias1 = bias1 ? THTensor_(newContiguous)(bias1) : NULL;
+  bias2 = bias2 ? THTensor_(newContiguous)(bias2) : NULL;
+
+  real *gates_data = THTensor_(data)(gates);
+  real *hidden_data = THTensor_(data)(hidden);
+  real *cx_data = THTensor_(data)(cx);
+  real *hy_data = THTensor_(data)(hy);
+  real *cy_data = THTensor_(data)(cy);
+  real *bias1_data = bias1 ? THTensor_(data)(bias1) : NULL;
+  real *bias2_data = bias2 ? THTensor_(data)(bias2) : NULL;
+
+  int64_t b;
+#pragma omp parallel for num_threads(THNN_(FusedRNN_numThreads)(batch, 6 * hsz)) private(b)
+  for (b = 0; b < batch; b++) {
+    real *ig = gates_data + b * 4 * hsz;
+    real *fg = ig + hsz;
+    real *cg = ig + 2 * hsz;
+    real *og = ig + 3 * hsz;
+    const real *hg = hidden_data + b * 4 * hsz;
+    const real *c = cx_data + b * hsz;
+    real *h_out = hy_data + b * hsz;
+    real *c_out = cy_data + b * hsz;
+    int64_t j;
+
+    for (j = 0; j < 4 * hsz; j++)
+      ig[j] += hg[j] + (bias1_data ? bias1_data[j] + bias2_data[j] : 0);
+    /* the input and forget gates are adjacent */
+    THVector_(sigmoid)(ig, ig, 2 * hsz);
+    THVector_(tanh)(cg, cg, hsz);
+    THVector_(sigmoid)(og, og, hsz);
+    for (j = 0; j < hsz; j++)
+      c_out[j] = fg[j] * c[j] + ig[j] * cg[j];
+    THVector_(tanh)(h_out, c_out, hsz);
+    for (j = 0; j < hsz; j++)
+      h_out[j] *= og[j];
+  }
+
+  THTensor_(freeCopyTo)(gates, input);
+  THTensor_(free)(hidden);
+  THTensor_(free)(cx);
+  if (bias1) {
+    THTensor_(free)(bias1);
+    THTensor_(free)(bias2);
+  }
 }
 
 void THNN_(LSTMFused_updateGradInput)(
@@ -49,7 +233,65 @@ void THNN_(LSTMFused_updateGradInput)(
           THTensor *gradOutputCell,
           THTensor *gradInputCx)
 {
-  THAssertMsg(false, "Not implemented for CPU");
+  THTensor_(resizeAs)(gradInputCx, gradOutput);
+  THNN_(FusedRNN_checkSizes)(4, storage, gradInGates, NULL, NULL, prevC);
+  THArgCheck(THTensor_(nElement)(cy) == THTensor_(nElement)(prevC) &&
+             THTensor_(nElement)(gradOutput) == THTensor_(nElement)(prevC) &&
+             THTensor_(nElement)(gradOutputCell) == THTensor_(nElement)(prevC), 4,
+             "cell and gradient tensors should have the size of the hidden state");
+  THArgCheck(THTensor_(isContiguous)(gradInGates), 3, "gradInGates must be contiguous");
+
+  int64_t hsz = THTensor_(size)(prevC, prevC->nDimension - 1);
+  int64_t batch = THTensor_(nElement)(prevC) / THMax(hsz, 1);
+  storage = THTensor_(newContiguous)(storage);
+  prevC = THTensor_(newContiguous)(prevC);
+  cy = THTensor_(newContiguous)(cy);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  gradOutputCell = THTensor_(newContiguous)(gradOutputCell);
+
+  real *storage_data = THTensor_(data)(storage);
+  real *gradInGates_data = THTensor_(data)(gradInGates);
+  real *cx_data = THTensor_(data)(prevC);
+  real *cy_data = THTensor_(data)(cy);
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *gradOutputCell_data = THTensor_(data)(gradOutputCell);
+  real *gradInputCx_data = THTensor_(data)(gradInputCx);
+
+  int64_t b;
+#pragma omp parallel for num_threads(THNN_(FusedRNN_numThreads)(batch, 12 * hsz)) private(b)
+  for (b = 0; b < batch; b++) {
+    const real *ig = storage_data + b * 4 * hsz;
+    const real *fg = ig + hsz;
+    const real *cg = ig + 2 * hsz;
+    const real *og = ig + 3 * hsz;
+    const real *cx = cx_data + b * hsz;
+    const real *go = gradOutput_data + b * hsz;
+    const real *goc = gradOutputCell_data + b * hsz;
+    real *gig = gradInGates_data + b * 4 * hsz;
+    real *gfg = gig + hsz;
+    real *gcg = gig + 2 * hsz;
+    real *gog = gig + 3 * hsz;
+    real *gcx = gradInputCx_data + b * hsz;
+    int64_t j;
+
+    /* gcx holds tanh(cy) until it is overwritten below */
+    THVector_(tanh)(gcx, cy_data + b * hsz, hsz);
+    for (j = 0; j < hsz; j++) {
+      real tanh_cy = gcx[j];
+      real gc = go[j] * og[j] * (1 - tanh_cy * tanh_cy) + goc[j];
+      gig[j] = gc * cg[j] * (1 - ig[j]) * ig[j];
+      gfg[j] = gc * cx[j] * (1 - fg[j]) * fg[j];
+      gcg[j] = gc * ig[j] * (1 - cg[j] * cg[j]);
+      gog[j] = go[j] * tanh_cy * (1 - og[j]) * og[j];
+      gcx[j] = gc * fg[j];
+    }
+  }
+
+  THTensor_(free)(storage);
+  THTensor_(free)(prevC);
+  THTensor_(free)(cy);
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(gradOutputCell);
 }
 
 #endif
@@ -48,7 +48,7 @@ void THNN_(HardTanh_updateOutput)(
     ptrdiff_t n = THTensor_(nElement)(input);
 
     if (inplace)
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(n, TH_PARALLEL_GRAIN_SIZE)) private(i)
       for (i = 0; i < n; i++)
       {
         if (ptr_input[i] < min_val)
@@ -57,7 +57,7 @@ void THNN_(HardTanh_updateOutput)(
           ptr_input[i] = max_val;
       }
     else
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(n, TH_PARALLEL_GRAIN_SIZE)) private(i)
       for (i = 0; i < n; i++)
       {
         if (ptr_input[i] < min_val)
@@ -117,14 +117,14 @@ void THNN_(HardTanh_updateGradInput)(
     ptrdiff_t n = THTensor_(nElement)(input);
 
     if (inplace)
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(n, TH_PARALLEL_GRAIN_SIZE)) private(i)
       for (i = 0; i < n; i++)
       {
         if (ptr_input[i] <= min_val || ptr_input[i] >= max_val)
           ptr_gradInput[i] = 0;
       }
     else
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(n, TH_PARALLEL_GRAIN_SIZE)) private(i)
       for (i = 0; i < n; i++)
       {
         if (ptr_input[i] <= min_val || ptr_input[i] >= max_val)
@@ -22,6 +22,121 @@ static void THNN_(LookupTable_resetCount)(
   }
 }
 
+/*
+ * Stable LSD radix sort of the (row, position) pairs, 8 bits per pass. Each
+ * thread histograms and scatters its own slice of the pairs, so a pass is
+ * O(numel / threads) whatever the vocabulary size. The slices are cut for
+ * the team OpenMP actually starts, which may be smaller than requested.
+ */
+static void THNN_(LookupTable_radixSort)(
+          THIndex_t *rows,
+          THIndex_t *positions,
+          THIndex_t *rowsBuffer,
+          THIndex_t *positionsBuffer,
+          ptrdiff_t numel,
+          int64_t maxRow)
+{
+  int nThreads = THParallelNumThreads(numel, TH_PARALLEL_GRAIN_SIZE);
+  ptrdiff_t *counts = (ptrdiff_t*)THAlloc(sizeof(ptrdiff_t) * 256 * nThreads);
+  THIndex_t *srcRows = rows, *srcPositions = positions;
+  THIndex_t *dstRows = rowsBuffer, *dstPositions = positionsBuffer;
+  int shift;
+
+  for (shift = 0; shift == 0 || (shift < 64 && (maxRow >> shift) > 0); shift += 8)
+  {
+    THIndex_t *tmp;
+    int nTeam = 1;
+#pragma omp parallel num_threads(nThreads)
+    {
+#ifdef _OPENMP
+      int tid = omp_get_thread_num();
+#pragma omp single
+      nTeam = omp_get_num_threads();
+#else
+      int tid = 0;
+#endif
+      ptrdiff_t begin = numel * tid / nTeam;
+      ptrdiff_t end = numel * (tid + 1) / nTeam;
+      ptrdiff_t *count = counts + 256 * tid;
+      ptrdiff_t i;
+
+      memset(count, 0, sizeof(ptrdiff_t) * 256);
+      for (i = begin; i < end; i++)
+        count[(srcRows[i] >> shift) & 255]++;
+
+#pragma omp barrier
+#pragma omp single
+      {
+        ptrdiff_t offset = 0;
+        int digit, t;
+        for (digit = 0; digit < 256; digit++) {
+          for (t = 0; t < nTeam; t++) {
+            ptrdiff_t c = counts[256 * t + digit];
+            counts[256 * t + digit] = offset;
+            offset += c;
+          }
+        }
+      }
+
+      for (i = begin; i < end; i++) {
+        ptrdiff_t dst = count[(srcRows[i] >> shift) & 255]++;
+        dstRows[dst] = srcRows[i];
+        dstPositions[dst] = srcPositions[i];
+      }
+    }
+    tmp = srcRows; srcRows = dstRows; dstRows = tmp;
+    tmp = srcPositions; srcPositions = dstPositions; dstPositions = tmp;
+  }
+
+  if (srcRows != rows) {
+    memcpy(rows, srcRows, sizeof(THIndex_t) * numel);
+    memcpy(positions, srcPositions, sizeof(THIndex_t) * numel);
+  }
+  THFree(counts);
+}
+
+/*
+ * Sorts the rows looked up by input (made 0-based) along with the positions
+ * they were looked up at, and returns the number of runs of equal rows. Run
+ * r covers [segments[r], segments[r + 1]) in rows and positions.
+ */
+static ptrdiff_t THNN_(LookupTable_segments)(
+          THIndexTensor *input,
+          THIndexTensor *rows,
+          THIndexTensor *positions,
+          THIndexTensor *segments,
+          int64_t numw)
+{
+  ptrdiff_t i;
+  THIndex_t *input_data = THIndexTensor_(data)(input);
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+
+  THIndexTensor_(resize1d)(rows, numel);
+  THIndexTensor_(resize1d)(positions, numel);
+  THIndex_t *rows_data = THIndexTensor_(data)(rows);
+  THIndex_t *positions_data = THIndexTensor_(data)(positions);
+
+  for (i = 0; i < numel; i++) {
+    rows_data[i] = input_data[i] - TH_INDEX_BASE;
+    positions_data[i] = i;
+  }
+
+  THIndexTensor *buffer = THIndexTensor_(newWithSize1d)(2 * numel);
+  THIndex_t *buffer_data = THIndexTensor_(data)(buffer);
+  THNN_(LookupTable_radixSort)(rows_data, positions_data,
+                               buffer_data, buffer_data + numel, numel, numw - 1);
+  THIndexTensor_(free)(buffer);
+
+  THIndexTensor_(resize1d)(segments, numel + 1);
+  THIndex_t *segments_data = THIndexTensor_(data)(segments);
+  ptrdiff_t nRuns = 0;
+  for (i = 0; i < numel; i++)
+    if (i == 0 || rows_data[i] != rows_data[i-1])
+      segments_data[nRuns++] = i;
+  segments_data[nRuns] = numel;
+  return nRuns;
+}
+
 void THNN_(LookupTable_accGradParameters)(
           THNNState *state,
           THIndexTensor *input,
@@ -77,32 +192,34 @@ void THNN_(LookupTable_accGradParameters)(
 #ifdef _OPENMP
   if (numel > 1000)
   {
-    // The strategy is to parallelize over sections of the vocabulary, so that
-    // thread 1 handles updates to gradWeight[0..nVocab/nThreads]. Every thread
-    // has to traverse the entire input, but the dominating factor is the axpy
-    // BLAS call.
-    #pragma omp parallel private(i)
-    {
-      int tid = omp_get_thread_num();
-      int nthreads = omp_get_num_threads();
+    // The lookups are sorted by row, and each thread accumulates whole runs
+    // of equal rows: every row of gradWeight is written by a single thread,
+    // and only the rows that were looked up are touched.
+    THIndexTensor *rows = THIndexTensor_(new)();
+    THIndexTensor *positions = THIndexTensor_(new)();
+    THIndexTensor *segments = THIndexTensor_(new)();
+    ptrdiff_t nRuns = THNN_(LookupTable_segments)(input, rows, positions, segments, numw);
+    THIndex_t *rows_data = THIndexTensor_(data)(rows);
+    THIndex_t *positions_data = THIndexTensor_(data)(positions);
+    THIndex_t *segments_data = THIndexTensor_(data)(segments);
 
-      int64_t start = tid * (numw/nthreads + 1);
-      int64_t end = start + (numw/nthreads + 1);
-      for (i=0; i<numel; i++)
-      {
-        if (input_data[i] != paddingValue)
-        {
-            int64_t k = input_data[i] - TH_INDEX_BASE;
-            if (k >= start && k < end)
-            {
-                real scale_ = scale;
-                if (count_data) scale_ /= count_data[k];
-                THBlas_(axpy)(stride, scale_, go + i*stride, 1, gw + k*stride, 1);
-            }
-        }
-      }
+    // a few frequent rows can make runs very uneven, hence the dynamic schedule
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(THParallelNumThreads(nRuns, 16)) private(i)
+    for (i=0; i<nRuns; i++)
+    {
+      int64_t k = rows_data[segments_data[i]];
+      ptrdiff_t j;
+      if (k + TH_INDEX_BASE == paddingValue)
+        continue;
+      real scale_ = scale;
+      if (count_data) scale_ /= count_data[k];
+      for (j=segments_data[i]; j<segments_data[i+1]; j++)
+        THBlas_(axpy)(stride, scale_, go + positions_data[j]*stride, 1, gw + k*stride, 1);
     }
 
+    THIndexTensor_(free)(rows);
+    THIndexTensor_(free)(positions);
+    THIndexTensor_(free)(segments);
     THTensor_(free)(gradOutput);
     return;
   }
@@ -122,6 +239,85 @@ void THNN_(LookupTable_accGradParameters)(
   THTensor_(free)(gradOutput);
 }
 
+void THNN_(LookupTable_accGradParametersSparse)(
+          THNNState *state,
+          THIndexTensor *input,
+          THTensor *gradOutput,
+          THIndexTensor *gradIndices,
+          THTensor *gradValues,
+          int64_t numWeights,
+          bool scaleGradByFreq,
+          int paddingValue,
+          accreal ascale)
+{
+  real scale = TH_CONVERT_ACCREAL_TO_REAL(ascale);
+  ptrdiff_t i;
+
+  if (!THIndexTensor_(isContiguous)(input))
+    THError("input must be contiguous");
+  if (THIndexTensor_(nDimension)(input) != 1 && THIndexTensor_(nDimension)(input) != 2) {
+    THDescBuff s1 = THIndexTensor_(sizeDesc)(input);
+    THError("input must be a vector or matrix, but is of shape: %s", s1.str);
+  }
+
+  THIndex_t *input_data = THIndexTensor_(data)(input);
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+
+  for (i=0; i<numel; i++)
+    if (input_data[i] < TH_INDEX_BASE || input_data[i] >= numWeights + TH_INDEX_BASE) {
+      THError("inputs need to be in the range %ld <= input < %ld, "
+	      "but got input of value: %ld", TH_INDEX_BASE, (numWeights + TH_INDEX_BASE),
+	      input_data[i]);
+    }
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  int64_t stride = THTensor_(size)(gradOutput, gradOutput->nDimension - 1);
+  real *go = THTensor_(data)(gradOutput);
+
+  THIndexTensor *rows = THIndexTensor_(new)();
+  THIndexTensor *positions = THIndexTensor_(new)();
+  THIndexTensor *segments = THIndexTensor_(new)();
+  ptrdiff_t nRuns = THNN_(LookupTable_segments)(input, rows, positions, segments, numWeights);
+  THIndex_t *rows_data = THIndexTensor_(data)(rows);
+  THIndex_t *positions_data = THIndexTensor_(data)(positions);
+  THIndex_t *segments_data = THIndexTensor_(data)(segments);
+
+  // the padding row, if looked up, is one of the runs but gets no gradient
+  ptrdiff_t paddingRun = -1;
+  for (i=0; i<nRuns; i++)
+    if (rows_data[segments_data[i]] + TH_INDEX_BASE == paddingValue)
+      paddingRun = i;
+  ptrdiff_t nnz = paddingRun < 0 ? nRuns : nRuns - 1;
+
+  THIndexTensor_(resize1d)(gradIndices, nnz);
+  THTensor_(resize2d)(gradValues, nnz, stride);
+  THIndex_t *gi = THIndexTensor_(data)(gradIndices);
+  real *gv = THTensor_(data)(gradValues);
+
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(THParallelNumThreads(nRuns, 16)) private(i)
+  for (i=0; i<nRuns; i++)
+  {
+    ptrdiff_t j, out;
+    if (i == paddingRun)
+      continue;
+    out = paddingRun >= 0 && i > paddingRun ? i - 1 : i;
+    real *row = gv + out*stride;
+    real scale_ = scale;
+    if (scaleGradByFreq) scale_ /= segments_data[i+1] - segments_data[i];
+
+    gi[out] = rows_data[segments_data[i]] + TH_INDEX_BASE;
+    j = segments_data[i];
+    memset(row, 0, sizeof(real)*stride);
+    for (; j<segments_data[i+1]; j++)
+      THBlas_(axpy)(stride, scale_, go + positions_data[j]*stride, 1, row, 1);
+  }
+
+  THIndexTensor_(free)(rows);
+  THIndexTensor_(free)(positions);
+  THIndexTensor_(free)(segments);
+  THTensor_(free)(gradOutput);
+}
+
 /*
  * Keep the norm of weight smaller than maxNorm
  */
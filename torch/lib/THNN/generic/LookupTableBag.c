@@ -0,0 +1,364 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/LookupTableBag.c"
+#else
+
+/*
+ * Bags of embeddings: output[b] reduces the rows of weight looked up by
+ * input[offsets[b] .. offsets[b+1]) (the last bag ends with input). Bags
+ * are independent, so the forward runs in parallel over them, gathering
+ * and reducing rows in a single pass while prefetching the rows coming
+ * next. The backward reuses the sorted segments of LookupTable.c.
+ */
+
+#ifndef THNN_LOOKUP_TABLE_BAG
+#define THNN_LOOKUP_TABLE_BAG
+
+#define THNN_BAG_MODE_SUM  0
+#define THNN_BAG_MODE_MEAN 1
+#define THNN_BAG_MODE_MAX  2
+
+/* how many lookups ahead rows are prefetched */
+#define THNN_BAG_PREFETCH_DISTANCE 4
+
+#if defined(__GNUC__)
+#define THNN_BAG_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define THNN_BAG_PREFETCH(p)
+#endif
+
+#endif
+
+static void THNN_(LookupTableBag_checkInputs)(
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *perSampleWeights,
+          int64_t numWeights,
+          int mode)
+{
+  ptrdiff_t i;
+  THArgCheck(THIndexTensor_(nDimension)(input) == 1 && THIndexTensor_(isContiguous)(input), 2,
+             "input must be a contiguous vector");
+  THArgCheck(THIndexTensor_(nDimension)(offsets) == 1 && THIndexTensor_(isContiguous)(offsets), 3,
+             "offsets must be a contiguous vector");
+  THArgCheck(mode == THNN_BAG_MODE_SUM || mode == THNN_BAG_MODE_MEAN || mode == THNN_BAG_MODE_MAX,
+             8, "unknown mode %d", mode);
+
+  THIndex_t *input_data = THIndexTensor_(data)(input);
+  THIndex_t *offsets_data = THIndexTensor_(data)(offsets);
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+  ptrdiff_t numBags = THIndexTensor_(nElement)(offsets);
+
+  for (i = 0; i < numel; i++)
+    if (input_data[i] < TH_INDEX_BASE || input_data[i] >= numWeights + TH_INDEX_BASE) {
+      THError("inputs need to be in the range %ld <= input < %ld, "
+	      "but got input of value: %ld", TH_INDEX_BASE, (numWeights + TH_INDEX_BASE),
+	      input_data[i]);
+    }
+  /* every lookup must belong to a bag */
+  THArgCheck(numBags > 0 || numel == 0, 3, "offsets can't be empty when input isn't");
+  THArgCheck(numBags == 0 || offsets_data[0] == 0, 3,
+             "offsets must start at 0, but got %ld", numBags > 0 ? (long)offsets_data[0] : 0L);
+  for (i = 0; i < numBags; i++)
+    if (offsets_data[i] < 0 || offsets_data[i] > numel ||
+        (i > 0 && offsets_data[i] < offsets_data[i-1])) {
+      THError("offsets must be non-decreasing and within [0, %ld], "
+              "but got %ld at position %ld", (long)numel, offsets_data[i], (long)i);
+    }
+
+  if (perSampleWeights) {
+    THArgCheck(mode == THNN_BAG_MODE_SUM, 6, "per sample weights are only supported in sum mode");
+    THArgCheck(THTensor_(isContiguous)(perSampleWeights) &&
+               THTensor_(nElement)(perSampleWeights) == numel, 6,
+               "per sample weights must be a contiguous tensor with one value per input");
+  }
+}
+
+/* bag of each lookup */
+static THIndex_t* THNN_(LookupTableBag_offset2bag)(
+          THIndexTensor *offsets,
+          ptrdiff_t numel)
+{
+  THIndex_t *offsets_data = THIndexTensor_(data)(offsets);
+  ptrdiff_t numBags = THIndexTensor_(nElement)(offsets);
+  THIndex_t *offset2bag = (THIndex_t*)THAlloc(sizeof(THIndex_t) * THMax(numel, 1));
+  ptrdiff_t b, j;
+  for (b = 0; b < numBags; b++) {
+    ptrdiff_t end = b + 1 < numBags ? offsets_data[b+1] : numel;
+    for (j = offsets_data[b]; j < end; j++)
+      offset2bag[j] = b;
+  }
+  return offset2bag;
+}
+
+void THNN_(LookupTableBag_updateOutput)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *weight,
+          THTensor *output,
+          THTensor *perSampleWeights,
+          THIndexTensor *maxIndices,
+          int mode)
+{
+  THArgCheck(THTensor_(nDimension)(weight) == 2 && THTensor_(isContiguous)(weight), 4,
+             "weight must be a contiguous matrix");
+  THNN_(LookupTableBag_checkInputs)(input, offsets, perSampleWeights,
+                                    THTensor_(size)(weight, 0), mode);
+
+  THIndex_t *input_data = THIndexTensor_(data)(input);
+  THIndex_t *offsets_data = THIndexTensor_(data)(offsets);
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+  ptrdiff_t numBags = THIndexTensor_(nElement)(offsets);
+  int64_t dim = THTensor_(size)(weight, 1);
+  ptrdiff_t b;
+
+  THTensor_(resize2d)(output, numBags, dim);
+  if (mode == THNN_BAG_MODE_MAX)
+    THIndexTensor_(resize2d)(maxIndices, numBags, dim);
+
+  real *weight_data = THTensor_(data)(weight);
+  real *output_data = THTensor_(data)(output);
+  real *psw = perSampleWeights ? THTensor_(data)(perSampleWeights) : NULL;
+  THIndex_t *max_data = mode == THNN_BAG_MODE_MAX ? THIndexTensor_(data)(maxIndices) : NULL;
+  ptrdiff_t work = numBags > 0 ? THMax(numel / numBags, 1) * dim : 1;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(numBags, TH_PARALLEL_GRAIN_SIZE / work)) private(b)
+  for (b = 0; b < numBags; b++) {
+    ptrdiff_t begin = offsets_data[b];
+    ptrdiff_t end = b + 1 < numBags ? offsets_data[b+1] : numel;
+    real *out = output_data + b*dim;
+    ptrdiff_t j;
+    int64_t d;
+
+    memset(out, 0, sizeof(real) * dim);
+    if (mode == THNN_BAG_MODE_MAX) {
+      THIndex_t *argmax = max_data + b*dim;
+      for (d = 0; d < dim; d++)
+        argmax[d] = -1;
+    }
+
+    for (j = begin; j < end; j++) {
+      if (j + THNN_BAG_PREFETCH_DISTANCE < end) {
+        real *next = weight_data +
+          (input_data[j + THNN_BAG_PREFETCH_DISTANCE] - TH_INDEX_BASE) * dim;
+        for (d = 0; d < dim; d += 64 / sizeof(real))
+          THNN_BAG_PREFETCH(next + d);
+      }
+      real *row = weight_data + (input_data[j] - TH_INDEX_BASE) * dim;
+      if (mode == THNN_BAG_MODE_MAX) {
+        THIndex_t *argmax = max_data + b*dim;
+        for (d = 0; d < dim; d++) {
+          if (j == begin || row[d] > out[d]) {
+            out[d] = row[d];
+            argmax[d] = j;
+          }
+        }
+      } else {
+        THBlas_(axpy)(dim, psw ? psw[j] : 1, row, 1, out, 1);
+      }
+    }
+
+    if (mode == THNN_BAG_MODE_MEAN && end > begin) {
+      real inv = 1. / (end - begin);
+      for (d = 0; d < dim; d++)
+        out[d] *= inv;
+    }
+  }
+}
+
+/*
+ * Adds the gradient of the lookups [begin, end) of the sorted runs to row.
+ * For max bags, maxIndices holds the lookup each output element came from.
+ */
+static void THNN_(LookupTableBag_accRun)(
+          real *row,
+          ptrdiff_t begin,
+          ptrdiff_t end,
+          THIndex_t *positions,
+          THIndex_t *offset2bag,
+          THIndex_t *offsets,
+          ptrdiff_t numBags,
+          ptrdiff_t numel,
+          real *gradOutput,
+          real *perSampleWeights,
+          THIndex_t *maxIndices,
+          int64_t dim,
+          int mode,
+          real scale)
+{
+  ptrdiff_t j;
+  int64_t d;
+  for (j = begin; j < end; j++) {
+    THIndex_t pos = positions[j];
+    THIndex_t bag = offset2bag[pos];
+    real *go = gradOutput + bag*dim;
+    if (mode == THNN_BAG_MODE_MAX) {
+      THIndex_t *argmax = maxIndices + bag*dim;
+      for (d = 0; d < dim; d++)
+        if (argmax[d] == pos)
+          row[d] += scale * go[d];
+    } else {
+      real scale_ = scale;
+      if (perSampleWeights)
+        scale_ *= perSampleWeights[pos];
+      if (mode == THNN_BAG_MODE_MEAN) {
+        ptrdiff_t bagEnd = bag + 1 < numBags ? offsets[bag+1] : numel;
+        scale_ /= bagEnd - offsets[bag];
+      }
+      THBlas_(axpy)(dim, scale_, go, 1, row, 1);
+    }
+  }
+}
+
+void THNN_(LookupTableBag_accGradParameters)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *gradOutput,
+          THTensor *gradWeight,
+          THTensor *perSampleWeights,
+          THIndexTensor *maxIndices,
+          bool scaleGradByFreq,
+          int mode,
+          accreal ascale)
+{
+  real scale = TH_CONVERT_ACCREAL_TO_REAL(ascale);
+  THArgCheck(THTensor_(isContiguous)(gradWeight), 5, "gradWeight must be contiguous");
+  THNN_(LookupTableBag_checkInputs)(input, offsets, perSampleWeights,
+                                    THTensor_(size)(gradWeight, 0), mode);
+
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+  ptrdiff_t numBags = THIndexTensor_(nElement)(offsets);
+  int64_t dim = THTensor_(size)(gradWeight, 1);
+  ptrdiff_t i;
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  THIndexTensor *rows = THIndexTensor_(new)();
+  THIndexTensor *positions = THIndexTensor_(new)();
+  THIndexTensor *segments = THIndexTensor_(new)();
+  ptrdiff_t nRuns = THNN_(LookupTable_segments)(input, rows, positions, segments,
+                                                THTensor_(size)(gradWeight, 0));
+  THIndex_t *rows_data = THIndexTensor_(data)(rows);
+  THIndex_t *positions_data = THIndexTensor_(data)(positions);
+  THIndex_t *segments_data = THIndexTensor_(data)(segments);
+  THIndex_t *offset2bag = THNN_(LookupTableBag_offset2bag)(offsets, numel);
+
+  real *gw = THTensor_(data)(gradWeight);
+  real *go = THTensor_(data)(gradOutput);
+  real *psw = perSampleWeights ? THTensor_(data)(perSampleWeights) : NULL;
+  THIndex_t *max_data = mode == THNN_BAG_MODE_MAX ? THIndexTensor_(data)(maxIndices) : NULL;
+
+  // every run of equal rows is handled by one thread, see LookupTable.c
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(THParallelNumThreads(nRuns, 16)) private(i)
+  for (i = 0; i < nRuns; i++) {
+    real scale_ = scale;
+    if (scaleGradByFreq)
+      scale_ /= segments_data[i+1] - segments_data[i];
+    THNN_(LookupTableBag_accRun)(gw + rows_data[segments_data[i]]*dim,
+                                 segments_data[i], segments_data[i+1],
+                                 positions_data, offset2bag, THIndexTensor_(data)(offsets),
+                                 numBags, numel, go, psw, max_data, dim, mode, scale_);
+  }
+
+  THFree(offset2bag);
+  THIndexTensor_(free)(rows);
+  THIndexTensor_(free)(positions);
+  THIndexTensor_(free)(segments);
+  THTensor_(free)(gradOutput);
+}
+
+void THNN_(LookupTableBag_accGradParametersSparse)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *gradOutput,
+          THIndexTensor *gradIndices,
+          THTensor *gradValues,
+          THTensor *perSampleWeights,
+          THIndexTensor *maxIndices,
+          int64_t numWeights,
+          bool scaleGradByFreq,
+          int mode,
+          accreal ascale)
+{
+  real scale = TH_CONVERT_ACCREAL_TO_REAL(ascale);
+  THNN_(LookupTableBag_checkInputs)(input, offsets, perSampleWeights, numWeights, mode);
+
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+  ptrdiff_t numBags = THIndexTensor_(nElement)(offsets);
+  int64_t dim = THTensor_(size)(gradOutput, 1);
+  ptrdiff_t i;
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  THIndexTensor *rows = THIndexTensor_(new)();
+  THIndexTensor *positions = THIndexTensor_(new)();
+  THIndexTensor *segments = THIndexTensor_(new)();
+  ptrdiff_t nRuns = THNN_(LookupTable_segments)(input, rows, positions, segments, numWeights);
+  THIndex_t *rows_data = THIndexTensor_(data)(rows);
+  THIndex_t *positions_data = THIndexTensor_(data)(positions);
+  THIndex_t *segments_data = THIndexTensor_(data)(segments);
+  THIndex_t *offset2bag = THNN_(LookupTableBag_offset2bag)(offsets, numel);
+
+  THIndexTensor_(resize1d)(gradIndices, nRuns);
+  THTensor_(resize2d)(gradValues, nRuns, dim);
+  THIndex_t *gi = THIndexTensor_(data)(gradIndices);
+  real *gv = THTensor_(data)(gradValues);
+  real *go = THTensor_(data)(gradOutput);
+  real *psw = perSampleWeights ? THTensor_(data)(perSampleWeights) : NULL;
+  THIndex_t *max_data = mode == THNN_BAG_MODE_MAX ? THIndexTensor_(data)(maxIndices) : NULL;
+
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(THParallelNumThreads(nRuns, 16)) private(i)
+  for (i = 0; i < nRuns; i++) {
+    real scale_ = scale;
+    if (scaleGradByFreq)
+      scale_ /= segments_data[i+1] - segments_data[i];
+    gi[i] = rows_data[segments_data[i]] + TH_INDEX_BASE;
+    memset(gv + i*dim, 0, sizeof(real) * dim);
+    THNN_(LookupTableBag_accRun)(gv + i*dim,
+                                 segments_data[i], segments_data[i+1],
+                                 positions_data, offset2bag, THIndexTensor_(data)(offsets),
+                                 numBags, numel, go, psw, max_data, dim, mode, scale_);
+  }
+
+  THFree(offset2bag);
+  THIndexTensor_(free)(rows);
+  THIndexTensor_(free)(positions);
+  THIndexTensor_(free)(segments);
+  THTensor_(free)(gradOutput);
+}
+
+void THNN_(LookupTableBag_updateGradPerSampleWeights)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *weight,
+          THTensor *gradOutput,
+          THTensor *gradPerSampleWeights)
+{
+  THArgCheck(THTensor_(nDimension)(weight) == 2 && THTensor_(isContiguous)(weight), 4,
+             "weight must be a contiguous matrix");
+  THNN_(LookupTableBag_checkInputs)(input, offsets, NULL,
+                                    THTensor_(size)(weight, 0), THNN_BAG_MODE_SUM);
+
+  THIndex_t *input_data = THIndexTensor_(data)(input);
+  ptrdiff_t numel = THIndexTensor_(nElement)(input);
+  int64_t dim = THTensor_(size)(weight, 1);
+  ptrdiff_t j;
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  THTensor_(resize1d)(gradPerSampleWeights, numel);
+  THIndex_t *offset2bag = THNN_(LookupTableBag_offset2bag)(offsets, numel);
+  real *weight_data = THTensor_(data)(weight);
+  real *go = THTensor_(data)(gradOutput);
+  real *gpsw = THTensor_(data)(gradPerSampleWeights);
+
+#pragma omp parallel for num_threads(THParallelNumThreads(numel, TH_PARALLEL_GRAIN_SIZE / THMax(dim, 1))) private(j)
+  for (j = 0; j < numel; j++)
+    gpsw[j] = THBlas_(dot)(dim, weight_data + (input_data[j] - TH_INDEX_BASE) * dim, 1,
+                           go + offset2bag[j] * dim, 1);
+
+  THFree(offset2bag);
+  THTensor_(free)(gradOutput);
+}
+
+#endif
@@ -0,0 +1,599 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/RNNSequence.c"
+#else
+
+/*
+ * Whole-sequence LSTM and GRU layers (one layer, one direction per call).
+ *
+ * The input holds the time steps one after the other, each step being a
+ * block of batchSizes[t] rows. This is the layout of a PackedSequence; a
+ * padded (seq_len x batch x inputSize) input is the special case where all
+ * batch sizes are equal. As in a PackedSequence, batch sizes must not
+ * increase with t, so the sequences alive at step t are rows [0, batchSizes[t]).
+ *
+ * The input projection of all time steps is a single GEMM done up front;
+ * inside the time loop, only the recurrent projection and the pointwise
+ * part remain. The workspace keeps, for every row, what the backward pass
+ * needs (activated gates and previous states):
+ *   LSTM: [ingate, forgetgate, cellgate, outgate, prev cell, cell, prev hidden]
+ *   GRU:  [resetgate, inputgate, newgate, prev hidden, hidden newgate]
+ * each hiddenSize wide.
+ */
+
+/* returns the offsets of the time steps in the input, with batchSizes[t] in
+   steps[T + 1 + t]; the caller frees the result */
+static int64_t *THNN_(RNNSequence_steps)(THIndexTensor *batchSizes, int64_t nrows, int64_t batch)
+{
+  int64_t T = THIndexTensor_(nElement)(batchSizes);
+  THArgCheck(T > 0, 2, "empty sequence");
+
+  THIndexTensor *bs_ = THIndexTensor_(newContiguous)(batchSizes);
+  THIndex_t *bs = THIndexTensor_(data)(bs_);
+  int64_t *steps = (int64_t*)THAlloc(sizeof(int64_t) * (2 * T + 1));
+  int64_t t;
+
+  steps[0] = 0;
+  for (t = 0; t < T; t++) {
+    if (bs[t] <= 0 || (t == 0 ? bs[t] != batch : bs[t] > bs[t - 1])) {
+      THIndexTensor_(free)(bs_);
+      THFree(steps);
+      THError("batch sizes must be non-increasing, positive and start with the "
+              "hidden state batch size (%ld), but got %ld at step %ld",
+              (long)batch, (long)bs[t], (long)t);
+    }
+    steps[t + 1] = steps[t] + bs[t];
+    steps[T + 1 + t] = bs[t];
+  }
+  THIndexTensor_(free)(bs_);
+  if (steps[T] != nrows) {
+    THFree(steps);
+    THError("batch sizes add up to %ld rows, but the input has %ld",
+            (long)steps[T], (long)nrows);
+  }
+  return steps;
+}
+
+/* number of sequences of step t that are also alive at step u, if u exists */
+static int64_t THNN_(RNNSequence_shared)(const int64_t *bs, int64_t T, int64_t t, int64_t u)
+{
+  if (u < 0 || u >= T)
+    return 0;
+  return THMin(bs[t], bs[u]);
+}
+
+static void THNN_(RNNSequence_checkSizes)(int factor, THTensor *input, THTensor *weight_ih,
+                                          THTensor *weight_hh, THTensor *bias_ih, THTensor *bias_hh,
+                                          THTensor *hx)
+{
+  int64_t hsz = THTensor_(size)(weight_hh, 1);
+  THNN_ARGCHECK(input->nDimension == 2, 2, input,
+                "2D input (rows x inputSize) expected, but got: %s");
+  THNN_CHECK_DIM_SIZE(weight_ih, 2, 0, factor * hsz);
+  THNN_CHECK_DIM_SIZE(weight_ih, 2, 1, THTensor_(size)(input, 1));
+  THNN_CHECK_DIM_SIZE(weight_hh, 2, 0, factor * hsz);
+  THNN_CHECK_DIM_SIZE(hx, 2, 1, hsz);
+  THArgCheck((bias_ih == NULL) == (bias_hh == NULL), 6, "both biases must be given, or none");
+  if (bias_ih) {
+    THArgCheck(THTensor_(nElement)(bias_ih) == factor * hsz &&
+               THTensor_(nElement)(bias_hh) == factor * hsz, 6,
+               "bias should have %d times the hidden size elements", factor);
+  }
+}
+
+/* rows of gates = bias + input * weight^T */
+static void THNN_(RNNSequence_projectInput)(THTensor *gates, THTensor *input, THTensor *weight,
+                                            THTensor *bias1, THTensor *bias2)
+{
+  int64_t nrows = THTensor_(size)(gates, 0);
+  int64_t width = THTensor_(size)(gates, 1);
+  real *gates_data = THTensor_(data)(gates);
+  int64_t stride = gates->stride[0];
+  THTensor *weightT = THTensor_(newTranspose)(weight, 0, 1);
+
+  if (bias1) {
+    THTensor *b1 = THTensor_(newContiguous)(bias1);
+    THTensor *b2 = bias2 ? THTensor_(newContiguous)(bias2) : NULL;
+    real *b1_data = THTensor_(data)(b1);
+    real *b2_data = b2 ? THTensor_(data)(b2) : NULL;
+    int64_t i;
+#pragma omp parallel for num_threads(THParallelNumThreads(nrows, TH_PARALLEL_GRAIN_SIZE / THMax(width, 1))) private(i)
+    for (i = 0; i < nrows; i++) {
+      real *row = gates_data + i * stride;
+      int64_t j;
+      for (j = 0; j < width; j++)
+        row[j] = b1_data[j] + (b2_data ? b2_data[j] : 0);
+    }
+    THTensor_(free)(b1);
+    if (b2)
+      THTensor_(free)(b2);
+    THTensor_(addmm)(gates, 1, gates, 1, input, weightT);
+  } else {
+    THTensor_(addmm)(gates, 0, gates, 1, input, weightT);
+  }
+  THTensor_(free)(weightT);
+}
+
+/* copies the states the rows of step t start from into column col of the workspace */
+static void THNN_(RNNSequence_gatherState)(real *ws, int64_t wsz, int64_t col, int64_t hsz,
+                                           const int64_t *steps, int64_t T, int64_t t, int64_t p,
+                                           const real *states, int64_t stateCol, int64_t stateWidth,
+                                           const real *initial)
+{
+  const int64_t *bs = steps + T + 1;
+  int64_t shared = THNN_(RNNSequence_shared)(bs, T, t, p);
+  int64_t j;
+  for (j = 0; j < bs[t]; j++) {
+    const real *src = j < shared ? states + (steps[p] + j) * stateWidth + stateCol
+                                 : initial + j * hsz;
+    memcpy(ws + (steps[t] + j) * wsz + col, src, hsz * sizeof(real));
+  }
+}
+
+void THNN_(LSTMSequence_updateOutput)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *bias_ih,
+          THTensor *bias_hh,
+          THTensor *hx,
+          THTensor *cx,
+          THTensor *output,
+          THTensor *hy,
+          THTensor *cy,
+          THTensor *workspace,
+          bool reverse)
+{
+  THNN_(RNNSequence_checkSizes)(4, input, weight_ih, weight_hh, bias_ih, bias_hh, hx);
+  THNN_CHECK_SHAPE(hx, cx);
+
+  int64_t hsz = THTensor_(size)(weight_hh, 1);
+  int64_t wsz = 7 * hsz;
+  int64_t nrows = THTensor_(size)(input, 0);
+  int64_t batch = THTensor_(size)(hx, 0);
+  int64_t T = THIndexTensor_(nElement)(batchSizes);
+  int64_t *steps = THNN_(RNNSequence_steps)(batchSizes, nrows, batch);
+  const int64_t *bs = steps + T + 1;
+
+  THTensor_(resize2d)(output, nrows, hsz);
+  THTensor_(resize2d)(workspace, nrows, wsz);
+  THTensor_(resizeAs)(hy, hx);
+  THTensor_(resizeAs)(cy, cx);
+  THArgCheck(THTensor_(isContiguous)(output) && THTensor_(isContiguous)(workspace) &&
+             THTensor_(isContiguous)(hy) && THTensor_(isContiguous)(cy), 10,
+             "output tensors must be contiguous");
+
+  input = THTensor_(newContiguous)(input);
+  /* the recurrent weights are reused by every step: pack them once */
+  THTensor *weight_hhT = THTensor_(newTranspose)(weight_hh, 0, 1);
+  THTensor *packed = THTensor_(newContiguous)(weight_hhT);
+  THTensor_(free)(weight_hhT);
+  weight_hhT = packed;
+  hx = THTensor_(newContiguous)(hx);
+  cx = THTensor_(newContiguous)(cx);
+
+  THTensor *gates = THTensor_(newNarrow)(workspace, 1, 0, 4 * hsz);
+  THNN_(RNNSequence_projectInput)(gates, input, weight_ih, bias_ih, bias_hh);
+
+  real *ws = THTensor_(data)(workspace);
+  real *out = THTensor_(data)(output);
+  real *hy_data = THTensor_(data)(hy);
+  real *cy_data = THTensor_(data)(cy);
+  real *hx_data = THTensor_(data)(hx);
+  real *cx_data = THTensor_(data)(cx);
+  THTensor *gates_t = THTensor_(new)();
+  THTensor *hprev_t = THTensor_(new)();
+  int64_t s;
+
+  for (s = 0; s < T; s++) {
+    int64_t t = reverse ? T - 1 - s : s;
+    int64_t p = reverse ? t + 1 : t - 1;
+    int64_t n = reverse ? t - 1 : t + 1;
+    int64_t alive = THNN_(RNNSequence_shared)(bs, T, t, n);
+    int64_t b;
+
+    THNN_(RNNSequence_gatherState)(ws, wsz, 6 * hsz, hsz, steps, T, t, p, out, 0, hsz, hx_data);
+    THNN_(RNNSequence_gatherState)(ws, wsz, 4 * hsz, hsz, steps, T, t, p, ws, 5 * hsz, wsz, cx_data);
+
+    THTensor_(narrow)(gates_t, gates, 0, steps[t], bs[t]);
+    THTensor_(setStorage2d)(hprev_t, workspace->storage,
+                            workspace->storageOffset + steps[t] * wsz + 6 * hsz,
+                            bs[t], wsz, hsz, 1);
+    THTensor_(addmm)(gates_t, 1, gates_t, 1, hprev_t, weight_hhT);
+
+#pragma omp parallel for num_threads(THParallelNumThreads(bs[t], TH_PARALLEL_GRAIN_SIZE / THMax(wsz, 1))) private(b)
+    for (b = 0; b < bs[t]; b++) {
+      real *row = ws + (steps[t] + b) * wsz;
+      real *ig = row, *fg = row + hsz, *cg = row + 2 * hsz, *og = row + 3 * hsz;
+      real *cp = row + 4 * hsz, *c = row + 5 * hsz;
+      real *h = out + (steps[t] + b) * hsz;
+      int64_t j;
+
+      THVector_(sigmoid)(ig, ig, 2 * hsz);
+      THVector_(tanh)(cg, cg, hsz);
+      THVector_(sigmoid)(og, og, hsz);
+      for (j = 0; j < hsz; j++)
+        c[j] = fg[j] * cp[j] + ig[j] * cg[j];
+      THVector_(tanh)(h, c, hsz);
+      for (j = 0; j < hsz; j++)
+        h[j] *= og[j];
+      /* sequences that do not go on to the next step end here */
+      if (b >= alive) {
+        memcpy(hy_data + b * hsz, h, hsz * sizeof(real));
+        memcpy(cy_data + b * hsz, c, hsz * sizeof(real));
+      }
+    }
+  }
+
+  THFree(steps);
+  THTensor_(free)(gates_t);
+  THTensor_(free)(hprev_t);
+  THTensor_(free)(gates);
+  THTensor_(free)(weight_hhT);
+  THTensor_(free)(input);
+  THTensor_(free)(hx);
+  THTensor_(free)(cx);
+}
+
+/* gradWeight_ih += grad^T * input, gradWeight_hh += gradHidden^T * prev hidden,
+   and the matching bias gradients */
+static void THNN_(RNNSequence_accGradParameters)(
+          THTensor *input, THTensor *hprev,
+          THTensor *grad, THTensor *gradHidden,
+          THTensor *gradWeight_ih, THTensor *gradWeight_hh,
+          THTensor *gradBias_ih, THTensor *gradBias_hh)
+{
+  THTensor *gradT = THTensor_(newTranspose)(grad, 0, 1);
+  THTensor *gradHiddenT = THTensor_(newTranspose)(gradHidden, 0, 1);
+  THTensor_(addmm)(gradWeight_ih, 1, gradWeight_ih, 1, gradT, input);
+  THTensor_(addmm)(gradWeight_hh, 1, gradWeight_hh, 1, gradHiddenT, hprev);
+  if (gradBias_ih) {
+    THTensor *sum = THTensor_(new)();
+    THTensor_(sum)(sum, grad, 0, 0);
+    THTensor_(cadd)(gradBias_ih, gradBias_ih, 1, sum);
+    THTensor_(sum)(sum, gradHidden, 0, 0);
+    THTensor_(cadd)(gradBias_hh, gradBias_hh, 1, sum);
+    THTensor_(free)(sum);
+  }
+  THTensor_(free)(gradT);
+  THTensor_(free)(gradHiddenT);
+}
+
+void THNN_(LSTMSequence_backward)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *workspace,
+          THTensor *gradOutput,
+          THTensor *gradHy,
+          THTensor *gradCy,
+          THTensor *gradInput,
+          THTensor *gradHx,
+          THTensor *gradCx,
+          THTensor *gradWeight_ih,
+          THTensor *gradWeight_hh,
+          THTensor *gradBias_ih,
+          THTensor *gradBias_hh,
+          bool reverse)
+{
+  THNN_(RNNSequence_checkSizes)(4, input, weight_ih, weight_hh, gradBias_ih, gradBias_hh, gradHy);
+  THNN_CHECK_SHAPE(gradHy, gradCy);
+  THNN_CHECK_SHAPE(weight_ih, gradWeight_ih);
+  THNN_CHECK_SHAPE(weight_hh, gradWeight_hh);
+
+  int64_t hsz = THTensor_(size)(weight_hh, 1);
+  int64_t wsz = 7 * hsz;
+  int64_t nrows = THTensor_(size)(input, 0);
+  int64_t batch = THTensor_(size)(gradHy, 0);
+  int64_t T = THIndexTensor_(nElement)(batchSizes);
+  int64_t *steps = THNN_(RNNSequence_steps)(batchSizes, nrows, batch);
+  const int64_t *bs = steps + T + 1;
+
+  THArgCheck(THTensor_(isContiguous)(workspace) && THTensor_(size)(workspace, 0) == nrows &&
+             THTensor_(size)(workspace, 1) == wsz, 6, "workspace does not come from updateOutput");
+  THNN_CHECK_DIM_SIZE(gradOutput, 2, 0, nrows);
+  THNN_CHECK_DIM_SIZE(gradOutput, 2, 1, hsz);
+
+  THTensor_(resizeAs)(gradHx, gradHy);
+  THTensor_(resizeAs)(gradCx, gradCy);
+  THArgCheck(THTensor_(isContiguous)(gradHx) && THTensor_(isContiguous)(gradCx), 11,
+             "gradHx and gradCx must be contiguous");
+
+  input = THTensor_(newContiguous)(input);
+  weight_hh = THTensor_(newContiguous)(weight_hh);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  gradHy = THTensor_(newContiguous)(gradHy);
+  gradCy = THTensor_(newContiguous)(gradCy);
+
+  THTensor *gradGates = THTensor_(newWithSize2d)(nrows, 4 * hsz);
+  real *ws = THTensor_(data)(workspace);
+  real *dg_data = THTensor_(data)(gradGates);
+  real *go_data = THTensor_(data)(gradOutput);
+  real *ghy_data = THTensor_(data)(gradHy);
+  real *gcy_data = THTensor_(data)(gradCy);
+  real *ghx_data = THTensor_(data)(gradHx);
+  real *gcx_data = THTensor_(data)(gradCx);
+  THTensor *gradGates_t = THTensor_(new)();
+  THTensor *gradHx_t = THTensor_(new)();
+  int64_t s;
+
+  /* gradHx and gradCx carry the gradient of the state from one step to the
+     one before it, and end up holding the gradient of the initial states */
+  for (s = T - 1; s >= 0; s--) {
+    int64_t t = reverse ? T - 1 - s : s;
+    int64_t n = reverse ? t - 1 : t + 1;
+    int64_t alive = THNN_(RNNSequence_shared)(bs, T, t, n);
+    int64_t b;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(bs[t], TH_PARALLEL_GRAIN_SIZE / THMax(wsz, 1))) private(b)
+    for (b = 0; b < bs[t]; b++) {
+      const real *row = ws + (steps[t] + b) * wsz;
+      const real *ig = row, *fg = row + hsz, *cg = row + 2 * hsz, *og = row + 3 * hsz;
+      const real *cp = row + 4 * hsz, *c = row + 5 * hsz;
+      const real *go = go_data + (steps[t] + b) * hsz;
+      const real *dh = (b >= alive ? ghy_data : ghx_data) + b * hsz;
+      const real *dc = (b >= alive ? gcy_data : gcx_data) + b * hsz;
+      real *dg = dg_data + (steps[t] + b) * 4 * hsz;
+      real *dcp = gcx_data + b * hsz;
+      int64_t j;
+
+      /* tanh(c) is kept in the outgate gradient slot until it is overwritten */
+      THVector_(tanh)(dg + 3 * hsz, c, hsz);
+      for (j = 0; j < hsz; j++) {
+        real tanh_c = dg[3 * hsz + j];
+        real gh = go[j] + dh[j];
+        real gc = gh * og[j] * (1 - tanh_c * tanh_c) + dc[j];
+        dg[j] = gc * cg[j] * (1 - ig[j]) * ig[j];
+        dg[hsz + j] = gc * cp[j] * (1 - fg[j]) * fg[j];
+        dg[2 * hsz + j] = gc * ig[j] * (1 - cg[j] * cg[j]);
+        dg[3 * hsz + j] = gh * tanh_c * (1 - og[j]) * og[j];
+        dcp[j] = gc * fg[j];
+      }
+    }
+
+    THTensor_(narrow)(gradGates_t, gradGates, 0, steps[t], bs[t]);
+    THTensor_(narrow)(gradHx_t, gradHx, 0, 0, bs[t]);
+    THTensor_(addmm)(gradHx_t, 0, gradHx_t, 1, gradGates_t, weight_hh);
+  }
+
+  THTensor_(resize2d)(gradInput, nrows, THTensor_(size)(input, 1));
+  THTensor_(addmm)(gradInput, 0, gradInput, 1, gradGates, weight_ih);
+
+  THTensor *hprev = THTensor_(new)();
+  THTensor_(setStorage2d)(hprev, workspace->storage, workspace->storageOffset + 6 * hsz,
+                          nrows, wsz, hsz, 1);
+  THNN_(RNNSequence_accGradParameters)(input, hprev, gradGates, gradGates,
+                                       gradWeight_ih, gradWeight_hh, gradBias_ih, gradBias_hh);
+
+  THFree(steps);
+  THTensor_(free)(hprev);
+  THTensor_(free)(gradGates_t);
+  THTensor_(free)(gradHx_t);
+  THTensor_(free)(gradGates);
+  THTensor_(free)(input);
+  THTensor_(free)(weight_hh);
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(gradHy);
+  THTensor_(free)(gradCy);
+}
+
+void THNN_(GRUSequence_updateOutput)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *bias_ih,
+          THTensor *bias_hh,
+          THTensor *hx,
+          THTensor *output,
+          THTensor *hy,
+          THTensor *workspace,
+          bool reverse)
+{
+  THNN_(RNNSequence_checkSizes)(3, input, weight_ih, weight_hh, bias_ih, bias_hh, hx);
+
+  int64_t hsz = THTensor_(size)(weight_hh, 1);
+  int64_t wsz = 5 * hsz;
+  int64_t nrows = THTensor_(size)(input, 0);
+  int64_t batch = THTensor_(size)(hx, 0);
+  int64_t T = THIndexTensor_(nElement)(batchSizes);
+  int64_t *steps = THNN_(RNNSequence_steps)(batchSizes, nrows, batch);
+  const int64_t *bs = steps + T + 1;
+
+  THTensor_(resize2d)(output, nrows, hsz);
+  THTensor_(resize2d)(workspace, nrows, wsz);
+  THTensor_(resizeAs)(hy, hx);
+  THArgCheck(THTensor_(isContiguous)(output) && THTensor_(isContiguous)(workspace) &&
+             THTensor_(isContiguous)(hy), 9, "output tensors must be contiguous");
+
+  input = THTensor_(newContiguous)(input);
+  THTensor *weight_hhT = THTensor_(newTranspose)(weight_hh, 0, 1);
+  THTensor *packed = THTensor_(newContiguous)(weight_hhT);
+  THTensor_(free)(weight_hhT);
+  weight_hhT = packed;
+  hx = THTensor_(newContiguous)(hx);
+  THTensor *bias = bias_hh ? THTensor_(newContiguous)(bias_hh) : NULL;
+
+  /* the reset, input and new gate slots first hold the input projection */
+  THTensor *gates = THTensor_(newNarrow)(workspace, 1, 0, 3 * hsz);
+  THNN_(RNNSequence_projectInput)(gates, input, weight_ih, bias_ih, NULL);
+
+  real *ws = THTensor_(data)(workspace);
+  real *out = THTensor_(data)(output);
+  real *hy_data = THTensor_(data)(hy);
+  real *hx_data = THTensor_(data)(hx);
+  real *bias_data = bias ? THTensor_(data)(bias) : NULL;
+  THTensor *hgates = THTensor_(newWithSize2d)(batch, 3 * hsz);
+  real *hg_data = THTensor_(data)(hgates);
+  THTensor *hgates_t = THTensor_(new)();
+  THTensor *hprev_t = THTensor_(new)();
+  int64_t s;
+
+  for (s = 0; s < T; s++) {
+    int64_t t = reverse ? T - 1 - s : s;
+    int64_t p = reverse ? t + 1 : t - 1;
+    int64_t n = reverse ? t - 1 : t + 1;
+    int64_t alive = THNN_(RNNSequence_shared)(bs, T, t, n);
+    int64_t b;
+
+    THNN_(RNNSequence_gatherState)(ws, wsz, 3 * hsz, hsz, steps, T, t, p, out, 0, hsz, hx_data);
+
+    THTensor_(narrow)(hgates_t, hgates, 0, 0, bs[t]);
+    THTensor_(setStorage2d)(hprev_t, workspace->storage,
+                            workspace->storageOffset + steps[t] * wsz + 3 * hsz,
+                            bs[t], wsz, hsz, 1);
+    THTensor_(addmm)(hgates_t, 0, hgates_t, 1, hprev_t, weight_hhT);
+
+#pragma omp parallel for num_threads(THParallelNumThreads(bs[t], TH_PARALLEL_GRAIN_SIZE / THMax(wsz, 1))) private(b)
+    for (b = 0; b < bs[t]; b++) {
+      real *row = ws + (steps[t] + b) * wsz;
+      real *rg = row, *ig = row + hsz, *ng = row + 2 * hsz;
+      real *hp = row + 3 * hsz, *hn = row + 4 * hsz;
+      const real *hg = hg_data + b * 3 * hsz;
+      real *h = out + (steps[t] + b) * hsz;
+      int64_t j;
+
+      for (j = 0; j < 2 * hsz; j++)
+        rg[j] += hg[j] + (bias_data ? bias_data[j] : 0);
+      THVector_(sigmoid)(rg, rg, 2 * hsz);
+      for (j = 0; j < hsz; j++) {
+        hn[j] = hg[2 * hsz + j] + (bias_data ? bias_data[2 * hsz + j] : 0);
+        ng[j] += rg[j] * hn[j];
+      }
+      THVector_(tanh)(ng, ng, hsz);
+      for (j = 0; j < hsz; j++)
+        h[j] = ng[j] + ig[j] * (hp[j] - ng[j]);
+      if (b >= alive)
+        memcpy(hy_data + b * hsz, h, hsz * sizeof(real));
+    }
+  }
+
+  THFree(steps);
+  THTensor_(free)(hgates);
+  THTensor_(free)(hgates_t);
+  THTensor_(free)(hprev_t);
+  THTensor_(free)(gates);
+  THTensor_(free)(weight_hhT);
+  THTensor_(free)(input);
+  THTensor_(free)(hx);
+  if (bias)
+    THTensor_(free)(bias);
+}
+
+void THNN_(GRUSequence_backward)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *workspace,
+          THTensor *gradOutput,
+          THTensor *gradHy,
+          THTensor *gradInput,
+          THTensor *gradHx,
+          THTensor *gradWeight_ih,
+          THTensor *gradWeight_hh,
+          THTensor *gradBias_ih,
+          THTensor *gradBias_hh,
+          bool reverse)
+{
+  THNN_(RNNSequence_checkSizes)(3, input, weight_ih, weight_hh, gradBias_ih, gradBias_hh, gradHy);
+  THNN_CHECK_SHAPE(weight_ih, gradWeight_ih);
+  THNN_CHECK_SHAPE(weight_hh, gradWeight_hh);
+
+  int64_t hsz = THTensor_(size)(weight_hh, 1);
+  int64_t wsz = 5 * hsz;
+  int64_t nrows = THTensor_(size)(input, 0);
+  int64_t batch = THTensor_(size)(gradHy, 0);
+  int64_t T = THIndexTensor_(nElement)(batchSizes);
+  int64_t *steps = THNN_(RNNSequence_steps)(batchSizes, nrows, batch);
+  const int64_t *bs = steps + T + 1;
+
+  THArgCheck(THTensor_(isContiguous)(workspace) && THTensor_(size)(workspace, 0) == nrows &&
+             THTensor_(size)(workspace, 1) == wsz, 6, "workspace does not come from updateOutput");
+  THNN_CHECK_DIM_SIZE(gradOutput, 2, 0, nrows);
+  THNN_CHECK_DIM_SIZE(gradOutput, 2, 1, hsz);
+
+  THTensor_(resizeAs)(gradHx, gradHy);
+  THArgCheck(THTensor_(isContiguous)(gradHx), 10, "gradHx must be contiguous");
+
+  input = THTensor_(newContiguous)(input);
+  weight_hh = THTensor_(newContiguous)(weight_hh);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  gradHy = THTensor_(newContiguous)(gradHy);
+
+  /* the new gate gradient differs on the input and on the hidden side */
+  THTensor *gradGates = THTensor_(newWithSize2d)(nrows, 3 * hsz);
+  THTensor *gradHGates = THTensor_(newWithSize2d)(nrows, 3 * hsz);
+  real *ws = THTensor_(data)(workspace);
+  real *dgi_data = THTensor_(data)(gradGates);
+  real *dgh_data = THTensor_(data)(gradHGates);
+  real *go_data = THTensor_(data)(gradOutput);
+  real *ghy_data = THTensor_(data)(gradHy);
+  real *ghx_data = THTensor_(data)(gradHx);
+  THTensor *gradHGates_t = THTensor_(new)();
+  THTensor *gradHx_t = THTensor_(new)();
+  int64_t s;
+
+  for (s = T - 1; s >= 0; s--) {
+    int64_t t = reverse ? T - 1 - s : s;
+    int64_t n = reverse ? t - 1 : t + 1;
+    int64_t alive = THNN_(RNNSequence_shared)(bs, T, t, n);
+    int64_t b;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(bs[t], TH_PARALLEL_GRAIN_SIZE / THMax(wsz, 1))) private(b)
+    for (b = 0; b < bs[t]; b++) {
+      const real *row = ws + (steps[t] + b) * wsz;
+      const real *rg = row, *ig = row + hsz, *ng = row + 2 * hsz;
+      const real *hp = row + 3 * hsz, *hn = row + 4 * hsz;
+      const real *go = go_data + (steps[t] + b) * hsz;
+      real *dgi = dgi_data + (steps[t] + b) * 3 * hsz;
+      real *dgh = dgh_data + (steps[t] + b) * 3 * hsz;
+      real *dh = ghx_data + b * hsz;
+      const real *dhy = ghy_data + b * hsz;
+      int64_t j;
+
+      for (j = 0; j < hsz; j++) {
+        real gh = go[j] + (b >= alive ? dhy[j] : dh[j]);
+        real gig = gh * (hp[j] - ng[j]) * (1 - ig[j]) * ig[j];
+        real gin = gh * (1 - ig[j]) * (1 - ng[j] * ng[j]);
+        real grg = gin * hn[j] * (1 - rg[j]) * rg[j];
+        dgi[j] = dgh[j] = grg;
+        dgi[hsz + j] = dgh[hsz + j] = gig;
+        dgi[2 * hsz + j] = gin;
+        dgh[2 * hsz + j] = gin * rg[j];
+        dh[j] = gh * ig[j];
+      }
+    }
+
+    THTensor_(narrow)(gradHGates_t, gradHGates, 0, steps[t], bs[t]);
+    THTensor_(narrow)(gradHx_t, gradHx, 0, 0, bs[t]);
+    THTensor_(addmm)(gradHx_t, 1, gradHx_t, 1, gradHGates_t, weight_hh);
+  }
+
+  THTensor_(resize2d)(gradInput, nrows, THTensor_(size)(input, 1));
+  THTensor_(addmm)(gradInput, 0, gradInput, 1, gradGates, weight_ih);
+
+  THTensor *hprev = THTensor_(new)();
+  THTensor_(setStorage2d)(hprev, workspace->storage, workspace->storageOffset + 3 * hsz,
+                          nrows, wsz, hsz, 1);
+  THNN_(RNNSequence_accGradParameters)(input, hprev, gradGates, gradHGates,
+                                       gradWeight_ih, gradWeight_hh, gradBias_ih, gradBias_hh);
+
+  THFree(steps);
+  THTensor_(free)(hprev);
+  THTensor_(free)(gradHGates_t);
+  THTensor_(free)(gradHx_t);
+  THTensor_(free)(gradGates);
+  THTensor_(free)(gradHGates);
+  THTensor_(free)(input);
+  THTensor_(free)(weight_hh);
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(gradHy);
+}
+
+#endif
@@ -34,7 +34,7 @@ void THNN_(Sigmoid_updateGradInput)(
       long i;
 
 #if _OPENMP
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(outputSize, TH_PARALLEL_GRAIN_SIZE)) private(i)
 #endif
       for (i = 0; i < THTensor_(nElement)(gradInput); i++)
       {
@@ -0,0 +1,312 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/SpatialConvolutionAlgorithms.c"
+#else
+
+/*
+ * Alternatives to the im2col + GEMM lowering of SpatialConvolutionMM:
+ *
+ *  - Winograd F(2x2, 3x3) for 3x3 stride 1 layers: 16 GEMMs on transformed
+ *    4x4 input tiles and filters replace the 9x unfolded input, and do 2.25x
+ *    fewer multiplies.
+ *  - a direct convolution for layers with a single output plane and a small
+ *    kernel (depthwise layers, as groups are split before reaching THNN),
+ *    where the GEMM is too thin to pay for the unfolded copy. Output planes
+ *    are processed in blocks of THNN_CONV_DIRECT_BLOCK, so each input row is
+ *    loaded once per block.
+ *
+ * Neither keeps the unfolded input around, so they leave finput empty; the
+ * backward pass rebuilds the columns when it needs them.
+ */
+
+#ifndef THNN_SPATIAL_CONVOLUTION_ALGORITHMS
+#define THNN_SPATIAL_CONVOLUTION_ALGORITHMS
+
+#include <stdlib.h>
+#include <string.h>
+
+#define THNN_CONV_DIRECT_BLOCK 8
+
+/* most multiply-adds per output (nInputPlane*kW*kH) the heuristics hand to
+   the direct convolution */
+#define THNN_CONV_DIRECT_MAX_TAPS 196
+
+/* elements of the columns the MM backward may rebuild at once when the
+   forward did not keep them */
+#define THNN_CONV_COLUMNS_BUDGET ((int64_t)1 << 24)
+
+#ifndef TH_HAVE_THREAD
+#define THNN_CONV_THREAD
+#elif _MSC_VER
+#define THNN_CONV_THREAD __declspec( thread )
+#else
+#define THNN_CONV_THREAD __thread
+#endif
+
+static THNN_CONV_THREAD THNNConvAlgorithm forcedConvAlgorithm = THNN_CONV_ALGO_DEFAULT;
+
+void THNN_SpatialConvolution_setAlgorithm(THNNConvAlgorithm algorithm)
+{
+  forcedConvAlgorithm = algorithm;
+}
+
+THNNConvAlgorithm THNN_SpatialConvolution_getAlgorithm(void)
+{
+  return forcedConvAlgorithm;
+}
+
+/* the THNN_CONV_ALGORITHM environment variable ("mm", "winograd", "direct"),
+   read on first use; THNN_CONV_ALGO_DEFAULT when unset or unknown */
+static THNNConvAlgorithm THNN_SpatialConvolution_envAlgorithm(void)
+{
+  static int envConvAlgorithm = -2; /* not read yet */
+  if (envConvAlgorithm == -2) {
+    const char *name = getenv("THNN_CONV_ALGORITHM");
+    THNNConvAlgorithm algorithm = THNN_CONV_ALGO_DEFAULT;
+    if (name && strcmp(name, "mm") == 0)
+      algorithm = THNN_CONV_ALGO_MM;
+    else if (name && strcmp(name, "winograd") == 0)
+      algorithm = THNN_CONV_ALGO_WINOGRAD;
+    else if (name && strcmp(name, "direct") == 0)
+      algorithm = THNN_CONV_ALGO_DIRECT;
+    envConvAlgorithm = algorithm;
+  }
+  return (THNNConvAlgorithm)envConvAlgorithm;
+}
+
+/* an algorithm forced with THNN_SpatialConvolution_setAlgorithm, then the
+   THNN_CONV_ALGORITHM environment variable override the heuristics when
+   the forced algorithm supports the layer */
+static THNNConvAlgorithm THNN_SpatialConvolution_chooseAlgorithm(
+    int64_t nInputPlane, int64_t nOutputPlane,
+    int64_t outputHeight, int64_t outputWidth,
+    int kW, int kH, int dW, int dH)
+{
+  int winograd_ok = kW == 3 && kH == 3 && dW == 1 && dH == 1;
+  THNNConvAlgorithm env = THNN_SpatialConvolution_envAlgorithm();
+  if (forcedConvAlgorithm != THNN_CONV_ALGO_DEFAULT &&
+      (forcedConvAlgorithm != THNN_CONV_ALGO_WINOGRAD || winograd_ok))
+    return forcedConvAlgorithm;
+  if (env != THNN_CONV_ALGO_DEFAULT &&
+      (env != THNN_CONV_ALGO_WINOGRAD || winograd_ok))
+    return env;
+  /* with more output planes, or many taps per output, unfolding and one
+     GEMM beat the direct loops whatever the number of input planes (a 7x7
+     RGB stem is 3x slower direct) */
+  if (nOutputPlane == 1 && nInputPlane*kW*kH <= THNN_CONV_DIRECT_MAX_TAPS)
+    return THNN_CONV_ALGO_DIRECT;
+  /* the transforms only pay off when there are enough planes to share them */
+  if (winograd_ok && nInputPlane >= 16 && nOutputPlane >= 16 &&
+      outputHeight >= 4 && outputWidth >= 4)
+    return THNN_CONV_ALGO_WINOGRAD;
+  return THNN_CONV_ALGO_MM;
+}
+
+#endif
+
+/* output planes of one frame, computed straight from the input */
+static void THNN_(SpatialConvolution_direct_frame)(
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *bias,
+          int kW, int kH, int dW, int dH, int padW, int padH,
+          int64_t nInputPlane, int64_t inputWidth, int64_t inputHeight,
+          int64_t nOutputPlane, int64_t outputWidth, int64_t outputHeight)
+{
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *weight_data = THTensor_(data)(weight);
+  real *bias_data = bias ? THTensor_(data)(bias) : NULL;
+  int64_t nblocks = (nOutputPlane + THNN_CONV_DIRECT_BLOCK - 1) / THNN_CONV_DIRECT_BLOCK;
+  int64_t work = THNN_CONV_DIRECT_BLOCK * nInputPlane * kH * kW * outputHeight * outputWidth;
+  int64_t blk;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(nblocks, TH_PARALLEL_GRAIN_SIZE / THMax(work, 1))) private(blk)
+  for (blk = 0; blk < nblocks; blk++) {
+    int64_t o0 = blk * THNN_CONV_DIRECT_BLOCK;
+    int64_t o1 = THMin(o0 + THNN_CONV_DIRECT_BLOCK, nOutputPlane);
+    int64_t o, c, y;
+
+    for (o = o0; o < o1; o++)
+      THVector_(fill)(output_data + o * outputHeight * outputWidth,
+                      bias_data ? bias_data[o] : 0, outputHeight * outputWidth);
+
+    for (c = 0; c < nInputPlane; c++) {
+      for (y = 0; y < outputHeight; y++) {
+        int ki, kj;
+        for (ki = 0; ki < kH; ki++) {
+          int64_t iy = y * dH - padH + ki;
+          if (iy < 0 || iy >= inputHeight)
+            continue;
+          real *in_row = input_data + (c * inputHeight + iy) * inputWidth;
+          for (kj = 0; kj < kW; kj++) {
+            /* output columns whose tap kj falls inside the input row */
+            int64_t x0 = padW > kj ? (padW - kj + dW - 1) / dW : 0;
+            int64_t x1 = inputWidth - 1 + padW - kj < 0 ? 0 :
+                         THMin((inputWidth - 1 + padW - kj) / dW + 1, outputWidth);
+            if (x0 >= x1)
+              continue;
+            for (o = o0; o < o1; o++) {
+              real w = weight_data[((o * nInputPlane + c) * kH + ki) * kW + kj];
+              real *out_row = output_data + (o * outputHeight + y) * outputWidth;
+              const real *in_ptr = in_row + x0 * dW - padW + kj;
+              if (dW == 1) {
+                THVector_(cadd)(out_row + x0, out_row + x0, in_ptr, w, x1 - x0);
+              } else {
+                int64_t x;
+                for (x = x0; x < x1; x++)
+                  out_row[x] += w * in_ptr[(x - x0) * dW];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/* U[xi][o][c] = (G g G^T)[xi] for every 3x3 filter g, with xi in [0, 16) */
+static THTensor *THNN_(SpatialConvolution_winograd_transformWeight)(
+          THTensor *weight, int64_t nInputPlane, int64_t nOutputPlane)
+{
+  THTensor *transformed = THTensor_(newWithSize3d)(16, nOutputPlane, nInputPlane);
+  real *u_data = THTensor_(data)(transformed);
+  real *weight_data = THTensor_(data)(weight);
+  int64_t plane = nOutputPlane * nInputPlane;
+  int64_t k;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(plane, TH_PARALLEL_GRAIN_SIZE / 32)) private(k)
+  for (k = 0; k < plane; k++) {
+    const real *g = weight_data + k * 9;
+    real t[4][3];
+    int i, j;
+    /* t = G g */
+    for (j = 0; j < 3; j++) {
+      t[0][j] = g[j];
+      t[1][j] = (g[j] + g[3 + j] + g[6 + j]) / 2;
+      t[2][j] = (g[j] - g[3 + j] + g[6 + j]) / 2;
+      t[3][j] = g[6 + j];
+    }
+    /* U = t G^T */
+    for (i = 0; i < 4; i++) {
+      u_data[(i * 4 + 0) * plane + k] = t[i][0];
+      u_data[(i * 4 + 1) * plane + k] = (t[i][0] + t[i][1] + t[i][2]) / 2;
+      u_data[(i * 4 + 2) * plane + k] = (t[i][0] - t[i][1] + t[i][2]) / 2;
+      u_data[(i * 4 + 3) * plane + k] = t[i][2];
+    }
+  }
+  return transformed;
+}
+
+/* scratch elements needed by one frame */
+static int64_t THNN_(SpatialConvolution_winograd_scratchSize)(
+          int64_t nInputPlane, int64_t nOutputPlane,
+          int64_t outputWidth, int64_t outputHeight)
+{
+  int64_t ntiles = ((outputHeight + 1) / 2) * ((outputWidth + 1) / 2);
+  return 16 * (nInputPlane + nOutputPlane) * ntiles;
+}
+
+static void THNN_(SpatialConvolution_winograd_frame)(
+          THTensor *input,
+          THTensor *output,
+          THTensor *transformedWeight,
+          THTensor *bias,
+          THTensor *scratch,
+          int padW, int padH,
+          int64_t nInputPlane, int64_t inputWidth, int64_t inputHeight,
+          int64_t nOutputPlane, int64_t outputWidth, int64_t outputHeight)
+{
+  int64_t tilesW = (outputWidth + 1) / 2;
+  int64_t ntiles = ((outputHeight + 1) / 2) * tilesW;
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *bias_data = bias ? THTensor_(data)(bias) : NULL;
+  /* V[xi][c][tile] followed by M[xi][o][tile] */
+  real *v_data = THTensor_(data)(scratch);
+  real *m_data = v_data + 16 * nInputPlane * ntiles;
+  int64_t c, o, xi;
+
+  /* V = B^T d B for every 4x4 input tile d */
+#pragma omp parallel for num_threads(THParallelNumThreads(nInputPlane, TH_PARALLEL_GRAIN_SIZE / THMax(16 * ntiles, 1))) private(c)
+  for (c = 0; c < nInputPlane; c++) {
+    const real *plane = input_data + c * inputHeight * inputWidth;
+    int64_t p;
+    for (p = 0; p < ntiles; p++) {
+      int64_t y0 = (p / tilesW) * 2 - padH;
+      int64_t x0 = (p % tilesW) * 2 - padW;
+      real d[4][4], t[4][4];
+      int i, j;
+      for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+          int64_t iy = y0 + i, ix = x0 + j;
+          d[i][j] = (iy >= 0 && iy < inputHeight && ix >= 0 && ix < inputWidth) ?
+            plane[iy * inputWidth + ix] : 0;
+        }
+      }
+      for (j = 0; j < 4; j++) {
+        t[0][j] = d[0][j] - d[2][j];
+        t[1][j] = d[1][j] + d[2][j];
+        t[2][j] = d[2][j] - d[1][j];
+        t[3][j] = d[1][j] - d[3][j];
+      }
+      for (i = 0; i < 4; i++) {
+        real *v = v_data + (i * 4 * nInputPlane + c) * ntiles + p;
+        int64_t step = nInputPlane * ntiles;
+        v[0] = t[i][0] - t[i][2];
+        v[step] = t[i][1] + t[i][2];
+        v[2 * step] = t[i][2] - t[i][1];
+        v[3 * step] = t[i][1] - t[i][3];
+      }
+    }
+  }
+
+  /* M[xi] = U[xi] V[xi] */
+  for (xi = 0; xi < 16; xi++) {
+    THTensor *u = THTensor_(newWithStorage2d)(transformedWeight->storage,
+                                              transformedWeight->storageOffset + xi * nOutputPlane * nInputPlane,
+                                              nOutputPlane, nInputPlane, nInputPlane, 1);
+    THTensor *v = THTensor_(newWithStorage2d)(scratch->storage,
+                                              scratch->storageOffset + xi * nInputPlane * ntiles,
+                                              nInputPlane, ntiles, ntiles, 1);
+    THTensor *m = THTensor_(newWithStorage2d)(scratch->storage,
+                                              scratch->storageOffset + (16 * nInputPlane + xi * nOutputPlane) * ntiles,
+                                              nOutputPlane, ntiles, ntiles, 1);
+    THTensor_(addmm)(m, 0, m, 1, u, v);
+    THTensor_(free)(u);
+    THTensor_(free)(v);
+    THTensor_(free)(m);
+  }
+
+  /* Y = A^T M A for every tile, clipped to the output */
+#pragma omp parallel for num_threads(THParallelNumThreads(nOutputPlane, TH_PARALLEL_GRAIN_SIZE / THMax(16 * ntiles, 1))) private(o)
+  for (o = 0; o < nOutputPlane; o++) {
+    real *plane = output_data + o * outputHeight * outputWidth;
+    real b = bias_data ? bias_data[o] : 0;
+    int64_t step = nOutputPlane * ntiles;
+    int64_t p;
+    for (p = 0; p < ntiles; p++) {
+      const real *m = m_data + o * ntiles + p;
+      real r[2][4];
+      int64_t y0 = (p / tilesW) * 2;
+      int64_t x0 = (p % tilesW) * 2;
+      int j;
+      for (j = 0; j < 4; j++) {
+        real m0 = m[j * step], m1 = m[(4 + j) * step];
+        real m2 = m[(8 + j) * step], m3 = m[(12 + j) * step];
+        r[0][j] = m0 + m1 + m2;
+        r[1][j] = m1 - m2 - m3;
+      }
+      for (j = 0; j < 2; j++) {
+        if (y0 + j >= outputHeight)
+          break;
+        real *out = plane + (y0 + j) * outputWidth + x0;
+        out[0] = b + r[j][0] + r[j][1] + r[j][2];
+        if (x0 + 1 < outputWidth)
+          out[1] = b + r[j][1] - r[j][2] - r[j][3];
+      }
+    }
+  }
+}
+
+#endif
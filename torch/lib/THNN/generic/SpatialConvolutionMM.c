@@ -66,6 +66,18 @@ static THTensor* THNN_(view_weight_MM2d)(THTensor *weight) {
   return weight;
 }
 
+/* columns of frames [t, t+n) in a column matrix holding frames side by side */
+static THTensor* THNN_(SpatialConvolutionMM_frameColumns)(
+          THTensor *columns,
+          int64_t t,
+          int64_t n,
+          int64_t frameSize)
+{
+  return THTensor_(newWithStorage2d)(columns->storage, columns->storageOffset + t*frameSize,
+                                     columns->size[0], columns->stride[0],
+                                     n*frameSize, 1);
+}
+
 static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
           THTensor *input,
           THTensor *output,
@@ -109,6 +121,49 @@ static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
   THTensor_(free)(output2d);
 }
 
+static void THNN_(SpatialConvolutionMM_updateOutput_algorithm)(
+          THNNConvAlgorithm algorithm,
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *transformedWeight,
+          THTensor *bias,
+          THTensor *finput,
+          int64_t scratchSize,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t nOutputPlane,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  if (algorithm == THNN_CONV_ALGO_WINOGRAD) {
+    THTensor *scratch = THTensor_(newWithSize1d)(scratchSize);
+    THNN_(SpatialConvolution_winograd_frame)
+      (input, output, transformedWeight, bias, scratch, padW, padH,
+       nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+    THTensor_(free)(scratch);
+  } else if (algorithm == THNN_CONV_ALGO_DIRECT) {
+    THNN_(SpatialConvolution_direct_frame)
+      (input, output, weight, bias, kW, kH, dW, dH, padW, padH,
+       nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  } else {
+    THNN_(SpatialConvolutionMM_updateOutput_frame)
+      (input, output, weight, bias, finput,
+       kW, kH, dW, dH, padW, padH,
+       nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  }
+}
+
 void THNN_(SpatialConvolutionMM_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -148,13 +203,33 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
   int64_t outputHeight = (inputHeight + 2*padH - kH) / dH + 1;
   int64_t outputWidth  = (inputWidth + 2*padW - kW) / dW + 1;
 
+  THNNConvAlgorithm algorithm = THNN_SpatialConvolution_chooseAlgorithm(
+    nInputPlane, nOutputPlane, outputHeight, outputWidth, kW, kH, dW, dH);
+  THTensor *transformedWeight = NULL;
+  int64_t scratchSize = 0;
+
+  if (algorithm == THNN_CONV_ALGO_MM) {
+    /* batches are unfolded side by side, so that the weight gradient can
+       be accumulated with GEMMs spanning several frames */
+    int64_t T = input->nDimension == 3 ? 1 : input->size[0];
+    THTensor_(resize2d)(finput, kW*kH*nInputPlane, T*outputHeight*outputWidth);
+  } else {
+    /* the columns are rebuilt by the backward pass if it needs them */
+    THTensor_(resize1d)(finput, 0);
+  }
+  if (algorithm == THNN_CONV_ALGO_WINOGRAD) {
+    transformedWeight = THNN_(SpatialConvolution_winograd_transformWeight)(
+      weight, nInputPlane, nOutputPlane);
+    scratchSize = THNN_(SpatialConvolution_winograd_scratchSize)(
+      nInputPlane, nOutputPlane, outputWidth, outputHeight);
+  }
+
   if(input->nDimension == 3)
   {
-    THTensor_(resize2d)(finput, kW*kH*nInputPlane, outputHeight*outputWidth);
     THTensor_(resize3d)(output, nOutputPlane, outputHeight, outputWidth);
 
-    THNN_(SpatialConvolutionMM_updateOutput_frame)
-      (input, output, weight, bias, finput,
+    THNN_(SpatialConvolutionMM_updateOutput_algorithm)
+      (algorithm, input, output, weight, transformedWeight, bias, finput, scratchSize,
        kW, kH, dW, dH, padW, padH,
        nInputPlane, inputWidth, inputHeight,
        nOutputPlane, outputWidth, outputHeight);
@@ -164,7 +239,6 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
     int64_t T = input->size[0];
     int64_t t;
 
-    THTensor_(resize3d)(finput, T, kW*kH*nInputPlane, outputHeight*outputWidth);
     THTensor_(resize4d)(output, T, nOutputPlane, outputHeight, outputWidth);
 
 #pragma omp parallel for private(t)
@@ -172,20 +246,24 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
     {
       THTensor *input_t = THTensor_(newSelect)(input, 0, t);
       THTensor *output_t = THTensor_(newSelect)(output, 0, t);
-      THTensor *finput_t = THTensor_(newSelect)(finput, 0, t);
+      THTensor *finput_t = algorithm == THNN_CONV_ALGO_MM ?
+        THNN_(SpatialConvolutionMM_frameColumns)(finput, t, 1, outputHeight*outputWidth) : NULL;
 
-      THNN_(SpatialConvolutionMM_updateOutput_frame)
-	(input_t, output_t, weight, bias, finput_t,
+      THNN_(SpatialConvolutionMM_updateOutput_algorithm)
+	(algorithm, input_t, output_t, weight, transformedWeight, bias, finput_t, scratchSize,
 	 kW, kH, dW, dH, padW, padH,
 	 nInputPlane, inputWidth, inputHeight,
 	 nOutputPlane, outputWidth, outputHeight);
 
       THTensor_(free)(input_t);
       THTensor_(free)(output_t);
-      THTensor_(free)(finput_t);
+      if (finput_t)
+        THTensor_(free)(finput_t);
     }
   }
 
+  if (transformedWeight)
+    THTensor_(free)(transformedWeight);
   THTensor_(free)(input);
   THTensor_(free)(weight);
 }
@@ -240,8 +318,15 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   input = THTensor_(newContiguous)(input);
   gradOutput = THTensor_(newContiguous)(gradOutput);
 
+  int64_t nColumns = weight->size[1];
+  int64_t outputPlaneSize = gradOutput->size[gradOutput->nDimension - 2] *
+    gradOutput->size[gradOutput->nDimension - 1];
+
   THTensor_(resizeAs)(gradInput, input);
-  THTensor_(resizeAs)(fgradInput, finput);
+  if (input->nDimension == 3)
+    THTensor_(resize2d)(fgradInput, nColumns, outputPlaneSize);
+  else
+    THTensor_(resize3d)(fgradInput, input->size[0], nColumns, outputPlaneSize);
 
   // depending on the BLAS library, fgradInput (result tensor) might
   // be left uninitialized on zero alpha, which might lead to weird behavior
@@ -284,6 +369,67 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   THTensor_(free)(weight);
 }
 
+/* unfolds frames [t, t+n) of input side by side into columns */
+static void THNN_(SpatialConvolutionMM_unfoldFrames)(
+          THTensor *columns,
+          THTensor *input,
+          int64_t t,
+          int64_t n,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  int64_t i;
+  int64_t nInputPlane = input->size[1];
+  THTensor_(resize2d)(columns, kW*kH*nInputPlane, n*outputHeight*outputWidth);
+  for (i = 0; i < n; i++) {
+    THTensor *input_t = THTensor_(newSelect)(input, 0, t + i);
+    THTensor *columns_t = THNN_(SpatialConvolutionMM_frameColumns)(
+      columns, i, 1, outputHeight*outputWidth);
+    THNN_(unfolded_copy)(columns_t, input_t, kW, kH, dW, dH, padW, padH,
+                         nInputPlane, input->size[3], input->size[2],
+                         outputWidth, outputHeight);
+    THTensor_(free)(columns_t);
+    THTensor_(free)(input_t);
+  }
+}
+
+/* gradOutput of frames [t, t+n) as one nOutputPlane x (n*oH*oW) matrix */
+static THTensor* THNN_(SpatialConvolutionMM_gatherGradOutput)(
+          THTensor *buffer,
+          THTensor *gradOutput,
+          int64_t t,
+          int64_t n)
+{
+  int64_t i;
+  int64_t nOutputPlane = gradOutput->size[1];
+  int64_t frameSize = gradOutput->size[2]*gradOutput->size[3];
+  if (n == 1) {
+    return THTensor_(newWithStorage2d)(gradOutput->storage,
+                                       gradOutput->storageOffset + t*gradOutput->stride[0],
+                                       nOutputPlane, -1, frameSize, -1);
+  }
+  THTensor_(resize2d)(buffer, nOutputPlane, n*frameSize);
+  for (i = 0; i < n; i++) {
+    THTensor *gradOutput_t = THTensor_(newSelect)(gradOutput, 0, t + i);
+    THTensor *buffer_t = THNN_(SpatialConvolutionMM_frameColumns)(buffer, i, 1, frameSize);
+    THTensor *gradOutput2d = THTensor_(newWithStorage2d)
+      (gradOutput_t->storage, gradOutput_t->storageOffset,
+       nOutputPlane, -1, frameSize, -1);
+    THTensor_(copy)(buffer_t, gradOutput2d);
+    THTensor_(free)(gradOutput2d);
+    THTensor_(free)(buffer_t);
+    THTensor_(free)(gradOutput_t);
+  }
+  THTensor_(retain)(buffer);
+  return buffer;
+}
+
 static void THNN_(SpatialConvolutionMM_accGradParameters_frame)(
           THTensor *gradOutput,
           THTensor *gradWeight,
@@ -317,6 +463,131 @@ static void THNN_(SpatialConvolutionMM_accGradParameters_frame)(
   THTensor_(free)(gradOutput2d);
 }
 
+/*
+ * Weight gradient of a batch. The batch is split between the threads of
+ * the team OpenMP actually starts, which may be smaller than requested.
+ * Each thread accumulates its frames into a partial gradient (the first
+ * thread directly into gradWeight) with GEMMs spanning several frames,
+ * and the partial gradients of the team are then summed in parallel. The columns come from
+ * finput when the MM forward kept them, otherwise they are rebuilt a few
+ * frames at a time, within THNN_CONV_COLUMNS_BUDGET elements.
+ */
+static void THNN_(SpatialConvolutionMM_accGradParameters_batch)(
+          THTensor *input,
+          THTensor *gradOutput,
+          THTensor *gradWeight,
+          THTensor *gradBias,
+          THTensor *finput,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          real scale)
+{
+  int64_t T = input->size[0];
+  int64_t nOutputPlane = gradWeight->size[0];
+  int64_t nColumns = gradWeight->size[1];
+  int64_t outputHeight = gradOutput->size[2];
+  int64_t outputWidth = gradOutput->size[3];
+  int64_t frameSize = outputHeight*outputWidth;
+  int64_t i;
+
+  int haveColumns = finput->nDimension == 2 && finput->size[0] == nColumns &&
+    finput->size[1] == T*frameSize && finput->stride[1] == 1;
+  int nThreads = THParallelNumThreads(T, 1);
+  int nTeam = 1;
+  int64_t chunk = haveColumns ? T :
+    THMax(1, THNN_CONV_COLUMNS_BUDGET / (nThreads*nColumns*frameSize));
+  THTensor *partials = nThreads > 1 ?
+    THTensor_(newWithSize3d)(nThreads - 1, nOutputPlane, nColumns) : NULL;
+
+#pragma omp parallel num_threads(nThreads)
+  {
+#ifdef _OPENMP
+    int tid = omp_get_thread_num();
+    int team = omp_get_num_threads();
+#else
+    int tid = 0;
+    int team = 1;
+#endif
+    int64_t begin = T*tid/team;
+    int64_t end = T*(tid + 1)/team;
+    int64_t t;
+    THTensor *gradWeight_t;
+    THTensor *columns = haveColumns ? NULL : THTensor_(new)();
+    THTensor *gradOutputBuffer = THTensor_(new)();
+
+    if (tid == 0) {
+      nTeam = team;
+      gradWeight_t = gradWeight;
+      THTensor_(retain)(gradWeight);
+    } else {
+      gradWeight_t = THTensor_(newSelect)(partials, 0, tid - 1);
+      THTensor_(zero)(gradWeight_t);
+    }
+
+    for (t = begin; t < end; t += chunk) {
+      int64_t n = THMin(chunk, end - t);
+      THTensor *columns_t, *tcolumns;
+      THTensor *gradOutput2d = THNN_(SpatialConvolutionMM_gatherGradOutput)(
+        gradOutputBuffer, gradOutput, t, n);
+      if (haveColumns) {
+        columns_t = THNN_(SpatialConvolutionMM_frameColumns)(finput, t, n, frameSize);
+      } else {
+        THNN_(SpatialConvolutionMM_unfoldFrames)(columns, input, t, n, kW, kH, dW, dH,
+                                                 padW, padH, outputWidth, outputHeight);
+        columns_t = columns;
+        THTensor_(retain)(columns);
+      }
+      tcolumns = THTensor_(newTranspose)(columns_t, 0, 1);
+      THTensor_(addmm)(gradWeight_t, 1, gradWeight_t, scale, gradOutput2d, tcolumns);
+      THTensor_(free)(tcolumns);
+      THTensor_(free)(columns_t);
+      THTensor_(free)(gradOutput2d);
+    }
+
+    THTensor_(free)(gradOutputBuffer);
+    if (columns)
+      THTensor_(free)(columns);
+    THTensor_(free)(gradWeight_t);
+  }
+
+  /* only the partials of threads that ran were zeroed and filled */
+  if (nTeam > 1) {
+    int64_t size = nOutputPlane*nColumns;
+    real *gradWeight_data = THTensor_(data)(gradWeight);
+    real *partials_data = THTensor_(data)(partials);
+#pragma omp parallel for num_threads(THParallelNumThreads(size, TH_PARALLEL_GRAIN_SIZE / nTeam)) private(i)
+    for (i = 0; i < size; i++) {
+      int p;
+      real sum = gradWeight_data[i];
+      for (p = 0; p < nTeam - 1; p++)
+        sum += partials_data[p*size + i];
+      gradWeight_data[i] = sum;
+    }
+  }
+  if (partials)
+    THTensor_(free)(partials);
+
+  if (gradBias) {
+    real *gradOutput_data = THTensor_(data)(gradOutput);
+    real *gradBias_data = THTensor_(data)(gradBias);
+#pragma omp parallel for num_threads(THParallelNumThreads(nOutputPlane, TH_PARALLEL_GRAIN_SIZE / THMax(T*frameSize, 1))) private(i)
+    for (i = 0; i < nOutputPlane; i++) {
+      int64_t t, k;
+      real sum = 0;
+      for (t = 0; t < T; t++) {
+        real *data = gradOutput_data + (t*nOutputPlane + i)*frameSize;
+        for (k = 0; k < frameSize; k++)
+          sum += data[k];
+      }
+      gradBias_data[i] += scale*sum;
+    }
+  }
+}
+
 void THNN_(SpatialConvolutionMM_accGradParameters)(
           THNNState *state,
           THTensor *input,
@@ -348,25 +619,27 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
 
   if(input->nDimension == 3)
   {
+    /* the Winograd and direct forward algorithms do not keep the columns */
+    THTensor *columns = THTensor_(new)();
+    if (THTensor_(nElement)(finput) == 0) {
+      THTensor *input4d = THTensor_(newWithStorage4d)
+        (input->storage, input->storageOffset, 1, -1,
+         input->size[0], -1, input->size[1], -1, input->size[2], -1);
+      THNN_(SpatialConvolutionMM_unfoldFrames)(columns, input4d, 0, 1, kW, kH, dW, dH,
+                                               padW, padH, gradOutput->size[2], gradOutput->size[1]);
+      THTensor_(free)(input4d);
+    } else {
+      THTensor_(set)(columns, finput);
+    }
     THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput, gradWeight,
-							gradBias, finput, scale);
+							gradBias, columns, scale);
+    THTensor_(free)(columns);
   }
   else
   {
-    int64_t T = input->size[0];
-    int64_t t;
-
-    for(t = 0; t < T; t++)
-    {
-      THTensor *gradOutput_t = THTensor_(newSelect)(gradOutput, 0, t);
-      THTensor *finput_t = THTensor_(newSelect)(finput, 0, t);
-
-      THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput_t, gradWeight,
-							  gradBias, finput_t, scale);
-
-      THTensor_(free)(gradOutput_t);
-      THTensor_(free)(finput_t);
-    }
+    THNN_(SpatialConvolutionMM_accGradParameters_batch)(input, gradOutput, gradWeight,
+							gradBias, finput, kW, kH, dW, dH,
+							padW, padH, scale);
   }
 
   THTensor_(free)(input);
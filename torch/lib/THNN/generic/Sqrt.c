@@ -38,7 +38,7 @@ void THNN_(Sqrt_updateGradInput)(
     real *gradInput_data  = THTensor_(data)(gradInput);
     real *output_data     = THTensor_(data)(output);
     int64_t i;
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(THTensor_(nElement)(output), TH_PARALLEL_GRAIN_SIZE)) private(i)
     for(i = 0; i < THTensor_(nElement)(output); i++)
     {
       if (output_data[i] == 0.0)
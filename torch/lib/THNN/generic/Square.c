@@ -20,7 +20,7 @@ void THNN_(Square_updateOutput)(
     real *output_data = THTensor_(data)(output);
     real *input_data  = THTensor_(data)(input);
     int64_t i;
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(THTensor_(nElement)(input), TH_PARALLEL_GRAIN_SIZE)) private(i)
     for (i = 0; i < THTensor_(nElement)(input); i++)
       output_data[i] = input_data[i]*input_data[i];
   }
@@ -50,7 +50,7 @@ void THNN_(Square_updateGradInput)(
     real *gradInput_data  = THTensor_(data)(gradInput);
     real *input_data  = THTensor_(data)(input);
     int64_t i;
-#pragma omp parallel for private(i)
+#pragma omp parallel for num_threads(THParallelNumThreads(THTensor_(nElement)(gradInput), TH_PARALLEL_GRAIN_SIZE)) private(i)
     for (i = 0; i < THTensor_(nElement)(gradInput); i++)
       gradInput_data[i] = 2.0 * gradOutput_data[i] * input_data[i];
   }
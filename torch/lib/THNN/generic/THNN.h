@@ -218,6 +218,70 @@ TH_API void THNN_(LSTMFused_updateGradInput)(
           THTensor *gradOutputCell,
           THTensor *gradInputCx);
 
+TH_API void THNN_(LSTMSequence_updateOutput)(
+          THNNState *state,
+          THTensor *input,             // rows of all time steps, each step a block of batchSizes[t] rows
+          THIndexTensor *batchSizes,   // number of sequences at each step (non-increasing)
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *bias_ih,           // [OPTIONAL]
+          THTensor *bias_hh,           // [OPTIONAL]
+          THTensor *hx,
+          THTensor *cx,
+          THTensor *output,            // [OUT] hidden state of every row
+          THTensor *hy,                // [OUT] last hidden state of every sequence
+          THTensor *cy,                // [OUT] last cell state of every sequence
+          THTensor *workspace,         // [OUT] saved for the backward pass
+          bool reverse);               // if true, runs the steps from last to first
+TH_API void THNN_(LSTMSequence_backward)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *workspace,
+          THTensor *gradOutput,
+          THTensor *gradHy,
+          THTensor *gradCy,
+          THTensor *gradInput,         // [OUT]
+          THTensor *gradHx,            // [OUT]
+          THTensor *gradCx,            // [OUT]
+          THTensor *gradWeight_ih,     // accumulated into
+          THTensor *gradWeight_hh,     // accumulated into
+          THTensor *gradBias_ih,       // [OPTIONAL] accumulated into
+          THTensor *gradBias_hh,       // [OPTIONAL] accumulated into
+          bool reverse);
+
+TH_API void THNN_(GRUSequence_updateOutput)(
+          THNNState *state,
+          THTensor *input,             // rows of all time steps, each step a block of batchSizes[t] rows
+          THIndexTensor *batchSizes,   // number of sequences at each step (non-increasing)
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *bias_ih,           // [OPTIONAL]
+          THTensor *bias_hh,           // [OPTIONAL]
+          THTensor *hx,
+          THTensor *output,            // [OUT] hidden state of every row
+          THTensor *hy,                // [OUT] last hidden state of every sequence
+          THTensor *workspace,         // [OUT] saved for the backward pass
+          bool reverse);               // if true, runs the steps from last to first
+TH_API void THNN_(GRUSequence_backward)(
+          THNNState *state,
+          THTensor *input,
+          THIndexTensor *batchSizes,
+          THTensor *weight_ih,
+          THTensor *weight_hh,
+          THTensor *workspace,
+          THTensor *gradOutput,
+          THTensor *gradHy,
+          THTensor *gradInput,         // [OUT]
+          THTensor *gradHx,            // [OUT]
+          THTensor *gradWeight_ih,     // accumulated into
+          THTensor *gradWeight_hh,     // accumulated into
+          THTensor *gradBias_ih,       // [OPTIONAL] accumulated into
+          THTensor *gradBias_hh,       // [OPTIONAL] accumulated into
+          bool reverse);
+
 TH_API void THNN_(LogSigmoid_updateOutput)(
           THNNState *state,            // library's state
           THTensor *input,             // input tensor
@@ -255,6 +319,17 @@ TH_API void THNN_(LookupTable_accGradParameters)(
           int paddingValue,
           accreal scale);
 
+TH_API void THNN_(LookupTable_accGradParametersSparse)(
+          THNNState *state,
+          THIndexTensor *input,
+          THTensor *gradOutput,
+          THIndexTensor *gradIndices,  // [OUT] distinct rows looked up, sorted
+          THTensor *gradValues,        // [OUT] gradient of each of these rows
+          int64_t numWeights,
+          bool scaleGradByFreq,
+          int paddingValue,
+          accreal scale);
+
 TH_API void THNN_(LookupTable_renorm)(
           THNNState *state,            // library's state
           THIndexTensor *idx,          // vector containing row indices (modified in function)
@@ -262,6 +337,50 @@ TH_API void THNN_(LookupTable_renorm)(
           accreal maxNorm,             // maximum norm
           accreal normType);           // the norm type (e.g., normType=2, then it's 2-norm)
 
+TH_API void THNN_(LookupTableBag_updateOutput)(
+          THNNState *state,
+          THIndexTensor *input,        // 1D tensor of the rows looked up by all bags
+          THIndexTensor *offsets,      // 1D tensor, offsets[b] is where bag b starts in input
+          THTensor *weight,
+          THTensor *output,            // [OUT] one reduced row per bag
+          THTensor *perSampleWeights,  // [OPTIONAL] weight of each lookup (sum mode only)
+          THIndexTensor *maxIndices,   // [OUT] position in input of each max (max mode only)
+          int mode);                   // 0 = sum, 1 = mean, 2 = max
+
+TH_API void THNN_(LookupTableBag_accGradParameters)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *gradOutput,
+          THTensor *gradWeight,
+          THTensor *perSampleWeights,  // [OPTIONAL]
+          THIndexTensor *maxIndices,   // [OPTIONAL] only used in max mode
+          bool scaleGradByFreq,
+          int mode,
+          accreal scale);
+
+TH_API void THNN_(LookupTableBag_accGradParametersSparse)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *gradOutput,
+          THIndexTensor *gradIndices,  // [OUT] distinct rows looked up, sorted
+          THTensor *gradValues,        // [OUT] gradient of each of these rows
+          THTensor *perSampleWeights,  // [OPTIONAL]
+          THIndexTensor *maxIndices,   // [OPTIONAL] only used in max mode
+          int64_t numWeights,
+          bool scaleGradByFreq,
+          int mode,
+          accreal scale);
+
+TH_API void THNN_(LookupTableBag_updateGradPerSampleWeights)(
+          THNNState *state,
+          THIndexTensor *input,
+          THIndexTensor *offsets,
+          THTensor *weight,
+          THTensor *gradOutput,
+          THTensor *gradPerSampleWeights); // [OUT]
+
 TH_API void THNN_(MarginCriterion_updateOutput)(
           THNNState *state,            // library's state
           THTensor *input,             // input tensor
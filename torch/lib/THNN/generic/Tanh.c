@@ -34,7 +34,7 @@ void THNN_(Tanh_updateGradInput)(
       real* ptr_output     = THTensor_(data)(output);
       long i;
 #if _OPENMP
-      #pragma omp parallel for private(i)
+      #pragma omp parallel for num_threads(THParallelNumThreads(outputSize, TH_PARALLEL_GRAIN_SIZE)) private(i)
 #endif
       for (i = 0; i < outputSize; i++)
       {
@@ -107,6 +107,10 @@ void THNN_(unfolded_copy)(
   int64_t k;
   real *input_data = THTensor_(data)(input);
   real *finput_data = THTensor_(data)(finput);
+  /* the rows of a 2D finput may be further apart than a frame, when several
+     frames are unfolded side by side into one column matrix */
+  size_t rowStride = finput->nDimension == 2 ?
+    (size_t)finput->stride[0] : (size_t)outputHeight*outputWidth;
 
 #pragma omp parallel for private(k)
   for(k = 0; k < (int64_t)nInputPlane*kH*kW; k++) {
@@ -116,7 +120,7 @@ void THNN_(unfolded_copy)(
     int64_t kw = rest % kW;
     int x, y;
     int64_t ix, iy;
-    real *dst = finput_data + nip*((size_t)kH*kW*outputHeight*outputWidth) + kh*((size_t)kW*outputHeight*outputWidth) + kw*((size_t)outputHeight*outputWidth);
+    real *dst = finput_data + k*rowStride;
     real *src = input_data + nip*((size_t)inputHeight*inputWidth);
     if (padW > 0 || padH > 0) {
       int64_t lpad,rpad;
@@ -101,6 +101,9 @@
 #include "generic/FusedRNNKernel.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/RNNSequence.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/LogSigmoid.c"
 #include "THGenerateFloatTypes.h"
 
@@ -110,6 +113,9 @@
 #include "generic/LookupTable.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/LookupTableBag.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/MSECriterion.c"
 #include "THGenerateFloatTypes.h"
 
@@ -194,6 +200,9 @@
 #include "generic/unfold.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/SpatialConvolutionAlgorithms.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/SpatialConvolutionMap.c"
 #include "THGenerateFloatTypes.h"
 
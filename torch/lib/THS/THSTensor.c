@@ -1,5 +1,176 @@
 #include "THSTensor.h"
 
+/******************************************************************************
+ * Helpers on flattened indices
+ *
+ *  Coalescing and the sparse-sparse arithmetic work on the 64-bit linear
+ *  index of every nonzero (its indices flattened in row-major order), which
+ *  keeps the ordering of the multi-dimensional indices. The work is cut into
+ *  contiguous chunks, one per thread, so it runs in parallel without atomics.
+ ******************************************************************************/
+
+#define THS_RADIX_BITS 8
+#define THS_RADIX_SIZE (1 << THS_RADIX_BITS)
+
+/* first element of chunk c out of nChunks for n elements */
+#define THS_CHUNK_BEGIN(n, c, nChunks) ((n) * (c) / (nChunks))
+
+/* Computes the linear index of each of the nnz columns of indices (nDimI x nnz)
+ * into a newly allocated array */
+static int64_t *THS_linearIndices(THLongTensor *indices, int64_t nnz, int64_t nDimI,
+                                  const int64_t *sizes)
+{
+  int64_t *keys = THAlloc(nnz * sizeof(int64_t));
+  int64_t i;
+#pragma omp parallel for num_threads(THParallelNumThreads(nnz, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nnz; i++) {
+    int64_t key = 0;
+    for (int64_t d = 0; d < nDimI; d++) {
+      key = key * sizes[d] + THTensor_fastGet2d(indices, d, i);
+    }
+    keys[i] = key;
+  }
+  return keys;
+}
+
+/* Stable LSD radix sort of keys, applying the same permutation to perm. Only
+ * the bits that vary between the smallest and the largest key are sorted. */
+static void THS_radixSort(int64_t *keys, int64_t *perm, int64_t n)
+{
+  int nChunks = THParallelNumThreads(n, TH_PARALLEL_GRAIN_SIZE);
+  int64_t *counts = THAlloc(nChunks * THS_RADIX_SIZE * sizeof(int64_t));
+  int64_t *keysBuffer = THAlloc(n * sizeof(int64_t));
+  int64_t *permBuffer = THAlloc(n * sizeof(int64_t));
+  int64_t *srcKeys = keys, *srcPerm = perm;
+  int64_t *dstKeys = keysBuffer, *dstPerm = permBuffer;
+  int64_t i, b;
+  int c, shift;
+
+  int64_t minKey = keys[0], maxKey = keys[0];
+  for (i = 1; i < n; i++) {
+    if (keys[i] < minKey) minKey = keys[i];
+    if (keys[i] > maxKey) maxKey = keys[i];
+  }
+  uint64_t range = (uint64_t)maxKey - (uint64_t)minKey;
+
+  for (shift = 0; shift < 64 && (range >> shift) != 0; shift += THS_RADIX_BITS) {
+#pragma omp parallel for num_threads(nChunks) private(c, i)
+    for (c = 0; c < nChunks; c++) {
+      int64_t *count = counts + c * THS_RADIX_SIZE;
+      memset(count, 0, THS_RADIX_SIZE * sizeof(int64_t));
+      for (i = THS_CHUNK_BEGIN(n, c, nChunks); i < THS_CHUNK_BEGIN(n, c + 1, nChunks); i++) {
+        count[(((uint64_t)srcKeys[i] - (uint64_t)minKey) >> shift) & (THS_RADIX_SIZE - 1)]++;
+      }
+    }
+
+    // digit-major exclusive scan: chunk c writes its keys with digit b after
+    // those of all smaller digits and of the chunks before it, which keeps
+    // the sort stable
+    int64_t offset = 0;
+    for (b = 0; b < THS_RADIX_SIZE; b++) {
+      for (c = 0; c < nChunks; c++) {
+        int64_t count = counts[c * THS_RADIX_SIZE + b];
+        counts[c * THS_RADIX_SIZE + b] = offset;
+        offset += count;
+      }
+    }
+
+#pragma omp parallel for num_threads(nChunks) private(c, i)
+    for (c = 0; c < nChunks; c++) {
+      int64_t *position = counts + c * THS_RADIX_SIZE;
+      for (i = THS_CHUNK_BEGIN(n, c, nChunks); i < THS_CHUNK_BEGIN(n, c + 1, nChunks); i++) {
+        int64_t p = position[(((uint64_t)srcKeys[i] - (uint64_t)minKey) >> shift) & (THS_RADIX_SIZE - 1)]++;
+        dstKeys[p] = srcKeys[i];
+        dstPerm[p] = srcPerm[i];
+      }
+    }
+
+    int64_t *tmp;
+    tmp = srcKeys; srcKeys = dstKeys; dstKeys = tmp;
+    tmp = srcPerm; srcPerm = dstPerm; dstPerm = tmp;
+  }
+
+  if (srcKeys != keys) {
+    memcpy(keys, srcKeys, n * sizeof(int64_t));
+    memcpy(perm, srcPerm, n * sizeof(int64_t));
+  }
+  THFree(counts);
+  THFree(keysBuffer);
+  THFree(permBuffer);
+}
+
+/* Writes the position of the first key of each run of equal sorted keys to
+ * starts, followed by n, and returns the number of runs */
+static int64_t THS_runStarts(const int64_t *keys, int64_t n, int64_t *starts)
+{
+  int64_t nRuns = 0;
+  for (int64_t i = 0; i < n; i++) {
+    if (i == 0 || keys[i] != keys[i - 1]) {
+      starts[nRuns++] = i;
+    }
+  }
+  starts[nRuns] = n;
+  return nRuns;
+}
+
+static int64_t THS_lowerBound(const int64_t *keys, int64_t n, int64_t key)
+{
+  int64_t lo = 0, hi = n;
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (keys[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Splits the merge of the sorted keys a and b into nChunks parts that never
+ * separate equal keys: part c merges a[aSplit[c], aSplit[c+1]) with
+ * b[bSplit[c], bSplit[c+1]). The splits are taken at evenly spaced keys of
+ * the longer list. */
+static void THS_mergeSplits(const int64_t *a, int64_t na, const int64_t *b, int64_t nb,
+                            int nChunks, int64_t *aSplit, int64_t *bSplit)
+{
+  const int64_t *longer = na >= nb ? a : b;
+  int64_t nLonger = na >= nb ? na : nb;
+  aSplit[0] = bSplit[0] = 0;
+  for (int c = 1; c < nChunks; c++) {
+    int64_t pivot = longer[THS_CHUNK_BEGIN(nLonger, c, nChunks)];
+    aSplit[c] = THS_lowerBound(a, na, pivot);
+    bSplit[c] = THS_lowerBound(b, nb, pivot);
+  }
+  aSplit[nChunks] = na;
+  bSplit[nChunks] = nb;
+}
+
+/* Number of keys in the union (or the intersection) of the merged ranges */
+static int64_t THS_mergeCount(const int64_t *a, int64_t aBegin, int64_t aEnd,
+                              const int64_t *b, int64_t bBegin, int64_t bEnd,
+                              int intersection)
+{
+  int64_t count = 0;
+  while (aBegin < aEnd && bBegin < bEnd) {
+    if (a[aBegin] < b[bBegin]) {
+      aBegin++;
+      count += !intersection;
+    } else if (a[aBegin] > b[bBegin]) {
+      bBegin++;
+      count += !intersection;
+    } else {
+      aBegin++;
+      bBegin++;
+      count++;
+    }
+  }
+  if (!intersection) {
+    count += (aEnd - aBegin) + (bEnd - bBegin);
+  }
+  return count;
+}
+
 #include "generic/THSTensor.c"
 #include "THSGenerateAllTypes.h"
 
@@ -352,6 +352,10 @@ int THSTensor_(isCoalesced)(const THSTensor *self) {
   return self->coalesced;
 }
 
+void THSTensor_(markCoalesced)(THSTensor *self) {
+  self->coalesced = 1;
+}
+
 /* Internal slice operations. Buffers can be reused across calls to avoid
 allocating tensors every time */
 
@@ -409,57 +413,49 @@ THSTensor *THSTensor_(newCoalesce)(THSTensor *self) {
   THTensor *values = THTensor_(newContiguous)(values_);
   int64_t nDimI = THSTensor_(nDimensionI)(self);
   int64_t nDimV = THSTensor_(nDimensionV)(self);
-
-  THLongTensor *indicesScalar = THLongTensor_newWithSize1d(self->nnz);
-  THLongTensor *indicesSlice = THLongTensor_new();
-  THLongTensor *indicesBuffer = THLongTensor_newWithSize1d(self->nnz);
-  THLongTensor *indicesPermutation = THLongTensor_newWithSize1d(self->nnz);
-  THLongTensor_zero(indicesScalar);
-  int64_t factor = 1;
-  for (int64_t d = nDimI - 1; d >= 0; d--) {
-    THLongTensor_select(indicesSlice, indices, 0, d);
-    THLongTensor_cadd(indicesScalar, indicesScalar, factor, indicesSlice);
-    factor *= self->size[d];
+  int64_t nnz = self->nnz;
+
+  // sort the nonzeros by linear index, keeping duplicates in their original
+  // order so that they are always summed the same way
+  int64_t *keys = THS_linearIndices(indices, nnz, nDimI, self->size);
+  int64_t *perm = THAlloc(nnz * sizeof(int64_t));
+  int64_t *starts = THAlloc((nnz + 1) * sizeof(int64_t));
+  int64_t i;
+  for (i = 0; i < nnz; i++) {
+    perm[i] = i;
   }
+  THS_radixSort(keys, perm, nnz);
+  int64_t nRuns = THS_runStarts(keys, nnz, starts);
 
   THLongTensor *newIndices = THLongTensor_new();
   THTensor *newValues = THTensor_(new)();
   THLongTensor_resizeAs(newIndices, indices);
   THTensor_(resizeAs)(newValues, values_);
-  // THSTensor_(_move)(self, newIndices, newValues);
   THSTensor *dst = THSTensor_(new)();
   THSTensor_(rawResize)(dst, nDimI, nDimV, self->size);
   THSTensor_(_move)(dst, newIndices, newValues);
 
-  THLongTensor_sort(indicesBuffer, indicesPermutation, indicesScalar, 0, 0);
-
-  int64_t i = -1;
-  int64_t prev = -1;
+  // each run of equal indices becomes one nonzero
   int64_t blockSize = values->stride[0];
-  for (int64_t j = 0; j < self->nnz; j++) {
-    int64_t pos = THTensor_fastGet1d(indicesPermutation, j);
-    int64_t curr = THTensor_fastGet1d(indicesBuffer, j);
-    if (curr == prev) {
-      THBlas_(axpy)(blockSize, 1,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
-    } else {
-      ++i;
-      for (int64_t d = 0; d < nDimI; d++) {
-        THTensor_fastSet2d(newIndices, d, i, THTensor_fastGet2d(indices, d, pos));
-      }
-      THBlas_(copy)(blockSize,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
+  real *valuesData = THTensor_(data)(values);
+  real *newValuesData = THTensor_(data)(newValues);
+#pragma omp parallel for num_threads(THParallelNumThreads(nnz * blockSize, TH_PARALLEL_GRAIN_SIZE)) private(i)
+  for (i = 0; i < nRuns; i++) {
+    int64_t pos = perm[starts[i]];
+    for (int64_t d = 0; d < nDimI; d++) {
+      THTensor_fastSet2d(newIndices, d, i, THTensor_fastGet2d(indices, d, pos));
+    }
+    real *dstRow = newValuesData + i * blockSize;
+    THVector_(copy)(dstRow, valuesData + pos * blockSize, blockSize);
+    for (int64_t j = starts[i] + 1; j < starts[i + 1]; j++) {
+      THVector_(cadd)(dstRow, dstRow, valuesData + perm[j] * blockSize, 1, blockSize);
     }
-    prev = curr;
   }
-  dst->nnz = i + 1;
+  dst->nnz = nRuns;
   dst->coalesced = 1;
-  THLongTensor_free(indicesScalar);
-  THLongTensor_free(indicesBuffer);
-  THLongTensor_free(indicesPermutation);
-  THLongTensor_free(indicesSlice);
+  THFree(keys);
+  THFree(perm);
+  THFree(starts);
   THLongTensor_free(indices);
   THTensor_(free)(values_);
   THTensor_(free)(values);
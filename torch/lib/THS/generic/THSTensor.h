@@ -56,6 +56,8 @@ TH_API void THSTensor_(copy)(THSTensor *self, THSTensor *src);
 
 TH_API void THSTensor_(transpose)(THSTensor *self, int dimension1_, int dimension2_);
 TH_API int THSTensor_(isCoalesced)(const THSTensor *self);
+/* for producers that build their indices sorted and without duplicates */
+TH_API void THSTensor_(markCoalesced)(THSTensor *self);
 TH_API int THSTensor_(isSameSizeAs)(const THSTensor *self, const THSTensor *src);
 TH_API THSTensor *THSTensor_(newCoalesce)(THSTensor *self);
 
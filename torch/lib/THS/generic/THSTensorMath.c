@@ -83,6 +83,149 @@ void THSTensor_(pow)(THSTensor *r_, THSTensor *t_, real value) {
 
   THSTensor_(free)(t);
 }
+
+/* Coalesces a gradient that is sparse along the first dimension of param and
+ * checks it, and the optimizer state, against param. Returns the number of rows
+ * to update; *rows and *values are then their contiguous indices and values. */
+static int64_t THTensor_(sparseStepRows)(THTensor *param, THSTensor *grad_,
+                                         THTensor **state, int nState,
+                                         THLongTensor **rows, THTensor **values)
+{
+  int64_t d, k;
+  THArgCheck(param->nDimension > 0 && THTensor_(isContiguous)(param), 1,
+             "parameter has to be a non-empty contiguous tensor");
+  THArgCheck(grad_->nDimensionI == 1, 2,
+             "gradient has to be sparse along the first dimension only");
+  THArgCheck(grad_->nDimensionI + grad_->nDimensionV == param->nDimension, 2,
+             "gradient and parameter have a different number of dimensions");
+  for (d = 0; d < param->nDimension; d++) {
+    THArgCheck(grad_->size[d] == param->size[d], 2,
+               "gradient and parameter have different sizes");
+  }
+  for (k = 0; k < nState; k++) {
+    THArgCheck(THTensor_(isContiguous)(state[k]) && THTensor_(isSameSizeAs)(state[k], param),
+               3 + k, "optimizer state has to be contiguous and of the size of the parameter");
+  }
+
+  THSTensor *grad = THSTensor_(newCoalesce)(grad_);
+  int64_t nnz = grad->nnz;
+  if (nnz == 0) {
+    THSTensor_(free)(grad);
+    return 0;
+  }
+
+  THLongTensor *indices = THSTensor_(newIndices)(grad);
+  THLongTensor *firstDim = THLongTensor_newSelect(indices, 0, 0);
+  THTensor *gradValues = THSTensor_(newValues)(grad);
+  *rows = THLongTensor_newContiguous(firstDim);
+  *values = THTensor_(newContiguous)(gradValues);
+  THLongTensor_free(firstDim);
+  THLongTensor_free(indices);
+  THTensor_(free)(gradValues);
+  THSTensor_(free)(grad);
+
+  int64_t *rowData = THLongTensor_data(*rows);
+  for (k = 0; k < nnz; k++) {
+    if (rowData[k] < 0 || rowData[k] >= param->size[0]) {
+      int64_t row = rowData[k];
+      THLongTensor_free(*rows);
+      THTensor_(free)(*values);
+      THArgCheck(0, 2, "gradient row %lld out of range", (long long)row);
+    }
+  }
+  return nnz;
+}
+
+void THTensor_(sparseAdamStep)(THTensor *param, THSTensor *grad, THTensor *expAvg,
+                               THTensor *expAvgSq, real stepSize, real beta1, real beta2,
+                               real eps, real weightDecay)
+{
+  THTensor *state[2] = {expAvg, expAvgSq};
+  THLongTensor *rows;
+  THTensor *values;
+  int64_t nnz = THTensor_(sparseStepRows)(param, grad, state, 2, &rows, &values);
+  if (nnz == 0) return;
+
+  int64_t rowSize = THTensor_(nElement)(param) / param->size[0];
+  int64_t *rowData = THLongTensor_data(rows);
+  real *g = THTensor_(data)(values);
+  real *p = THTensor_(data)(param);
+  real *m = THTensor_(data)(expAvg);
+  real *v = THTensor_(data)(expAvgSq);
+  int64_t k;
+
+  // rows are unique after coalescing, so they can be updated independently
+#pragma omp parallel for num_threads(THParallelNumThreads(nnz * rowSize, TH_PARALLEL_GRAIN_SIZE)) private(k)
+  for (k = 0; k < nnz; k++) {
+    int64_t offset = rowData[k] * rowSize;
+    THVector_(adam)(p + offset, g + k * rowSize, m + offset, v + offset,
+                    stepSize, beta1, beta2, eps, weightDecay, rowSize);
+  }
+
+  THLongTensor_free(rows);
+  THTensor_(free)(values);
+}
+
+void THTensor_(sparseAdagradStep)(THTensor *param, THSTensor *grad, THTensor *sum,
+                                  real lr, real eps, real weightDecay)
+{
+  THLongTensor *rows;
+  THTensor *values;
+  int64_t nnz = THTensor_(sparseStepRows)(param, grad, &sum, 1, &rows, &values);
+  if (nnz == 0) return;
+
+  int64_t rowSize = THTensor_(nElement)(param) / param->size[0];
+  int64_t *rowData = THLongTensor_data(rows);
+  real *g = THTensor_(data)(values);
+  real *p = THTensor_(data)(param);
+  real *s = THTensor_(data)(sum);
+  int64_t k;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(nnz * rowSize, TH_PARALLEL_GRAIN_SIZE)) private(k)
+  for (k = 0; k < nnz; k++) {
+    int64_t offset = rowData[k] * rowSize;
+    THVector_(adagrad)(p + offset, g + k * rowSize, s + offset, lr, eps, weightDecay, rowSize);
+  }
+
+  THLongTensor_free(rows);
+  THTensor_(free)(values);
+}
+
+void THTensor_(sparseSgdStep)(THTensor *param, THSTensor *grad, THTensor *momentumBuffer,
+                              real lr, real momentum, real dampening, real weightDecay,
+                              int nesterov)
+{
+  THLongTensor *rows;
+  THTensor *values;
+  int64_t nnz = THTensor_(sparseStepRows)(param, grad, &momentumBuffer, 1, &rows, &values);
+  if (nnz == 0) return;
+
+  int64_t rowSize = THTensor_(nElement)(param) / param->size[0];
+  int64_t *rowData = THLongTensor_data(rows);
+  real *g = THTensor_(data)(values);
+  real *p = THTensor_(data)(param);
+  real *buf = THTensor_(data)(momentumBuffer);
+  int64_t k;
+
+#pragma omp parallel for num_threads(THParallelNumThreads(nnz * rowSize, TH_PARALLEL_GRAIN_SIZE)) private(k)
+  for (k = 0; k < nnz; k++) {
+    int64_t offset = rowData[k] * rowSize;
+    THVector_(sgd)(p + offset, g + k * rowSize, buf + offset, lr, momentum, dampening,
+                   weightDecay, nesterov, rowSize);
+  }
+
+  if (weightDecay != 0) {
+    // like in the dense step, the gradient receives the weight decay: it now
+    // holds the coalesced rows the kernel decayed in place
+    THLongTensor *indices = THLongTensor_newWithStorage2d(
+      rows->storage, rows->storageOffset, 1, nnz, nnz, 1);
+    THSTensor_(_move)(grad, indices, values);
+    grad->coalesced = 1;
+  } else {
+    THTensor_(free)(values);
+  }
+  THLongTensor_free(rows);
+}
 #endif
 
 void THSTensor_(div)(THSTensor *r_, THSTensor *t, real value) {
@@ -129,70 +272,101 @@ void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
   ptrdiff_t t_nnz = t->nnz, s_nnz = src->nnz, max_nnz = t_nnz + s_nnz;
   int t_coalesced = t->coalesced, s_coalesced = src->coalesced;
   int64_t nDimI = THSTensor_(nDimensionI)(src);
-  int64_t nDimV = THSTensor_(nDimensionV)(src);
   THLongTensor *t_indices_ = THSTensor_(newIndices)(t);
   THTensor *t_values_ = THSTensor_(newValues)(t);
   THLongTensor *src_indices_ = THSTensor_(newIndices)(src);
   THTensor *s_values_ = THSTensor_(newValues)(src);
+  THTensor *t_values = THTensor_(newContiguous)(t_values_);
+  THTensor *s_values = THTensor_(newContiguous)(s_values_);
+  int64_t *t_keys = THS_linearIndices(t_indices_, t_nnz, nDimI, src->size);
+  int64_t *s_keys = THS_linearIndices(src_indices_, s_nnz, nDimI, src->size);
   THLongTensor *r_indices_ = THLongTensor_newWithSize2d(nDimI, max_nnz);
   THTensor *r_values_ = THSTensor_(newValuesWithSizeOf)(s_values_, max_nnz);
-  THTensor_(zero)(r_values_);
   THSTensor_(resizeAs)(r_, src);
   THSTensor_(_move)(r_, r_indices_, r_values_);
 
+  // Sorted inputs are merged in parallel, in chunks that never separate equal
+  // indices: a first pass counts the output of every chunk, a second one
+  // writes it. Uncoalesced inputs keep a single serial merge.
   int64_t blockSize = r_values_->stride[0];
-  int64_t cmp, d;
-  int64_t r_i = 0, t_i = 0, s_i = 0;
-  while (t_i < t_nnz || s_i < s_nnz) {
-    if (t_i >= t_nnz) {
-      cmp = -1;
-    } else if (s_i >= s_nnz) {
-      cmp = 1;
-    } else {
-      cmp = 0;
-      for (d = 0; d < nDimI; d++) {
-        if (THTensor_fastGet2d(t_indices_, d, t_i) < THTensor_fastGet2d(src_indices_, d, s_i)) {
-          cmp = 1;
-          break;
+  int nChunks = (t_coalesced && s_coalesced) ?
+    THParallelNumThreads(max_nnz * blockSize, TH_PARALLEL_GRAIN_SIZE) : 1;
+  int64_t *t_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  int64_t *s_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  int64_t *r_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  THS_mergeSplits(t_keys, t_nnz, s_keys, s_nnz, nChunks, t_split, s_split);
+  int c;
+
+#pragma omp parallel for num_threads(nChunks) private(c)
+  for (c = 0; c < nChunks; c++) {
+    r_split[c + 1] = THS_mergeCount(t_keys, t_split[c], t_split[c + 1],
+                                    s_keys, s_split[c], s_split[c + 1], 0);
+  }
+  r_split[0] = 0;
+  for (c = 0; c < nChunks; c++) {
+    r_split[c + 1] += r_split[c];
+  }
+
+  real *t_data = THTensor_(data)(t_values);
+  real *s_data = THTensor_(data)(s_values);
+  real *r_data = THTensor_(data)(r_values_);
+#pragma omp parallel for num_threads(nChunks) private(c)
+  for (c = 0; c < nChunks; c++) {
+    int64_t t_i = t_split[c], t_end = t_split[c + 1];
+    int64_t s_i = s_split[c], s_end = s_split[c + 1];
+    int64_t r_i = r_split[c];
+    int64_t cmp, d;
+    while (t_i < t_end || s_i < s_end) {
+      if (t_i >= t_end) {
+        cmp = -1;
+      } else if (s_i >= s_end) {
+        cmp = 1;
+      } else {
+        cmp = t_keys[t_i] < s_keys[s_i] ? 1 : (t_keys[t_i] > s_keys[s_i] ? -1 : 0);
+      }
+      real *r_row = r_data + r_i * blockSize;
+      if (cmp >= 0) {
+        for (d = 0; d < nDimI; d++) {
+          THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(t_indices_, d, t_i));
         }
-        if (THTensor_fastGet2d(t_indices_, d, t_i) > THTensor_fastGet2d(src_indices_, d, s_i)) {
-          cmp = -1;
-          break;
+      } else {
+        for (d = 0; d < nDimI; d++) {
+          THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(src_indices_, d, s_i));
         }
       }
-    }
-    if (cmp >= 0) {
-      for (d = 0; d < nDimI; d++) {
-        THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(t_indices_, d, t_i));
-      }
-      THBlas_(axpy)(blockSize, 1,
-        THTensor_(data)(t_values_) + t_i * blockSize, 1,
-        THTensor_(data)(r_values_) + r_i * blockSize, 1);
-      t_i++;
-    }
-    if (cmp <= 0) {
-      for (d = 0; d < nDimI; d++) {
-        THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(src_indices_, d, s_i));
+      if (cmp == 0) {
+        THVector_(cadd)(r_row, t_data + t_i * blockSize, s_data + s_i * blockSize, value, blockSize);
+        t_i++;
+        s_i++;
+      } else if (cmp > 0) {
+        THVector_(copy)(r_row, t_data + t_i * blockSize, blockSize);
+        t_i++;
+      } else {
+        THVector_(muls)(r_row, s_data + s_i * blockSize, value, blockSize);
+        s_i++;
       }
-      THBlas_(axpy)(blockSize, value,
-        THTensor_(data)(s_values_) + s_i * blockSize, 1,
-        THTensor_(data)(r_values_) + r_i * blockSize, 1);
-      s_i++;
+      r_i++;
     }
-    r_i++;
   }
 
-  r_->nnz = r_i;
+  r_->nnz = r_split[nChunks];
   // TODO: I think it may be possible to track inside the loop and
   // detect when we are uncoalesced (e.g., by observing that an
   // index goes backwards) which may be more precise than using the
   // coalesced flag here.  But this is easy.
   r_->coalesced = t_coalesced && s_coalesced;
 
+  THFree(t_keys);
+  THFree(s_keys);
+  THFree(t_split);
+  THFree(s_split);
+  THFree(r_split);
   THLongTensor_free(t_indices_);
   THTensor_(free)(t_values_);
+  THTensor_(free)(t_values);
   THLongTensor_free(src_indices_);
   THTensor_(free)(s_values_);
+  THTensor_(free)(s_values);
 }
 
 void THSTensor_(csub)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
@@ -216,56 +390,78 @@ void THSTensor_(cmul)(THSTensor *r_, THSTensor *t_, THSTensor *src_) {
   ptrdiff_t t_nnz = t->nnz, s_nnz = src->nnz;
   ptrdiff_t max_nnz = t_nnz < s_nnz ? t_nnz : s_nnz;
   int64_t nDimI = THSTensor_(nDimensionI)(src);
-  int64_t nDimV = THSTensor_(nDimensionV)(src);
   THLongTensor *t_indices_ = THSTensor_(newIndices)(t);
   THTensor *t_values_ = THSTensor_(newValues)(t);
   THLongTensor *src_indices_ = THSTensor_(newIndices)(src);
   THTensor *s_values_ = THSTensor_(newValues)(src);
+  THTensor *t_values = THTensor_(newContiguous)(t_values_);
+  THTensor *s_values = THTensor_(newContiguous)(s_values_);
+  int64_t *t_keys = THS_linearIndices(t_indices_, t_nnz, nDimI, src->size);
+  int64_t *s_keys = THS_linearIndices(src_indices_, s_nnz, nDimI, src->size);
   THLongTensor *r_indices_ = THLongTensor_newWithSize2d(nDimI, max_nnz);
   THTensor *r_values_ = THSTensor_(newValuesWithSizeOf)(s_values_, max_nnz);
-  THTensor_(zero)(r_values_);
   THSTensor_(resizeAs)(r_, src);
   THSTensor_(_move)(r_, r_indices_, r_values_);
 
-  THTensor *src1Buffer = THTensor_(new)();
-  THTensor *src2Buffer = THTensor_(new)();
-  THTensor *dstBuffer = THTensor_(new)();
-  int64_t match, d;
-  int64_t r_i = 0, t_i = 0, s_i = 0;
-  while (t_i < t_nnz && s_i < s_nnz) {
-    match = 1;
-    for (d = 0; d < nDimI; d++) {
-      if (THTensor_fastGet2d(t_indices_, d, t_i) < THTensor_fastGet2d(src_indices_, d, s_i)) {
+  // both inputs are coalesced, so they are intersected in parallel like cadd
+  int64_t blockSize = r_values_->stride[0];
+  int nChunks = THParallelNumThreads((t_nnz + s_nnz) * blockSize, TH_PARALLEL_GRAIN_SIZE);
+  int64_t *t_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  int64_t *s_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  int64_t *r_split = THAlloc((nChunks + 1) * sizeof(int64_t));
+  THS_mergeSplits(t_keys, t_nnz, s_keys, s_nnz, nChunks, t_split, s_split);
+  int c;
+
+#pragma omp parallel for num_threads(nChunks) private(c)
+  for (c = 0; c < nChunks; c++) {
+    r_split[c + 1] = THS_mergeCount(t_keys, t_split[c], t_split[c + 1],
+                                    s_keys, s_split[c], s_split[c + 1], 1);
+  }
+  r_split[0] = 0;
+  for (c = 0; c < nChunks; c++) {
+    r_split[c + 1] += r_split[c];
+  }
+
+  real *t_data = THTensor_(data)(t_values);
+  real *s_data = THTensor_(data)(s_values);
+  real *r_data = THTensor_(data)(r_values_);
+#pragma omp parallel for num_threads(nChunks) private(c)
+  for (c = 0; c < nChunks; c++) {
+    int64_t t_i = t_split[c], t_end = t_split[c + 1];
+    int64_t s_i = s_split[c], s_end = s_split[c + 1];
+    int64_t r_i = r_split[c];
+    while (t_i < t_end && s_i < s_end) {
+      if (t_keys[t_i] < s_keys[s_i]) {
+        t_i++;
+      } else if (t_keys[t_i] > s_keys[s_i]) {
+        s_i++;
+      } else {
+        for (int64_t d = 0; d < nDimI; d++) {
+          THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(t_indices_, d, t_i));
+        }
+        THVector_(cmul)(r_data + r_i * blockSize, t_data + t_i * blockSize,
+                        s_data + s_i * blockSize, blockSize);
+        r_i++;
         t_i++;
-        match = 0;
-        break;
-      }
-      if (THTensor_fastGet2d(t_indices_, d, t_i) > THTensor_fastGet2d(src_indices_, d, s_i)) {
         s_i++;
-        match = 0;
-        break;
       }
     }
-    if (!match) continue;
-    for (d = 0; d < nDimI; d++) {
-      THTensor_fastSet2d(r_indices_, d, r_i, THTensor_fastGet2d(t_indices_, d, t_i));
-    }
-    THSTensor_(mulSlice)(dstBuffer, src1Buffer, src2Buffer, r_values_, t_values_, s_values_, 0, r_i, t_i, s_i);
-    r_i++;
-    t_i++;
-    s_i++;
   }
 
-  r_->nnz = r_i;
+  r_->nnz = r_split[nChunks];
   r_->coalesced = 1;
 
+  THFree(t_keys);
+  THFree(s_keys);
+  THFree(t_split);
+  THFree(s_split);
+  THFree(r_split);
   THLongTensor_free(t_indices_);
   THTensor_(free)(t_values_);
+  THTensor_(free)(t_values);
   THLongTensor_free(src_indices_);
   THTensor_(free)(s_values_);
-  THTensor_(free)(src1Buffer);
-  THTensor_(free)(src2Buffer);
-  THTensor_(free)(dstBuffer);
+  THTensor_(free)(s_values);
   THSTensor_(free)(t);
   THSTensor_(free)(src);
 }
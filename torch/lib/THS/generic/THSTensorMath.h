@@ -32,6 +32,18 @@ TH_API void THSTensor_(spcadd)(THTensor *r_, THTensor *dense, real value, THSTen
 
 #if defined(THS_REAL_IS_FLOAT) || defined(THS_REAL_IS_DOUBLE)
 TH_API void THSTensor_(pow)(THSTensor *r_, THSTensor *t, real value);
+
+// Optimizer steps for a gradient that is sparse along the first dimension of
+// the parameter: only the rows present in the gradient are updated, together
+// with the same rows of the (dense) optimizer state.
+TH_API void THTensor_(sparseAdamStep)(THTensor *param, THSTensor *grad, THTensor *expAvg,
+                                      THTensor *expAvgSq, real stepSize, real beta1, real beta2,
+                                      real eps, real weightDecay);
+TH_API void THTensor_(sparseAdagradStep)(THTensor *param, THSTensor *grad, THTensor *sum,
+                                         real lr, real eps, real weightDecay);
+TH_API void THTensor_(sparseSgdStep)(THTensor *param, THSTensor *grad, THTensor *momentumBuffer,
+                                     real lr, real momentum, real dampening, real weightDecay,
+                                     int nesterov);
 #endif
 
 #endif
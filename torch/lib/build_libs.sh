@@ -148,6 +148,31 @@ function build_mkldnn() {
     cd ../..
  }
 
+# The C++ inference runtime lives in torch/csrc/jit/runtime and is built
+# against the libraries installed above.  Nothing else builds its tests, so
+# they are run here.
+function build_jit_runtime() {
+  mkdir -p build/jit_runtime
+  cd build/jit_runtime
+  ${CMAKE_VERSION} "$BASE_DIR/torch/csrc/jit/runtime" \
+              -DCMAKE_INSTALL_PREFIX="$INSTALL_DIR" \
+              -DCMAKE_CXX_FLAGS="$C_FLAGS -fexceptions $CPP_FLAGS" \
+              -DCMAKE_EXE_LINKER_FLAGS="$LDFLAGS" \
+              -DTH_INCLUDE_PATH="$INSTALL_DIR/include" \
+              -DTH_LIB_PATH="$INSTALL_DIR/lib" \
+              -DTH_LIBRARIES="$INSTALL_DIR/lib/libTH$LD_POSTFIX" \
+              -DATEN_LIBRARIES="$INSTALL_DIR/lib/libATen$LD_POSTFIX" \
+              -DTHNN_LIBRARIES="$INSTALL_DIR/lib/libTHNN$LD_POSTFIX" \
+              -DTHS_LIBRARIES="$INSTALL_DIR/lib/libTHS$LD_POSTFIX" \
+              -DJIT_RUNTIME_WITH_TESTS=1 \
+              -DCMAKE_BUILD_TYPE=$([ $DEBUG ] && echo Debug || echo Release)
+  make install -j$(getconf _NPROCESSORS_ONLN)
+  LD_LIBRARY_PATH="$INSTALL_DIR/lib:$LD_LIBRARY_PATH" \
+    DYLD_LIBRARY_PATH="$INSTALL_DIR/lib:$DYLD_LIBRARY_PATH" \
+    ctest --output-on-failure
+  cd ../..
+}
+
 # In the torch/lib directory, create an installation directory
 mkdir -p tmp_install
 
@@ -159,6 +184,8 @@ for arg in "$@"; do
         build gloo $GLOO_FLAGS
     elif [[ "$arg" == "mkldnn" ]]; then
         build_mkldnn
+    elif [[ "$arg" == "jit_runtime" ]]; then
+        build_jit_runtime
     else
         build $arg
     fi
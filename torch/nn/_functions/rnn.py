@@ -1,7 +1,9 @@
 import warnings
+import torch
 from torch.autograd import Function, NestedIOFunction, Variable
 from torch.autograd.function import _iter_variables, _unflatten
 import torch.backends.cudnn as cudnn
+from torch._thnn import type2backend
 from .. import functional as F
 from .thnn import rnnFusedPointwise as fusedBackend
 
@@ -21,14 +23,58 @@ def RNNTanhCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     return hy
 
 
-def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
-    if input.is_cuda:
-        igates = F.linear(input, w_ih)
-        hgates = F.linear(hidden[0], w_hh)
-        state = fusedBackend.LSTMFused.apply
-        return state(igates, hgates, hidden[1]) if b_ih is None else state(igates, hgates, hidden[1], b_ih, b_hh)
+class FusedWithAutogradFallback(Function):
+    """Runs fused_fn, built on fused or native kernels whose gradients can't
+    be differentiated, and differentiates autograd_fn, the same computation
+    written with autograd ops, when backward is called with create_graph=True.
+
+    Both functions take and return flat tuples of Variables."""
+
+    @staticmethod
+    def forward(ctx, fused_fn, autograd_fn, *inputs):
+        ctx.autograd_fn = autograd_fn
+        ctx.inner_inputs = tuple(Variable(i, requires_grad=True) for i in inputs)
+        ctx.inner_outputs = fused_fn(*ctx.inner_inputs)
+        ctx.save_for_backward(*inputs)
+        return tuple(o.data for o in ctx.inner_outputs)
+
+    @staticmethod
+    def backward(ctx, *grad_outputs):
+        grad_outputs = tuple(g if g is not None else Variable(o.data.new(o.size()).zero_())
+                             for g, o in zip(grad_outputs, ctx.inner_outputs))
+        if all(g.volatile for g in grad_outputs):
+            # the graph of the fused kernels is kept for the next backward
+            # when the outer graph is retained
+            grads = torch.autograd.grad(ctx.inner_outputs, ctx.inner_inputs,
+                                        grad_outputs, retain_graph=True)
+        else:
+            inputs = ctx.saved_variables
+            grads = torch.autograd.grad(ctx.autograd_fn(*inputs), inputs,
+                                        grad_outputs, create_graph=True)
+        return (None, None) + tuple(grads)
 
-    hx, cx = hidden
+
+def fused_with_autograd_fallback(fused_fn, autograd_fn, *inputs):
+    if any(i.volatile for i in inputs) or not any(i.requires_grad for i in inputs):
+        return fused_fn(*inputs)
+    return FusedWithAutogradFallback.apply(fused_fn, autograd_fn, *inputs)
+
+
+def _use_cpu_fused_kernels(input):
+    # THNN has fused pointwise kernels for float/double on CPU. They have no
+    # symbolic, so traces keep the autograd ops.
+    return (isinstance(input.data, (torch.FloatTensor, torch.DoubleTensor)) and
+            not torch._C._jit_is_tracing(input))
+
+
+def _fused_lstm_cell(input, hx, cx, w_ih, w_hh, b_ih=None, b_hh=None):
+    igates = F.linear(input, w_ih)
+    hgates = F.linear(hx, w_hh)
+    state = fusedBackend.LSTMFused.apply
+    return state(igates, hgates, cx) if b_ih is None else state(igates, hgates, cx, b_ih, b_hh)
+
+
+def _autograd_lstm_cell(input, hx, cx, w_ih, w_hh, b_ih=None, b_hh=None):
     gates = F.linear(input, w_ih, b_ih) + F.linear(hx, w_hh, b_hh)
 
     ingate, forgetgate, cellgate, outgate = gates.chunk(4, 1)
@@ -44,14 +90,24 @@ def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     return hy, cy
 
 
-def GRUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
-
+def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+    hx, cx = hidden
     if input.is_cuda:
-        gi = F.linear(input, w_ih)
-        gh = F.linear(hidden, w_hh)
-        state = fusedBackend.GRUFused.apply
-        return state(gi, gh, hidden) if b_ih is None else state(gi, gh, hidden, b_ih, b_hh)
+        return _fused_lstm_cell(input, hx, cx, w_ih, w_hh, b_ih, b_hh)
+    if _use_cpu_fused_kernels(input):
+        args = (input, hx, cx, w_ih, w_hh) + ((b_ih, b_hh) if b_ih is not None else ())
+        return fused_with_autograd_fallback(_fused_lstm_cell, _autograd_lstm_cell, *args)
+    return _autograd_lstm_cell(input, hx, cx, w_ih, w_hh, b_ih, b_hh)
 
+
+def _fused_gru_cell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+    gi = F.linear(input, w_ih)
+    gh = F.linear(hidden, w_hh)
+    state = fusedBackend.GRUFused.apply
+    return state(gi, gh, hidden) if b_ih is None else state(gi, gh, hidden, b_ih, b_hh)
+
+
+def _autograd_gru_cell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     gi = F.linear(input, w_ih, b_ih)
     gh = F.linear(hidden, w_hh, b_hh)
     i_r, i_i, i_n = gi.chunk(3, 1)
@@ -65,6 +121,16 @@ def GRUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     return hy
 
 
+def GRUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
+    if input.is_cuda:
+        return _fused_gru_cell(input, hidden, w_ih, w_hh, b_ih, b_hh)
+    if _use_cpu_fused_kernels(input):
+        args = (input, hidden, w_ih, w_hh) + ((b_ih, b_hh) if b_ih is not None else ())
+        return fused_with_autograd_fallback(lambda *a: (_fused_gru_cell(*a),),
+                                            lambda *a: (_autograd_gru_cell(*a),), *args)[0]
+    return _autograd_gru_cell(input, hidden, w_ih, w_hh, b_ih, b_hh)
+
+
 def StackedRNN(inners, num_layers, lstm=False, dropout=0, train=True):
 
     num_directions = len(inners)
@@ -343,6 +409,149 @@ class CudnnRNN(NestedIOFunction):
         return grad_input, grad_weight, grad_hx
 
 
+class CpuRNN(NestedIOFunction):
+    """Runs LSTM and GRU layers over whole sequences with the native THNN
+    kernels: one call per layer and direction instead of a few autograd ops
+    per time step."""
+
+    def __init__(self, mode, input_size, hidden_size, num_layers=1,
+                 batch_first=False, dropout=0, train=True, bidirectional=False,
+                 batch_sizes=None, dropout_state=None, flat_weight=None):
+        super(CpuRNN, self).__init__()
+        self.mode = mode
+        self.input_size = input_size
+        self.hidden_size = hidden_size
+        self.num_layers = num_layers
+        self.batch_first = batch_first
+        self.dropout = dropout
+        self.train = train
+        self.num_directions = 2 if bidirectional else 1
+        self.batch_sizes = batch_sizes
+
+    @staticmethod
+    def is_acceptable(mode, tensor):
+        return mode in ('LSTM', 'GRU') and isinstance(tensor, (torch.FloatTensor, torch.DoubleTensor))
+
+    def _flatten_input(self, input):
+        # the kernels take the time steps as consecutive blocks of rows,
+        # which is already the layout of a packed sequence
+        if self.batch_sizes is not None:
+            return input, torch.LongTensor(self.batch_sizes)
+        if self.batch_first:
+            input = input.transpose(0, 1)
+        seq_length, batch = input.size(0), input.size(1)
+        return input.contiguous().view(seq_length * batch, -1), torch.LongTensor(seq_length).fill_(batch)
+
+    def _unflatten_output(self, output, input):
+        if self.batch_sizes is not None:
+            return output
+        seq_dim, batch_dim = (1, 0) if self.batch_first else (0, 1)
+        output = output.view(input.size(seq_dim), input.size(batch_dim), output.size(1))
+        return output.transpose(0, 1) if self.batch_first else output
+
+    def forward_extended(self, input, weight, hx):
+        backend = type2backend[type(input)]
+        is_lstm = self.mode == 'LSTM'
+        x, batch_sizes = self._flatten_input(input)
+        hidden = tuple(hx) if is_lstm else (hx,)
+        hy = tuple(h.new().resize_as_(h) for h in hidden)
+
+        self.layer_inputs = []
+        self.workspaces = []
+        self.dropout_masks = []
+        for layer in range(self.num_layers):
+            self.layer_inputs.append(x)
+            outputs = []
+            for direction in range(self.num_directions):
+                l = layer * self.num_directions + direction
+                w_ih, w_hh = weight[l][0], weight[l][1]
+                b_ih, b_hh = (weight[l][2], weight[l][3]) if len(weight[l]) == 4 else (None, None)
+                output = x.new()
+                workspace = x.new()
+                if is_lstm:
+                    backend.LSTMSequence_updateOutput(
+                        backend.library_state, x, batch_sizes, w_ih, w_hh, b_ih, b_hh,
+                        hidden[0][l], hidden[1][l], output, hy[0][l], hy[1][l], workspace,
+                        direction == 1)
+                else:
+                    backend.GRUSequence_updateOutput(
+                        backend.library_state, x, batch_sizes, w_ih, w_hh, b_ih, b_hh,
+                        hidden[0][l], output, hy[0][l], workspace, direction == 1)
+                outputs.append(output)
+                self.workspaces.append(workspace)
+            x = torch.cat(outputs, 1) if self.num_directions == 2 else outputs[0]
+
+            mask = None
+            if self.dropout != 0 and self.train and layer < self.num_layers - 1:
+                mask = x.new().resize_as_(x)
+                if self.dropout == 1:
+                    mask.fill_(0)
+                else:
+                    mask.bernoulli_(1 - self.dropout).div_(1 - self.dropout)
+                x = x * mask
+            self.dropout_masks.append(mask)
+
+        self.batch_sizes_tensor = batch_sizes
+        output = self._unflatten_output(x, input)
+        self.save_for_backward(input, hx, weight, output)
+        return output, (hy if is_lstm else hy[0])
+
+    def backward_extended(self, grad_output, grad_hy):
+        input, hx, weight, output = self.saved_tensors
+        backend = type2backend[type(input)]
+        is_lstm = self.mode == 'LSTM'
+        hidden = tuple(hx) if is_lstm else (hx,)
+        grad_hy = tuple(grad_hy) if is_lstm else (grad_hy,)
+        grad_hy = tuple(g.contiguous() if g is not None else h.new().resize_as_(h).zero_()
+                        for g, h in zip(grad_hy, hidden))
+        grad_hx = tuple(h.new().resize_as_(h) for h in hidden)
+        grad_weight = [tuple(w.new().resize_as_(w).zero_() for w in layer_weight) for layer_weight in weight]
+        batch_sizes = self.batch_sizes_tensor
+        hsz = self.hidden_size
+
+        if self.batch_sizes is None:
+            grad_x = grad_output.transpose(0, 1) if self.batch_first else grad_output
+            grad_x = grad_x.contiguous().view(-1, grad_x.size(2))
+        else:
+            grad_x = grad_output
+        for layer in reversed(range(self.num_layers)):
+            x = self.layer_inputs[layer]
+            if self.dropout_masks[layer] is not None:
+                grad_x = grad_x * self.dropout_masks[layer]
+            grad_layer_input = None
+            for direction in range(self.num_directions):
+                l = layer * self.num_directions + direction
+                w_ih, w_hh = weight[l][0], weight[l][1]
+                gw = grad_weight[l]
+                gb_ih, gb_hh = (gw[2], gw[3]) if len(gw) == 4 else (None, None)
+                grad_input = x.new()
+                if is_lstm:
+                    backend.LSTMSequence_backward(
+                        backend.library_state, x, batch_sizes, w_ih, w_hh,
+                        self.workspaces[l], grad_x.narrow(1, direction * hsz, hsz),
+                        grad_hy[0][l], grad_hy[1][l], grad_input, grad_hx[0][l], grad_hx[1][l],
+                        gw[0], gw[1], gb_ih, gb_hh, direction == 1)
+                else:
+                    backend.GRUSequence_backward(
+                        backend.library_state, x, batch_sizes, w_ih, w_hh,
+                        self.workspaces[l], grad_x.narrow(1, direction * hsz, hsz),
+                        grad_hy[0][l], grad_input, grad_hx[0][l],
+                        gw[0], gw[1], gb_ih, gb_hh, direction == 1)
+                if grad_layer_input is None:
+                    grad_layer_input = grad_input
+                else:
+                    grad_layer_input.add_(grad_input)
+            grad_x = grad_layer_input
+
+        if self.batch_sizes is None:
+            seq_dim, batch_dim = (1, 0) if self.batch_first else (0, 1)
+            grad_x = grad_x.view(input.size(seq_dim), input.size(batch_dim), input.size(2))
+            if self.batch_first:
+                grad_x = grad_x.transpose(0, 1)
+
+        return grad_x, grad_weight, (grad_hx if is_lstm else grad_hx[0])
+
+
 def hack_onnx_rnn(fargs, output, args, kwargs):
     input, all_weights, hx = fargs
     output_tensors = tuple(v.data for v in _iter_variables(output))
@@ -368,16 +577,62 @@ def hack_onnx_rnn(fargs, output, args, kwargs):
     return _unflatten(flat_output, output)
 
 
+def CpuRNNWithAutogradFallback(*args, **kwargs):
+    """Runs CpuRNN, and AutogradRNN when a differentiable gradient is needed."""
+    is_lstm = args[0] == 'LSTM'
+
+    def uses_dropout(mode, input_size, hidden_size, num_layers=1, batch_first=False,
+                     dropout=0, train=True, **unused):
+        return dropout != 0 and train
+
+    def forward(input, weight, hx):
+        flat_weight = tuple(_iter_variables(weight))
+        hidden = tuple(hx) if is_lstm else (hx,)
+        # both implementations draw the dropout masks from the default
+        # generator in the same order, so replaying its state gives the
+        # recomputation the masks of the forward
+        rng_state = torch.get_rng_state() if uses_dropout(*args, **kwargs) else None
+
+        def unflatten(flat):
+            flat_hx = flat[1 + len(flat_weight):]
+            return flat[0], _unflatten(flat[1:1 + len(flat_weight)], weight), \
+                (tuple(flat_hx) if is_lstm else flat_hx[0])
+
+        def flatten(output, hy):
+            return (output,) + (tuple(hy) if is_lstm else (hy,))
+
+        def cpu_fn(*flat):
+            return flatten(*CpuRNN(*args, **kwargs)(*unflatten(flat)))
+
+        def autograd_fn(*flat):
+            if rng_state is None:
+                return flatten(*AutogradRNN(*args, **kwargs)(*unflatten(flat)))
+            current_rng_state = torch.get_rng_state()
+            torch.set_rng_state(rng_state)
+            try:
+                return flatten(*AutogradRNN(*args, **kwargs)(*unflatten(flat)))
+            finally:
+                torch.set_rng_state(current_rng_state)
+
+        outputs = fused_with_autograd_fallback(cpu_fn, autograd_fn, input, *(flat_weight + hidden))
+        return outputs[0], (tuple(outputs[1:]) if is_lstm else outputs[1])
+
+    return forward
+
+
 def RNN(*args, **kwargs):
     def forward(input, *fargs, **fkwargs):
+        is_tracing = torch._C._jit_is_tracing(input)
         if cudnn.is_acceptable(input.data):
             func = CudnnRNN(*args, **kwargs)
+        elif CpuRNN.is_acceptable(args[0], input.data):
+            func = CpuRNN(*args, **kwargs) if is_tracing else CpuRNNWithAutogradFallback(*args, **kwargs)
         else:
             func = AutogradRNN(*args, **kwargs)
 
         # Hack for the tracer that allows us to represent RNNs as single
         # nodes and export them to ONNX in this form
-        if torch._C._jit_is_tracing(input):
+        if is_tracing:
             assert not fkwargs
             output = func(input, *fargs)
             return hack_onnx_rnn((input,) + fargs, output, args, kwargs)
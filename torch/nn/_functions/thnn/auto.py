@@ -302,6 +302,8 @@ def _generate_function_classes(scope_dict):
         'LogSoftMax',
         'GRUFused',
         'LSTMFused',
+        'GRUSequence',
+        'LSTMSequence',
         'unfolded',
     }
     name_remap = {
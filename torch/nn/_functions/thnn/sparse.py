@@ -102,13 +102,41 @@ class Embedding(Function):
             tensor_type = type(grad_output).__name__
             if grad_output.is_cuda:
                 SparseTensor = getattr(torch.cuda.sparse, tensor_type)
+                grad_weight = SparseTensor(
+                    indices.view(1, -1),
+                    grad_output.view(-1, ctx._weight_size[1]),
+                    ctx._weight_size,
+                )
             else:
+                # one row per distinct index, already summed and sorted
                 SparseTensor = getattr(torch.sparse, tensor_type)
-            grad_weight = SparseTensor(
-                indices.view(1, -1),
-                grad_output.view(-1, ctx._weight_size[1]),
-                ctx._weight_size,
-            )
+                grad_indices = indices.new()
+                grad_values = grad_output.new()
+                ctx._backend.LookupTable_accGradParametersSparse(
+                    ctx._backend.library_state,
+                    indices,
+                    grad_output,
+                    grad_indices,
+                    grad_values,
+                    ctx._weight_size[0],
+                    ctx.scale_grad_by_freq,
+                    ctx.padding_idx,
+                    1
+                )
+                if grad_indices.dim() == 0:
+                    # every index was padding_idx; zero_() empties a one row
+                    # gradient, as TH tensors can't have a zero-sized dimension
+                    grad_indices = indices.new(1, 1).zero_()
+                    grad_values = grad_output.new(1, ctx._weight_size[1]).zero_()
+                    grad_weight = SparseTensor(grad_indices, grad_values, ctx._weight_size)
+                    grad_weight.zero_()
+                else:
+                    grad_weight = SparseTensor(
+                        grad_indices.view(1, -1),
+                        grad_values,
+                        ctx._weight_size,
+                    )
+                grad_weight._mark_coalesced()
         return None, grad_weight, None, None, None, None, None
 
 
@@ -116,6 +144,7 @@ _all_functions.append(Embedding)
 
 MODE_SUM = 0
 MODE_MEAN = 1
+MODE_MAX = 2
 
 
 class EmbeddingBag(Function):
@@ -133,18 +162,22 @@ class EmbeddingBag(Function):
 
     @classmethod
     def forward(cls, ctx, weight, indices, offsets,
-                max_norm, norm_type, scale_grad_by_freq, mode):
+                max_norm, norm_type, scale_grad_by_freq, mode,
+                sparse=False, per_sample_weights=None):
 
         ctx.max_norm = max_norm
         ctx.norm_type = norm_type
         ctx.scale_grad_by_freq = scale_grad_by_freq
+        ctx.sparse = sparse
 
         if mode == 'sum':
             ctx.mode = MODE_SUM
         elif mode == 'mean':
             ctx.mode = MODE_MEAN
+        elif mode == 'max':
+            ctx.mode = MODE_MAX
         else:
-            raise ValueError("mode needs to be 'sum' or 'mean', but got {}"
+            raise ValueError("mode needs to be 'sum', 'mean' or 'max', but got {}"
                              .format(mode))
 
         assert not ctx.needs_input_grad[1], "EmbeddingBag doesn't " \
@@ -166,19 +199,34 @@ class EmbeddingBag(Function):
                              " ({}), but got offsets[-1] of {}"
                              .format(indices.size(0), offsets[-1]))
 
+        # the weight is only needed for the gradient of per_sample_weights
+        ctx.save_for_backward(indices, offsets, per_sample_weights,
+                              weight if per_sample_weights is not None else None)
+
+        if per_sample_weights is not None:
+            if ctx.mode != MODE_SUM:
+                raise ValueError("per_sample_weights are only supported with mode='sum'")
+            if per_sample_weights.numel() != indices.numel():
+                raise ValueError("per_sample_weights has to have one weight per index,"
+                                 " but got {} weights for {} indices"
+                                 .format(per_sample_weights.numel(), indices.numel()))
+            per_sample_weights = per_sample_weights.contiguous().view(-1)
+
         ctx._backend = type2backend[type(weight)]
         ctx._weight_size = weight.size()
         ctx._offset2bag = offsets.new()
 
-        ctx.save_for_backward(indices)
-
         indices = indices.contiguous().view(-1)
+        offsets = offsets.contiguous()
         output = weight.new()
 
         if ctx.max_norm is not None:
             cls._renorm(ctx, indices, weight, max_norm=max_norm, norm_type=norm_type)
 
         if weight.is_cuda:
+            if ctx.mode == MODE_MAX or per_sample_weights is not None:
+                raise NotImplementedError("mode='max' and per_sample_weights are "
+                                          "only implemented for CPU tensors")
             if ctx.mode == MODE_MEAN:
                 ctx.bag_size = offsets.new().resize_(offsets.size())
             else:
@@ -195,46 +243,40 @@ class EmbeddingBag(Function):
                 ctx.bag_size
             )
         else:
-            # slow CPU implementation
-            index_output = torch.index_select(weight, 0, indices)
-            # indices = [1, 2, 30, 100, 12], offsets = [0, 2, 3]
-            ctx._offset2bag.resize_(indices.size(0)).zero_()  # offset2bag = [0 0 0 0 0]
-            ctx._offset2bag.index_fill_(0, offsets, 1)  # offset2bag = [1 0 1 0 1]
-            ctx._offset2bag[0] = 0  # offset2bag = [0 0 1 0 1]
-            ctx._offset2bag = ctx._offset2bag.cumsum(0)  # offset2bag = [0 0 1 1 2]
-            output.resize_(offsets.size(0), weight.size(1)).zero_()
-            output.index_add_(0, ctx._offset2bag, index_output)
-            if ctx.mode == MODE_MEAN:
-                if offsets.size(0) == 1:
-                    ctx.bag_size = indices.size(0)
-                else:
-                    ctx.bag_size = weight.new().resize_(offsets.size())
-                    ctx.bag_size[:-1] = offsets[1:] - offsets[:-1]
-                    ctx.bag_size[-1] = indices.size(0) - offsets[-1]
-                    ctx.bag_size = ctx.bag_size[:, None].expand_as(output)
-                output /= ctx.bag_size
+            ctx._max_indices = indices.new()
+            ctx._backend.LookupTableBag_updateOutput(
+                ctx._backend.library_state,
+                indices,
+                offsets,
+                weight,
+                output,
+                per_sample_weights,
+                ctx._max_indices,
+                ctx.mode
+            )
 
         return output
 
     @staticmethod
     @once_differentiable
     def backward(ctx, grad_output):
-        indices, = ctx.saved_tensors
+        indices, offsets, per_sample_weights, weight = ctx.saved_tensors
         indices = indices.contiguous().view(-1)
+        offsets = offsets.contiguous()
+        if per_sample_weights is not None:
+            per_sample_weights = per_sample_weights.contiguous().view(-1)
         grad_output = grad_output.contiguous()
 
-        with torch.cuda.device_of(grad_output):
-            if grad_output.is_cuda:
+        if grad_output.is_cuda:
+            if ctx.sparse:
+                raise NotImplementedError("sparse gradients are only implemented "
+                                          "for CPU tensors in EmbeddingBag")
+            with torch.cuda.device_of(grad_output):
                 _sorted = torch.cuda.LongTensor()
                 _indices = torch.cuda.LongTensor()
                 _count = torch.cuda.LongTensor()
-            else:
-                _count = torch.IntTensor()
-                _sorted = _indices = None
-
-        grad_weight = grad_output.new(ctx._weight_size).zero_()
 
-        if grad_output.is_cuda:
+            grad_weight = grad_output.new(ctx._weight_size).zero_()
             ctx._backend.LookupTableBag_accGradParameters(
                 ctx._backend.library_state,
                 indices,
@@ -249,27 +291,58 @@ class EmbeddingBag(Function):
                 ctx.bag_size,
                 1
             )
+        elif ctx.sparse:
+            # one row per distinct index, already summed and sorted
+            SparseTensor = getattr(torch.sparse, type(grad_output).__name__)
+            grad_indices = indices.new()
+            grad_values = grad_output.new()
+            ctx._backend.LookupTableBag_accGradParametersSparse(
+                ctx._backend.library_state,
+                indices,
+                offsets,
+                grad_output,
+                grad_indices,
+                grad_values,
+                per_sample_weights,
+                ctx._max_indices,
+                ctx._weight_size[0],
+                ctx.scale_grad_by_freq,
+                ctx.mode,
+                1
+            )
+            grad_weight = SparseTensor(
+                grad_indices.view(1, -1),
+                grad_values,
+                ctx._weight_size,
+            )._mark_coalesced()
         else:
-            # slow CPU implementation
-            if ctx.mode == MODE_MEAN:
-                # divide by average count
-                grad_output = grad_output / ctx.bag_size
-
-            index_grad_output = grad_output.index_select(0, ctx._offset2bag)
-            ctx._backend.LookupTable_accGradParameters(
+            grad_weight = grad_output.new(ctx._weight_size).zero_()
+            ctx._backend.LookupTableBag_accGradParameters(
                 ctx._backend.library_state,
                 indices,
-                index_grad_output,
+                offsets,
+                grad_output,
                 grad_weight,
-                _count,
-                _sorted,
-                _indices,
+                per_sample_weights,
+                ctx._max_indices,
                 ctx.scale_grad_by_freq,
-                -1,
+                ctx.mode,
                 1
             )
 
-        return grad_weight, None, None, None, None, None, None
+        grad_per_sample_weights = None
+        if per_sample_weights is not None and ctx.needs_input_grad[8]:
+            grad_per_sample_weights = grad_output.new()
+            ctx._backend.LookupTableBag_updateGradPerSampleWeights(
+                ctx._backend.library_state,
+                indices,
+                offsets,
+                weight,
+                grad_output,
+                grad_per_sample_weights
+            )
+
+        return grad_weight, None, None, None, None, None, None, None, grad_per_sample_weights
 
 
 _all_functions.append(EmbeddingBag)
@@ -6,6 +6,7 @@ from operator import mul
 from functools import reduce
 
 import torch
+import torch.backends.cpu
 from torch._C import _infer_size, _add_docstr
 from . import _functions
 from .modules import utils
@@ -50,7 +51,8 @@ def conv1d(input, weight, bias=None, stride=1, padding=0, dilation=1,
 
     f = _ConvNd(_single(stride), _single(padding), _single(dilation), False,
                 _single(0), groups, torch.backends.cudnn.benchmark,
-                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled)
+                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled,
+                torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -86,7 +88,8 @@ def conv2d(input, weight, bias=None, stride=1, padding=0, dilation=1,
 
     f = _ConvNd(_pair(stride), _pair(padding), _pair(dilation), False,
                 _pair(0), groups, torch.backends.cudnn.benchmark,
-                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled)
+                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled,
+                torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -122,7 +125,8 @@ def conv3d(input, weight, bias=None, stride=1, padding=0, dilation=1,
 
     f = _ConvNd(_triple(stride), _triple(padding), _triple(dilation), False,
                 _triple(0), groups, torch.backends.cudnn.benchmark,
-                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled)
+                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled,
+                torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -155,7 +159,7 @@ def conv_transpose1d(input, weight, bias=None, stride=1, padding=0,
     f = _ConvNd(_single(stride), _single(padding), _single(dilation), True,
                 _single(output_padding),
                 groups, torch.backends.cudnn.benchmark, torch.backends.cudnn.deterministic,
-                torch.backends.cudnn.enabled)
+                torch.backends.cudnn.enabled, torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -188,7 +192,8 @@ def conv_transpose2d(input, weight, bias=None, stride=1, padding=0,
 
     f = _ConvNd(_pair(stride), _pair(padding), _pair(dilation), True,
                 _pair(output_padding), groups, torch.backends.cudnn.benchmark,
-                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled)
+                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled,
+                torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -220,7 +225,8 @@ def conv_transpose3d(input, weight, bias=None, stride=1, padding=0,
 
     f = _ConvNd(_triple(stride), _triple(padding), _triple(dilation), True,
                 _triple(output_padding), groups, torch.backends.cudnn.benchmark,
-                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled)
+                torch.backends.cudnn.deterministic, torch.backends.cudnn.enabled,
+                torch.backends.cpu.benchmark)
     return f(input, weight, bias)
 
 
@@ -925,13 +931,15 @@ def embedding(input, embedding_matrix,
 
 
 def embedding_bag(embedding_matrix, indices, offsets=None,
-                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean'):
-    r"""Computes sums or means of 'bags' of embeddings, without instantiating the
+                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean',
+                  sparse=False, per_sample_weights=None):
+    r"""Computes sums, means or maxima of 'bags' of embeddings, without instantiating the
         intermediate embeddings.
 
         For bags of constant length,
             * embedding_bag with `mode=sum` is equivalent to nn.functional.embedding followed by `torch.sum(dim=1)`
             * with `mode=mean` is equivalent to nn.functional.embedding followed by `torch.mean(dim=1)`
+            * with `mode=max` is equivalent to nn.functional.embedding followed by `torch.max(dim=1)`
 
         However, embedding_bag is much more time and memory efficient than using a chain of these
         operations.
@@ -949,7 +957,12 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             norm_type (float, optional): The p of the p-norm to compute for the max_norm option
             scale_grad_by_freq (boolean, optional): if given, this will scale gradients by the frequency of
                                                     the words in the dictionary.
-            mode (string, optional): 'sum' | 'mean'. Specifies the way to reduce the bag. Default: 'mean'
+            mode (string, optional): 'sum' | 'mean' | 'max'. Specifies the way to reduce the bag. Default: 'mean'
+            sparse (boolean, optional): if ``True``, gradient w.r.t. the embedding matrix will be a sparse
+                                        tensor. Only supported for CPU tensors.
+            per_sample_weights (Variable, optional): weights of each index, the rows are scaled by them
+                                                     before being summed. Only supported with `mode='sum'`
+                                                     on CPU tensors.
 
         Shape:
             - Embedding_matrix: FloatTensor `(V, embedding_dim)`,
@@ -961,6 +974,7 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
                        offsets in `input` for each bag, i.e. the cumsum of lengths.
                        Offsets is not given if Input is 2D `BxN` Tensor,
                        the input is considered to be of fixed-length sequences
+            - Per_sample_weights: `N` or `BxN`, the same shape as Input
             - Output: `(B, embedding_dim)`
 
         Examples::
@@ -988,6 +1002,8 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             offsets = Variable(torch.arange(0, indices.numel(), indices.size(1),
                                out=indices.data.new().long()))
             indices = indices.view(-1)
+            if per_sample_weights is not None:
+                per_sample_weights = per_sample_weights.view(-1)
 
     elif indices.dim() != 1:
         raise ValueError("input has to be 1D or 2D Tensor,"
@@ -999,7 +1015,8 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
     return _functions.thnn.EmbeddingBag.apply(
         embedding_matrix, indices, offsets,
         max_norm, norm_type,
-        scale_grad_by_freq, mode
+        scale_grad_by_freq, mode,
+        sparse, per_sample_weights
     )
 
 
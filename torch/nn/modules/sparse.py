@@ -120,12 +120,13 @@ class Embedding(Module):
 
 
 class EmbeddingBag(Module):
-    r"""Computes sums or means of 'bags' of embeddings, without instantiating the
+    r"""Computes sums, means or maxima of 'bags' of embeddings, without instantiating the
     intermediate embeddings.
 
     For bags of constant length,
         * nn.EmbeddingBag with `mode=sum` is equivalent to nn.Embedding followed by `torch.sum(dim=1)`
         * with `mode=mean` is equivalent to nn.Embedding followed by `torch.mean(dim=1)`
+        * with `mode=max` is equivalent to nn.Embedding followed by `torch.max(dim=1)`
 
     However, nn.EmbeddingBag is much more time and memory efficient than using a chain of these
     operations.
@@ -137,12 +138,14 @@ class EmbeddingBag(Module):
         norm_type (float, optional): The p of the p-norm to compute for the max_norm option
         scale_grad_by_freq (boolean, optional): if given, this will scale gradients by the frequency of
                                                 the words in the dictionary.
-        mode (string, optional): 'sum' | 'mean'. Specifies the way to reduce the bag. Default: 'mean'
+        mode (string, optional): 'sum' | 'mean' | 'max'. Specifies the way to reduce the bag. Default: 'mean'
+        sparse (boolean, optional): if True, gradient w.r.t. weight matrix will be a sparse tensor.
+                                    Only supported for CPU tensors. See Notes of nn.Embedding.
 
     Attributes:
         weight (Tensor): the learnable weights of the module of shape (num_embeddings, embedding_dim)
 
-    Inputs: input, offsets
+    Inputs: input, offsets, per_sample_weights
         - **input** (N or BxN): LongTensor containing the indices of the embeddings
                                 to extract. When `input` is 1D Tensor of shape `N`,
                                 an `offsets` Tensor is given, that contains the
@@ -154,7 +157,9 @@ class EmbeddingBag(Module):
                                    does not need to be given, as the `input` is
                                    treated as a mini-batch of fixed length sequences
                                    of length `N` each.
-
+        - **per_sample_weights** (N or BxN, optional): weight of each index, the
+                                   embeddings are scaled by it before being summed.
+                                   Only supported with `mode='sum'` on CPU tensors.
 
     Shape:
         - Input: LongTensor `N`, N = number of embeddings to extract
@@ -184,7 +189,7 @@ class EmbeddingBag(Module):
 
     def __init__(self, num_embeddings, embedding_dim,
                  max_norm=None, norm_type=2, scale_grad_by_freq=False,
-                 mode='mean'):
+                 mode='mean', sparse=False):
         super(EmbeddingBag, self).__init__()
         self.num_embeddings = num_embeddings
         self.embedding_dim = embedding_dim
@@ -193,16 +198,18 @@ class EmbeddingBag(Module):
         self.scale_grad_by_freq = scale_grad_by_freq
         self.weight = Parameter(torch.Tensor(num_embeddings, embedding_dim))
         self.mode = mode
+        self.sparse = sparse
 
         self.reset_parameters()
 
     def reset_parameters(self):
         self.weight.data.normal_(0, 1)
 
-    def forward(self, input, offsets=None):
+    def forward(self, input, offsets=None, per_sample_weights=None):
         return F.embedding_bag(self.weight, input, offsets,
                                self.max_norm, self.norm_type,
-                               self.scale_grad_by_freq, self.mode)
+                               self.scale_grad_by_freq, self.mode,
+                               self.sparse, per_sample_weights)
 
     def __repr__(self):
         s = '{name}({num_embeddings}, {embedding_dim}'
@@ -213,6 +220,8 @@ class EmbeddingBag(Module):
         if self.scale_grad_by_freq is not False:
             s += ', scale_grad_by_freq={scale_grad_by_freq}'
         s += ', mode={mode}'
+        if self.sparse is not False:
+            s += ', sparse=True'
         s += ')'
         return s.format(name=self.__class__.__name__, **self.__dict__)
 
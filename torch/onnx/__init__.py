@@ -14,6 +14,8 @@ import string
 import json
 import math
 import contextlib
+import io
+import os
 import numbers
 import warnings
 from torch._utils import _range
@@ -109,18 +111,34 @@ def _export(model, args, f, export_params=True, verbose=False, training=False):
     if verbose:
         print(trace)
 
-    # TODO: Don't allocate a in-memory string for the protobuf
     if export_params:
         # NB: OrderedDict values is not actually a list, but trace.export is
         # not duck-typed and expects an actual list.
-        proto = trace.export(list(model.state_dict().values()))
+        initializers = list(model.state_dict().values())
     else:
-        proto = trace.export()
+        initializers = []
 
-    torch.serialization._with_file_like(f, "wb", lambda f: f.write(proto))
+    torch.serialization._with_file_like(f, "wb", lambda f: _write_proto(trace, f, initializers))
     return torch_out
 
 
+def _write_proto(trace, f, initializers):
+    try:
+        fd = f.fileno()
+    except (AttributeError, io.UnsupportedOperation):
+        f.write(trace.export(initializers))
+        return
+
+    # A real file: the protobuf is written to it while it's being encoded,
+    # instead of being built in memory first.
+    f.flush()
+    trace.export_to_file(fd, initializers)
+    try:
+        f.seek(os.lseek(fd, 0, os.SEEK_CUR))
+    except (IOError, OSError):
+        pass  # not seekable, e.g. a pipe
+
+
 attr_pattern = re.compile("^(.+)_([ifstgz])$")
 
 
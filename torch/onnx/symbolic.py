@@ -12,6 +12,10 @@ import warnings
 # - Looking for inplace ops?  They're detected by the trailing underscore, and
 #   transparently dispatched to their non inplace versions in
 #   'run_symbolic_function'.   See Note [Export inplace]
+# - The most common operators are translated by C++ rules in
+#   torch/csrc/jit/passes/onnx/symbolic.cpp, which fall back to the functions
+#   here only for calls they don't support.  Changing one of these functions?
+#   Change its C++ counterpart too.
 
 # ---------------------------------------------------------------------
 # Helper functions
@@ -47,6 +51,14 @@ def _broadcast_if_scalar(x):
         return {"broadcast_i": 1}
 
 
+def _pool_pair(x):
+    """Like _pair, but also expand an IntList[2] holding a single int, which
+    ATen uses for both dimensions."""
+    if isinstance(x, (list, tuple)) and len(x) == 1:
+        x = x[0]
+    return _pair(x)
+
+
 def _unimplemented(op, msg):
     warnings.warn("ONNX export failed on " + op + " because " + msg + " not supported")
 
@@ -234,10 +246,10 @@ def max_pool2d(g, input, kernel_size, stride, padding, dilation, ceil_mode):
     if not stride:
         stride = kernel_size
     r = g.op("MaxPool", input,
-             kernel_shape_i=_pair(kernel_size),
-             pads_i=_pair(padding),
-             dilations_i=_pair(dilation),
-             strides_i=_pair(stride))
+             kernel_shape_i=_pool_pair(kernel_size),
+             pads_i=_pool_pair(padding),
+             dilations_i=_pool_pair(dilation),
+             strides_i=_pool_pair(stride))
     return r, None
 
 
@@ -248,9 +260,9 @@ def avg_pool2d(g, input, kernel_size, stride, padding, ceil_mode, count_include_
         stride = kernel_size
     # TODO: What about count_include_pad?!
     return g.op("AveragePool", input,
-                kernel_shape_i=_pair(kernel_size),
-                strides_i=_pair(stride),
-                pads_i=_pair(padding))
+                kernel_shape_i=_pool_pair(kernel_size),
+                strides_i=_pool_pair(stride),
+                pads_i=_pool_pair(padding))
 
 
 def log_softmax(g, input, dim=None):
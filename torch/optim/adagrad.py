@@ -1,6 +1,7 @@
 import torch
+from collections import defaultdict
 
-from .optimizer import Optimizer
+from .optimizer import Optimizer, _can_fuse_step, _can_fuse_sparse_step
 
 
 class Adagrad(Optimizer):
@@ -48,6 +49,9 @@ class Adagrad(Optimizer):
             loss = closure()
 
         for group in self.param_groups:
+            # parameters updated by a single fused call, by type and step
+            fused = defaultdict(lambda: ([], [], []))
+
             for p in group['params']:
                 if p.grad is None:
                     continue
@@ -57,6 +61,12 @@ class Adagrad(Optimizer):
 
                 state['step'] += 1
 
+                if _can_fuse_step(p.data, grad, state['sum']):
+                    tensors = (p.data, grad, state['sum'])
+                    for tensor_list, tensor in zip(fused[type(p.data), state['step']], tensors):
+                        tensor_list.append(tensor)
+                    continue
+
                 if group['weight_decay'] != 0:
                     if p.grad.data.is_sparse:
                         raise RuntimeError("weight_decay option is not compatible with sparse gradients ")
@@ -65,6 +75,10 @@ class Adagrad(Optimizer):
                 clr = group['lr'] / (1 + (state['step'] - 1) * group['lr_decay'])
 
                 if p.grad.data.is_sparse:
+                    if _can_fuse_sparse_step(p.data, grad, state['sum']):
+                        # updates the rows of the gradient in place
+                        p.data._sparse_adagrad_step_(grad, state['sum'], clr, 1e-10, 0)
+                        continue
                     grad = grad.coalesce()  # the update is non-linear so indices must be unique
                     grad_indices = grad._indices()
                     grad_values = grad._values()
@@ -84,4 +98,8 @@ class Adagrad(Optimizer):
                     std = state['sum'].sqrt().add_(1e-10)
                     p.data.addcdiv_(-clr, grad, std)
 
+            for (_, step), (params, grads, sums) in fused.items():
+                clr = group['lr'] / (1 + (step - 1) * group['lr_decay'])
+                torch._C._adagrad_step(params, grads, sums, clr, 1e-10, group['weight_decay'])
+
         return loss
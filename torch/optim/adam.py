@@ -1,5 +1,7 @@
 import math
-from .optimizer import Optimizer
+import torch
+from collections import defaultdict
+from .optimizer import Optimizer, _can_fuse_step, _can_fuse_sparse_step
 
 
 class Adam(Optimizer):
@@ -17,6 +19,13 @@ class Adam(Optimizer):
             numerical stability (default: 1e-8)
         weight_decay (float, optional): weight decay (L2 penalty) (default: 0)
 
+    .. note::
+        Gradients that are sparse along the first dimension (e.g. those of
+        :class:`~torch.nn.Embedding` with ``sparse=True``) are supported for
+        float and double CPU parameters. They are applied lazily: only the
+        rows present in the gradient, and the same rows of the moment
+        estimates, are updated; the moments of the other rows are not decayed.
+
     .. _Adam\: A Method for Stochastic Optimization:
         https://arxiv.org/abs/1412.6980
     """
@@ -27,6 +36,13 @@ class Adam(Optimizer):
                         weight_decay=weight_decay)
         super(Adam, self).__init__(params, defaults)
 
+    @staticmethod
+    def _step_size(group, step):
+        beta1, beta2 = group['betas']
+        bias_correction1 = 1 - beta1 ** step
+        bias_correction2 = 1 - beta2 ** step
+        return group['lr'] * math.sqrt(bias_correction2) / bias_correction1
+
     def step(self, closure=None):
         """Performs a single optimization step.
 
@@ -39,6 +55,10 @@ class Adam(Optimizer):
             loss = closure()
 
         for group in self.param_groups:
+            beta1, beta2 = group['betas']
+            # parameters updated by a single fused call, by type and step
+            fused = defaultdict(lambda: ([], [], [], []))
+
             for p in group['params']:
                 if p.grad is None:
                     continue
@@ -49,15 +69,30 @@ class Adam(Optimizer):
                 if len(state) == 0:
                     state['step'] = 0
                     # Exponential moving average of gradient values
-                    state['exp_avg'] = grad.new().resize_as_(grad).zero_()
+                    state['exp_avg'] = p.data.new().resize_as_(p.data).zero_()
                     # Exponential moving average of squared gradient values
-                    state['exp_avg_sq'] = grad.new().resize_as_(grad).zero_()
+                    state['exp_avg_sq'] = p.data.new().resize_as_(p.data).zero_()
 
                 exp_avg, exp_avg_sq = state['exp_avg'], state['exp_avg_sq']
-                beta1, beta2 = group['betas']
 
                 state['step'] += 1
 
+                if grad.is_sparse:
+                    if not _can_fuse_sparse_step(p.data, grad, exp_avg, exp_avg_sq):
+                        raise RuntimeError("Adam only supports sparse gradients of contiguous "
+                                           "float or double CPU parameters, sparse along "
+                                           "their first dimension")
+                    p.data._sparse_adam_step_(grad, exp_avg, exp_avg_sq,
+                                              self._step_size(group, state['step']), beta1, beta2,
+                                              group['eps'], group['weight_decay'])
+                    continue
+
+                if _can_fuse_step(p.data, grad, exp_avg, exp_avg_sq):
+                    tensors = (p.data, grad, exp_avg, exp_avg_sq)
+                    for tensor_list, tensor in zip(fused[type(p.data), state['step']], tensors):
+                        tensor_list.append(tensor)
+                    continue
+
                 if group['weight_decay'] != 0:
                     grad = grad.add(group['weight_decay'], p.data)
 
@@ -67,10 +102,13 @@ class Adam(Optimizer):
 
                 denom = exp_avg_sq.sqrt().add_(group['eps'])
 
-                bias_correction1 = 1 - beta1 ** state['step']
-                bias_correction2 = 1 - beta2 ** state['step']
-                step_size = group['lr'] * math.sqrt(bias_correction2) / bias_correction1
+                step_size = self._step_size(group, state['step'])
 
                 p.data.addcdiv_(-step_size, exp_avg, denom)
 
+            for (_, step), (params, grads, exp_avgs, exp_avg_sqs) in fused.items():
+                torch._C._adam_step(params, grads, exp_avgs, exp_avg_sqs,
+                                    self._step_size(group, step), beta1, beta2,
+                                    group['eps'], group['weight_decay'])
+
         return loss
@@ -7,6 +7,29 @@ from torch.autograd import Variable
 
 required = object()
 
+_fused_step_types = (torch.FloatTensor, torch.DoubleTensor)
+
+
+def _can_fuse_step(*tensors):
+    """Returns whether the fused CPU kernels (``torch._C._adam_step`` and
+    friends) can update these tensors: they have to be dense float or double
+    CPU tensors of a single type, all contiguous.
+    """
+    tensor_type = type(tensors[0])
+    return (tensor_type in _fused_step_types and
+            all(type(t) is tensor_type and t.is_contiguous() for t in tensors))
+
+
+def _can_fuse_sparse_step(param, grad, *state):
+    """Returns whether the row-sparse CPU kernels (``param._sparse_adam_step_``
+    and friends) can apply ``grad``: it has to be a sparse tensor of the
+    matching type, sparse along the first dimension only, and the parameter
+    and its state have to satisfy :func:`_can_fuse_step`.
+    """
+    return (grad.is_sparse and grad._dimI() == 1 and
+            _can_fuse_step(param, *state) and
+            type(grad) is getattr(torch.sparse, type(param).__name__, None))
+
 
 class Optimizer(object):
     """Base class for all optimizers.
@@ -1,4 +1,6 @@
-from .optimizer import Optimizer
+import torch
+from collections import defaultdict
+from .optimizer import Optimizer, _can_fuse_step
 
 
 class RMSprop(Optimizer):
@@ -46,6 +48,9 @@ class RMSprop(Optimizer):
             loss = closure()
 
         for group in self.param_groups:
+            # parameters updated by a single fused call, by type
+            fused = defaultdict(lambda: ([], [], [], [], []))
+
             for p in group['params']:
                 if p.grad is None:
                     continue
@@ -66,6 +71,12 @@ class RMSprop(Optimizer):
 
                 state['step'] += 1
 
+                tensors = (p.data, grad, square_avg, state.get('grad_avg'), state.get('momentum_buffer'))
+                if _can_fuse_step(*[t for t in tensors if t is not None]):
+                    for tensor_list, tensor in zip(fused[type(p.data)], tensors):
+                        tensor_list.append(tensor)
+                    continue
+
                 if group['weight_decay'] != 0:
                     grad = grad.add(group['weight_decay'], p.data)
 
@@ -85,4 +96,11 @@ class RMSprop(Optimizer):
                 else:
                     p.data.addcdiv_(-group['lr'], grad, avg)
 
+            for params, grads, square_avgs, grad_avgs, bufs in fused.values():
+                torch._C._rmsprop_step(params, grads, square_avgs,
+                                       grad_avgs if group['centered'] else None,
+                                       bufs if group['momentum'] > 0 else None,
+                                       group['lr'], group['alpha'], group['eps'],
+                                       group['weight_decay'], group['momentum'])
+
         return loss
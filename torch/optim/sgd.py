@@ -1,4 +1,6 @@
-from .optimizer import Optimizer, required
+import torch
+from collections import defaultdict
+from .optimizer import Optimizer, required, _can_fuse_step, _can_fuse_sparse_step
 
 
 class SGD(Optimizer):
@@ -24,6 +26,13 @@ class SGD(Optimizer):
 
     __ http://www.cs.toronto.edu/%7Ehinton/absps/momentum.pdf
 
+    .. note::
+        With momentum, gradients that are sparse along the first dimension
+        (e.g. those of :class:`~torch.nn.Embedding` with ``sparse=True``) of
+        float and double CPU parameters are applied lazily: only the rows
+        present in the gradient, and the same rows of the momentum buffer,
+        are updated.
+
     .. note::
         The implementation of SGD with Momentum/Nesterov subtly differs from
         Sutskever et. al. and implementations in some other frameworks.
@@ -77,19 +86,41 @@ class SGD(Optimizer):
             dampening = group['dampening']
             nesterov = group['nesterov']
 
+            # parameters updated by a single fused call, by type and by
+            # whether their momentum buffer was just created
+            fused = defaultdict(lambda: ([], [], []))
+
             for p in group['params']:
                 if p.grad is None:
                     continue
                 d_p = p.grad.data
-                if weight_decay != 0:
-                    d_p.add_(weight_decay, p.data)
+                first_step = False
+                tensors = (p.data, d_p)
                 if momentum != 0:
                     param_state = self.state[p]
                     if 'momentum_buffer' not in param_state:
-                        buf = param_state['momentum_buffer'] = p.data.new().resize_as_(p.data).zero_()
+                        param_state['momentum_buffer'] = p.data.new().resize_as_(p.data).zero_()
+                        first_step = True
+                    buf = param_state['momentum_buffer']
+                    tensors += (buf,)
+
+                    if _can_fuse_sparse_step(p.data, d_p, buf):
+                        p.data._sparse_sgd_step_(d_p, buf, group['lr'], momentum,
+                                                 0 if first_step else dampening,
+                                                 weight_decay, bool(nesterov))
+                        continue
+
+                if _can_fuse_step(*tensors):
+                    for tensor_list, tensor in zip(fused[type(p.data), first_step], tensors):
+                        tensor_list.append(tensor)
+                    continue
+
+                if weight_decay != 0:
+                    d_p.add_(weight_decay, p.data)
+                if momentum != 0:
+                    if first_step:
                         buf.mul_(momentum).add_(d_p)
                     else:
-                        buf = param_state['momentum_buffer']
                         buf.mul_(momentum).add_(1 - dampening, d_p)
                     if nesterov:
                         d_p = d_p.add(momentum, buf)
@@ -98,4 +129,10 @@ class SGD(Optimizer):
 
                 p.data.add_(-group['lr'], d_p)
 
+            for (_, first_step), (params, grads, bufs) in fused.items():
+                # a new buffer is set to the gradient, undampened
+                torch._C._sgd_step(params, grads, bufs if momentum != 0 else None,
+                                   group['lr'], momentum, 0 if first_step else dampening,
+                                   weight_decay, nesterov)
+
         return loss
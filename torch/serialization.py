@@ -1,5 +1,7 @@
 import difflib
 import inspect
+import io
+import mmap
 import os
 import shutil
 import struct
@@ -7,9 +9,11 @@ import sys
 import torch
 import tarfile
 import tempfile
+import threading
 import warnings
 from contextlib import closing, contextmanager
 from ._utils import _import_dotted_name
+from ._six import string_classes
 if sys.version_info[0] == 2:
     import cPickle as pickle
 else:
@@ -23,6 +27,10 @@ SHORT_SIZE = struct.Struct('=h').size
 
 MAGIC_NUMBER = 0x1950a86a20f9469cfc6c
 PROTOCOL_VERSION = 1001
+# same as PROTOCOL_VERSION, but the storage data is page aligned
+ALIGNED_PROTOCOL_VERSION = 1002
+# storages are preceded by their size, written as an int64 by _write_file
+STORAGE_HEADER_SIZE = 8
 STORAGE_KEY_SEPARATOR = ','
 
 
@@ -100,6 +108,10 @@ def storage_to_tensor_type(storage):
     return getattr(module, storage_type.__name__.replace('Storage', 'Tensor'))
 
 
+def _align(offset, alignment):
+    return (offset + alignment - 1) // alignment * alignment
+
+
 def _with_file_like(f, mode, body):
     """
     Executes a body function with a file object for f, opening
@@ -116,7 +128,7 @@ def _with_file_like(f, mode, body):
             f.close()
 
 
-def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
+def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL, page_aligned=False):
     """Saves an object to a disk file.
 
     See also: :ref:`recommend-saving-models`
@@ -127,11 +139,15 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
             or a string containing a file name
         pickle_module: module used for pickling metadata and objects
         pickle_protocol: can be specified to override the default protocol
+        page_aligned: if True, the data of every storage starts on a page
+            boundary, so that :func:`torch.load` can map it into memory
+            with ``mmap_mode``. Such files can't be read by versions of
+            PyTorch that predate this option.
     """
-    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol))
+    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol, page_aligned))
 
 
-def _save(obj, f, pickle_module, pickle_protocol):
+def _save(obj, f, pickle_module, pickle_protocol, page_aligned=False, storage_writer=None):
     import torch.nn as nn
     serialized_container_types = {}
     serialized_storages = {}
@@ -186,6 +202,10 @@ def _save(obj, f, pickle_module, pickle_protocol):
         ),
     )
 
+    if page_aligned:
+        return _save_aligned(obj, f, pickle_module, pickle_protocol,
+                             persistent_id, serialized_storages, sys_info, storage_writer)
+
     pickle_module.dump(MAGIC_NUMBER, f, protocol=pickle_protocol)
     pickle_module.dump(PROTOCOL_VERSION, f, protocol=pickle_protocol)
     pickle_module.dump(sys_info, f, protocol=pickle_protocol)
@@ -200,7 +220,172 @@ def _save(obj, f, pickle_module, pickle_protocol):
         serialized_storages[key]._write_file(f)
 
 
-def load(f, map_location=None, pickle_module=pickle):
+def _save_aligned(obj, f, pickle_module, pickle_protocol, persistent_id,
+                  serialized_storages, sys_info, storage_writer=None):
+    # The object is pickled first, so that the offsets of all storages are
+    # known before anything is written. The file then contains the usual
+    # header, a table of (storage key, data offset) records, the pickled
+    # object, and the storages. Each storage is preceded by its size
+    # (as written by _write_file), and its data starts on a page boundary.
+    pickled = io.BytesIO()
+    pickler = pickle_module.Pickler(pickled, protocol=pickle_protocol)
+    pickler.persistent_id = persistent_id
+    pickler.dump(obj)
+    pickled = pickled.getvalue()
+
+    alignment = mmap.PAGESIZE
+    storage_records = []
+    offset = 0
+    for key in sorted(serialized_storages.keys()):
+        storage = serialized_storages[key]
+        offset = _align(offset + STORAGE_HEADER_SIZE, alignment)
+        storage_records.append((key, offset))
+        offset += storage.size() * storage.element_size()
+
+    sys_info['storage_alignment'] = alignment
+    pickle_module.dump(MAGIC_NUMBER, f, protocol=pickle_protocol)
+    pickle_module.dump(ALIGNED_PROTOCOL_VERSION, f, protocol=pickle_protocol)
+    pickle_module.dump(sys_info, f, protocol=pickle_protocol)
+    pickle_module.dump((len(pickled), storage_records), f, protocol=pickle_protocol)
+    f.write(pickled)
+
+    position = f.tell()
+    data_start = _align(position, alignment)
+    # (storage, file offset of its size) pairs
+    records = [(serialized_storages[key], data_start + offset - STORAGE_HEADER_SIZE)
+               for key, offset in storage_records]
+    if storage_writer is not None:
+        return storage_writer(records)
+
+    for storage, record_start in records:
+        f.write(b'\0' * (record_start - position))
+        f.flush()
+        storage._write_file(f)
+        position = record_start + STORAGE_HEADER_SIZE + storage.size() * storage.element_size()
+
+
+class SaveFuture(object):
+    """Handle to a checkpoint written in the background by :func:`save_async`."""
+
+    def __init__(self):
+        self._event = threading.Event()
+        self._error = None
+
+    def _set_done(self, error=None):
+        self._error = error
+        self._event.set()
+
+    def done(self):
+        """Returns True if writing the checkpoint has finished (or failed)."""
+        return self._event.is_set()
+
+    def wait(self, timeout=None):
+        """Blocks until the checkpoint is written, or until ``timeout`` seconds
+        have passed. Returns True if the checkpoint is written, and re-raises
+        the error that made writing it fail, if any.
+        """
+        if not self._event.wait(timeout):
+            return False
+        if self._error is not None:
+            raise self._error
+        return True
+
+
+def _write_storages(fd, records, num_threads):
+    # biggest storages first, so that the threads finish at about the same time
+    records = iter(sorted(records, key=lambda r: -r[0].size() * r[0].element_size()))
+    lock = threading.Lock()
+    errors = []
+
+    def worker():
+        while not errors:
+            with lock:
+                record = next(records, None)
+            if record is None:
+                return
+            storage, offset = record
+            try:
+                # releases the GIL, so the writes of all threads overlap
+                storage._write_file_at(fd, offset)
+            except Exception as e:
+                errors.append(e)
+
+    threads = [threading.Thread(target=worker) for _ in range(max(num_threads, 1))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    if errors:
+        raise errors[0]
+
+
+def save_async(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL,
+               num_threads=4, fsync=False):
+    """Saves an object to a disk file in the background.
+
+    The storages of ``obj`` are copied before this function returns, so
+    ``obj`` can be modified right away. The copies are then written by
+    ``num_threads`` threads while the caller continues. The file has the
+    format of :func:`save` with ``page_aligned=True``.
+
+    Args:
+        obj: saved object
+        f: a file-like object (has to implement fileno that returns a file
+            descriptor), or a string containing a file name. A file object
+            must not be used until the save is done.
+        pickle_module: module used for pickling metadata and objects
+        pickle_protocol: can be specified to override the default protocol
+        num_threads: number of threads writing the storages
+        fsync: if True, the file is flushed to the disk (with a single
+            ``fsync``) before the save is reported as done
+
+    Returns:
+        a :class:`~torch.serialization.SaveFuture`
+
+    Example:
+        >>> future = torch.save_async(model.state_dict(), 'model.pt')
+        >>> train(model)  # doesn't wait for the checkpoint to be written
+        >>> future.wait()
+    """
+    new_fd = isinstance(f, string_classes)
+    if new_fd:
+        f = open(f, 'wb')
+    future = SaveFuture()
+
+    def write_in_background(records):
+        # snapshot the storages, CUDA ones go to the CPU at the same time
+        records = [(storage.cpu() if storage.is_cuda else storage.clone(), offset)
+                   for storage, offset in records]
+        f.flush()
+
+        def run():
+            error = None
+            try:
+                _write_storages(f.fileno(), records, num_threads)
+                if fsync:
+                    os.fsync(f.fileno())
+                # the storages were written without moving the file position
+                f.seek(0, os.SEEK_END)
+            except Exception as e:
+                error = e
+            finally:
+                if new_fd:
+                    f.close()
+            future._set_done(error)
+
+        threading.Thread(target=run).start()
+
+    try:
+        _save(obj, f, pickle_module, pickle_protocol, page_aligned=True,
+              storage_writer=write_in_background)
+    except Exception:
+        if new_fd:
+            f.close()
+        raise
+    return future
+
+
+def load(f, map_location=None, pickle_module=pickle, mmap_mode=None):
     """Loads an object saved with :func:`torch.save` from a file.
 
     torch.load uses Python's unpickling facilities but treats storages,
@@ -237,6 +422,13 @@ def load(f, map_location=None, pickle_module=pickle):
             locations
         pickle_module: module used for unpickling metadata and objects (has to
             match the pickle_module used to serialize file)
+        mmap_mode: if ``'c'`` or ``'r'``, the storages of a file saved with
+            ``page_aligned=True`` are mapped into memory instead of being read.
+            With ``'c'`` (copy-on-write) they can be modified without changing
+            the file; with ``'r'`` (read-only) any write to them crashes the
+            process. Processes mapping the same file share its pages, and
+            only the pages that are accessed get loaded. ``f`` has to be a
+            file name or a file opened from one.
 
     Example:
         >>> torch.load('tensors.pt')
@@ -246,20 +438,31 @@ def load(f, map_location=None, pickle_module=pickle):
         >>> torch.load('tensors.pt', map_location=lambda storage, loc: storage.cuda(1))
         # Map tensors from GPU 1 to GPU 0
         >>> torch.load('tensors.pt', map_location={'cuda:1':'cuda:0'})
+        # Map the storages of a page aligned checkpoint into memory
+        >>> torch.save(model.state_dict(), 'model.pt', page_aligned=True)
+        >>> torch.load('model.pt', mmap_mode='c')
 
     """
+    filename = None
+    if mmap_mode is not None:
+        if mmap_mode not in ('c', 'r'):
+            raise ValueError("mmap_mode must be None, 'c' or 'r', but got {}".format(mmap_mode))
+        filename = f if isinstance(f, string_classes) else getattr(f, 'name', None)
+        if not isinstance(filename, string_classes) or not os.path.isfile(filename):
+            raise ValueError("mmap_mode requires f to be a file name or a file "
+                             "opened from one")
     new_fd = False
     if isinstance(f, str) or (sys.version_info[0] == 2 and isinstance(f, unicode)):
         new_fd = True
         f = open(f, 'rb')
     try:
-        return _load(f, map_location, pickle_module)
+        return _load(f, map_location, pickle_module, filename, mmap_mode)
     finally:
         if new_fd:
             f.close()
 
 
-def _load(f, map_location, pickle_module):
+def _load(f, map_location, pickle_module, filename=None, mmap_mode=None):
     deserialized_objects = {}
 
     if map_location is None:
@@ -357,6 +560,14 @@ def _load(f, map_location, pickle_module):
             return result
 
     deserialized_objects = {}
+    # maps the keys of page aligned storages to the file offset of their data
+    storage_offsets = {}
+
+    def load_storage(data_type, root_key, size):
+        if filename is not None and root_key in storage_offsets and size > 0:
+            return data_type._new_with_mapped_file(filename, storage_offsets[root_key],
+                                                   size, mmap_mode == 'r')
+        return data_type(size)
 
     def persistent_load(saved_id):
         assert isinstance(saved_id, tuple)
@@ -372,7 +583,7 @@ def _load(f, map_location, pickle_module):
             data_type, root_key, location, size, view_metadata = data
             if root_key not in deserialized_objects:
                 deserialized_objects[root_key] = restore_location(
-                    data_type(size), location)
+                    load_storage(data_type, root_key, size), location)
             storage = deserialized_objects[root_key]
             if view_metadata is not None:
                 view_key, offset, view_size = view_metadata
@@ -386,23 +597,48 @@ def _load(f, map_location, pickle_module):
 
     # try the legacy loader first, which only works if f is a tarfile
     try:
-        return legacy_load(f)
+        result = legacy_load(f)
     except tarfile.TarError:
         pass
+    else:
+        if mmap_mode is not None:
+            warnings.warn("mmap_mode is ignored for files saved in the legacy format")
+        return result
 
     f.seek(0)
     magic_number = pickle_module.load(f)
     if magic_number != MAGIC_NUMBER:
         raise RuntimeError("Invalid magic number; corrupt file?")
     protocol_version = pickle_module.load(f)
-    if protocol_version != PROTOCOL_VERSION:
+    if protocol_version not in (PROTOCOL_VERSION, ALIGNED_PROTOCOL_VERSION):
         raise RuntimeError("Invalid protocol version: %s" % protocol_version)
 
     _sys_info = pickle_module.load(f)
+    if protocol_version == ALIGNED_PROTOCOL_VERSION:
+        pickle_size, storage_records = pickle_module.load(f)
+        data_start = _align(f.tell() + pickle_size, _sys_info['storage_alignment'])
+        storage_offsets.update((key, data_start + offset) for key, offset in storage_records)
+        if filename is not None and (sys.platform == 'win32' or sys.byteorder != 'little' or
+                                     not _sys_info['little_endian'] or
+                                     _sys_info['storage_alignment'] % mmap.PAGESIZE != 0):
+            warnings.warn("the storages of this file can't be mapped on this "
+                          "machine, they will be read instead")
+            filename = None
+    elif filename is not None:
+        warnings.warn("mmap_mode is ignored for files that were not saved with "
+                      "page_aligned=True")
+        filename = None
+
     unpickler = pickle_module.Unpickler(f)
     unpickler.persistent_load = persistent_load
     result = unpickler.load()
 
+    if protocol_version == ALIGNED_PROTOCOL_VERSION:
+        if filename is None:
+            for key, offset in storage_offsets.items():
+                deserialized_objects[key]._set_from_file(f, offset - STORAGE_HEADER_SIZE)
+        return result
+
     deserialized_storage_keys = pickle_module.load(f)
 
     offset = f.tell()
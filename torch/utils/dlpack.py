@@ -1,4 +1,17 @@
 import torch
 
 from torch._C import _from_dlpack as from_dlpack
-from torch._C import _to_dlpack as to_dlpack
+from torch._C import _to_dlpack
+from torch._utils import _rebuild_tensor
+
+
+def to_dlpack(obj):
+    """Returns a DLPack capsule sharing the memory of a tensor or a storage.
+
+    Storages, including the ones moved to shared memory, are exported as
+    1-D tensors without copying them. A capsule can be consumed only once;
+    if it never is, its memory is released with the capsule.
+    """
+    if torch.is_storage(obj):
+        obj = _rebuild_tensor(obj, 0, torch.Size([obj.size()]), (1,))
+    return _to_dlpack(obj)